@@ -32,6 +32,36 @@
 #   acinclude.m4 - custom m4 macros used by configure.ac
 #
 
+# AC_LDAP_UTILS_LDAP2ARROW
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAP2ARROW],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldap2arrow,
+      [AS_HELP_STRING([--disable-ldap2arrow], [disable building ldap2arrow utility])],
+      [ ELDAP2ARROW=$enableval ],
+      [ ELDAP2ARROW=$enableval ]
+   )
+
+   if test "x${ELDAP2ARROW}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDAP2ARROW=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDAP2ARROW=${ELDAP2ARROW}
+
+   LDAPUTILS_LDAP2ARROW_STATUS="skip"
+   if test "x${ELDAP2ARROW}" == "xyes";then
+      LDAPUTILS_LDAP2ARROW_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDAP2ARROW], [test "x$LDAPUTILS_LDAP2ARROW" = "xyes"])
+])dnl
+
+
 # AC_LDAP_UTILS_LDAP2CSV
 # ______________________________________________________________________________
 AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAP2CSV],[dnl
@@ -122,6 +152,36 @@ AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPDEBUG],[dnl
 ])dnl
 
 
+# AC_LDAP_UTILS_LDAPDIFF
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPDIFF],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldapdiff,
+      [AS_HELP_STRING([--disable-ldapdiff], [disable building ldapdiff utility])],
+      [ ELDAPDIFF=$enableval ],
+      [ ELDAPDIFF=$enableval ]
+   )
+
+   if test "x${ELDAPDIFF}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDAPDIFF=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDAPDIFF=${ELDAPDIFF}
+
+   LDAPUTILS_LDAPDIFF_STATUS="skip"
+   if test "x${ELDAPDIFF}" == "xyes";then
+      LDAPUTILS_LDAPDIFF_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDAPDIFF], [test "x$LDAPUTILS_LDAPDIFF" = "xyes"])
+])dnl
+
+
 # AC_LDAP_UTILS_LDAPDN2STR
 # ______________________________________________________________________________
 AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPDN2STR],[dnl
@@ -182,6 +242,36 @@ AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPINFO],[dnl
 ])dnl
 
 
+# AC_LDAP_UTILS_LDAPLINT
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPLINT],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldaplint,
+      [AS_HELP_STRING([--disable-ldaplint], [disable building ldaplint utility])],
+      [ ELDAPLINT=$enableval ],
+      [ ELDAPLINT=$enableval ]
+   )
+
+   if test "x${ELDAPLINT}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDAPLINT=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDAPLINT=${ELDAPLINT}
+
+   LDAPUTILS_LDAPLINT_STATUS="skip"
+   if test "x${ELDAPLINT}" == "xyes";then
+      LDAPUTILS_LDAPLINT_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDAPLINT], [test "x$LDAPUTILS_LDAPLINT" = "xyes"])
+])dnl
+
+
 # AC_LDAP_UTILS_LDAPSCHEMA
 # ______________________________________________________________________________
 AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPSCHEMA],[dnl
@@ -239,12 +329,135 @@ AC_DEFUN_ONCE([AC_LDAP_UTILS_LDAPTREE],[dnl
 ])dnl
 
 
+# AC_LDAP_UTILS_LDIF2CSV
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDIF2CSV],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldif2csv,
+      [AS_HELP_STRING([--disable-ldif2csv], [disable building ldif2csv utility])],
+      [ ELDIF2CSV=$enableval ],
+      [ ELDIF2CSV=$enableval ]
+   )
+
+   if test "x${ELDIF2CSV}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDIF2CSV=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDIF2CSV=${ELDIF2CSV}
+
+   LDAPUTILS_LDIF2CSV_STATUS="skip"
+   if test "x${ELDIF2CSV}" == "xyes";then
+      LDAPUTILS_LDIF2CSV_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDIF2CSV], [test "x$LDAPUTILS_LDIF2CSV" = "xyes"])
+])dnl
+
+
+# AC_LDAP_UTILS_LDIFDIFF
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDIFDIFF],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldifdiff,
+      [AS_HELP_STRING([--disable-ldifdiff], [disable building ldifdiff utility])],
+      [ ELDIFDIFF=$enableval ],
+      [ ELDIFDIFF=$enableval ]
+   )
+
+   if test "x${ELDIFDIFF}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDIFDIFF=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDIFDIFF=${ELDIFDIFF}
+
+   LDAPUTILS_LDIFDIFF_STATUS="skip"
+   if test "x${ELDIFDIFF}" == "xyes";then
+      LDAPUTILS_LDIFDIFF_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDIFDIFF], [test "x$LDAPUTILS_LDIFDIFF" = "xyes"])
+])dnl
+
+
+# AC_LDAP_UTILS_LDIFLINT
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDIFLINT],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldiflint,
+      [AS_HELP_STRING([--disable-ldiflint], [disable building ldiflint utility])],
+      [ ELDIFLINT=$enableval ],
+      [ ELDIFLINT=$enableval ]
+   )
+
+   if test "x${ELDIFLINT}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDIFLINT=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDIFLINT=${ELDIFLINT}
+
+   LDAPUTILS_LDIFLINT_STATUS="skip"
+   if test "x${ELDIFLINT}" == "xyes";then
+      LDAPUTILS_LDIFLINT_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDIFLINT], [test "x$LDAPUTILS_LDIFLINT" = "xyes"])
+])dnl
+
+
+# AC_LDAP_UTILS_LDIFSORT
+# ______________________________________________________________________________
+AC_DEFUN_ONCE([AC_LDAP_UTILS_LDIFSORT],[dnl
+
+   # prerequists
+   AC_REQUIRE([AC_LDAP_UTILS_UTILITIES])
+
+   enableval=""
+   AC_ARG_ENABLE(
+      ldifsort,
+      [AS_HELP_STRING([--disable-ldifsort], [disable building ldifsort utility])],
+      [ ELDIFSORT=$enableval ],
+      [ ELDIFSORT=$enableval ]
+   )
+
+   if test "x${ELDIFSORT}" != "x${LDAPUTILS_UTILITIES_ALT}";then
+      ELDIFSORT=${LDAPUTILS_UTILITIES}
+   fi
+   LDAPUTILS_LDIFSORT=${ELDIFSORT}
+
+   LDAPUTILS_LDIFSORT_STATUS="skip"
+   if test "x${ELDIFSORT}" == "xyes";then
+      LDAPUTILS_LDIFSORT_STATUS="install"
+      LDAPUTILS_LIBLDAPUTILS="yes"
+   fi
+
+   AM_CONDITIONAL([LDAPUTILS_LDIFSORT], [test "x$LDAPUTILS_LDIFSORT" = "xyes"])
+])dnl
+
+
 # AC_LDAP_UTILS_LIBLDAPSCHEMA
 # ______________________________________________________________________________
 AC_DEFUN_ONCE([AC_LDAP_UTILS_LIBLDAPSCHEMA],[dnl
 
+   AC_REQUIRE([AC_LDAP_UTILS_LDAP2ARROW])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPSCHEMA])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPINFO])
+   AC_REQUIRE([AC_LDAP_UTILS_LDAPLINT])
+   AC_REQUIRE([AC_LDAP_UTILS_LDIFLINT])
 
    enableval=""
    AC_ARG_ENABLE(
@@ -266,7 +479,7 @@ AC_DEFUN_ONCE([AC_LDAP_UTILS_LIBLDAPSCHEMA],[dnl
       LDAPUTILS_LIBLDAPSCHEMA="no"
       LDAPUTILS_LIBLDAPSCHEMA_STATUS="skip"
       LDAPUTILS_LTLIBLDAPSCHEMA_STATUS="skip"
-      if test "x${LDAPUTILS_LDAPINFO}" == "xyes" || test "x${LDAPUTILS_LDAPSCHEMA}" == "xyes";then
+      if test "x${LDAPUTILS_LDAPINFO}" == "xyes" || test "x${LDAPUTILS_LDAPSCHEMA}" == "xyes" || test "x${LDAPUTILS_LDAP2ARROW}" == "xyes" || test "x${LDAPUTILS_LDAPLINT}" == "xyes" || test "x${LDAPUTILS_LDIFLINT}" == "xyes";then
          LDAPUTILS_LIBLDAPSCHEMA="yes"
          LDAPUTILS_LIBLDAPSCHEMA_STATUS="build"
       fi
@@ -285,13 +498,20 @@ AC_DEFUN_ONCE([AC_LDAP_UTILS_LIBLDAPSCHEMA],[dnl
 # ______________________________________________________________________________
 AC_DEFUN_ONCE([AC_LDAP_UTILS_LIBLDAPUTILS],[dnl
 
+   AC_REQUIRE([AC_LDAP_UTILS_LDAP2ARROW])
    AC_REQUIRE([AC_LDAP_UTILS_LDAP2CSV])
    AC_REQUIRE([AC_LDAP_UTILS_LDAP2JSON])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPDEBUG])
+   AC_REQUIRE([AC_LDAP_UTILS_LDAPDIFF])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPDN2STR])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPINFO])
+   AC_REQUIRE([AC_LDAP_UTILS_LDAPLINT])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPSCHEMA])
    AC_REQUIRE([AC_LDAP_UTILS_LDAPTREE])
+   AC_REQUIRE([AC_LDAP_UTILS_LDIF2CSV])
+   AC_REQUIRE([AC_LDAP_UTILS_LDIFDIFF])
+   AC_REQUIRE([AC_LDAP_UTILS_LDIFLINT])
+   AC_REQUIRE([AC_LDAP_UTILS_LDIFSORT])
 
    if test "x${LDAPUTILS_LIBLDAPUTILS}" == "xno";then
       LDAPUTILS_LIBLDAPUTILS_STATUS="skip"
@@ -114,6 +114,8 @@
 #define LDAPSCHEMA_SCHEMA_ERROR                       0x7001   ///< schema error
 #define LDAPSCHEMA_DUPLICATE                          0x7002   ///< duplicate defintion
 #define LDAPSCHEMA_UNKNOWN_FIELD                      0x7003   ///< unknown field
+#define LDAPSCHEMA_FILE_ERROR                         0x7004   ///< schema file could not be read
+#define LDAPSCHEMA_DECODING_ERROR                     0x7005   ///< schema file is malformed
 #define LDAPSCHEMA_NO_MEMORY                          (-10)    ///< an memory allocation failed
 
 // model flags
@@ -202,6 +204,16 @@
 #define LDAPSCHEMA_FLD_SUPERIOR                       24
 #define LDAPSCHEMA_FLD_SYNTAX                         25
 
+// schema violations of entries
+#define LDAPSCHEMA_V_UNKNOWN_CLASS                    1        ///< objectClass is not defined by schema
+#define LDAPSCHEMA_V_NO_STRUCTURAL                    2        ///< entry does not have a structural objectClass
+#define LDAPSCHEMA_V_UNKNOWN_ATTRIBUTE                3        ///< attributeType is not defined by schema
+#define LDAPSCHEMA_V_NOT_ALLOWED                      4        ///< attribute is not allowed by objectClasses of entry
+#define LDAPSCHEMA_V_MISSING                          5        ///< attribute required by objectClasses of entry is missing
+#define LDAPSCHEMA_V_SINGLE_VALUE                     6        ///< single value attribute has multiple values
+#define LDAPSCHEMA_V_SYNTAX                           7        ///< value does not match syntax of attributeType
+#define LDAPSCHEMA_V_MAX                              7
+
 
 /////////////////
 //             //
@@ -235,6 +247,12 @@ typedef struct ldapschema_spec LDAPSchemaSpec;
 
 typedef struct ldapschema_cursor * LDAPSchemaCur;
 
+/// objectClass and attributeType checks compiled from schema, shared by threads
+typedef struct ldapschema_validator LDAPSchemaValidator;
+
+/// state of entry being checked, used by a single thread
+typedef struct ldapschema_checker LDAPSchemaChecker;
+
 
 //////////////////
 //              //
@@ -261,6 +279,21 @@ _LDAPSCHEMA_F char **
 ldapschema_schema_errors(
          LDAPSchema            * lsd );
 
+_LDAPSCHEMA_F const char *
+ldapschema_violation2string(
+         int                     code );
+
+
+//----------------//
+// file functions //
+//----------------//
+#pragma mark file functions
+
+_LDAPSCHEMA_F int
+ldapschema_load(
+         LDAPSchema            * lsd,
+         const char            * file );
+
 
 //------------------//
 // format functions //
@@ -285,6 +318,22 @@ ldapschema_fetch(
          LDAPSchema            * lsd,
          LDAP                  * ld );
 
+_LDAPSCHEMA_F int
+ldapschema_fetch_cache(
+         LDAPSchema            * lsd,
+         LDAP                  * ld,
+         const char            * dir );
+
+_LDAPSCHEMA_F int
+ldapschema_link(
+         LDAPSchema            * lsd );
+
+_LDAPSCHEMA_F int
+ldapschema_parse(
+         LDAPSchema            * lsd,
+         int                     type,
+         const struct berval   * def );
+
 
 //------------------//
 // memory functions //
@@ -503,6 +552,52 @@ ldapschema_next_objectclass(
          LDAPSchemaCur           cur);
 
 
+//----------------------//
+// validation functions //
+//----------------------//
+#pragma mark validation functions
+
+_LDAPSCHEMA_F int
+ldapschema_check_attribute(
+         LDAPSchemaChecker     * chk,
+         const struct berval   * name,
+         const struct berval   * vals,
+         size_t                  vals_len );
+
+_LDAPSCHEMA_F void
+ldapschema_check_begin(
+         LDAPSchemaChecker     * chk );
+
+_LDAPSCHEMA_F int
+ldapschema_check_end(
+         LDAPSchemaChecker     * chk );
+
+_LDAPSCHEMA_F int
+ldapschema_check_violation(
+         LDAPSchemaChecker     * chk,
+         size_t                  idx,
+         struct berval         * namep,
+         size_t                * valuep );
+
+_LDAPSCHEMA_F void
+ldapschema_checker_free(
+         LDAPSchemaChecker     * chk );
+
+_LDAPSCHEMA_F int
+ldapschema_checker_initialize(
+         LDAPSchemaValidator   * val,
+         LDAPSchemaChecker    ** chkp );
+
+_LDAPSCHEMA_F void
+ldapschema_validator_free(
+         LDAPSchemaValidator   * val );
+
+_LDAPSCHEMA_F int
+ldapschema_validator_initialize(
+         LDAPSchema            * lsd,
+         LDAPSchemaValidator  ** valp );
+
+
 //---------------------------//
 // sort comparison functions //
 //---------------------------//
@@ -47,7 +47,9 @@
 
 #include <ldaputils_cdefs.h>
 
+#include <stdio.h>
 #include <inttypes.h>
+#include <ldap.h>
 
 
 ///////////////////
@@ -78,6 +80,7 @@
 
 #define LDAPUTILS_BUFF_LEN                 4096
 #define LDAPUTILS_OPT_LEN                  128
+#define LDAPUTILS_SINK_PREALLOC            (16 * 1024 * 1024)
 
 
 #define LDAPUTILS_OPTIONS_COMMON           "cd:D:hH:np:P:uvVw:Wxy:Y:Z"
@@ -87,6 +90,34 @@
 #define LDAPUTILS_TREE_HIERARCHY           0x0000
 #define LDAPUTILS_TREE_BULLETS             0x0001
 
+#define LDAPUTILS_TREE_SUBORDINATES        "numSubordinates"
+
+#define LDAPUTILS_CSV_RFC4180              0x0001
+#define LDAPUTILS_CSV_SEPARATOR            '|'
+
+#define LDAPUTILS_JSON_BINARY              0x0001
+
+#define LDAPUTILS_ARROW_UTF8               1
+#define LDAPUTILS_ARROW_BINARY             2
+#define LDAPUTILS_ARROW_INT64              3
+#define LDAPUTILS_ARROW_BOOL               4
+#define LDAPUTILS_ARROW_LIST               0x0001
+#define LDAPUTILS_ARROW_ROWS               16384
+
+#define LDAPUTILS_PIPELINE_FLUSH           0x0001
+#define LDAPUTILS_PIPELINE_CHANGES         0x0002   // LDIF change records other than add are passed with only their changetype
+#define LDAPUTILS_PIPELINE_ROWS            256
+#define LDAPUTILS_PIPELINE_MAX_THREADS     32
+
+#define LDAPUTILS_DN_DN                    1     // RFC 4514 string
+#define LDAPUTILS_DN_RDN                   2     // relative DN
+#define LDAPUTILS_DN_UFN                   3     // user friendly name
+#define LDAPUTILS_DN_ADC                   4     // Active Directory canonical name
+#define LDAPUTILS_DN_DCE                   5     // DCE-style DN
+#define LDAPUTILS_DN_IDN                   6     // inverted DN
+#define LDAPUTILS_DN_KEY                   7     // binary sort key, parents sort before children
+#define LDAPUTILS_DN_AVAS                  64    // attribute value assertions parsed without allocating memory
+
 
 /////////////////
 //             //
@@ -103,6 +134,22 @@ typedef struct ldap_utils_entries      LDAPUtilsEntries;
 typedef struct ldap_utils_tree         LDAPUtilsTree;
 typedef struct ldaputils_config_struct LDAPUtils;
 typedef struct ldap_utils_tree_opts    LDAPUtilsTreeOpts;
+typedef struct ldap_utils_sink         LDAPUtilsSink;
+typedef struct ldap_utils_arrow        LDAPUtilsArrow;
+typedef struct ldap_utils_pipeline     LDAPUtilsPipeline;
+typedef struct ldap_utils_pipeline_opts LDAPUtilsPipelineOpts;
+typedef struct ldap_utils_row          LDAPUtilsRow;
+typedef struct ldap_utils_row_attr     LDAPUtilsRowAttr;
+typedef struct ldap_utils_dn           LDAPUtilsDN;
+typedef struct ldap_utils_dn_ava       LDAPUtilsDNAva;
+typedef struct ldap_utils_ldif         LDAPUtilsLDIF;
+typedef struct ldap_utils_sort_item    LDAPUtilsSortItem;
+typedef struct ldap_utils_sort_buff    LDAPUtilsSortBuff;
+typedef struct ldap_utils_sort_run     LDAPUtilsSortRun;
+typedef struct ldap_utils_sort_merge   LDAPUtilsSortMerge;
+typedef struct ldap_utils_diff_value   LDAPUtilsDiffValue;
+typedef struct ldap_utils_diff_attr    LDAPUtilsDiffAttr;
+typedef struct ldap_utils_diff_entry   LDAPUtilsDiffEntry;
 
 struct ldap_utils_tree_opts
 {
@@ -113,6 +160,152 @@ struct ldap_utils_tree_opts
    size_t    style;
    size_t    compact;
    size_t    expandall;
+   size_t    subordinates;
+   size_t    threads;       // number of rendering threads, 0 for number of CPUs
+};
+
+
+struct ldap_utils_pipeline_opts
+{
+   size_t    threads;       // number of formatting threads, 0 for number of CPUs
+   size_t    rows;          // entries per batch, 0 for LDAPUTILS_PIPELINE_ROWS
+   size_t    columns;       // number of columns attributes are mapped onto, 0 to keep entry order
+   int       flags;
+   int       pad0;
+   void    * ctx;           // passed to callbacks
+   int    (* column)(void * ctx, const struct berval * attr);
+   int    (* format)(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+   void * (* worker)(void * ctx, size_t idx); // optional, returns ctx passed to format by formatter idx
+};
+
+
+// decoded attribute, strings are copies terminated with NUL
+struct ldap_utils_row_attr
+{
+   struct berval       name;
+   struct berval     * vals;
+   size_t              vals_len;
+};
+
+
+// decoded entry
+struct ldap_utils_row
+{
+   size_t              idx;           // position of entry within results, byte offset of LDIF record, or line of DN
+   size_t              src;           // index of input containing DN
+   struct berval       dn;
+   LDAPUtilsRowAttr  * attrs;
+   size_t              attrs_len;
+};
+
+
+// attribute value assertion, references string of parsed DN
+struct ldap_utils_dn_ava
+{
+   const char        * type;
+   size_t              type_len;
+   const char        * val;           // value as escaped within DN
+   size_t              val_len;
+   int                 hex;           // value is '#' followed by hex encoded BER
+   int                 pad0;
+};
+
+
+// DN parsed into spans without copying, may be declared on the stack but
+// must not be copied, and is released with ldaputils_dn_free()
+struct ldap_utils_dn
+{
+   size_t              rdns_len;
+   size_t              avas_len;
+   size_t              avas_size;
+   size_t            * rdns;                            // index of first AVA of each RDN
+   LDAPUtilsDNAva    * avas;
+   size_t              rdns_buff[LDAPUTILS_DN_AVAS+1];  // storage of DNs which fit without allocating
+   LDAPUtilsDNAva      avas_buff[LDAPUTILS_DN_AVAS];
+};
+
+
+// record ordered by binary key
+struct ldap_utils_sort_item
+{
+   uint64_t            prefix;        // leading bytes of key in big endian order
+   const char        * key;
+   size_t              key_off;       // offset of key while records are appended to buffer
+   size_t              key_len;
+   const char        * data;
+   size_t              data_off;
+   size_t              data_len;
+};
+
+
+// keys and data of records appended to one buffer
+struct ldap_utils_sort_buff
+{
+   char              * text;
+   size_t              text_len;
+   size_t              text_size;
+   LDAPUtilsSortItem * items;
+   size_t              items_len;
+   size_t              items_size;
+};
+
+
+// sorted records being merged, kept in memory or stored in temporary file
+struct ldap_utils_sort_run
+{
+   const LDAPUtilsSortBuff * mem;
+   FILE              * fp;
+   char              * buff;          // key and data read from file
+   size_t              size;
+   size_t              pos;           // next record kept in memory
+   int                 done;
+   int                 pad0;
+   LDAPUtilsSortItem   item;
+};
+
+
+// tournament tree of runs
+struct ldap_utils_sort_merge
+{
+   LDAPUtilsSortRun  * runs;
+   int               * tree;          // loser of each match, winner at index 0
+   int                 k;
+   int                 pad0;
+};
+
+
+// attribute value of decoded record, references buffer of entry
+struct ldap_utils_diff_value
+{
+   const char        * name;
+   const char        * val;
+   size_t              val_len;
+   uint64_t            hash;          // FNV-1a hash of value
+};
+
+
+// values of one attribute once values are grouped
+struct ldap_utils_diff_attr
+{
+   const char        * name;
+   LDAPUtilsDiffValue * vals;
+   size_t              vals_len;
+   uint64_t            hash;          // sum of hashes of values, independent of order
+};
+
+
+// LDIF record decoded for comparison, buffers are reused between records
+struct ldap_utils_diff_entry
+{
+   struct berval       dn;
+   char              * buff;          // unfolded and decoded names and values
+   size_t              buff_size;
+   LDAPUtilsDiffValue * vals;
+   size_t              vals_len;
+   size_t              vals_size;
+   LDAPUtilsDiffAttr * attrs;
+   size_t              attrs_len;
+   size_t              attrs_size;
 };
 
 
@@ -136,6 +329,7 @@ struct ldaputils_config_struct
    const char      * filter;       //    search filter
    const char      * passfile;     // -y password file
    const char      * sortattr;     // -S sort by attribute
+   const char      * output;       // -o output file
 };
 
 
@@ -146,6 +340,222 @@ struct ldaputils_config_struct
 //////////////////
 LDAPUTILS_BEGIN_C_DECLS
 
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: Output
+#endif
+
+// flushes buffered output and frees sink
+int ldaputils_sink_close(LDAPUtilsSink * sink);
+
+// appends data as base64 encoded text
+int ldaputils_sink_base64(LDAPUtilsSink * sink, const void * data, size_t len);
+
+// compresses output as gzip or zstd using worker threads
+int ldaputils_sink_compress(LDAPUtilsSink * sink, const char * spec, size_t threads);
+
+// appends value as contents of quoted CSV field
+int ldaputils_sink_csv(LDAPUtilsSink * sink, const void * data, size_t len, char sep, int flags);
+
+// opens buffered output sink for file descriptor
+int ldaputils_sink_fdopen(LDAPUtilsSink ** sinkp, int fd);
+
+// writes buffered output
+int ldaputils_sink_flush(LDAPUtilsSink * sink);
+
+// opens buffered output sink for file or standard output
+int ldaputils_sink_open(LDAPUtilsSink ** sinkp, const char * path, size_t prealloc);
+
+// appends formatted string to output
+int ldaputils_sink_printf(LDAPUtilsSink * sink, const char * fmt, ...)
+   __attribute__((format(printf, 2, 3)));
+
+// appends string to output
+int ldaputils_sink_puts(LDAPUtilsSink * sink, const char * str);
+
+// appends string as quoted and escaped JSON string
+int ldaputils_sink_json_string(LDAPUtilsSink * sink, const void * data, size_t len);
+
+// appends value as JSON string, or as base64 encoded object if value is not UTF-8
+int ldaputils_sink_json_value(LDAPUtilsSink * sink, const void * data, size_t len, int flags);
+
+// appends data to output
+int ldaputils_sink_write(LDAPUtilsSink * sink, const void * data, size_t len);
+
+
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: Arrow
+#endif
+
+// appends value to column of current row
+int ldaputils_arrow_append(LDAPUtilsArrow * arrow, int col, const void * data, size_t len);
+
+// adds column to schema
+int ldaputils_arrow_column(LDAPUtilsArrow * arrow, const char * name, int type, int flags);
+
+// returns index of column
+int ldaputils_arrow_find(LDAPUtilsArrow * arrow, const char * name, size_t len);
+
+// writes remaining rows and end of stream marker
+int ldaputils_arrow_finish(LDAPUtilsArrow * arrow);
+
+// frees Arrow stream writer
+void ldaputils_arrow_free(LDAPUtilsArrow * arrow);
+
+// initializes Arrow IPC stream writer
+int ldaputils_arrow_initialize(LDAPUtilsArrow ** arrowp, LDAPUtilsSink * sink, size_t rows);
+
+// completes current row and writes record batch when full
+int ldaputils_arrow_next(LDAPUtilsArrow * arrow);
+
+
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: Pipeline
+#endif
+
+// copies DN and queues it for formatting as entry without attributes
+int ldaputils_pipeline_dn(LDAPUtilsPipeline * pipe, const char * dn, size_t len, size_t src, size_t idx);
+
+// decodes entry and queues it for formatting, usable as ldaputils_search_each() callback
+int ldaputils_pipeline_entry(void * pipe, LDAP * ld, LDAPMessage * msg);
+
+// formats remaining entries, waits for output to be written and stops threads
+int ldaputils_pipeline_finish(LDAPUtilsPipeline * pipe);
+
+// queues partially filled batch so entries already received are written
+void ldaputils_pipeline_flush(LDAPUtilsPipeline * pipe);
+
+// stops threads and frees pipeline
+void ldaputils_pipeline_free(LDAPUtilsPipeline * pipe);
+
+// starts decode, format and write pipeline
+int ldaputils_pipeline_initialize(LDAPUtilsPipeline ** pipep, LDAPUtilsSink * sink, const LDAPUtilsPipelineOpts * opts);
+
+// queues LDIF records for parsing and formatting by formatter threads
+int ldaputils_pipeline_ldif(LDAPUtilsPipeline * pipe, LDAPUtilsLDIF * ldif);
+
+// returns byte offset of first LDIF record which could not be parsed
+size_t ldaputils_pipeline_offset(LDAPUtilsPipeline * pipe);
+
+
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: LDIF
+#endif
+
+// returns next chunk of complete LDIF records
+int ldaputils_ldif_chunk(LDAPUtilsLDIF * ldif, size_t size, struct berval * chunk, size_t * offp);
+
+// unmaps LDIF file and frees resources
+void ldaputils_ldif_close(LDAPUtilsLDIF * ldif);
+
+// returns description of error encountered while reading LDIF records
+const char * ldaputils_ldif_err2string(int err);
+
+// decodes next attribute of LDIF record, the first attribute is the DN
+int ldaputils_ldif_next(const struct berval * rec, size_t * posp, char ** buffp, struct berval * name, struct berval * val);
+
+// maps LDIF file into memory, NULL or "-" reads stdin
+int ldaputils_ldif_open(LDAPUtilsLDIF ** ldifp, const char * file);
+
+// locates next LDIF record, skipping blank lines, comments and version
+int ldaputils_ldif_record(const char * buff, size_t len, size_t * posp, struct berval * rec);
+
+// returns size of LDIF file in bytes
+size_t ldaputils_ldif_size(LDAPUtilsLDIF * ldif);
+
+// copies first value of attribute within LDIF record, unfolded and decoded
+int ldaputils_ldif_value(const struct berval * rec, const char * attr, char * buff, struct berval * val);
+
+
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: DN Strings
+#endif
+
+// renders parsed DN into buffer, returns length of complete string
+size_t ldaputils_dn_format(const LDAPUtilsDN * dn, int format, char * buff, size_t size);
+
+// frees memory allocated for DN with many attribute value assertions
+void ldaputils_dn_free(LDAPUtilsDN * dn);
+
+// parses RFC 4514 DN, only allocating memory for very long DNs
+int ldaputils_dn_parse(LDAPUtilsDN * dn, const char * str, size_t len);
+
+
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: Diff
+#endif
+
+// appends change record which adds decoded entry
+int ldaputils_diff_add(LDAPUtilsSortBuff * buff, const LDAPUtilsDiffEntry * ent, const char * key, size_t key_len);
+
+// appends change record which deletes decoded entry
+int ldaputils_diff_delete(LDAPUtilsSortBuff * buff, const LDAPUtilsDiffEntry * ent, const char * key, size_t key_len);
+
+// frees buffers of decoded entry
+void ldaputils_diff_free(LDAPUtilsDiffEntry * ent);
+
+// calculates FNV-1a hash of bytes
+uint64_t ldaputils_diff_hash(const char * data, size_t len);
+
+// compares decoded entries and appends modify change record if entries differ
+int ldaputils_diff_modify(LDAPUtilsSortBuff * buff, LDAPUtilsDiffEntry * p1, LDAPUtilsDiffEntry * p2, const char * key, size_t key_len);
+
+// decodes LDIF content record into attribute values
+int ldaputils_diff_parse(LDAPUtilsDiffEntry * ent, const char * data, size_t len);
+
+// appends attribute value as LDIF, base64 encoded if not safe
+int ldaputils_diff_value(LDAPUtilsSortBuff * buff, const char * name, const char * val, size_t len);
+
+
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes: Sort
+#endif
+
+// appends bytes to buffer of records
+int ldaputils_sort_append(LDAPUtilsSortBuff * buff, const void * data, size_t len);
+
+// compares keys of records, usable with qsort()
+int ldaputils_sort_cmp(const void * ptr1, const void * ptr2);
+
+// frees bytes and records of buffer
+void ldaputils_sort_free(LDAPUtilsSortBuff * buff);
+
+// ensures space is available for appended bytes
+int ldaputils_sort_grow(LDAPUtilsSortBuff * buff, size_t len);
+
+// adds record whose key starts at offset and whose data ends at end of buffer
+int ldaputils_sort_item(LDAPUtilsSortBuff * buff, size_t start, size_t key_len);
+
+// frees tournament tree and read buffers of runs
+void ldaputils_sort_merge_free(LDAPUtilsSortMerge * merge);
+
+// reads first record of each run and plays initial tournament
+int ldaputils_sort_merge_init(LDAPUtilsSortMerge * merge, LDAPUtilsSortRun * runs, size_t len);
+
+// returns current record of merged runs, or NULL once all runs are exhausted
+const LDAPUtilsSortItem * ldaputils_sort_merge_item(LDAPUtilsSortMerge * merge);
+
+// advances merge to next record
+int ldaputils_sort_merge_next(LDAPUtilsSortMerge * merge);
+
+// returns leading bytes of key as an integer
+uint64_t ldaputils_sort_prefix(const char * key, size_t len);
+
+// writes key and data of record to run
+int ldaputils_sort_put(FILE * fp, const LDAPUtilsSortItem * item);
+
+// assigns pointers of records and sorts records by key
+void ldaputils_sort_records(LDAPUtilsSortBuff * buff);
+
+// assigns pointers of records once records are no longer appended
+void ldaputils_sort_resolve(LDAPUtilsSortBuff * buff);
+
+// parses size with optional K, M, or G suffix
+int ldaputils_sort_size(const char * str, size_t * sizep);
+
+// creates unlinked temporary file for run
+FILE * ldaputils_sort_temp(const char * tmpdir, const char * prefix, size_t buff_len);
+
+
 #ifdef __LDAPUTILS_PMARK
 #pragma mark - Prototypes: Passwords
 #endif
@@ -176,8 +586,12 @@ int ldaputils_entry_cmp(const void * ptr1, const void * ptr2);
 // compares two LDAP entry DNs for sorting
 int ldaputils_entry_cmp_dn(const void * ptr1, const void * ptr2);
 
+// releases reference to entry and frees entry after last reference is released
 void ldaputils_entry_free(LDAPUtilsEntry * entry);
 
+// adds reference to entry
+LDAPUtilsEntry * ldaputils_entry_retain(LDAPUtilsEntry * entry);
+
 int ldaputils_count_entries(LDAPUtilsEntries * entries);
 LDAPUtilsEntry * ldaputils_first_entry(LDAPUtilsEntries * entries);
 LDAPUtilsEntry * ldaputils_next_entry(LDAPUtilsEntries * entries);
@@ -197,6 +611,9 @@ int ldaputils_values_sort(struct berval ** vals);
 // removes newlines and carriage returns
 char * ldaputils_chomp(char * str);
 
+// tests whether data is valid UTF-8 without NUL bytes
+int ldaputils_utf8_valid(const void * data, size_t len);
+
 #ifdef __LDAPUTILS_PMARK
 #pragma mark - Prototypes: Configuration
 #endif
@@ -244,6 +661,9 @@ int ldaputils_initialize(LDAPUtils ** lup, const char * prog_name);
 // connects and binds to LDAP server
 int ldaputils_search(LDAPUtils * lud, LDAPMessage ** resp);
 
+// performs LDAP search and passes each entry to callback as it is received
+int ldaputils_search_each(LDAPUtils * lud, int (*func)(void * ctx, LDAP * ld, LDAPMessage * entry), void * ctx);
+
 // frees common config
 void ldaputils_unbind(LDAPUtils * lud);
 
@@ -253,7 +673,7 @@ void ldaputils_unbind(LDAPUtils * lud);
 #endif
 
 LDAPUtilsTree * ldaputils_get_tree(LDAP * ld, LDAPMessage * res,
-int copy);
+int copy, const char * countattr);
 
 int ldaputils_tree_add_dn(LDAPUtilsTree * tree, const char * dn, LDAPUtilsTree ** nodep);
 
@@ -265,7 +685,7 @@ LDAPUtilsTree * ldaputils_tree_initialize(LDAPUtilsEntries * entries, int copy);
 
 size_t ldaputils_tree_level_count(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts);
 
-void ldaputils_tree_print(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts);
+int ldaputils_tree_print(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts, LDAPUtilsSink * sink);
 
 
 LDAPUTILS_END_C_DECLS
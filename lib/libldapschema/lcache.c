@@ -0,0 +1,444 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *   @file src/ldapschema/lcache.c  contains schema cache functions
+ */
+/*
+ *  The cache holds the definitions of a subschema entry exactly as they were
+ *  published by the server, along with the URI of the server and the DN,
+ *  modifyTimestamp and entryCSN of the subschema entry.  Definitions are
+ *  parsed and linked again when the cache is loaded, which avoids storing
+ *  pointers, compiled regular expressions and references to the OID
+ *  specifications, and keeps caches valid across versions of the library.
+ *
+ *  A cache file starts with LDAPSCHEMA_CACHE_MAGIC and is followed by
+ *  records.  Each record is a one byte type, a four byte big endian length,
+ *  the string and a terminating NUL.  The first four records have the type
+ *  LDAPSCHEMA_CACHE_FIELD and contain the URI, DN, modifyTimestamp and
+ *  entryCSN.  The remaining records contain definitions and their type is
+ *  the type of the definition, in the order the definitions are parsed.
+ */
+#define _LIB_LIBLDAPSCHEMA_LCACHE_C 1
+#include "lcache.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+/// appends record to cache
+/// @param[in]  cache     reference to cache
+/// @param[in]  type      type of record
+/// @param[in]  str       contents of record
+/// @param[in]  len       length of contents
+///
+/// @return    Returns 0 on success, or -1 if memory could not be allocated.
+/// @see       ldapschema_cache_decode, ldapschema_cache_next
+int ldapschema_cache_append(LDAPSchemaCache * cache, int type, const char * str,
+   size_t len)
+{
+   size_t      size;
+   char      * data;
+
+   assert(cache != NULL);
+   assert( (str != NULL) || (!(len)) );
+
+   if (len > UINT32_MAX)
+   {
+      errno = EOVERFLOW;
+      return(-1);
+   };
+
+   // allocates room for magic, record header, string and terminator
+   for(size = ((cache->data_size)) ? cache->data_size : 4096; (size < (cache->data_len + len + LDAPSCHEMA_CACHE_MAGIC_LEN + 6)); size *= 2);
+   if (size > cache->data_size)
+   {
+      if ((data = realloc(cache->data, size)) == NULL)
+         return(-1);
+      cache->data      = data;
+      cache->data_size = size;
+   };
+   if (!(cache->data_len))
+   {
+      memcpy(cache->data, LDAPSCHEMA_CACHE_MAGIC, LDAPSCHEMA_CACHE_MAGIC_LEN);
+      cache->data_len = LDAPSCHEMA_CACHE_MAGIC_LEN;
+   };
+
+   data    = &cache->data[cache->data_len];
+   data[0] = (char)type;
+   data[1] = (char)((len >> 24) & 0xff);
+   data[2] = (char)((len >> 16) & 0xff);
+   data[3] = (char)((len >>  8) & 0xff);
+   data[4] = (char)((len >>  0) & 0xff);
+   if ((len))
+      memcpy(&data[5], str, len);
+   data[5+len] = '\0';
+   cache->data_len += len + 6;
+
+   return(0);
+}
+
+
+/// validates records of cache and locates fields
+/// @param[in]  cache     reference to cache
+///
+/// @return    Returns 0 if the cache is valid, otherwise -1 is returned.
+/// @see       ldapschema_cache_read
+int ldapschema_cache_decode(LDAPSchemaCache * cache)
+{
+   int             rc;
+   int             type;
+   size_t          x;
+   size_t          pos;
+   struct berval   str;
+   struct berval * fields[LDAPSCHEMA_CACHE_FIELDS];
+
+   assert(cache != NULL);
+
+   fields[0] = &cache->uri;
+   fields[1] = &cache->dn;
+   fields[2] = &cache->timestamp;
+   fields[3] = &cache->csn;
+
+   if ( (cache->data_len < LDAPSCHEMA_CACHE_MAGIC_LEN) || ((memcmp(cache->data, LDAPSCHEMA_CACHE_MAGIC, LDAPSCHEMA_CACHE_MAGIC_LEN))) )
+      return(-1);
+
+   // leading records describe subschema entry
+   pos = LDAPSCHEMA_CACHE_MAGIC_LEN;
+   for(x = 0; (x < LDAPSCHEMA_CACHE_FIELDS); x++)
+   {
+      if (ldapschema_cache_next(cache, &pos, &type, fields[x]) != 1)
+         return(-1);
+      if (type != LDAPSCHEMA_CACHE_FIELD)
+         return(-1);
+   };
+   cache->defs = pos;
+
+   // remaining records are definitions
+   while ((rc = ldapschema_cache_next(cache, &pos, &type, &str)) == 1)
+      if (type == LDAPSCHEMA_CACHE_FIELD)
+         return(-1);
+
+   return(rc);
+}
+
+
+/// frees resources of cache
+/// @param[in]  cache     reference to cache
+void ldapschema_cache_free(LDAPSchemaCache * cache)
+{
+   if (!(cache))
+      return;
+   free(cache->data);
+   bzero(cache, sizeof(LDAPSchemaCache));
+   return;
+}
+
+
+/// returns next record of cache
+/// @param[in]  cache     reference to cache
+/// @param[in]  posp      offset of record, updated to offset of next record
+/// @param[out] typep     type of record
+/// @param[out] str       terminated contents of record
+///
+/// @return    Returns 1 if a record was returned, 0 at the end of the
+///            cache, or -1 if the record is truncated.
+int ldapschema_cache_next(const LDAPSchemaCache * cache, size_t * posp,
+   int * typep, struct berval * str)
+{
+   size_t                  len;
+   const unsigned char   * data;
+
+   assert(cache != NULL);
+   assert(posp  != NULL);
+   assert(typep != NULL);
+   assert(str   != NULL);
+
+   if (*posp >= cache->data_len)
+      return(0);
+   if ((cache->data_len - *posp) < 6)
+      return(-1);
+
+   data = (const unsigned char *)&cache->data[*posp];
+   len  = ((size_t)data[1] << 24) | ((size_t)data[2] << 16) | ((size_t)data[3] << 8) | (size_t)data[4];
+   if ( ((cache->data_len - *posp - 6) < len) || (data[5+len] != '\0') )
+      return(-1);
+
+   *typep      = (int)data[0];
+   str->bv_val = (char *)&data[5];
+   str->bv_len = len;
+   *posp      += len + 6;
+
+   return(1);
+}
+
+
+/// parses definitions of cache without linking superiors, ldapSyntaxes
+/// are parsed before attributeTypes and attributeTypes before objectClasses
+/// @param[in]  lsd       reference to schema
+/// @param[in]  cache     reference to decoded cache
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if a
+///            definition was rejected, or an error code if memory could not
+///            be allocated.
+/// @see       ldapschema_cache_parse_type, ldapschema_link
+int ldapschema_cache_parse(LDAPSchema * lsd, const LDAPSchemaCache * cache)
+{
+   int             rc;
+   int             err;
+   size_t          x;
+
+   static const int types[] = { LDAPSCHEMA_SYNTAX, LDAPSCHEMA_ATTRIBUTETYPE, LDAPSCHEMA_OBJECTCLASS };
+
+   rc = LDAPSCHEMA_SUCCESS;
+   for(x = 0; (x < (sizeof(types)/sizeof(types[0]))); x++)
+   {
+      if ((err = ldapschema_cache_parse_type(lsd, cache, types[x])) == LDAPSCHEMA_SCHEMA_ERROR)
+         rc = err;
+      else if (err != LDAPSCHEMA_SUCCESS)
+         return(err);
+   };
+
+   return(rc);
+}
+
+
+/// parses definitions of a single type without linking superiors
+/// @param[in]  lsd       reference to schema
+/// @param[in]  cache     reference to decoded cache
+/// @param[in]  type      type of definitions to parse
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if a
+///            definition was rejected, or an error code if memory could not
+///            be allocated.
+/// @see       ldapschema_cache_parse, ldapschema_parse
+int ldapschema_cache_parse_type(LDAPSchema * lsd, const LDAPSchemaCache * cache,
+   int type)
+{
+   int             rc;
+   int             err;
+   int             deftype;
+   size_t          pos;
+   struct berval   def;
+
+   assert(lsd   != NULL);
+   assert(cache != NULL);
+
+   // appends definitions unsorted and sorts them once all are parsed
+   ldapschema_bulk_begin(lsd);
+
+   rc  = LDAPSCHEMA_SUCCESS;
+   pos = cache->defs;
+   while (ldapschema_cache_next(cache, &pos, &deftype, &def) == 1)
+   {
+      if (deftype != type)
+         continue;
+      if ((err = ldapschema_parse(lsd, type, &def)) == LDAPSCHEMA_SCHEMA_ERROR)
+         rc = err;
+      else if (err != LDAPSCHEMA_SUCCESS)
+      {
+         rc = err;
+         break;
+      };
+   };
+
+   if ((err = ldapschema_bulk_end(lsd)) != LDAPSCHEMA_SUCCESS)
+      return(err);
+
+   return(rc);
+}
+
+
+/// generates name of cache file of server
+/// @param[in]  dir       directory containing cache files
+/// @param[in]  uri       URI of server
+///
+/// @return    Returns allocated file name, or NULL if memory could not be
+///            allocated.
+char * ldapschema_cache_path(const char * dir, const char * uri)
+{
+   size_t               x;
+   size_t               size;
+   uint64_t             hash;
+   char               * file;
+
+   assert(dir != NULL);
+   assert(uri != NULL);
+
+   // FNV-1a hash of URI
+   hash = 14695981039346656037ULL;
+   for(x = 0; ((uri[x])); x++)
+   {
+      hash ^= (uint64_t)(unsigned char)uri[x];
+      hash *= 1099511628211ULL;
+   };
+
+   size = strlen(dir) + 32;
+   if ((file = malloc(size)) == NULL)
+      return(NULL);
+   snprintf(file, size, "%s/schema-%016llx.cache", dir, (unsigned long long)hash);
+
+   return(file);
+}
+
+
+/// reads and validates cache file
+/// @param[in]  cache     reference to cache
+/// @param[in]  file      name of cache file
+///
+/// @return    Returns 0 on success, or -1 if the file could not be read or
+///            is not a valid cache file.
+/// @see       ldapschema_cache_write
+int ldapschema_cache_read(LDAPSchemaCache * cache, const char * file)
+{
+   int            fd;
+   ssize_t        rc;
+   struct stat    sb;
+
+   assert(cache != NULL);
+   assert(file  != NULL);
+
+   bzero(cache, sizeof(LDAPSchemaCache));
+
+   if ((fd = open(file, O_RDONLY)) == -1)
+      return(-1);
+   if ( (fstat(fd, &sb) == -1) || (sb.st_size < LDAPSCHEMA_CACHE_MAGIC_LEN) )
+   {
+      close(fd);
+      return(-1);
+   };
+   cache->data_size = (size_t)sb.st_size + 1;
+   if ((cache->data = malloc(cache->data_size)) == NULL)
+   {
+      close(fd);
+      return(-1);
+   };
+
+   while (cache->data_len < (size_t)sb.st_size)
+   {
+      if ((rc = read(fd, &cache->data[cache->data_len], (size_t)sb.st_size - cache->data_len)) <= 0)
+      {
+         if ( (rc == -1) && (errno == EINTR) )
+            continue;
+         close(fd);
+         ldapschema_cache_free(cache);
+         return(-1);
+      };
+      cache->data_len += (size_t)rc;
+   };
+   close(fd);
+
+   if (ldapschema_cache_decode(cache) == -1)
+   {
+      ldapschema_cache_free(cache);
+      return(-1);
+   };
+
+   return(0);
+}
+
+
+/// writes cache file, replacing existing file once completely written
+/// @param[in]  cache     reference to cache
+/// @param[in]  file      name of cache file
+///
+/// @return    Returns 0 on success, or -1 if the file could not be written.
+/// @see       ldapschema_cache_read
+int ldapschema_cache_write(const LDAPSchemaCache * cache, const char * file)
+{
+   int            fd;
+   size_t         pos;
+   size_t         size;
+   ssize_t        rc;
+   char         * tmp;
+
+   assert(cache != NULL);
+   assert(file  != NULL);
+
+   size = strlen(file) + 8;
+   if ((tmp = malloc(size)) == NULL)
+      return(-1);
+   snprintf(tmp, size, "%s.XXXXXX", file);
+   if ((fd = mkstemp(tmp)) == -1)
+   {
+      free(tmp);
+      return(-1);
+   };
+
+   for(pos = 0; (pos < cache->data_len); pos += (size_t)rc)
+   {
+      if ((rc = write(fd, &cache->data[pos], cache->data_len - pos)) == -1)
+      {
+         if (errno == EINTR)
+         {
+            rc = 0;
+            continue;
+         };
+         close(fd);
+         unlink(tmp);
+         free(tmp);
+         return(-1);
+      };
+   };
+
+   if ( (close(fd) == -1) || (rename(tmp, file) == -1) )
+   {
+      unlink(tmp);
+      free(tmp);
+      return(-1);
+   };
+   free(tmp);
+
+   return(0);
+}
+
+/* end of source file */
@@ -0,0 +1,118 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *   @file src/ldapschema/lcache.h  contains schema cache functions
+ */
+#ifndef _LIB_LIBLDAPSCHEMA_LCACHE_H
+#define _LIB_LIBLDAPSCHEMA_LCACHE_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libldapschema.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define LDAPSCHEMA_CACHE_MAGIC            "LDAPSCHEMA-CACHE-1\n"
+#define LDAPSCHEMA_CACHE_MAGIC_LEN        19
+#define LDAPSCHEMA_CACHE_FIELD            0x00     ///< record type of URI, DN, modifyTimestamp and entryCSN
+#define LDAPSCHEMA_CACHE_FIELDS           4
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+ldapschema_cache_append(
+         LDAPSchemaCache          * cache,
+         int                        type,
+         const char               * str,
+         size_t                     len );
+
+int
+ldapschema_cache_decode(
+         LDAPSchemaCache          * cache );
+
+void
+ldapschema_cache_free(
+         LDAPSchemaCache          * cache );
+
+int
+ldapschema_cache_next(
+         const LDAPSchemaCache    * cache,
+         size_t                   * posp,
+         int                      * typep,
+         struct berval            * str );
+
+int
+ldapschema_cache_parse(
+         LDAPSchema               * lsd,
+         const LDAPSchemaCache    * cache );
+
+int
+ldapschema_cache_parse_type(
+         LDAPSchema               * lsd,
+         const LDAPSchemaCache    * cache,
+         int                        type );
+
+char *
+ldapschema_cache_path(
+         const char               * dir,
+         const char               * uri );
+
+int
+ldapschema_cache_read(
+         LDAPSchemaCache          * cache,
+         const char               * file );
+
+int
+ldapschema_cache_write(
+         const LDAPSchemaCache    * cache,
+         const char               * file );
+
+
+#endif /* end of header file */
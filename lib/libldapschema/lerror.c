@@ -72,6 +72,8 @@ const char * ldapschema_err2string( int err )
       case LDAPSCHEMA_SCHEMA_ERROR:             return("schema error");
       case LDAPSCHEMA_DUPLICATE:                return("duplicate definition");
       case LDAPSCHEMA_UNKNOWN_FIELD:            return("unknown field");
+      case LDAPSCHEMA_FILE_ERROR:               return("unable to read schema file");
+      case LDAPSCHEMA_DECODING_ERROR:           return("malformed schema file");
       default:                                  return("unknown error");
    };
 
@@ -102,7 +104,7 @@ int ldapschema_schema_err(LDAPSchema * lsd, LDAPSchemaModel * mod, const char *
 {
    char        buff[512];
    va_list     args;
-   char      * str;
+   char     ** errs;
    const char  * type;
    size_t        len;
 
@@ -141,13 +143,10 @@ int ldapschema_schema_err(LDAPSchema * lsd, LDAPSchemaModel * mod, const char *
       snprintf(buff, sizeof(buff), "%s %zu: ", type, lsd->schema_errs_cnt);
       len = strlen(buff);
       snprintf(&buff[len], sizeof(buff)-len, "definition: %s", mod->definition);
-      if ((str = strdup(buff)) == NULL)
-         return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
-      if ((lsd->schema_errs = ldapschema_value_add(lsd->schema_errs, str, NULL)) == NULL)
-      {
-         free(str);
+      if ((errs = ldapschema_value_add(lsd->schema_errs, buff, NULL)) == NULL)
          return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
-      };
+      lsd->schema_errs     = errs;
+      lsd->schema_errs_cur = mod;
    };
 
    // create error header
@@ -160,13 +159,9 @@ int ldapschema_schema_err(LDAPSchema * lsd, LDAPSchemaModel * mod, const char *
    va_end(args);
 
    // save error
-   if ((str = strdup(buff)) == NULL)
+   if ((errs = ldapschema_value_add(lsd->schema_errs, buff, NULL)) == NULL)
       return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
-   if ((lsd->schema_errs = ldapschema_value_add(lsd->schema_errs, str, NULL)) == NULL)
-   {
-      free(str);
-      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
-   };
+   lsd->schema_errs = errs;
 
    // set error code
    lsd->errcode = LDAPSCHEMA_SCHEMA_ERROR;
@@ -203,4 +198,25 @@ char ** ldapschema_schema_errors(LDAPSchema * lsd )
    return(errs);
 }
 
+
+/// describes schema violation of entry
+/// @param[in]    code        violation code
+///
+/// @return    Returns a string representation of the violation code.
+/// @see       ldapschema_check_violation
+const char * ldapschema_violation2string( int code )
+{
+   switch(code)
+   {
+      case LDAPSCHEMA_V_UNKNOWN_CLASS:          return("undefined objectClass");
+      case LDAPSCHEMA_V_NO_STRUCTURAL:          return("no structural objectClass");
+      case LDAPSCHEMA_V_UNKNOWN_ATTRIBUTE:      return("undefined attributeType");
+      case LDAPSCHEMA_V_NOT_ALLOWED:            return("attribute not allowed by objectClasses");
+      case LDAPSCHEMA_V_MISSING:                return("missing required attribute");
+      case LDAPSCHEMA_V_SINGLE_VALUE:           return("multiple values of single-value attribute");
+      case LDAPSCHEMA_V_SYNTAX:                 return("value does not match syntax");
+      default:                                  return("unknown violation");
+   };
+}
+
 /* end of source file */
@@ -0,0 +1,813 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *   @file src/ldapschema/lfile.c  contains functions for loading schema files
+ */
+/*
+ *  Schema files are read by ldapschema_load() which only queues the
+ *  definitions of a file.  Definitions are parsed by ldapschema_link() once
+ *  all files are loaded, ldapSyntaxes of every file first, followed by the
+ *  attributeTypes and then the objectClasses, so that the order in which
+ *  files are loaded does not matter and superiors are linked in one pass.
+ *
+ *  Three formats are recognized by the contents of the file:
+ *
+ *     - cache files written by ldapschema_fetch_cache()
+ *     - LDIF containing a subschema entry or cn=schema,cn=config entries
+ *     - OpenLDAP .schema files using attributetype, objectclass, ldapsyntax
+ *       and objectidentifier directives
+ *
+ *  OID macros defined with objectidentifier are expanded in the OID and the
+ *  SYNTAX of definitions.  Syntaxes which are not defined by the files are
+ *  taken from the OID specifications, as OpenLDAP does not publish the
+ *  syntaxes it implements in its schema files.
+ */
+#define _LIB_LIBLDAPSCHEMA_LFILE_C 1
+#include "lfile.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "lcache.h"
+#include "lldap.h"
+#include "lspec.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+/// reads definitions from schema file, definitions are parsed and linked by
+/// ldapschema_link() after all schema files have been loaded
+/// @param[in]    lsd         reference to schema
+/// @param[in]    file        name of cache, LDIF or .schema file
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_FILE_ERROR if the file
+///            could not be read, LDAPSCHEMA_DECODING_ERROR if the file is
+///            malformed, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_link
+int ldapschema_load(LDAPSchema * lsd, const char * file)
+{
+   int                  err;
+   int                  fd;
+   ssize_t              rc;
+   size_t               len;
+   size_t               pos;
+   char               * data;
+   struct stat          sb;
+
+   assert(lsd  != NULL);
+   assert(file != NULL);
+
+   // queue of definitions is created by first file
+   if (!(lsd->pending))
+   {
+      if ((lsd->pending = calloc(1, sizeof(LDAPSchemaCache))) == NULL)
+         return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+      lsd->pending->defs = LDAPSCHEMA_CACHE_MAGIC_LEN;
+   };
+
+   // reads entire file
+   if ((fd = open(file, O_RDONLY)) == -1)
+      return(lsd->errcode = LDAPSCHEMA_FILE_ERROR);
+   if (fstat(fd, &sb) == -1)
+   {
+      err = errno;
+      close(fd);
+      errno = err;
+      return(lsd->errcode = LDAPSCHEMA_FILE_ERROR);
+   };
+   if ((data = malloc((size_t)sb.st_size + 1)) == NULL)
+   {
+      close(fd);
+      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+   };
+   for(len = 0; (len < (size_t)sb.st_size); len += (size_t)rc)
+   {
+      if ((rc = read(fd, &data[len], (size_t)sb.st_size - len)) > 0)
+         continue;
+      if ( (rc == -1) && (errno == EINTR) )
+      {
+         rc = 0;
+         continue;
+      };
+      if (!(rc))
+         break;
+      err = errno;
+      close(fd);
+      free(data);
+      errno = err;
+      return(lsd->errcode = LDAPSCHEMA_FILE_ERROR);
+   };
+   close(fd);
+   data[len] = '\0';
+
+   // skips leading comments to determine format of file
+   for(pos = 0; (pos < len); pos++)
+   {
+      if (data[pos] == '#')
+         while ( (pos < len) && (data[pos] != '\n') )
+            pos++;
+      else if (!(isspace((unsigned char)data[pos])))
+         break;
+   };
+
+   if ( (len >= LDAPSCHEMA_CACHE_MAGIC_LEN) && (!(memcmp(data, LDAPSCHEMA_CACHE_MAGIC, LDAPSCHEMA_CACHE_MAGIC_LEN))) )
+      err = ldapschema_load_cache(lsd, data, len);
+   else if ( (!(strncasecmp(&data[pos], "dn:", 3))) || (!(strncasecmp(&data[pos], "version:", 8))) )
+      err = ldapschema_load_ldif(lsd, data, len);
+   else
+      err = ldapschema_load_conf(lsd, data, len);
+
+   free(data);
+
+   return(err);
+}
+
+
+/// appends definition to queue of definitions
+/// @param[in]    lsd         reference to schema
+/// @param[in]    type        type of definition
+/// @param[in]    def         definition
+/// @param[in]    len         length of definition
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS or LDAPSCHEMA_NO_MEMORY.
+int ldapschema_load_append(LDAPSchema * lsd, int type, const char * def,
+   size_t len)
+{
+   assert(lsd          != NULL);
+   assert(lsd->pending != NULL);
+
+   // removes ordering prefix of cn=config values
+   if ( (len > 0) && (def[0] == '{') )
+   {
+      while ( (len > 0) && (def[0] != '}') )
+      {
+         def++;
+         len--;
+      };
+      if (len > 0)
+      {
+         def++;
+         len--;
+      };
+   };
+
+   if (ldapschema_cache_append(lsd->pending, type, def, len) == -1)
+      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// decodes base64 encoded LDIF value
+/// @param[in]    str         encoded value, replaced by decoded value
+/// @param[in]    lenp        length of value
+///
+/// @return    Returns 0 on success, or -1 if the value is not valid base64.
+int ldapschema_load_base64(char * str, size_t * lenp)
+{
+   size_t               x;
+   size_t               len;
+   unsigned             bits;
+   unsigned             nbits;
+   int                  val;
+   char                 c;
+
+   len   = 0;
+   bits  = 0;
+   nbits = 0;
+
+   for(x = 0; (x < *lenp); x++)
+   {
+      c = str[x];
+      if      ( (c >= 'A') && (c <= 'Z') ) val = c - 'A';
+      else if ( (c >= 'a') && (c <= 'z') ) val = c - 'a' + 26;
+      else if ( (c >= '0') && (c <= '9') ) val = c - '0' + 52;
+      else if (c == '+')                  val = 62;
+      else if (c == '/')                  val = 63;
+      else if (c == '=')                  break;
+      else if (isspace((unsigned char)c)) continue;
+      else                                return(-1);
+
+      bits   = ((bits << 6) | (unsigned)val) & 0xffffff;
+      nbits += 6;
+      if (nbits >= 8)
+      {
+         nbits -= 8;
+         str[len++] = (char)((bits >> nbits) & 0xff);
+      };
+   };
+
+   *lenp = len;
+
+   return(0);
+}
+
+
+/// queues definitions of cache file
+/// @param[in]    lsd         reference to schema
+/// @param[in]    data        contents of file
+/// @param[in]    len         length of file
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_DECODING_ERROR or
+///            LDAPSCHEMA_NO_MEMORY.
+int ldapschema_load_cache(LDAPSchema * lsd, char * data, size_t len)
+{
+   int                  err;
+   int                  type;
+   size_t               pos;
+   struct berval        def;
+   LDAPSchemaCache      cache;
+
+   assert(lsd  != NULL);
+   assert(data != NULL);
+
+   bzero(&cache, sizeof(cache));
+   cache.data      = data;
+   cache.data_len  = len;
+   cache.data_size = len;
+   if (ldapschema_cache_decode(&cache) == -1)
+      return(lsd->errcode = LDAPSCHEMA_DECODING_ERROR);
+
+   pos = cache.defs;
+   while (ldapschema_cache_next(&cache, &pos, &type, &def) == 1)
+      if ((err = ldapschema_load_append(lsd, type, def.bv_val, def.bv_len)) != LDAPSCHEMA_SUCCESS)
+         return(err);
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// queues definitions of OpenLDAP .schema file
+/// @param[in]    lsd         reference to schema
+/// @param[in]    data        contents of file
+/// @param[in]    len         length of file
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_DECODING_ERROR or
+///            LDAPSCHEMA_NO_MEMORY.
+int ldapschema_load_conf(LDAPSchema * lsd, char * data, size_t len)
+{
+   int                  err;
+   size_t               pos;
+   size_t               bol;
+   size_t               eol;
+   size_t               stmt_len;
+   size_t               stmt_size;
+   char               * stmt;
+   void               * ptr;
+
+   assert(lsd  != NULL);
+   assert(data != NULL);
+
+   stmt      = NULL;
+   stmt_len  = 0;
+   stmt_size = 0;
+   err       = LDAPSCHEMA_SUCCESS;
+
+   for(pos = 0; ( (pos <= len) && (err == LDAPSCHEMA_SUCCESS) ); pos = eol + 1)
+   {
+      // determines bounds of line
+      for(eol = pos; ( (eol < len) && (data[eol] != '\n') ); eol++);
+      bol = pos;
+      if ( (eol > bol) && (data[eol-1] == '\r') )
+         data[eol-1] = '\0';
+      data[eol] = '\0';
+
+      // comments are skipped without ending statement
+      if (data[bol] == '#')
+         continue;
+
+      // lines starting with white space continue statement
+      if ( (data[bol] == ' ') || (data[bol] == '\t') )
+      {
+         while ( (data[bol] == ' ') || (data[bol] == '\t') )
+            bol++;
+         if ( (!(data[bol])) || (!(stmt_len)) )
+            continue;
+      } else if ((stmt_len))
+      {
+         err      = ldapschema_load_directive(lsd, stmt);
+         stmt_len = 0;
+         if (err != LDAPSCHEMA_SUCCESS)
+            continue;
+      };
+      if (!(data[bol]))
+         continue;
+
+      // appends line to statement
+      if ((stmt_len + strlen(&data[bol]) + 2) > stmt_size)
+      {
+         stmt_size = stmt_len + strlen(&data[bol]) + 256;
+         if ((ptr = realloc(stmt, stmt_size)) == NULL)
+         {
+            free(stmt);
+            return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+         };
+         stmt = ptr;
+      };
+      if ((stmt_len))
+         stmt[stmt_len++] = ' ';
+      strcpy(&stmt[stmt_len], &data[bol]);
+      stmt_len += strlen(&data[bol]);
+   };
+
+   if ( (err == LDAPSCHEMA_SUCCESS) && ((stmt_len)) )
+      err = ldapschema_load_directive(lsd, stmt);
+
+   free(stmt);
+
+   return(err);
+}
+
+
+/// processes directive of OpenLDAP .schema file
+/// @param[in]    lsd         reference to schema
+/// @param[in]    stmt        directive and its arguments
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_DECODING_ERROR or
+///            LDAPSCHEMA_NO_MEMORY.
+int ldapschema_load_directive(LDAPSchema * lsd, char * stmt)
+{
+   int                  err;
+   size_t               x;
+   size_t               len;
+   char               * args;
+   char               * name;
+   char               * oid;
+   char               * def;
+   void               * ptr;
+
+   static const struct
+   {
+      const char * name;
+      int          type;
+   } directives[] =
+   {
+      { "ldapsyntax",         LDAPSCHEMA_SYNTAX },
+      { "ldapsyntaxes",       LDAPSCHEMA_SYNTAX },
+      { "attributetype",      LDAPSCHEMA_ATTRIBUTETYPE },
+      { "attributetypes",     LDAPSCHEMA_ATTRIBUTETYPE },
+      { "objectclass",        LDAPSCHEMA_OBJECTCLASS },
+      { "objectclasses",      LDAPSCHEMA_OBJECTCLASS },
+   };
+
+   assert(lsd  != NULL);
+   assert(stmt != NULL);
+
+   // splits directive from arguments
+   for(len = 0; ( ((stmt[len])) && (!(isspace((unsigned char)stmt[len]))) ); len++);
+   for(args = &stmt[len]; (isspace((unsigned char)args[0])); args++);
+   stmt[len] = '\0';
+
+   // objectidentifier name oid
+   if (!(strcasecmp(stmt, "objectidentifier")))
+   {
+      name = args;
+      for(len = 0; ( ((name[len])) && (!(isspace((unsigned char)name[len]))) ); len++);
+      for(oid = &name[len]; (isspace((unsigned char)oid[0])); oid++);
+      name[len] = '\0';
+      for(len = 0; ( ((oid[len])) && (!(isspace((unsigned char)oid[len]))) ); len++);
+      oid[len] = '\0';
+      if ( (!(name[0])) || (!(oid[0])) )
+         return(lsd->errcode = LDAPSCHEMA_DECODING_ERROR);
+      if ((oid = ldapschema_load_expand(lsd, oid, strlen(oid))) == NULL)
+         return(lsd->errcode);
+      if ((ptr = realloc(lsd->oidmacros, sizeof(char *) * (lsd->oidmacros_len + 2))) == NULL)
+      {
+         free(oid);
+         return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+      };
+      lsd->oidmacros = ptr;
+      if ((lsd->oidmacros[lsd->oidmacros_len] = strdup(name)) == NULL)
+      {
+         free(oid);
+         return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+      };
+      lsd->oidmacros[lsd->oidmacros_len+1] = oid;
+      lsd->oidmacros_len += 2;
+      return(LDAPSCHEMA_SUCCESS);
+   };
+
+   // other directives are not part of the schema
+   for(x = 0; (x < (sizeof(directives)/sizeof(directives[0]))); x++)
+      if (!(strcasecmp(stmt, directives[x].name)))
+         break;
+   if (x >= (sizeof(directives)/sizeof(directives[0])))
+      return(LDAPSCHEMA_SUCCESS);
+
+   if ((def = ldapschema_load_macros(lsd, args)) == NULL)
+      return(lsd->errcode);
+   err = ldapschema_load_append(lsd, directives[x].type, def, strlen(def));
+   free(def);
+
+   return(err);
+}
+
+
+/// expands OID macro
+/// @param[in]    lsd         reference to schema
+/// @param[in]    str         OID, macro, or macro with suffix
+/// @param[in]    len         length of str
+///
+/// @return    Returns allocated expanded OID, or NULL if memory could not be
+///            allocated.
+char * ldapschema_load_expand(LDAPSchema * lsd, const char * str, size_t len)
+{
+   size_t               x;
+   size_t               pre;
+   size_t               size;
+   const char         * oid;
+   char               * buff;
+
+   assert(lsd != NULL);
+   assert(str != NULL);
+
+   // macro may be followed by suffix separated by a colon
+   for(pre = 0; ( (pre < len) && (str[pre] != ':') ); pre++);
+
+   oid = NULL;
+   if ( (pre > 0) && (!(isdigit((unsigned char)str[0]))) )
+      for(x = 0; ( (x < lsd->oidmacros_len) && (!(oid)) ); x += 2)
+         if ( (strlen(lsd->oidmacros[x]) == pre) && (!(strncasecmp(lsd->oidmacros[x], str, pre))) )
+            oid = lsd->oidmacros[x+1];
+
+   size = ((oid)) ? strlen(oid) + len - pre + 1 : len + 1;
+   if ((buff = malloc(size)) == NULL)
+   {
+      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      return(NULL);
+   };
+
+   if (!(oid))
+   {
+      memcpy(buff, str, len);
+      buff[len] = '\0';
+   } else if (pre < len)
+   {
+      snprintf(buff, size, "%s.%.*s", oid, (int)(len - pre - 1), &str[pre+1]);
+   } else
+   {
+      snprintf(buff, size, "%s", oid);
+   };
+
+   return(buff);
+}
+
+
+/// frees definitions and OID macros of schema files which have not been
+/// parsed
+/// @param[in]    lsd         reference to schema
+void ldapschema_load_free(LDAPSchema * lsd)
+{
+   size_t               x;
+
+   assert(lsd != NULL);
+
+   if ((lsd->pending))
+   {
+      ldapschema_cache_free(lsd->pending);
+      free(lsd->pending);
+   };
+   lsd->pending = NULL;
+
+   for(x = 0; (x < lsd->oidmacros_len); x++)
+      free(lsd->oidmacros[x]);
+   free(lsd->oidmacros);
+   lsd->oidmacros     = NULL;
+   lsd->oidmacros_len = 0;
+
+   return;
+}
+
+
+/// queues definitions of LDIF file
+/// @param[in]    lsd         reference to schema
+/// @param[in]    data        contents of file
+/// @param[in]    len         length of file
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_DECODING_ERROR or
+///            LDAPSCHEMA_NO_MEMORY.
+int ldapschema_load_ldif(LDAPSchema * lsd, char * data, size_t len)
+{
+   int                  err;
+   int                  type;
+   size_t               x;
+   size_t               pos;
+   size_t               eol;
+   size_t               seg;
+   size_t               line_len;
+   size_t               line_size;
+   size_t               name_len;
+   size_t               val_len;
+   char               * line;
+   char               * val;
+   void               * ptr;
+
+   // attributes of subschema entries and of cn=schema,cn=config entries
+   static const struct
+   {
+      const char * name;
+      int          type;
+   } attrs[] =
+   {
+      { "ldapSyntaxes",       LDAPSCHEMA_SYNTAX },
+      { "attributeTypes",     LDAPSCHEMA_ATTRIBUTETYPE },
+      { "objectClasses",      LDAPSCHEMA_OBJECTCLASS },
+      { "olcLdapSyntaxes",    LDAPSCHEMA_SYNTAX },
+      { "olcAttributeTypes",  LDAPSCHEMA_ATTRIBUTETYPE },
+      { "olcObjectClasses",   LDAPSCHEMA_OBJECTCLASS },
+   };
+
+   assert(lsd  != NULL);
+   assert(data != NULL);
+
+   line      = NULL;
+   line_size = 0;
+
+   for(pos = 0; (pos < len); )
+   {
+      // unfolds lines continued with a leading space
+      line_len = 0;
+      do
+      {
+         for(eol = pos; ( (eol < len) && (data[eol] != '\n') ); eol++);
+         seg = ( (eol > pos) && (data[eol-1] == '\r') ) ? eol - 1 : eol;
+         if ((line_len))
+            pos++;
+         if ((line_len + (seg - pos) + 1) > line_size)
+         {
+            line_size = line_len + (seg - pos) + 256;
+            if ((ptr = realloc(line, line_size)) == NULL)
+            {
+               free(line);
+               return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+            };
+            line = ptr;
+         };
+         memcpy(&line[line_len], &data[pos], seg - pos);
+         line_len += seg - pos;
+         pos = eol + 1;
+      } while ( (pos < len) && (data[pos] == ' ') && ((line_len)) );
+      if ( (!(line_len)) || (line[0] == '#') || (line[0] == '-') )
+         continue;
+      line[line_len] = '\0';
+
+      // splits attribute description from value
+      if ((val = memchr(line, ':', line_len)) == NULL)
+      {
+         free(line);
+         return(lsd->errcode = LDAPSCHEMA_DECODING_ERROR);
+      };
+      for(name_len = 0; ( (&line[name_len] < val) && (line[name_len] != ';') ); name_len++);
+      for(x = 0, type = 0; ( (x < (sizeof(attrs)/sizeof(attrs[0]))) && (!(type)) ); x++)
+         if ( (strlen(attrs[x].name) == name_len) && (!(strncasecmp(line, attrs[x].name, name_len))) )
+            type = attrs[x].type;
+      if (!(type))
+         continue;
+
+      // decodes value
+      val++;
+      if (val[0] == '<')
+         continue;
+      if (val[0] == ':')
+      {
+         for(val++; (val[0] == ' '); val++);
+         val_len = line_len - (size_t)(val - line);
+         if (ldapschema_load_base64(val, &val_len) == -1)
+         {
+            free(line);
+            return(lsd->errcode = LDAPSCHEMA_DECODING_ERROR);
+         };
+      } else
+      {
+         for(; (val[0] == ' '); val++);
+         val_len = line_len - (size_t)(val - line);
+      };
+
+      if ((err = ldapschema_load_append(lsd, type, val, val_len)) != LDAPSCHEMA_SUCCESS)
+      {
+         free(line);
+         return(err);
+      };
+   };
+
+   free(line);
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// expands OID macros in the OID and SYNTAX of definition
+/// @param[in]    lsd         reference to schema
+/// @param[in]    def         definition
+///
+/// @return    Returns allocated definition, or NULL if memory could not be
+///            allocated.
+char * ldapschema_load_macros(LDAPSchema * lsd, const char * def)
+{
+   int                  expand;
+   size_t               pos;
+   size_t               len;
+   size_t               tok;
+   size_t               tok_len;
+   size_t               size;
+   size_t               count;
+   char               * buff;
+   char               * oid;
+   void               * ptr;
+
+   assert(lsd != NULL);
+   assert(def != NULL);
+
+   len  = strlen(def);
+   size = len + 1;
+   if ((buff = malloc(size)) == NULL)
+   {
+      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      return(NULL);
+   };
+
+   count  = 0;
+   expand = 0;
+   for(pos = 0, tok = 0; (pos < len); tok++)
+   {
+      // copies white space, parentheses and quoted strings
+      if ( (isspace((unsigned char)def[pos])) || (def[pos] == '(') || (def[pos] == ')') )
+      {
+         buff[count++] = def[pos++];
+         tok--;
+         continue;
+      };
+      if (def[pos] == '\'')
+      {
+         do
+            buff[count++] = def[pos++];
+         while ( (pos < len) && (def[pos] != '\'') );
+         if (pos < len)
+            buff[count++] = def[pos++];
+         expand = 0;
+         continue;
+      };
+
+      // finds end of token
+      for(tok_len = 0; ( ((def[pos+tok_len])) && (!(isspace((unsigned char)def[pos+tok_len]))) && (!(strchr("()'{", def[pos+tok_len]))) ); tok_len++);
+
+      // the first token is the OID of the definition
+      if ( ((tok_len)) && ( (!(tok)) || ((expand)) ) )
+      {
+         if ((oid = ldapschema_load_expand(lsd, &def[pos], tok_len)) == NULL)
+         {
+            free(buff);
+            return(NULL);
+         };
+         size += strlen(oid);
+         if ((ptr = realloc(buff, size)) == NULL)
+         {
+            free(oid);
+            free(buff);
+            lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+            return(NULL);
+         };
+         buff = ptr;
+         memcpy(&buff[count], oid, strlen(oid));
+         count += strlen(oid);
+         pos   += tok_len;
+         free(oid);
+         expand = 0;
+         continue;
+      };
+
+      expand = ( (tok_len == 6) && (!(strncasecmp(&def[pos], "SYNTAX", 6))) ) ? 1 : 0;
+      if (!(tok_len))
+         tok_len = 1;
+      memcpy(&buff[count], &def[pos], tok_len);
+      count += tok_len;
+      pos   += tok_len;
+   };
+   buff[count] = '\0';
+
+   return(buff);
+}
+
+
+/// parses queued definitions, called by ldapschema_link() before superiors
+/// are linked
+/// @param[in]    lsd         reference to schema
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if a
+///            definition was rejected, or an error code if memory could not
+///            be allocated.
+/// @see       ldapschema_link
+int ldapschema_load_parse(LDAPSchema * lsd)
+{
+   int                  rc;
+   int                  err;
+   size_t               x;
+
+   static const int types[] = { LDAPSCHEMA_SYNTAX, LDAPSCHEMA_ATTRIBUTETYPE, LDAPSCHEMA_OBJECTCLASS };
+
+   assert(lsd != NULL);
+
+   rc  = LDAPSCHEMA_SUCCESS;
+   err = LDAPSCHEMA_SUCCESS;
+   for(x = 0; (x < (sizeof(types)/sizeof(types[0]))); x++)
+   {
+      if ((err = ldapschema_cache_parse_type(lsd, lsd->pending, types[x])) == LDAPSCHEMA_SCHEMA_ERROR)
+         rc = err;
+      else if (err != LDAPSCHEMA_SUCCESS)
+         break;
+      if ( (types[x] == LDAPSCHEMA_SYNTAX) && ((err = ldapschema_load_syntaxes(lsd)) != LDAPSCHEMA_SUCCESS) )
+         break;
+   };
+
+   // definitions and macros are not needed once parsed
+   ldapschema_load_free(lsd);
+
+   if ( (err != LDAPSCHEMA_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+      return(err);
+   return(rc);
+}
+
+
+/// adds syntaxes of the OID specifications which were not defined by the
+/// loaded schema files
+/// @param[in]    lsd         reference to schema
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS or an error code.
+int ldapschema_load_syntaxes(LDAPSchema * lsd)
+{
+   int                             err;
+   size_t                          x;
+   size_t                          len;
+   char                            def[256];
+   struct berval                   bv;
+   const LDAPSchemaSpec * const  * specs;
+
+   assert(lsd != NULL);
+
+   specs = ldapschema_spec_list(&len);
+
+   for(x = 0; (x < len); x++)
+   {
+      if (specs[x]->type != LDAPSCHEMA_SYNTAX)
+         continue;
+      if ( ((ldapschema_find_ldapsyntax(lsd, specs[x]->oid))) || (strlen(specs[x]->oid) > (sizeof(def) - 5)) )
+         continue;
+      bv.bv_len = (size_t)snprintf(def, sizeof(def), "( %s )", specs[x]->oid);
+      bv.bv_val = def;
+      if ( ((err = ldapschema_parse(lsd, LDAPSCHEMA_SYNTAX, &bv)) != LDAPSCHEMA_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+         return(err);
+   };
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+/* end of source file */
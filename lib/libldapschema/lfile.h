@@ -0,0 +1,123 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *   @file src/ldapschema/lfile.h  contains functions for loading schema files
+ */
+#ifndef _LIB_LIBLDAPSCHEMA_LFILE_H
+#define _LIB_LIBLDAPSCHEMA_LFILE_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libldapschema.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+int
+ldapschema_load_append(
+         LDAPSchema               * lsd,
+         int                        type,
+         const char               * def,
+         size_t                     len );
+
+int
+ldapschema_load_base64(
+         char                     * str,
+         size_t                   * lenp );
+
+int
+ldapschema_load_cache(
+         LDAPSchema               * lsd,
+         char                     * data,
+         size_t                     len );
+
+int
+ldapschema_load_conf(
+         LDAPSchema               * lsd,
+         char                     * data,
+         size_t                     len );
+
+int
+ldapschema_load_directive(
+         LDAPSchema               * lsd,
+         char                     * stmt );
+
+char *
+ldapschema_load_expand(
+         LDAPSchema               * lsd,
+         const char               * str,
+         size_t                     len );
+
+void
+ldapschema_load_free(
+         LDAPSchema               * lsd );
+
+int
+ldapschema_load_ldif(
+         LDAPSchema               * lsd,
+         char                     * data,
+         size_t                     len );
+
+char *
+ldapschema_load_macros(
+         LDAPSchema               * lsd,
+         const char               * def );
+
+int
+ldapschema_load_parse(
+         LDAPSchema               * lsd );
+
+int
+ldapschema_load_syntaxes(
+         LDAPSchema               * lsd );
+
+
+#endif /* end of header file */
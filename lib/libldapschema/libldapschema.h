@@ -48,6 +48,7 @@
 #endif
 
 #include <assert.h>
+#include <stdint.h>
 
 #define LDAP_DEPRECATED 1
 #include <ldap.h>
@@ -69,24 +70,55 @@
 /////////////////
 #pragma mark - Datatypes
 
+typedef struct ldapschema_alias_index LDAPSchemaAliasIndex;
+
+typedef struct ldapschema_cache LDAPSchemaCache;
+
+typedef struct ldapschema_check_attr LDAPSchemaCheckAttr;
+
+typedef struct ldapschema_check_class LDAPSchemaCheckClass;
+
+typedef struct ldapschema_check_name LDAPSchemaCheckName;
+
+typedef struct ldapschema_check_set LDAPSchemaCheckSet;
+
+typedef struct ldapschema_violation LDAPSchemaViolation;
+
+
+/// hash table of names and OIDs of a sorted array of aliases
+struct ldapschema_alias_index
+{
+   LDAPSchemaCheckName                  * names;            ///< NULL if array is not indexed
+   size_t                                 size;             ///< power of two
+   size_t                                 len;              ///< length of array when indexed
+};
+
+
 /// LDAP schema descriptor state
 struct ldap_schema
 {
    int32_t                                errcode;          ///< last error code
-   int32_t                                pad32;
+   int32_t                                bulk;             ///< appends objects to arrays unsorted until ldapschema_bulk_end()
    LDAPSchemaPointer                    * dups;             ///< array of duplicate oids
    size_t                                 dups_len;         ///< length of duplicate array
    LDAPSchemaPointer                    * oids;             ///< array of all known oids
    size_t                                 oids_len;         ///< length of oids array
+   size_t                                 oids_sorted;      ///< length of sorted part of oids array while loading in bulk
    LDAPSchemaAlias                     ** syntaxes;         ///< array of syntaxes
    size_t                                 syntaxes_len;     ///< length of syntaxes array
    LDAPSchemaAlias                     ** attrs;            ///< array of attributeTypes
    size_t                                 attrs_len;        ///< length of attributeTypes array
    LDAPSchemaAlias                     ** objclses;         ///< array of objectClasses
    size_t                                 objclses_len;     ///< length of objectClasses array
+   LDAPSchemaAliasIndex                   syntaxes_idx;     ///< hash table of syntaxes
+   LDAPSchemaAliasIndex                   attrs_idx;        ///< hash table of attributeTypes
+   LDAPSchemaAliasIndex                   objclses_idx;     ///< hash table of objectClasses
    char                                ** schema_errs;      ///< list of schema errors discovered
    size_t                                 schema_errs_cnt;  ///< number of objects with errors
    LDAPSchemaModel                      * schema_errs_cur;  ///< reference to current object being reported (may contain multiple errors)
+   LDAPSchemaCache                      * pending;          ///< definitions of schema files which have not been parsed
+   char                                ** oidmacros;        ///< names and OIDs of OID macros of schema files
+   size_t                                 oidmacros_len;    ///< length of OID macros array
 };
 
 
@@ -189,6 +221,8 @@ struct ldap_schema_syntax
 {
    LDAPSchemaModel                        model;
    size_t                                 data_class;
+   int32_t                                re_compiled;      ///< regular expression of specification was compiled
+   int32_t                                pad32;
    regex_t                                re;
 };
 
@@ -199,6 +233,116 @@ struct ldap_schema_matchingrule
 };
 
 
+/// attributeType compiled for validation
+struct ldapschema_check_attr
+{
+   LDAPSchemaAttributeType              * attr;
+   const LDAPSchemaSyntax               * syntax;           ///< syntax, or syntax inherited from superior
+   const char                           * name;             ///< first name or OID of attributeType
+   uint32_t                               flags;
+   uint32_t                               usage;
+};
+
+
+/// objectClass compiled for validation
+struct ldapschema_check_class
+{
+   LDAPSchemaObjectclass                * objcls;
+   uint64_t                             * must;             ///< bitmap of required attributeTypes
+   uint64_t                             * may;              ///< bitmap of allowed attributeTypes and their subtypes
+   uint64_t                               kind;
+   int32_t                                extensible;       ///< allows all user attributes
+   int32_t                                pad32;
+};
+
+
+/// hash table slot of case folded name
+struct ldapschema_check_name
+{
+   const char                           * name;             ///< NULL if slot is empty
+   size_t                                 len;
+   size_t                                 hash;
+   size_t                                 idx;              ///< index of attributeType or objectClass
+};
+
+
+/// objectClasses of entry resolved to required and allowed attributeTypes
+struct ldapschema_check_set
+{
+   size_t                               * classes;          ///< sorted indexes of objectClasses, NULL if slot is empty
+   size_t                                 classes_len;
+   size_t                                 hash;
+   uint64_t                             * must;             ///< followed by bitmap of allowed attributeTypes
+   uint64_t                             * may;
+   int32_t                                structural;
+   int32_t                                extensible;
+};
+
+
+/// schema violation of entry
+struct ldapschema_violation
+{
+   int32_t                                code;
+   int32_t                                pad32;
+   size_t                                 value;            ///< index of value which does not match syntax
+   struct berval                          name;             ///< attribute or objectClass
+};
+
+
+/// objectClass and attributeType checks compiled from schema
+struct ldapschema_validator
+{
+   LDAPSchema                           * lsd;
+   LDAPSchemaCheckAttr                  * attrs;
+   size_t                                 attrs_len;
+   LDAPSchemaCheckClass                 * classes;
+   size_t                                 classes_len;
+   LDAPSchemaCheckName                  * attr_names;       ///< names and OIDs of attributeTypes
+   size_t                                 attr_names_size;  ///< power of two
+   LDAPSchemaCheckName                  * class_names;      ///< names and OIDs of objectClasses
+   size_t                                 class_names_size; ///< power of two
+   size_t                                 words;            ///< number of words in each bitmap
+   size_t                                 objectclass;      ///< index of objectClass attributeType
+   uint64_t                             * bits;             ///< bitmaps of objectClasses
+};
+
+
+/// state of entry being checked by one thread
+struct ldapschema_checker
+{
+   LDAPSchemaValidator                  * val;
+   uint64_t                             * present;          ///< bitmap of attributeTypes of entry
+   size_t                               * attrs;            ///< indexes of attributeTypes of entry
+   size_t                                 attrs_len;
+   size_t                               * classes;          ///< indexes of objectClasses of entry
+   size_t                                 classes_len;
+   size_t                                 classes_size;
+   size_t                                 unknown;          ///< number of unknown objectClasses of entry
+   LDAPSchemaCheckSet                   * sets;             ///< hash table of resolved objectClass combinations
+   size_t                                 sets_len;
+   size_t                                 sets_size;        ///< power of two
+   LDAPSchemaViolation                  * viols;
+   size_t                                 viols_len;
+   size_t                                 viols_size;
+   char                                 * buff;             ///< terminated copy of value matched by regular expression
+   size_t                                 buff_size;
+};
+
+
+/// serialized definitions of subschema entry
+struct ldapschema_cache
+{
+   char                                 * data;             ///< contents of cache file
+   size_t                                 data_len;
+   size_t                                 data_size;
+   size_t                                 defs;             ///< offset of first definition
+   struct berval                          uri;              ///< URI of server
+   struct berval                          dn;               ///< DN of subschema entry
+   struct berval                          timestamp;        ///< modifyTimestamp of subschema entry
+   struct berval                          csn;              ///< entryCSN of subschema entry
+};
+
+
 //////////////////
 //              //
 //  Prototypes  //
@@ -211,6 +355,14 @@ struct ldap_schema_matchingrule
 //-------=----------//
 #pragma mark memory functions
 
+int
+ldapschema_add(
+         LDAPSchema            * lsd,
+         void                *** listp,
+         size_t                * lenp,
+         void                  * obj,
+         int (*compar)(const void *, const void *) );
+
 void
 ldapschema_attributetype_free(
          LDAPSchemaAttributeType  * attr );
@@ -219,6 +371,30 @@ LDAPSchemaAttributeType *
 ldapschema_attributetype_initialize(
          LDAPSchema            * lsd );
 
+int
+ldapschema_bulk_aliases(
+         LDAPSchema            * lsd,
+         LDAPSchemaAlias      ** list,
+         size_t                * lenp,
+         const char            * type );
+
+void
+ldapschema_bulk_begin(
+         LDAPSchema            * lsd );
+
+int
+ldapschema_bulk_end(
+         LDAPSchema            * lsd );
+
+int
+ldapschema_bulk_list(
+         LDAPSchema            * lsd,
+         void                 ** list,
+         size_t                * lenp,
+         int (*compar)(const void *, const void *),
+         LDAPSchemaModel       * mod,
+         const char            * field );
+
 void
 ldapschema_ext_free(
          LDAPSchemaExtension   * ext );
@@ -228,6 +404,12 @@ ldapschema_ext_initialize(
          LDAPSchema            * lsd,
          const char            * name );
 
+int
+ldapschema_grow(
+         LDAPSchema            * lsd,
+         void                *** listp,
+         size_t                  len );
+
 int
 ldapschema_insert(
          LDAPSchema            * lsd,
@@ -48,7 +48,10 @@
 #include <string.h>
 #include <strings.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
+#include "lcache.h"
+#include "lfile.h"
 #include "llexer.h"
 #include "lquery.h"
 #include "lerror.h"
@@ -61,24 +64,38 @@
 /////////////////
 #pragma mark - Functions
 
+/// retrieves and links schema of directory server
+/// @param[in]    lsd         reference to schema
+/// @param[in]    ld          reference to LDAP connection
+///
+/// @return    Returns LDAP_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if the schema
+///            contained errors, or an error code if the schema could not be
+///            retrieved.
+/// @see       ldapschema_fetch_cache, ldapschema_link, ldapschema_parse
 int ldapschema_fetch(LDAPSchema * lsd, LDAP * ld)
+{
+   return(ldapschema_fetch_cache(lsd, ld, NULL));
+}
+
+
+/// retrieves and links schema of directory server, reusing the definitions
+/// saved in the cache directory if the subschema entry has not been modified
+/// since the definitions were saved
+/// @param[in]    lsd         reference to schema
+/// @param[in]    ld          reference to LDAP connection
+/// @param[in]    dir         directory of cache files, or NULL to disable
+///                           the cache
+///
+/// @return    Returns LDAP_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if the schema
+///            contained errors, or an error code if the schema could not be
+///            retrieved.
+/// @see       ldapschema_fetch, ldapschema_link, ldapschema_parse
+int ldapschema_fetch_cache(LDAPSchema * lsd, LDAP * ld, const char * dir)
 {
    int                  err;
-   int                  x;
-   struct timeval       timeout;
-   LDAPMessage        * res;
-   LDAPMessage        * msg;
-   char              ** dns;
-   char              ** attrs;
-   struct berval     ** vals;
-   void               * ptr;
-   size_t               idx;
-   size_t               subidx;
-   LDAPSchemaAlias    * alias;
-   LDAPSchemaAttributeType     * attr;
-   LDAPSchemaAttributeType     * attrsup;
-   LDAPSchemaObjectclass       * objcls;
-   LDAPSchemaObjectclass       * objclssup;
+   char               * uri;
+   char               * file;
+   LDAPSchemaCache      cache;
 
    assert(lsd != NULL);
    assert(ld  != NULL);
@@ -90,6 +107,98 @@ int ldapschema_fetch(LDAPSchema * lsd, LDAP * ld)
    lsd->schema_errs_cnt = 0;
    lsd->schema_errs_cur = NULL;
 
+   uri  = NULL;
+   file = NULL;
+   bzero(&cache, sizeof(cache));
+
+   // parses cached definitions if subschema entry is unchanged
+   if ((dir))
+   {
+      if ( (ldap_get_option(ld, LDAP_OPT_URI, &uri) == LDAP_OPT_SUCCESS) && ((uri)) )
+         file = ldapschema_cache_path(dir, uri);
+      if ( ((file)) && (ldapschema_cache_read(&cache, file) == 0) && (ldapschema_fetch_fresh(ld, &cache, uri) == 1) )
+      {
+         free(file);
+         ldap_memfree(uri);
+         err = ldapschema_cache_parse(lsd, &cache);
+         ldapschema_cache_free(&cache);
+         if ( (err != LDAPSCHEMA_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+            return(err);
+         return(ldapschema_link(lsd));
+      };
+      ldapschema_cache_free(&cache);
+   };
+
+   // retrieves definitions from subschema entry
+   if ((err = ldapschema_fetch_entry(lsd, ld, uri, &cache)) != LDAP_SUCCESS)
+   {
+      free(file);
+      ldap_memfree(uri);
+      return(err);
+   };
+   ldap_memfree(uri);
+
+   // process ldapSyntaxes, attributeTypes, and objectClasses
+   if ( ((err = ldapschema_cache_parse(lsd, &cache)) != LDAPSCHEMA_SUCCESS) &&
+        (err != LDAPSCHEMA_SCHEMA_ERROR) )
+   {
+      free(file);
+      ldapschema_cache_free(&cache);
+      return(err);
+   };
+
+   // saves definitions, a failed write only costs a download on the next run
+   if ((file))
+   {
+      mkdir(dir, 0700);
+      ldapschema_cache_write(&cache, file);
+      free(file);
+   };
+   ldapschema_cache_free(&cache);
+
+   // maps superiors and inherits specs of superiors
+   return(ldapschema_link(lsd));
+}
+
+
+/// retrieves the subschema entry of directory server and stores the
+/// definitions and modification stamps of the entry in a cache
+/// @param[in]    lsd         reference to schema
+/// @param[in]    ld          reference to LDAP connection
+/// @param[in]    uri         URI of directory server, or NULL
+/// @param[out]   cache       reference to cache
+///
+/// @return    Returns LDAP_SUCCESS or an error code.
+/// @see       ldapschema_fetch_cache
+int ldapschema_fetch_entry(LDAPSchema * lsd, LDAP * ld, const char * uri,
+   LDAPSchemaCache * cache)
+{
+   int                  err;
+   int                  x;
+   size_t               y;
+   struct timeval       timeout;
+   LDAPMessage        * res;
+   LDAPMessage        * msg;
+   char              ** dns;
+   char              ** attrs;
+   struct berval     ** vals;
+
+   static const char * stamps[] = { "modifyTimestamp", "entryCSN" };
+   static const struct
+   {
+      const char * name;
+      int          type;
+   } defs[] =
+   {
+      { "ldapSyntaxes",   LDAPSCHEMA_SYNTAX },
+      { "attributeTypes", LDAPSCHEMA_ATTRIBUTETYPE },
+      { "objectClasses",  LDAPSCHEMA_OBJECTCLASS },
+   };
+
+   assert(lsd   != NULL);
+   assert(ld    != NULL);
+   assert(cache != NULL);
+
    attrs = NULL;
    if ((err = ldapschema_definition_split(lsd, NULL, "( + * )", 7, &attrs)) == -1)
       return(lsd->errcode);
@@ -106,12 +215,13 @@ int ldapschema_fetch(LDAPSchema * lsd, LDAP * ld)
    if ((msg = ldap_first_entry(ld, res)) == NULL)
    {
       ldap_msgfree(res);
+      ldapschema_value_free(attrs);
       return(-1);
    };
    if ((dns = ldap_get_values(ld, msg, "subschemaSubentry")) == NULL)
    {
       ldap_msgfree(res);
-      ldap_value_free(dns);
+      ldapschema_value_free(attrs);
       return(-1);
    };
    ldap_msgfree(res);
@@ -126,69 +236,192 @@ int ldapschema_fetch(LDAPSchema * lsd, LDAP * ld)
       ldapschema_value_free(attrs);
       return(-1);
    };
-   ldap_value_free(dns);
    ldapschema_value_free(attrs);
-   dns   = NULL;
    attrs = NULL;
    if ((msg = ldap_first_entry(ld, res)) == NULL)
    {
+      ldap_value_free(dns);
       ldap_msgfree(res);
       return(-1);
    };
 
-   // process ldapSyntaxes
-   if ((vals = ldap_get_values_len(ld, msg, "ldapSyntaxes")) != NULL)
+   // records URI, DN, modifyTimestamp, and entryCSN of schema entry
+   err = 0;
+   uri = ((uri)) ? uri : "";
+   err |= ldapschema_cache_append(cache, LDAPSCHEMA_CACHE_FIELD, uri, strlen(uri));
+   err |= ldapschema_cache_append(cache, LDAPSCHEMA_CACHE_FIELD, dns[0], strlen(dns[0]));
+   ldap_value_free(dns);
+   dns = NULL;
+   for(y = 0; (y < (sizeof(stamps)/sizeof(stamps[0]))); y++)
    {
-      for(x = 0; ((vals[x])); x++)
+      if ((vals = ldap_get_values_len(ld, msg, stamps[y])) == NULL)
       {
-         if ( ((ptr = ldapschema_parse_syntax(lsd, vals[x])) == NULL) &&
-              (lsd->errcode != LDAPSCHEMA_SCHEMA_ERROR) )
-         {
-            ldap_value_free_len(vals);
-            ldap_msgfree(res);
-            return(-1);
-         };
+         err |= ldapschema_cache_append(cache, LDAPSCHEMA_CACHE_FIELD, "", 0);
+         continue;
       };
+      err |= ldapschema_cache_append(cache, LDAPSCHEMA_CACHE_FIELD, vals[0]->bv_val, vals[0]->bv_len);
       ldap_value_free_len(vals);
    };
 
-   // process attributeTypes
-   if ((vals = ldap_get_values_len(ld, msg, "attributeTypes")) != NULL)
+   // records ldapSyntaxes, attributeTypes, and objectClasses
+   for(y = 0; (y < (sizeof(defs)/sizeof(defs[0]))); y++)
    {
-      // initial parsing of definition
+      if ((vals = ldap_get_values_len(ld, msg, defs[y].name)) == NULL)
+         continue;
       for(x = 0; ((vals[x])); x++)
+         err |= ldapschema_cache_append(cache, defs[y].type, vals[x]->bv_val, vals[x]->bv_len);
+      ldap_value_free_len(vals);
+   };
+
+   ldap_msgfree(res);
+
+   if ( ((err)) || (ldapschema_cache_decode(cache) == -1) )
+   {
+      ldapschema_cache_free(cache);
+      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// compares modification stamps of subschema entry with stamps stored in
+/// cache
+/// @param[in]    ld          reference to LDAP connection
+/// @param[in]    cache       reference to decoded cache
+/// @param[in]    uri         URI of directory server
+///
+/// @return    Returns 1 if the cache is current, otherwise 0 is returned.
+/// @see       ldapschema_fetch_cache
+int ldapschema_fetch_fresh(LDAP * ld, const LDAPSchemaCache * cache,
+   const char * uri)
+{
+   int                  rc;
+   size_t               y;
+   struct timeval       timeout;
+   LDAPMessage        * res;
+   LDAPMessage        * msg;
+   struct berval     ** vals;
+   const struct berval * cached[2];
+
+   static char * attrs[] = { "modifyTimestamp", "entryCSN", NULL };
+
+   assert(ld    != NULL);
+   assert(cache != NULL);
+   assert(uri   != NULL);
+
+   cached[0] = &cache->timestamp;
+   cached[1] = &cache->csn;
+
+   // cache is never current without a stamp to compare
+   if ((strcmp(cache->uri.bv_val, uri)))
+      return(0);
+   if ( (!(cache->timestamp.bv_len)) && (!(cache->csn.bv_len)) )
+      return(0);
+
+   timeout.tv_sec    = 5;
+   timeout.tv_usec   = 0;
+   res               = NULL;
+   if (ldap_search_ext_s(ld, cache->dn.bv_val, LDAP_SCOPE_BASE, "(objectclass=*)", attrs, 0, NULL, NULL, &timeout, 0, &res) != LDAP_SUCCESS)
+   {
+      ldap_msgfree(res);
+      return(0);
+   };
+   if ((msg = ldap_first_entry(ld, res)) == NULL)
+   {
+      ldap_msgfree(res);
+      return(0);
+   };
+
+   rc = 1;
+   for(y = 0; ( (y < (sizeof(cached)/sizeof(cached[0]))) && ((rc)) ); y++)
+   {
+      if ((vals = ldap_get_values_len(ld, msg, attrs[y])) == NULL)
       {
-         if ( ((ptr = ldapschema_parse_attributetype(lsd, vals[x])) == NULL) &&
-              (lsd->errcode != LDAPSCHEMA_SCHEMA_ERROR) )
-         {
-            ldap_value_free_len(vals);
-            ldap_msgfree(res);
-            return(-1);
-         };
+         rc = (!(cached[y]->bv_len)) ? 1 : 0;
+         continue;
       };
+      if ( (vals[0]->bv_len != cached[y]->bv_len) || ((memcmp(vals[0]->bv_val, cached[y]->bv_val, cached[y]->bv_len))) )
+         rc = 0;
       ldap_value_free_len(vals);
+   };
+
+   ldap_msgfree(res);
 
-      // maps superior
-      for(idx = 0; (idx < lsd->oids_len); idx++)
+   return(rc);
+}
+
+
+/// maps superiors of attributeTypes and objectClasses and inherits the
+/// specifications of the superiors, called once after all definitions have
+/// been parsed or loaded with ldapschema_load()
+/// @param[in]    lsd         reference to schema
+///
+/// @return    Returns LDAP_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if errors were
+///            recorded while parsing or linking the schema, or an error code
+///            if memory could not be allocated.
+/// @see       ldapschema_load, ldapschema_parse, ldapschema_schema_errors
+int ldapschema_link(LDAPSchema * lsd)
+{
+   int                           err;
+   size_t                        idx;
+   size_t                        subidx;
+   size_t                        depth;
+   LDAPSchemaAlias             * alias;
+   LDAPSchemaAttributeType     * attr;
+   LDAPSchemaAttributeType     * attrsup;
+   LDAPSchemaObjectclass       * objcls;
+   LDAPSchemaObjectclass       * objclssup;
+
+   assert(lsd != NULL);
+
+   // parses definitions loaded from schema files
+   if ((lsd->pending))
+      if ( ((err = ldapschema_load_parse(lsd)) != LDAPSCHEMA_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+         return(err);
+
+   // maps superiors before inheriting specs, so that specs are inherited
+   // through the entire chain regardless of the order of the definitions
+   for(idx = 0; (idx < lsd->oids_len); idx++)
+   {
+      switch(lsd->oids[idx].model->type)
       {
-         // checks for superior
+         case LDAPSCHEMA_ATTRIBUTETYPE:
          attr = lsd->oids[idx].attributetype;
-         if (attr->model.type != LDAPSCHEMA_ATTRIBUTETYPE)
-            continue;
          if (!(attr->sup_name))
-            continue;
-         if ((alias = ldapschema_find_alias(lsd, attr->sup_name, lsd->attrs, lsd->attrs_len)) == NULL)
-         {
+            break;
+         if ((alias = ldapschema_find_alias(lsd, attr->sup_name, lsd->attrs, lsd->attrs_len, &lsd->attrs_idx)) == NULL)
             ldapschema_schema_err(lsd, &attr->model, "specified invalid superior '%s'", attr->sup_name);
-            continue;
-         };
+         else
+            attr->sup = alias->attributetype;
+         break;
 
-         // saves superior
-         attr->sup = alias->attributetype;
+         case LDAPSCHEMA_OBJECTCLASS:
+         objcls = lsd->oids[idx].objectclass;
+         if (!(objcls->sup_name))
+            break;
+         if ((alias = ldapschema_find_alias(lsd, objcls->sup_name, lsd->objclses, lsd->objclses_len, &lsd->objclses_idx)) == NULL)
+            ldapschema_schema_err(lsd, &objcls->model, "specified invalid superior '%s'", objcls->sup_name);
+         else
+            objcls->sup = alias->objectclass;
+         break;
 
-         // inherent specs from superior
-         attrsup   = attr;
-         while((attrsup = attrsup->sup) != NULL)
+         default:
+         break;
+      };
+   };
+
+   // inherent specs from superiors, inherited attributeTypes are sorted
+   // once all objectClasses are processed
+   ldapschema_bulk_begin(lsd);
+   for(idx = 0; (idx < lsd->oids_len); idx++)
+   {
+      switch(lsd->oids[idx].model->type)
+      {
+         case LDAPSCHEMA_ATTRIBUTETYPE:
+         attr    = lsd->oids[idx].attributetype;
+         attrsup = attr;
+         for(depth = 0; ( ((attrsup = attrsup->sup) != NULL) && (depth < lsd->oids_len) ); depth++)
          {
             attr->model.flags |= attrsup->model.flags;
             if (!(attr->syntax))
@@ -198,77 +431,85 @@ int ldapschema_fetch(LDAPSchema * lsd, LDAP * ld)
             if (!(attr->usage))
                attr->usage = attrsup->usage;
          };
-      };
-   };
-
-   // process objectClasses
-   if ((vals = ldap_get_values_len(ld, msg, "objectClasses")) != NULL)
-   {
-      // initial parsing of definition
-      for(x = 0; ((vals[x])); x++)
-      {
-         if ( ((ptr = ldapschema_parse_objectclass(lsd, vals[x])) == NULL) &&
-              (lsd->errcode != LDAPSCHEMA_SCHEMA_ERROR) )
-         {
-            ldap_value_free_len(vals);
-            ldap_msgfree(res);
-            return(-1);
-         };
-      };
-      ldap_value_free_len(vals);
-
-      // maps superior
-      for(idx = 0; (idx < lsd->oids_len); idx++)
-      {
-         // checks for superior
-         objcls = lsd->oids[idx].objectclass;
-         if (objcls->model.type != LDAPSCHEMA_OBJECTCLASS)
-            continue;
-         if (!(objcls->sup_name))
-            continue;
-         if ((alias = ldapschema_find_alias(lsd, objcls->sup_name, lsd->objclses, lsd->objclses_len)) == NULL)
-         {
-            ldapschema_schema_err(lsd, &objcls->model, "specified invalid superior '%s'", objcls->sup_name);
-            continue;
-         };
-
-         // saves superior
-         objcls->sup = alias->objectclass;
+         break;
 
-         // inherent specs from superior
-         objclssup   = objcls;
-         while((objclssup = objclssup->sup) != NULL)
+         case LDAPSCHEMA_OBJECTCLASS:
+         objcls    = lsd->oids[idx].objectclass;
+         objclssup = objcls;
+         for(depth = 0; ( ((objclssup = objclssup->sup) != NULL) && (depth < lsd->oids_len) ); depth++)
          {
             objcls->model.flags |= objclssup->model.flags;
-            if (!(objcls->kind))
-               objcls->kind = objclssup->kind;
             for(subidx = 0; (subidx < objclssup->may_len); subidx++)
-            {
-               if ((err = ldapschema_objectclass_attribute(lsd, objcls, objclssup->may[subidx], 0, 1)) > 0)
+               if (ldapschema_objectclass_attribute(lsd, objcls, objclssup->may[subidx], 0, 1) > 0)
                {
-                  ldap_value_free_len(vals);
-                  ldap_msgfree(res);
+                  ldapschema_bulk_end(lsd);
                   return(lsd->errcode);
                };
-            };
             for(subidx = 0; (subidx < objclssup->must_len); subidx++)
-            {
-               if ((err = ldapschema_objectclass_attribute(lsd, objcls, objclssup->must[subidx], 1, 1)) > 0)
+               if (ldapschema_objectclass_attribute(lsd, objcls, objclssup->must[subidx], 1, 1) > 0)
                {
-                  ldap_value_free_len(vals);
-                  ldap_msgfree(res);
+                  ldapschema_bulk_end(lsd);
                   return(lsd->errcode);
                };
-            };
          };
+         break;
+
+         default:
+         break;
       };
    };
 
-   ldap_msgfree(res);
+   // sorts inherited attributeTypes and indexes names and OIDs for lookups
+   if (ldapschema_bulk_end(lsd) != LDAPSCHEMA_SUCCESS)
+      return(lsd->errcode);
 
    if ((lsd->schema_errs))
       return(lsd->errcode = LDAPSCHEMA_SCHEMA_ERROR);
    return(LDAP_SUCCESS);
 }
 
+
+/// parses a single definition and adds it to the schema without linking it
+/// to its superior
+/// @param[in]    lsd         reference to schema
+/// @param[in]    type        LDAPSCHEMA_SYNTAX, LDAPSCHEMA_ATTRIBUTETYPE, or
+///                           LDAPSCHEMA_OBJECTCLASS
+/// @param[in]    def         definition as published in subschema entry
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, LDAPSCHEMA_SCHEMA_ERROR if the
+///            definition was rejected and recorded as a schema error, or an
+///            error code if memory could not be allocated.
+/// @see       ldapschema_link, ldapschema_schema_errors
+int ldapschema_parse(LDAPSchema * lsd, int type, const struct berval * def)
+{
+   void * ptr;
+
+   assert(lsd != NULL);
+   assert(def != NULL);
+
+   switch(type)
+   {
+      case LDAPSCHEMA_SYNTAX:
+      ptr = ldapschema_parse_syntax(lsd, def);
+      break;
+
+      case LDAPSCHEMA_ATTRIBUTETYPE:
+      ptr = ldapschema_parse_attributetype(lsd, def);
+      break;
+
+      case LDAPSCHEMA_OBJECTCLASS:
+      ptr = ldapschema_parse_objectclass(lsd, def);
+      break;
+
+      default:
+      return(lsd->errcode = LDAPSCHEMA_UNKNOWN_FIELD);
+   };
+
+   if ((ptr))
+      return(LDAPSCHEMA_SUCCESS);
+   if (lsd->errcode == LDAPSCHEMA_SCHEMA_ERROR)
+      return(LDAPSCHEMA_SCHEMA_ERROR);
+   return(((lsd->errcode)) ? lsd->errcode : LDAPSCHEMA_NO_MEMORY);
+}
+
 /* end of source file */
@@ -62,5 +62,18 @@
 //////////////////
 #pragma mark - Prototypes
 
+int
+ldapschema_fetch_entry(
+         LDAPSchema               * lsd,
+         LDAP                     * ld,
+         const char               * uri,
+         LDAPSchemaCache          * cache );
+
+int
+ldapschema_fetch_fresh(
+         LDAP                     * ld,
+         const LDAPSchemaCache    * cache,
+         const char               * uri );
+
 
 #endif /* end of header file */
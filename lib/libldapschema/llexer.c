@@ -167,7 +167,17 @@ int ldapschema_definition_split(LDAPSchema * lsd, LDAPSchemaModel * mod,
 
    // finds opening and ending parentheses
    for(bol = 0; ((bol < strlen) && (str[bol] != '(')); bol++);
-   for(eol = strlen-1; ((eol > bol) && (str[eol] != ')')); eol--);
+   for(eol = strlen; ((eol > bol) && (str[eol-1] != ')')); eol--);
+   eol = (eol > bol) ? eol - 1 : bol;
+
+   // checks for required formatting
+   if ( (bol >= strlen) || (eol <= bol) || (str[eol] != ')') )
+   {
+      if ( (!(mod)) || (!(mod->definition)) )
+         ldapschema_schema_err(lsd, mod, "definition: %.*s", (int)strlen, str);
+      ldapschema_schema_err(lsd, mod, "invalid LDAP definition syntax");
+      return(-1);
+   };
 
    // allocates mutable string
    line_len = (eol - bol - 1); // adjusts for beginning of line>
@@ -179,16 +189,6 @@ int ldapschema_definition_split(LDAPSchema * lsd, LDAPSchemaModel * mod,
    strncpy(line, &str[bol+1], line_len);
    line[line_len] = '\0';
 
-   // checks for required formatting
-   if ( (str[bol] != '(') || (eol <= bol) || (str[eol] != ')') )
-   {
-      if ( (!(mod)) || (!(mod->desc)) )
-         ldapschema_schema_err(lsd, mod, "definition: %s", line);
-      ldapschema_schema_err(lsd, mod, "invalid LDAP definition syntax");
-      free(line);
-      return(-1);
-   };
-
    // initializes argument list
    if ((argv = malloc(sizeof(char *))) == NULL)
    {
@@ -231,7 +231,7 @@ int ldapschema_definition_split(LDAPSchema * lsd, LDAPSchemaModel * mod,
             {
                free(line);
                ldapschema_value_free(argv);
-               lsd->errcode = LDAPSCHEMA_SCHEMA_ERROR;
+               ldapschema_schema_err(lsd, mod, "invalid LDAP definition syntax");
                return(-1);
             };
 
@@ -255,15 +255,8 @@ int ldapschema_definition_split(LDAPSchema * lsd, LDAPSchemaModel * mod,
             // stores beginning of segment
             bos = pos;
 
-            // finds end of line segment
-            for(pos = pos+1; ((line[pos] != ' ') && (line[pos] != '\0')); pos++);
-            if (line[pos] == '\0')
-            {
-               free(line);
-               ldapschema_value_free(argv);
-               lsd->errcode = LDAPSCHEMA_SCHEMA_ERROR;
-               return(-1);
-            };
+            // finds end of line segment, which may end the line
+            for(pos = pos+1; ((line[pos] != ' ') && (line[pos] != '\t') && (line[pos] != '\0')); pos++);
             line[pos] = '\0';
 
             // adds argument to argv
@@ -351,9 +344,9 @@ int ldapschema_objectclass_attribute(LDAPSchema * lsd,
    };
 
    // adds to objectClass
-   if ((err = ldapschema_insert(lsd, (void ***)attr_listp,   attr_lenp, objcls, ldapschema_compar_objectclasses)) > 0)
+   if ((err = ldapschema_add(lsd, (void ***)attr_listp,   attr_lenp, objcls, ldapschema_compar_objectclasses)) > 0)
       return(err);
-   if ((err = ldapschema_insert(lsd, (void ***)objcls_listp, objcls_lenp, attr, ldapschema_compar_attributetypes)) > 0)
+   if ((err = ldapschema_add(lsd, (void ***)objcls_listp, objcls_lenp, attr, ldapschema_compar_attributetypes)) > 0)
       return(err);
 
    // exits with insert err if not inherited
@@ -487,30 +480,38 @@ LDAPSchemaAttributeType * ldapschema_parse_attributetype(LDAPSchema * lsd, const
    if ((attr = ldapschema_attributetype_initialize(lsd)) == NULL)
       return(NULL);
 
+   // copy definition into syntax, definition is reported by schema errors
+   if ((attr->model.definition = malloc(def->bv_len+1)) == NULL)
+   {
+      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      ldapschema_attributetype_free(attr);
+      return(NULL);
+   };
+   memcpy(attr->model.definition, def->bv_val, def->bv_len);
+   attr->model.definition[def->bv_len] = '\0';
+
    // parses definition
    if ((argc = ldapschema_definition_split_len(lsd, &attr->model, def, &argv)) == -1)
    {
       ldapschema_attributetype_free(attr);
       return(NULL);
    };
-
-   // copy definition and oid into syntax
-   if ((attr->model.oid = strdup(argv[0])) == NULL)
+   if (argc < 1)
    {
-      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      ldapschema_schema_err(lsd, &attr->model, "invalid LDAP definition syntax");
       ldapschema_value_free(argv);
       ldapschema_attributetype_free(attr);
       return(NULL);
    };
-   if ((attr->model.definition = malloc(def->bv_len+1)) == NULL)
+
+   // copy oid into syntax
+   if ((attr->model.oid = strdup(argv[0])) == NULL)
    {
       lsd->errcode = LDAPSCHEMA_NO_MEMORY;
       ldapschema_value_free(argv);
       ldapschema_attributetype_free(attr);
       return(NULL);
    };
-   memcpy(attr->model.definition, def->bv_val, def->bv_len);
-   attr->model.definition[def->bv_len] = '\0';
 
    // processes attribute definition
    for(pos = 1; pos < argc; pos++)
@@ -689,44 +690,60 @@ LDAPSchemaAttributeType * ldapschema_parse_attributetype(LDAPSchema * lsd, const
    // adds specification to syntax
    attr->model.spec = ldapschema_spec_search(attr->model.oid);
 
-   // adds syntax into OID list
-   if ((ldapschema_insert(lsd, (void ***)&lsd->oids, &lsd->oids_len, attr, ldapschema_compar_models)) != LDAP_SUCCESS)
+   // adds attributeType into OID list
+   if ((err = ldapschema_add(lsd, (void ***)&lsd->oids, &lsd->oids_len, attr, ldapschema_compar_models)) > 0)
    {
       ldapschema_attributetype_free(attr);
       return(NULL);
    };
+   if (err == -1)
+   {
+      ldapschema_schema_err(lsd,  &attr->model, "LDAP definition defines duplicate OID '%s'", attr->model.oid);
+      if ((err = ldapschema_append(lsd,(void ***)&lsd->dups, &lsd->dups_len, attr)) != LDAP_SUCCESS)
+      {
+         ldapschema_attributetype_free(attr);
+         return(NULL);
+      };
+      return(attr);
+   };
 
    // adds attributeType into attributeType list using OID and names
-   if ((alias = malloc(sizeof(LDAPSchemaAlias *))) == NULL)
+   if ((alias = malloc(sizeof(LDAPSchemaAlias))) == NULL)
    {
       lsd->errcode = LDAPSCHEMA_NO_MEMORY;
       return(NULL);
    };
    alias->alias         = attr->model.oid;
    alias->attributetype = attr;
-   if ((err = ldapschema_insert(lsd, (void ***)&lsd->attrs, &lsd->attrs_len, alias, ldapschema_compar_aliases)) > 0)
+   if ((err = ldapschema_add(lsd, (void ***)&lsd->attrs, &lsd->attrs_len, alias, ldapschema_compar_aliases)) > 0)
    {
       free(alias);
       return(NULL);
    };
    if (err == -1)
-      ldapschema_schema_err(lsd,  &attr->model, " attributeType with duplicate oid '%s' found", attr->model.oid);
+   {
+      ldapschema_schema_err(lsd,  &attr->model, "attributeType with duplicate oid '%s' found", attr->model.oid);
+      free(alias);
+   };
    for(pos = 0; (size_t)pos < attr->names_len; pos++)
    {
-      if ((alias = malloc(sizeof(LDAPSchemaAlias *))) == NULL)
+      if ((alias = malloc(sizeof(LDAPSchemaAlias))) == NULL)
       {
          lsd->errcode = LDAPSCHEMA_NO_MEMORY;
          return(NULL);
       };
       alias->alias         = attr->names[pos];
       alias->attributetype = attr;
-      if ((ldapschema_insert(lsd, (void ***)&lsd->attrs, &lsd->attrs_len, alias, ldapschema_compar_aliases)) > 0)
+      if ((err = ldapschema_add(lsd, (void ***)&lsd->attrs, &lsd->attrs_len, alias, ldapschema_compar_aliases)) > 0)
       {
          free(alias);
          return(NULL);
       };
       if (err == -1)
-         ldapschema_schema_err(lsd,  &attr->model, " attributeType with duplicate name '%s' found", attr->names[pos]);
+      {
+         ldapschema_schema_err(lsd,  &attr->model, "attributeType with duplicate name '%s' found", attr->names[pos]);
+         free(alias);
+      };
    };
 
    return(attr);
@@ -837,40 +854,52 @@ LDAPSchemaObjectclass * ldapschema_parse_objectclass(LDAPSchema * lsd, const str
    int64_t                             pos;
    int                                 argc;
    int                                 err;
+   const char                        * must;
+   const char                        * may;
    LDAPSchemaObjectclass             * objcls;
    LDAPSchemaAlias                   * alias;
 
    objcls   = NULL;
    argv     = NULL;
+   must     = NULL;
+   may      = NULL;
 
    // initialize objectClass
    if ((objcls = ldapschema_objectclass_initialize(lsd)) == NULL)
       return(NULL);
 
+   // copy definition into syntax, definition is reported by schema errors
+   if ((objcls->model.definition = malloc(def->bv_len+1)) == NULL)
+   {
+      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      ldapschema_objectclass_free(objcls);
+      return(NULL);
+   };
+   memcpy(objcls->model.definition, def->bv_val, def->bv_len);
+   objcls->model.definition[def->bv_len] = '\0';
+
    // parses definition
    if ((argc = ldapschema_definition_split_len(lsd, &objcls->model, def, &argv)) == -1)
    {
       ldapschema_objectclass_free(objcls);
       return(NULL);
    };
-
-   // copy definition and oid into syntax
-   if ((objcls->model.oid = strdup(argv[0])) == NULL)
+   if (argc < 1)
    {
-      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      ldapschema_schema_err(lsd, &objcls->model, "invalid LDAP definition syntax");
       ldapschema_value_free(argv);
       ldapschema_objectclass_free(objcls);
       return(NULL);
    };
-   if ((objcls->model.definition = malloc(def->bv_len+1)) == NULL)
+
+   // copy oid into syntax
+   if ((objcls->model.oid = strdup(argv[0])) == NULL)
    {
       lsd->errcode = LDAPSCHEMA_NO_MEMORY;
       ldapschema_value_free(argv);
       ldapschema_objectclass_free(objcls);
       return(NULL);
    };
-   memcpy(objcls->model.definition, def->bv_val, def->bv_len);
-   objcls->model.definition[def->bv_len] = '\0';
 
    // processes attribute definition
    for(pos = 1; pos < argc; pos++)
@@ -976,31 +1005,28 @@ LDAPSchemaObjectclass * ldapschema_parse_objectclass(LDAPSchema * lsd, const str
       }
       else if (!(strcasecmp(argv[pos], "AUXILIARY")))
       {
-         objcls->kind = LDAPSCHEMA_STRUCTURAL;
+         objcls->kind = LDAPSCHEMA_AUXILIARY;
       }
 
-      // inteprets MUST
+      // inteprets MUST, attributeTypes are added once the objectClass is
+      // accepted, so that rejected objectClasses are not referenced
       else if (!(strcasecmp(argv[pos], "MUST")))
       {
          pos++;
-         if ((err = ldapschema_parse_objectclass_attrs(lsd, "MUST", objcls, argv[pos], 1)) > 0)
-         {
-            ldapschema_value_free(argv);
-            ldapschema_objectclass_free(objcls);
-            return(NULL);
-         };
+         if ((must))
+            ldapschema_schema_err(lsd,  &objcls->model, "LDAP definition contains duplicate '%s'", "MUST");
+         else
+            must = argv[pos];
       }
 
       // inteprets MAY
       else if (!(strcasecmp(argv[pos], "MAY")))
       {
          pos++;
-         if ((err = ldapschema_parse_objectclass_attrs(lsd, "MAY", objcls, argv[pos], 0)) > 0)
-         {
-            ldapschema_value_free(argv);
-            ldapschema_objectclass_free(objcls);
-            return(NULL);
-         };
+         if ((may))
+            ldapschema_schema_err(lsd,  &objcls->model, "LDAP definition contains duplicate '%s'", "MAY");
+         else
+            may = argv[pos];
       }
 
       // handle unknown parameters
@@ -1012,58 +1038,75 @@ LDAPSchemaObjectclass * ldapschema_parse_objectclass(LDAPSchema * lsd, const str
          return(NULL);
       };
    };
-   ldapschema_value_free(argv);
 
    // adds specification to syntax
    objcls->model.spec = ldapschema_spec_search(objcls->model.oid);
 
    // adds objectClass into OID list
-   if ((err = ldapschema_insert(lsd, (void ***)&lsd->oids, &lsd->oids_len, objcls, ldapschema_compar_models)) > 0)
+   if ((err = ldapschema_add(lsd, (void ***)&lsd->oids, &lsd->oids_len, objcls, ldapschema_compar_models)) > 0)
    {
+      ldapschema_value_free(argv);
       ldapschema_objectclass_free(objcls);
       return(NULL);
    };
    if (err == -1)
    {
       ldapschema_schema_err(lsd,  &objcls->model, "LDAP definition defines duplicate OID '%s'", objcls->model.oid);
+      ldapschema_value_free(argv);
       if ((err = ldapschema_append(lsd,(void ***)&lsd->dups, &lsd->dups_len, objcls)) != LDAP_SUCCESS)
       {
          ldapschema_objectclass_free(objcls);
          return(NULL);
       };
+      return(objcls);
    };
 
+   // adds attributeTypes to objectClass and objectClass to attributeTypes
+   if ((must))
+      err = ldapschema_parse_objectclass_attrs(lsd, "MUST", objcls, must, 1);
+   if ( ((may)) && (err <= 0) )
+      err = ldapschema_parse_objectclass_attrs(lsd, "MAY", objcls, may, 0);
+   ldapschema_value_free(argv);
+   if (err > 0)
+      return(NULL);
+
    // adds objectclass into objectclass list using OID and names
-   if ((alias = malloc(sizeof(LDAPSchemaAlias *))) == NULL)
+   if ((alias = malloc(sizeof(LDAPSchemaAlias))) == NULL)
    {
       lsd->errcode = LDAPSCHEMA_NO_MEMORY;
       return(NULL);
    };
    alias->alias         = objcls->model.oid;
    alias->objectclass   = objcls;
-   if ((err = ldapschema_insert(lsd, (void ***)&lsd->objclses, &lsd->objclses_len, alias, ldapschema_compar_aliases)) > 0)
+   if ((err = ldapschema_add(lsd, (void ***)&lsd->objclses, &lsd->objclses_len, alias, ldapschema_compar_aliases)) > 0)
    {
       free(alias);
       return(NULL);
    };
    if (err == -1)
-      ldapschema_schema_err(lsd,  &objcls->model, " objectClasses with duplicate oid '%s' found", objcls->model.oid);
+   {
+      ldapschema_schema_err(lsd,  &objcls->model, "objectClass with duplicate oid '%s' found", objcls->model.oid);
+      free(alias);
+   };
    for(pos = 0; (size_t)pos < objcls->names_len; pos++)
    {
-      if ((alias = malloc(sizeof(LDAPSchemaAlias *))) == NULL)
+      if ((alias = malloc(sizeof(LDAPSchemaAlias))) == NULL)
       {
          lsd->errcode = LDAPSCHEMA_NO_MEMORY;
          return(NULL);
       };
       alias->alias         = objcls->names[pos];
       alias->objectclass   = objcls;
-      if ((err = ldapschema_insert(lsd, (void ***)&lsd->objclses, &lsd->objclses_len, alias, ldapschema_compar_aliases)) > 0)
+      if ((err = ldapschema_add(lsd, (void ***)&lsd->objclses, &lsd->objclses_len, alias, ldapschema_compar_aliases)) > 0)
       {
          free(alias);
          return(NULL);
       };
       if (err == -1)
-         ldapschema_schema_err(lsd,  &objcls->model, " objectClasses with duplicate name '%s' found", objcls->names[pos]);
+      {
+         ldapschema_schema_err(lsd,  &objcls->model, "objectClass with duplicate name '%s' found", objcls->names[pos]);
+         free(alias);
+      };
    };
 
    return(objcls);
@@ -1084,13 +1127,6 @@ int ldapschema_parse_objectclass_attrs(LDAPSchema * lsd, const char * field,
    assert(objcls  != NULL);
    assert(liststr != NULL);
 
-   // checks for preexisting attribute list
-   if ( (((must)) && ((objcls->must))) || ((!(must)) && ((objcls->may))) )
-   {
-      ldapschema_schema_err(lsd,  &objcls->model, "LDAP definition contains duplicate '%s'", field);
-      return(0);
-   };
-
    // generate list of attributes
    if (liststr[0] == '(')
    {
@@ -1114,7 +1150,7 @@ int ldapschema_parse_objectclass_attrs(LDAPSchema * lsd, const char * field,
    // adds attribute to objectclass and objectclass to attribute
    for(idx = 0; idx < attrnames_len; idx++)
    {
-      if ((alias = ldapschema_find_alias(lsd, attrnames[idx], lsd->attrs, lsd->attrs_len)) == NULL)
+      if ((alias = ldapschema_find_alias(lsd, attrnames[idx], lsd->attrs, lsd->attrs_len, &lsd->attrs_idx)) == NULL)
       {
          ldapschema_schema_err(lsd,  &objcls->model, "'%s' contains invalid attributeType '%s'", field, attrnames[idx]);
          lsd->errcode = LDAPSCHEMA_SCHEMA_ERROR;
@@ -1192,30 +1228,38 @@ LDAPSchemaSyntax * ldapschema_parse_syntax(LDAPSchema * lsd, const struct berval
    if ((syntax = ldapschema_syntax_initialize(lsd)) == NULL)
       return(syntax);
 
+   // copy definition into syntax, definition is reported by schema errors
+   if ((syntax->model.definition = malloc(def->bv_len+1)) == NULL)
+   {
+      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      ldapschema_syntax_free(syntax);
+      return(NULL);
+   };
+   memcpy(syntax->model.definition, def->bv_val, def->bv_len);
+   syntax->model.definition[def->bv_len] = '\0';
+
    // parses definition
    if ((argc = ldapschema_definition_split_len(lsd, &syntax->model, def, &argv)) == -1)
    {
       ldapschema_syntax_free(syntax);
       return(NULL);
    };
-
-   // copy definition and oid into syntax
-   if ((syntax->model.oid = strdup(argv[0])) == NULL)
+   if (argc < 1)
    {
-      lsd->errcode = LDAPSCHEMA_NO_MEMORY;
+      ldapschema_schema_err(lsd, &syntax->model, "invalid LDAP definition syntax");
       ldapschema_value_free(argv);
       ldapschema_syntax_free(syntax);
       return(NULL);
    };
-   if ((syntax->model.definition = malloc(def->bv_len+1)) == NULL)
+
+   // copy oid into syntax
+   if ((syntax->model.oid = strdup(argv[0])) == NULL)
    {
       lsd->errcode = LDAPSCHEMA_NO_MEMORY;
       ldapschema_value_free(argv);
       ldapschema_syntax_free(syntax);
       return(NULL);
    };
-   memcpy(syntax->model.definition, def->bv_val, def->bv_len);
-   syntax->model.definition[def->bv_len] = '\0';
 
    // processes attribute definition
    for(pos = 1; pos < argc; pos++)
@@ -1279,47 +1323,66 @@ LDAPSchemaSyntax * ldapschema_parse_syntax(LDAPSchema * lsd, const struct berval
       {
          regfree(&syntax->re);
          bzero(&syntax->re, sizeof(syntax->re));
+      } else
+      {
+         syntax->re_compiled = 1;
       };
    };
 
    // adds syntax into OID list
-   if ((ldapschema_insert(lsd, (void ***)&lsd->oids, &lsd->oids_len, syntax, ldapschema_compar_models)) != LDAP_SUCCESS)
+   if ((err = ldapschema_add(lsd, (void ***)&lsd->oids, &lsd->oids_len, syntax, ldapschema_compar_models)) > 0)
    {
       ldapschema_syntax_free(syntax);
       return(NULL);
    };
+   if (err == -1)
+   {
+      ldapschema_schema_err(lsd,  &syntax->model, "LDAP definition defines duplicate OID '%s'", syntax->model.oid);
+      if ((err = ldapschema_append(lsd,(void ***)&lsd->dups, &lsd->dups_len, syntax)) != LDAP_SUCCESS)
+      {
+         ldapschema_syntax_free(syntax);
+         return(NULL);
+      };
+      return(syntax);
+   };
 
    // adds syntax into syntax list using OID and desc
-   if ((alias = malloc(sizeof(LDAPSchemaAlias *))) == NULL)
+   if ((alias = malloc(sizeof(LDAPSchemaAlias))) == NULL)
    {
       lsd->errcode = LDAPSCHEMA_NO_MEMORY;
       return(NULL);
    };
    alias->alias  = syntax->model.oid;
    alias->syntax = syntax;
-   if ((err = ldapschema_insert(lsd, (void ***)&lsd->syntaxes, &lsd->syntaxes_len, alias, ldapschema_compar_aliases)) > 0)
+   if ((err = ldapschema_add(lsd, (void ***)&lsd->syntaxes, &lsd->syntaxes_len, alias, ldapschema_compar_aliases)) > 0)
    {
       free(alias);
       return(NULL);
    };
    if (err == -1)
-      ldapschema_schema_err(lsd,  &syntax->model, " ldapSyntax with duplicate oid '%s' found", syntax->model.oid);
+   {
+      ldapschema_schema_err(lsd,  &syntax->model, "ldapSyntax with duplicate oid '%s' found", syntax->model.oid);
+      free(alias);
+   };
    if ((syntax->model.desc))
    {
-      if ((alias = malloc(sizeof(LDAPSchemaAlias *))) == NULL)
+      if ((alias = malloc(sizeof(LDAPSchemaAlias))) == NULL)
       {
          lsd->errcode = LDAPSCHEMA_NO_MEMORY;
          return(NULL);
       };
       alias->alias  = syntax->model.desc;
       alias->syntax = syntax;
-      if ((ldapschema_insert(lsd, (void ***)&lsd->syntaxes, &lsd->syntaxes_len, alias, ldapschema_compar_aliases)) > 0)
+      if ((err = ldapschema_add(lsd, (void ***)&lsd->syntaxes, &lsd->syntaxes_len, alias, ldapschema_compar_aliases)) > 0)
       {
          free(alias);
          return(NULL);
       };
       if (err == -1)
-         ldapschema_schema_err(lsd,  &syntax->model, " ldapSyntax with duplicate desc '%s' found", syntax->model.desc);
+      {
+         ldapschema_schema_err(lsd,  &syntax->model, "ldapSyntax with duplicate desc '%s' found", syntax->model.desc);
+         free(alias);
+      };
    };
 
 
@@ -49,6 +49,10 @@
 #include <strings.h>
 #include <stdlib.h>
 
+#include "lerror.h"
+#include "lfile.h"
+#include "lquery.h"
+#include "lsort.h"
 #include "lspec.h"
 
 
@@ -59,23 +63,42 @@
 /////////////////
 #pragma mark - Functions
 
-int ldapschema_append(LDAPSchema * lsd, void *** listp, size_t * lenp, void * obj)
+/// adds object to sorted array, or appends object to end of array while
+/// definitions are loaded in bulk
+/// @param[in]  lsd        reference to allocated ldap_schema struct
+/// @param[in]  listp      reference to sorted array to manipulate
+/// @param[in]  lenp       reference to length of array
+/// @param[in]  obj        reference to object to add to array
+/// @param[in]  compar     reference to compare function used to determine
+///                        object's position within the list.
+///
+/// @return    If successfull, returns 0.  If duplicate, returns -1. Otherwise
+///            errcode is set and the value is return.  Duplicates of objects
+///            appended in bulk are reported by ldapschema_bulk_end().
+/// @see       ldapschema_bulk_begin, ldapschema_insert
+int ldapschema_add(LDAPSchema * lsd, void *** listp, size_t * lenp, void * obj, int (*compar)(const void *, const void *))
 {
-   void        ** list;
-   size_t         size;
+   assert(lsd != NULL);
+
+   if ((lsd->bulk))
+      return(ldapschema_append(lsd, listp, lenp, obj));
+
+   return(ldapschema_insert(lsd, listp, lenp, obj, compar));
+}
+
 
+int ldapschema_append(LDAPSchema * lsd, void *** listp, size_t * lenp, void * obj)
+{
    assert(lsd    != NULL);
    assert(listp  != NULL);
    assert(lenp   != NULL);
    assert(obj    != NULL);
 
    // increase size of array
-   size = sizeof(void *) * ((*lenp) + 2);
-   if ((list = realloc(*listp, size)) == NULL)
-      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
-   *listp        = list;
-   list[*lenp+0] = obj;
-   list[*lenp+1] = NULL;
+   if (ldapschema_grow(lsd, listp, *lenp) != LDAPSCHEMA_SUCCESS)
+      return(lsd->errcode);
+   (*listp)[*lenp+0] = obj;
+   (*listp)[*lenp+1] = NULL;
    (*lenp)++;
 
    return(LDAPSCHEMA_SUCCESS);
@@ -88,6 +111,19 @@ void ldapschema_attributetype_free( LDAPSchemaAttributeType  * attr )
 
    ldapschema_object_free(&attr->model);
 
+   if ((attr->sup_name))
+      free(attr->sup_name);
+
+   if ((attr->names))
+      ldapschema_value_free(attr->names);
+
+   if ((attr->allowed_by))
+      free(attr->allowed_by);
+   if ((attr->required_by))
+      free(attr->required_by);
+
+   free(attr);
+
    return;
 }
 
@@ -111,6 +147,216 @@ LDAPSchemaAttributeType * ldapschema_attributetype_initialize(LDAPSchema * lsd)
 }
 
 
+/// sorts array of aliases appended in bulk, discards aliases of definitions
+/// with duplicate OIDs and reports aliases used by more than one definition
+/// @param[in]  lsd        reference to allocated ldap_schema struct
+/// @param[in]  list       array of aliases
+/// @param[in]  lenp       reference to length of array
+/// @param[in]  type       type of definitions used in errors
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_bulk_end
+int ldapschema_bulk_aliases(LDAPSchema * lsd, LDAPSchemaAlias ** list,
+   size_t * lenp, const char * type)
+{
+   int                  err;
+   size_t               x;
+   size_t               len;
+   const char         * field;
+   LDAPSchemaAlias    * alias;
+
+   assert(lsd  != NULL);
+   assert(lenp != NULL);
+   assert(type != NULL);
+
+   if ((err = ldapschema_sort(lsd, (void **)list, *lenp, ldapschema_compar_aliases)) != LDAPSCHEMA_SUCCESS)
+      return(err);
+
+   for(x = 0, len = 0; (x < *lenp); x++)
+   {
+      alias = list[x];
+
+      // discards aliases of definitions moved to duplicates
+      if (ldapschema_oid(lsd, alias->model->oid, 0) != alias->model)
+      {
+         free(alias);
+         continue;
+      };
+
+      // keeps alias of first definition
+      if ( ((len)) && (!(ldapschema_compar_aliases(&list[len-1], &alias))) )
+      {
+         if (alias->alias == alias->model->oid)
+            field = "oid";
+         else
+            field = (alias->model->type == LDAPSCHEMA_SYNTAX) ? "desc" : "name";
+         ldapschema_schema_err(lsd, alias->model, "%s with duplicate %s '%s' found", type, field, alias->alias);
+         free(alias);
+         continue;
+      };
+
+      list[len++] = alias;
+   };
+   if ((list))
+      list[len] = NULL;
+   *lenp = len;
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// appends objects to arrays without sorting until ldapschema_bulk_end() is
+/// called, so that loading a schema does not shift arrays for each
+/// definition
+/// @param[in]  lsd        reference to allocated ldap_schema struct
+///
+/// @see       ldapschema_add, ldapschema_bulk_end
+void ldapschema_bulk_begin(LDAPSchema * lsd)
+{
+   assert(lsd        != NULL);
+   assert(lsd->bulk  == 0);
+
+   // OIDs added before bulk loading remain sorted and searchable
+   lsd->bulk         = 1;
+   lsd->oids_sorted  = lsd->oids_len;
+
+   return;
+}
+
+
+/// sorts arrays appended in bulk and reports duplicates, the first
+/// definition of an OID or name is kept
+/// @param[in]  lsd        reference to allocated ldap_schema struct
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_add, ldapschema_bulk_begin
+int ldapschema_bulk_end(LDAPSchema * lsd)
+{
+   int                           rc;
+   int                           err;
+   size_t                        x;
+   size_t                        len;
+   LDAPSchemaModel             * model;
+   LDAPSchemaAttributeType     * attr;
+   LDAPSchemaObjectclass       * objcls;
+
+   assert(lsd != NULL);
+
+   rc        = LDAPSCHEMA_SUCCESS;
+   lsd->bulk = 0;
+
+   // sorts OIDs and moves definitions with duplicate OIDs to duplicates
+   if ((err = ldapschema_sort(lsd, (void **)lsd->oids, lsd->oids_len, ldapschema_compar_models)) != LDAPSCHEMA_SUCCESS)
+      return(err);
+   for(x = 0, len = 0; (x < lsd->oids_len); x++)
+   {
+      model = lsd->oids[x].model;
+      if ( ((len)) && (!(ldapschema_compar_models(&lsd->oids[len-1], &lsd->oids[x]))) )
+      {
+         ldapschema_schema_err(lsd, model, "LDAP definition defines duplicate OID '%s'", model->oid);
+         if ((err = ldapschema_append(lsd, (void ***)&lsd->dups, &lsd->dups_len, model)) == LDAPSCHEMA_SUCCESS)
+            continue;
+         rc = err;
+      };
+      lsd->oids[len++].model = model;
+   };
+   lsd->oids[len].model = NULL;
+   lsd->oids_len        = len;
+
+   // sorts aliases
+   if ((err = ldapschema_bulk_aliases(lsd, lsd->syntaxes, &lsd->syntaxes_len, "ldapSyntax")) != LDAPSCHEMA_SUCCESS)
+      return(err);
+   if ((err = ldapschema_bulk_aliases(lsd, lsd->attrs, &lsd->attrs_len, "attributeType")) != LDAPSCHEMA_SUCCESS)
+      return(err);
+   if ((err = ldapschema_bulk_aliases(lsd, lsd->objclses, &lsd->objclses_len, "objectClass")) != LDAPSCHEMA_SUCCESS)
+      return(err);
+
+   // indexes names and OIDs for lookups
+   if ((err = ldapschema_index(lsd)) != LDAPSCHEMA_SUCCESS)
+      return(err);
+
+   // sorts attributeTypes of objectClasses and objectClasses of attributeTypes
+   for(x = 0; (x < lsd->oids_len); x++)
+   {
+      switch(lsd->oids[x].model->type)
+      {
+         case LDAPSCHEMA_ATTRIBUTETYPE:
+         attr = lsd->oids[x].attributetype;
+         if ((err = ldapschema_bulk_list(lsd, (void **)attr->allowed_by, &attr->allowed_by_len, ldapschema_compar_objectclasses, NULL, NULL)) != LDAPSCHEMA_SUCCESS)
+            return(err);
+         if ((err = ldapschema_bulk_list(lsd, (void **)attr->required_by, &attr->required_by_len, ldapschema_compar_objectclasses, NULL, NULL)) != LDAPSCHEMA_SUCCESS)
+            return(err);
+         break;
+
+         case LDAPSCHEMA_OBJECTCLASS:
+         objcls = lsd->oids[x].objectclass;
+         if ((err = ldapschema_bulk_list(lsd, (void **)objcls->must, &objcls->must_len, ldapschema_compar_attributetypes, &objcls->model, "MUST")) != LDAPSCHEMA_SUCCESS)
+            return(err);
+         if ((err = ldapschema_bulk_list(lsd, (void **)objcls->may, &objcls->may_len, ldapschema_compar_attributetypes, &objcls->model, "MAY")) != LDAPSCHEMA_SUCCESS)
+            return(err);
+         if ((err = ldapschema_bulk_list(lsd, (void **)objcls->inherit_must, &objcls->inherit_must_len, ldapschema_compar_attributetypes, NULL, NULL)) != LDAPSCHEMA_SUCCESS)
+            return(err);
+         if ((err = ldapschema_bulk_list(lsd, (void **)objcls->inherit_may, &objcls->inherit_may_len, ldapschema_compar_attributetypes, NULL, NULL)) != LDAPSCHEMA_SUCCESS)
+            return(err);
+         break;
+
+         default:
+         break;
+      };
+   };
+
+   return(rc);
+}
+
+
+/// sorts array appended in bulk and discards duplicates
+/// @param[in]  lsd        reference to allocated ldap_schema struct
+/// @param[in]  list       array to sort
+/// @param[in]  lenp       reference to length of array
+/// @param[in]  compar     reference to compare function
+/// @param[in]  mod        objectClass to which duplicate attributeTypes are
+///                        reported, or NULL if duplicates are discarded
+///                        silently
+/// @param[in]  field      field of objectClass containing the array
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_bulk_end
+int ldapschema_bulk_list(LDAPSchema * lsd, void ** list, size_t * lenp,
+   int (*compar)(const void *, const void *), LDAPSchemaModel * mod,
+   const char * field)
+{
+   int                           err;
+   size_t                        x;
+   size_t                        len;
+   LDAPSchemaAttributeType     * attr;
+
+   assert(lsd  != NULL);
+   assert(lenp != NULL);
+
+   if ((err = ldapschema_sort(lsd, list, *lenp, compar)) != LDAPSCHEMA_SUCCESS)
+      return(err);
+
+   for(x = 0, len = 0; (x < *lenp); x++)
+   {
+      if ( ((len)) && (!(compar(&list[len-1], &list[x]))) )
+      {
+         if ((mod))
+         {
+            attr = list[x];
+            ldapschema_schema_err(lsd, mod, "'%s' contains duplicate attributeType '%s'", field, ((attr->names)) ? attr->names[0] : attr->model.oid);
+         };
+         continue;
+      };
+      list[len++] = list[x];
+   };
+   if ((list))
+      list[len] = NULL;
+   *lenp = len;
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
 /// counts number of values in list
 /// @param[in]  vals   Reference to allocated ldap_schema struct
 ///
@@ -237,6 +483,23 @@ void ldapschema_free(LDAPSchema * lsd)
    };
    lsd->attrs = NULL;
 
+   // frees objectClasses list
+   if ((lsd->objclses))
+   {
+      for(pos = 0; pos < lsd->objclses_len; pos++)
+         free(lsd->objclses[pos]);
+      free(lsd->objclses);
+   };
+   lsd->objclses = NULL;
+
+   // frees hash tables of names
+   if ((lsd->syntaxes_idx.names))
+      free(lsd->syntaxes_idx.names);
+   if ((lsd->attrs_idx.names))
+      free(lsd->attrs_idx.names);
+   if ((lsd->objclses_idx.names))
+      free(lsd->objclses_idx.names);
+
    if ((lsd->schema_errs))
       ldapschema_value_free(lsd->schema_errs);
 
@@ -251,6 +514,10 @@ void ldapschema_free(LDAPSchema * lsd)
             ldapschema_attributetype_free(lsd->oids[i].attributetype);
             break;
 
+            case LDAPSCHEMA_OBJECTCLASS:
+            ldapschema_objectclass_free(lsd->oids[i].objectclass);
+            break;
+
             case LDAPSCHEMA_SYNTAX:
             ldapschema_syntax_free(lsd->oids[i].syntax);
             break;
@@ -273,6 +540,10 @@ void ldapschema_free(LDAPSchema * lsd)
             ldapschema_attributetype_free(lsd->dups[i].attributetype);
             break;
 
+            case LDAPSCHEMA_OBJECTCLASS:
+            ldapschema_objectclass_free(lsd->dups[i].objectclass);
+            break;
+
             case LDAPSCHEMA_SYNTAX:
             ldapschema_syntax_free(lsd->dups[i].syntax);
             break;
@@ -282,16 +553,49 @@ void ldapschema_free(LDAPSchema * lsd)
             break;
          };
       };
-      free(lsd->oids);
-      lsd->oids = NULL;
+      free(lsd->dups);
+      lsd->dups = NULL;
    };
 
+   // frees definitions of schema files which were not parsed
+   ldapschema_load_free(lsd);
+
    free(lsd);
 
    return;
 }
 
 
+/// grows array so that another object and the terminating NULL fit, arrays
+/// are allocated in powers of two so that appending is amortized
+/// @param[in]  lsd        reference to allocated ldap_schema struct
+/// @param[in]  listp      reference to array
+/// @param[in]  len        length of array
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_append, ldapschema_insert
+int ldapschema_grow(LDAPSchema * lsd, void *** listp, size_t len)
+{
+   void        ** list;
+   size_t         size;
+
+   assert(lsd    != NULL);
+   assert(listp  != NULL);
+
+   // determines number of slots currently allocated
+   for(size = 1; (size < (len + 1)); size *= 2);
+   if ( ((*listp)) && (size >= (len + 2)) )
+      return(LDAPSCHEMA_SUCCESS);
+
+   for(; (size < (len + 2)); size *= 2);
+   if ((list = realloc(*listp, (sizeof(void *) * size))) == NULL)
+      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+   *listp = list;
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
 /// initializes LDAP schema
 /// @param[out]   lsdp        Reference to pointer used to store allocated ldap_schema struct.
 ///
@@ -323,7 +627,7 @@ int ldapschema_initialize(LDAPSchema ** lsdp)
       ldapschema_free(lsd);
       return(LDAPSCHEMA_NO_MEMORY);
    };
-   bzero(lsd->oids, sizeof(void *));
+   bzero(lsd->syntaxes, sizeof(void *));
 
    // saves structure
    *lsdp = lsd;
@@ -346,7 +650,6 @@ int ldapschema_initialize(LDAPSchema ** lsdp)
 int ldapschema_insert(LDAPSchema * lsd, void *** listp, size_t * lenp, void * obj, int (*compar)(const void *, const void *))
 {
    void        ** list;
-   size_t         size;
    size_t         low;
    size_t         mid;
    size_t         high;
@@ -361,10 +664,9 @@ int ldapschema_insert(LDAPSchema * lsd, void *** listp, size_t * lenp, void * ob
    assert(compar != NULL);
 
    // increase size of array
-   size = sizeof(void *) * ((*lenp) + 2);
-   if ((list = realloc(*listp, size)) == NULL)
-      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
-   *listp        = list;
+   if (ldapschema_grow(lsd, listp, *lenp) != LDAPSCHEMA_SUCCESS)
+      return(lsd->errcode);
+   list          = *listp;
    list[*lenp+0] = NULL;
    list[*lenp+1] = NULL;
 
@@ -536,10 +838,14 @@ void * ldapschema_oid(LDAPSchema * lsd, const char * oid, size_t type)
    assert(lsd  != NULL);
    assert(oid  != NULL);
 
+   // searches only sorted OIDs while loading in bulk
+   if ((high = ((lsd->bulk)) ? lsd->oids_sorted : lsd->oids_len) == 0)
+      return(NULL);
+
    type     = LDAPSCHEMA_TYPE(type);
    models   = (LDAPSchemaModel **)lsd->oids;
    low      = 0;
-   high     = lsd->oids_len;
+   high     = high - 1;
 
    // finds position in array
    while ((high - low) > 1)
@@ -574,7 +880,8 @@ void ldapschema_syntax_free(LDAPSchemaSyntax * syntax)
 {
    assert(syntax != NULL);
 
-   regfree(&syntax->re);
+   if ((syntax->re_compiled))
+      regfree(&syntax->re);
    ldapschema_object_free(&syntax->model);
 
    free(syntax);
@@ -52,6 +52,7 @@
 #include "lsort.h"
 #include "lspec.h"
 #include "lmemory.h"
+#include "lvalidate.h"
 
 
 //////////////////
@@ -125,8 +126,20 @@ size_t ldapschema_count_objectclasses(LDAPSchema * lsd)
 //----------------------//
 #pragma mark ldapschema_find_XXXX functions
 
+/// finds alias within sorted array of aliases
+/// @param[in]  lsd       reference to allocated ldap_schema struct
+/// @param[in]  alias     name or OID to find
+/// @param[in]  list      sorted array of aliases
+/// @param[in]  list_len  length of array
+/// @param[in]  index     hash table of array, may be NULL
+///
+/// @return    Returns the alias, or NULL if the name is not known.  The hash
+///            table is used if it was built from the current array, otherwise
+///            the array is searched.
+/// @see       ldapschema_index
 LDAPSchemaAlias * ldapschema_find_alias(LDAPSchema * lsd,
-   const char * alias, LDAPSchemaAlias ** list, size_t list_len)
+   const char * alias, LDAPSchemaAlias ** list, size_t list_len,
+   const LDAPSchemaAliasIndex * index)
 {
    size_t         low;
    size_t         mid;
@@ -135,8 +148,19 @@ LDAPSchemaAlias * ldapschema_find_alias(LDAPSchema * lsd,
 
    assert(lsd     != NULL);
    assert(alias   != NULL);
+
+   if (!(list_len))
+      return(NULL);
    assert(list    != NULL);
 
+   // uses hash table if array has not changed since it was indexed
+   if ( ((index)) && ((index->names)) && (index->len == list_len) )
+   {
+      if ((mid = ldapschema_check_find(index->names, index->size, alias, strlen(alias))) == SIZE_MAX)
+         return(NULL);
+      return(list[mid]);
+   };
+
    low   = 0;
    high  = list_len - 1;
 
@@ -181,7 +205,7 @@ LDAPSchemaAttributeType * ldapschema_find_attributetype(LDAPSchema * lsd,
    assert(lsd     != NULL);
    assert(name    != NULL);
 
-   if ((alias = ldapschema_find_alias(lsd, name, lsd->attrs, lsd->attrs_len)) == NULL)
+   if ((alias = ldapschema_find_alias(lsd, name, lsd->attrs, lsd->attrs_len, &lsd->attrs_idx)) == NULL)
       return(NULL);
 
    return(alias->attributetype);
@@ -204,7 +228,7 @@ LDAPSchemaSyntax * ldapschema_find_ldapsyntax(LDAPSchema * lsd,
    assert(lsd     != NULL);
    assert(name    != NULL);
 
-   if ((alias = ldapschema_find_alias(lsd, name, lsd->syntaxes, lsd->syntaxes_len)) == NULL)
+   if ((alias = ldapschema_find_alias(lsd, name, lsd->syntaxes, lsd->syntaxes_len, &lsd->syntaxes_idx)) == NULL)
       return(NULL);
 
    return(alias->syntax);
@@ -228,7 +252,7 @@ LDAPSchemaObjectclass * ldapschema_find_objectclass(LDAPSchema * lsd,
    assert(lsd     != NULL);
    assert(name    != NULL);
 
-   if ((alias = ldapschema_find_alias(lsd, name, lsd->objclses, lsd->objclses_len)) == NULL)
+   if ((alias = ldapschema_find_alias(lsd, name, lsd->objclses, lsd->objclses_len, &lsd->objclses_idx)) == NULL)
       return(NULL);
 
    return(alias->objectclass);
@@ -364,6 +388,16 @@ int ldapschema_get_info_ldapsyntax(LDAPSchema * lsd,
    assert(syntax     != NULL);
    assert(field      != 0);
    assert(outvalue   != 0);
+
+   switch(field)
+   {
+      // int values (flags/types/etc)
+      case LDAPSCHEMA_FLD_CLASS: *(int *)outvalue = (int)syntax->data_class; return(0);
+
+      default:
+      break;
+   };
+
    return(ldapschema_get_info_model(lsd, &syntax->model, field, outvalue));
 }
 
@@ -449,6 +483,69 @@ int ldapschema_get_info_objectclass(LDAPSchema * lsd,
 }
 
 
+//-----------------------//
+// ldapschema_index_XXXX //
+//-----------------------//
+#pragma mark ldapschema_index_XXXX functions
+
+/// builds hash tables of names and OIDs of syntaxes, attributeTypes and
+/// objectClasses, called by ldapschema_bulk_end() once definitions have been
+/// sorted so that lookups do not search the sorted arrays
+/// @param[in]  lsd       reference to allocated ldap_schema struct
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_bulk_end, ldapschema_find_alias
+int ldapschema_index(LDAPSchema * lsd)
+{
+   assert(lsd != NULL);
+
+   if (ldapschema_index_aliases(lsd, &lsd->syntaxes_idx, lsd->syntaxes, lsd->syntaxes_len) != LDAPSCHEMA_SUCCESS)
+      return(lsd->errcode);
+   if (ldapschema_index_aliases(lsd, &lsd->attrs_idx, lsd->attrs, lsd->attrs_len) != LDAPSCHEMA_SUCCESS)
+      return(lsd->errcode);
+   if (ldapschema_index_aliases(lsd, &lsd->objclses_idx, lsd->objclses, lsd->objclses_len) != LDAPSCHEMA_SUCCESS)
+      return(lsd->errcode);
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// builds hash table of sorted array of aliases
+/// @param[in]  lsd       reference to allocated ldap_schema struct
+/// @param[in]  index     hash table to build
+/// @param[in]  list      sorted array of aliases
+/// @param[in]  list_len  length of array
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_index
+int ldapschema_index_aliases(LDAPSchema * lsd, LDAPSchemaAliasIndex * index,
+   LDAPSchemaAlias ** list, size_t list_len)
+{
+   size_t                  idx;
+   size_t                  size;
+   LDAPSchemaCheckName   * names;
+
+   assert(lsd   != NULL);
+   assert(index != NULL);
+
+   for(size = 16; (size < (list_len * 2)); size *= 2);
+   if ((names = malloc(sizeof(LDAPSchemaCheckName) * size)) == NULL)
+      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+   bzero(names, sizeof(LDAPSchemaCheckName) * size);
+
+   for(idx = 0; (idx < list_len); idx++)
+      ldapschema_check_name(names, size, list[idx]->alias, idx);
+
+   if ((index->names))
+      free(index->names);
+   index->names = names;
+   index->size  = size;
+   index->len   = list_len;
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
 //----------------------//
 // ldapschema_model_XXXX //
 //----------------------//
@@ -66,6 +66,18 @@ ldapschema_find_alias(
          LDAPSchema               * lsd,
          const char               * alias,
          LDAPSchemaAlias         ** list,
+         size_t                     list_len,
+         const LDAPSchemaAliasIndex * index );
+
+int
+ldapschema_index(
+         LDAPSchema               * lsd );
+
+int
+ldapschema_index_aliases(
+         LDAPSchema               * lsd,
+         LDAPSchemaAliasIndex     * index,
+         LDAPSchemaAlias         ** list,
          size_t                     list_len );
 
 
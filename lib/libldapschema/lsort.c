@@ -43,6 +43,7 @@
 ///////////////
 #pragma mark - Headers
 
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 
@@ -109,5 +110,76 @@ ldapschema_compar_values(
 /////////////////
 #pragma mark - Functions
 
+/// sorts array with a stable merge sort, so that objects which compare
+/// equal keep the order in which they were appended
+/// @param[in]  lsd       reference to allocated ldap_schema struct
+/// @param[in]  list      array to sort
+/// @param[in]  len       length of array
+/// @param[in]  compar    reference to compare function
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_bulk_end
+int ldapschema_sort(LDAPSchema * lsd, void ** list, size_t len,
+   int (*compar)(const void *, const void *))
+{
+   size_t         x;
+   size_t         y;
+   size_t         z;
+   size_t         pos;
+   size_t         mid;
+   size_t         end;
+   size_t         width;
+   void        ** src;
+   void        ** dst;
+   void        ** tmp;
+
+   assert(lsd    != NULL);
+   assert(compar != NULL);
+
+   // skips arrays which are already sorted
+   for(x = 1; (x < len); x++)
+      if (compar(&list[x-1], &list[x]) > 0)
+         break;
+   if (x >= len)
+      return(LDAPSCHEMA_SUCCESS);
+
+   if ((tmp = malloc(sizeof(void *) * len)) == NULL)
+      return(lsd->errcode = LDAPSCHEMA_NO_MEMORY);
+
+   // merges runs of increasing width, preferring the left run on ties
+   src = list;
+   dst = tmp;
+   for(width = 1; (width < len); width *= 2)
+   {
+      for(pos = 0; (pos < len); pos += width * 2)
+      {
+         mid = ((pos + width) < len)       ? (pos + width)     : len;
+         end = ((pos + (width * 2)) < len) ? (pos + width * 2) : len;
+         for(x = pos, y = mid, z = pos; (z < end); z++)
+         {
+            if ( (y >= end) || ( (x < mid) && (compar(&src[x], &src[y]) <= 0) ) )
+               dst[z] = src[x++];
+            else
+               dst[z] = src[y++];
+         };
+      };
+      tmp = src;
+      src = dst;
+      dst = tmp;
+   };
+
+   // copies result into array
+   if (src != list)
+   {
+      memcpy(list, src, sizeof(void *) * len);
+      free(src);
+   } else
+   {
+      free(dst);
+   };
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
 
 /* end of source file */
@@ -62,6 +62,13 @@
 //////////////////
 #pragma mark - Prototypes
 
+int
+ldapschema_sort(
+         LDAPSchema               * lsd,
+         void                    ** list,
+         size_t                     len,
+         int (*compar)(const void *, const void *) );
+
 
 ////////////////////////
 //                    //
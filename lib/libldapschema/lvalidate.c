@@ -0,0 +1,898 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *   @file src/ldapschema/lvalidate.c  validates entries against schema
+ */
+/*
+ *  The validator compiles the schema once.  Names and OIDs of
+ *  attributeTypes and objectClasses are placed into case folded hash
+ *  tables, and the required and allowed attributeTypes of each objectClass,
+ *  including inherited attributeTypes and subtypes of allowed attributeTypes,
+ *  become bitmaps indexed by attributeType.  The validator is not modified
+ *  once compiled and is shared by threads.  Each thread checks entries with
+ *  its own checker, which remembers the bitmaps of each combination of
+ *  objectClasses it resolves, so checking an entry costs one hash lookup per
+ *  attribute and per objectClass value and one lookup of the combination.
+ */
+#define _LIB_LIBLDAPSCHEMA_LVALIDATE_C 1
+#include "lvalidate.h"
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+/// checks attribute of entry against schema
+/// @param[in]  chk       reference to checker of entry
+/// @param[in]  name      attribute description, may include options
+/// @param[in]  vals      array of values
+/// @param[in]  vals_len  number of values
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY if a
+///            violation could not be recorded.
+/// @see       ldapschema_check_begin, ldapschema_check_end
+int ldapschema_check_attribute(LDAPSchemaChecker * chk,
+   const struct berval * name, const struct berval * vals, size_t vals_len)
+{
+   int                     rc;
+   int                     binary;
+   size_t                  x;
+   size_t                  y;
+   size_t                  idx;
+   size_t                  len;
+   size_t                  cls;
+   const char            * opt;
+   void                  * ptr;
+   LDAPSchemaValidator   * val;
+   LDAPSchemaCheckAttr   * attr;
+
+   assert(chk  != NULL);
+   assert(name != NULL);
+   assert( (!(vals_len)) || ((vals)) );
+
+   val = chk->val;
+
+   // separates attribute options from attributeType
+   len    = name->bv_len;
+   binary = 0;
+   if ((opt = memchr(name->bv_val, ';', name->bv_len)) != NULL)
+   {
+      len = (size_t)(opt - name->bv_val);
+      for(x = len; (x < name->bv_len); x = y)
+      {
+         for(y = x + 1; ( (y < name->bv_len) && (name->bv_val[y] != ';') ); y++);
+         if ( ((y - x) == 7) && (!(strncasecmp(&name->bv_val[x], ";binary", 7))) )
+            binary = 1;
+      };
+   };
+
+   if ((idx = ldapschema_check_find(val->attr_names, val->attr_names_size, name->bv_val, len)) == SIZE_MAX)
+   {
+      if (ldapschema_check_violate(chk, LDAPSCHEMA_V_UNKNOWN_ATTRIBUTE, name->bv_val, name->bv_len, 0) == -1)
+         return(LDAPSCHEMA_NO_MEMORY);
+      return(LDAPSCHEMA_SUCCESS);
+   };
+   attr = &val->attrs[idx];
+
+   // collects objectClasses of entry
+   for(x = 0; ( (idx == val->objectclass) && (x < vals_len) ); x++)
+   {
+      if ((cls = ldapschema_check_find(val->class_names, val->class_names_size, vals[x].bv_val, vals[x].bv_len)) == SIZE_MAX)
+      {
+         chk->unknown++;
+         if (ldapschema_check_violate(chk, LDAPSCHEMA_V_UNKNOWN_CLASS, vals[x].bv_val, vals[x].bv_len, x) == -1)
+            return(LDAPSCHEMA_NO_MEMORY);
+         continue;
+      };
+      if (chk->classes_len == chk->classes_size)
+      {
+         if ((ptr = realloc(chk->classes, sizeof(size_t) * chk->classes_size * 2)) == NULL)
+            return(LDAPSCHEMA_NO_MEMORY);
+         chk->classes       = ptr;
+         chk->classes_size *= 2;
+      };
+      chk->classes[chk->classes_len++] = cls;
+   };
+
+   // records attributeType for checks against objectClasses
+   if (!(chk->present[idx / 64] & (UINT64_C(1) << (idx % 64))))
+   {
+      chk->present[idx / 64] |= UINT64_C(1) << (idx % 64);
+      chk->attrs[chk->attrs_len++] = idx;
+   };
+
+   if ( ((attr->flags & LDAPSCHEMA_O_SINGLEVALUE)) && (vals_len > 1) )
+      if (ldapschema_check_violate(chk, LDAPSCHEMA_V_SINGLE_VALUE, name->bv_val, name->bv_len, 1) == -1)
+         return(LDAPSCHEMA_NO_MEMORY);
+
+   // values transferred with the binary option are BER encoded
+   if ( (!(attr->syntax)) || ((binary)) )
+      return(LDAPSCHEMA_SUCCESS);
+   for(x = 0; (x < vals_len); x++)
+   {
+      if ((rc = ldapschema_check_value(chk, attr->syntax, &vals[x])) == -1)
+         return(LDAPSCHEMA_NO_MEMORY);
+      if ( ((rc)) && (ldapschema_check_violate(chk, LDAPSCHEMA_V_SYNTAX, name->bv_val, name->bv_len, x) == -1) )
+         return(LDAPSCHEMA_NO_MEMORY);
+   };
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// starts checking entry, discarding state of previous entry
+/// @param[in]  chk       reference to checker
+///
+/// @see       ldapschema_check_attribute, ldapschema_check_end
+void ldapschema_check_begin(LDAPSchemaChecker * chk)
+{
+   size_t x;
+
+   assert(chk != NULL);
+
+   for(x = 0; (x < chk->attrs_len); x++)
+      chk->present[chk->attrs[x] / 64] = 0;
+   chk->attrs_len    = 0;
+   chk->classes_len  = 0;
+   chk->unknown      = 0;
+   chk->viols_len    = 0;
+
+   return;
+}
+
+
+/// sets bits of attributeTypes within bitmap
+/// @param[in]  val       reference to validator
+/// @param[in]  bits      bitmap
+/// @param[in]  list      array of attributeTypes
+/// @param[in]  len       length of array
+void ldapschema_check_bits(LDAPSchemaValidator * val, uint64_t * bits,
+   LDAPSchemaAttributeType ** list, size_t len)
+{
+   size_t   x;
+   size_t   idx;
+
+   for(x = 0; (x < len); x++)
+   {
+      if ((idx = ldapschema_check_find(val->attr_names, val->attr_names_size, list[x]->model.oid, strlen(list[x]->model.oid))) == SIZE_MAX)
+         continue;
+      bits[idx / 64] |= UINT64_C(1) << (idx % 64);
+   };
+
+   return;
+}
+
+
+/// completes checks of entry which depend upon objectClasses
+/// @param[in]  chk       reference to checker
+///
+/// @return    Returns the number of violations found in the entry, or
+///            LDAPSCHEMA_NO_MEMORY if the checks could not be completed.
+/// @see       ldapschema_check_begin, ldapschema_check_violation
+int ldapschema_check_end(LDAPSchemaChecker * chk)
+{
+   size_t                  w;
+   size_t                  x;
+   size_t                  idx;
+   uint64_t                bits;
+   LDAPSchemaValidator   * val;
+   LDAPSchemaCheckSet    * set;
+   LDAPSchemaCheckAttr   * attr;
+
+   assert(chk != NULL);
+
+   val = chk->val;
+
+   // entries without known objectClasses are only missing objectClass
+   if (!(chk->classes_len))
+   {
+      if ( (!(chk->unknown)) && (val->objectclass != SIZE_MAX) )
+      {
+         attr = &val->attrs[val->objectclass];
+         if (ldapschema_check_violate(chk, LDAPSCHEMA_V_MISSING, attr->name, strlen(attr->name), 0) == -1)
+            return(LDAPSCHEMA_NO_MEMORY);
+      };
+      return((int)chk->viols_len);
+   };
+
+   if ((set = ldapschema_check_set(chk)) == NULL)
+      return(LDAPSCHEMA_NO_MEMORY);
+
+   // an unknown objectClass may be structural or allow any attribute
+   if ( (!(set->structural)) && (!(chk->unknown)) )
+      if (ldapschema_check_violate(chk, LDAPSCHEMA_V_NO_STRUCTURAL, NULL, 0, 0) == -1)
+         return(LDAPSCHEMA_NO_MEMORY);
+   for(x = 0; ( (!(chk->unknown)) && (!(set->extensible)) && (x < chk->attrs_len) ); x++)
+   {
+      idx  = chk->attrs[x];
+      attr = &val->attrs[idx];
+      if ( (attr->usage != LDAPSCHEMA_USER_APP) || ((set->may[idx / 64] & (UINT64_C(1) << (idx % 64)))) )
+         continue;
+      if (ldapschema_check_violate(chk, LDAPSCHEMA_V_NOT_ALLOWED, attr->name, strlen(attr->name), 0) == -1)
+         return(LDAPSCHEMA_NO_MEMORY);
+   };
+
+   // reports required attributeTypes missing from entry
+   for(w = 0; (w < val->words); w++)
+   {
+      if ((bits = set->must[w] & ~chk->present[w]) == 0)
+         continue;
+      for(x = 0; (x < 64); x++)
+      {
+         if (!(bits & (UINT64_C(1) << x)))
+            continue;
+         attr = &val->attrs[(w * 64) + x];
+         if (ldapschema_check_violate(chk, LDAPSCHEMA_V_MISSING, attr->name, strlen(attr->name), 0) == -1)
+            return(LDAPSCHEMA_NO_MEMORY);
+      };
+   };
+
+   return((int)chk->viols_len);
+}
+
+
+/// finds index of name within hash table
+/// @param[in]  names     hash table
+/// @param[in]  size      number of slots in hash table
+/// @param[in]  name      name or OID, not required to be terminated
+/// @param[in]  len       length of name
+///
+/// @return    Returns index of attributeType or objectClass, or SIZE_MAX
+///            if the name is not known.
+size_t ldapschema_check_find(const LDAPSchemaCheckName * names, size_t size,
+   const char * name, size_t len)
+{
+   size_t   pos;
+   size_t   hash;
+
+   hash = ldapschema_check_hash(name, len);
+   for(pos = hash & (size - 1); ((names[pos].name)); pos = (pos + 1) & (size - 1))
+      if ( (names[pos].hash == hash) && (names[pos].len == len) && (!(strncasecmp(names[pos].name, name, len))) )
+         return(names[pos].idx);
+
+   return(SIZE_MAX);
+}
+
+
+/// calculates case folded FNV-1a hash of name
+/// @param[in]  name      name or OID
+/// @param[in]  len       length of name
+size_t ldapschema_check_hash(const char * name, size_t len)
+{
+   size_t      x;
+   uint64_t    c;
+   uint64_t    hash;
+
+   hash = UINT64_C(14695981039346656037);
+   for(x = 0; (x < len); x++)
+   {
+      c     = (uint64_t)(unsigned char)name[x];
+      hash ^= ( (c >= 'A') && (c <= 'Z') ) ? (c + 32) : c;
+      hash *= UINT64_C(1099511628211);
+   };
+
+   return((size_t)hash);
+}
+
+
+/// adds name to hash table unless already present
+/// @param[in]  names     hash table
+/// @param[in]  size      number of slots in hash table
+/// @param[in]  name      terminated name or OID
+/// @param[in]  idx       index of attributeType or objectClass
+///
+/// @return    Returns 0 if the name was added, or -1 if the name is
+///            already used.
+int ldapschema_check_name(LDAPSchemaCheckName * names, size_t size,
+   const char * name, size_t idx)
+{
+   size_t   pos;
+   size_t   len;
+   size_t   hash;
+
+   len  = strlen(name);
+   hash = ldapschema_check_hash(name, len);
+   for(pos = hash & (size - 1); ((names[pos].name)); pos = (pos + 1) & (size - 1))
+      if ( (names[pos].hash == hash) && (names[pos].len == len) && (!(strcasecmp(names[pos].name, name))) )
+         return(-1);
+
+   names[pos].name = name;
+   names[pos].len  = len;
+   names[pos].hash = hash;
+   names[pos].idx  = idx;
+
+   return(0);
+}
+
+
+/// resolves objectClasses of entry to required and allowed attributeTypes
+/// @param[in]  chk       reference to checker
+///
+/// @return    Returns the resolved objectClass combination, or NULL if
+///            out of memory.
+LDAPSchemaCheckSet * ldapschema_check_set(LDAPSchemaChecker * chk)
+{
+   size_t                  x;
+   size_t                  y;
+   size_t                  w;
+   size_t                  pos;
+   size_t                  len;
+   size_t                  hash;
+   size_t                  size;
+   LDAPSchemaValidator   * val;
+   LDAPSchemaCheckSet    * set;
+   LDAPSchemaCheckSet    * sets;
+   LDAPSchemaCheckClass  * cls;
+
+   val = chk->val;
+
+   // sorts objectClasses and removes duplicates, lists are short
+   for(x = 1; (x < chk->classes_len); x++)
+   {
+      for(y = x; ( (y > 0) && (chk->classes[y-1] > chk->classes[y]) ); y--)
+      {
+         pos                = chk->classes[y];
+         chk->classes[y]    = chk->classes[y-1];
+         chk->classes[y-1]  = pos;
+      };
+   };
+   for(x = 1, len = 1; (x < chk->classes_len); x++)
+      if (chk->classes[x] != chk->classes[len-1])
+         chk->classes[len++] = chk->classes[x];
+   chk->classes_len = len;
+
+   // finds combination resolved by a previous entry
+   hash = ldapschema_check_hash((const char *)chk->classes, sizeof(size_t) * len);
+   for(pos = hash & (chk->sets_size - 1); ((chk->sets[pos].classes)); pos = (pos + 1) & (chk->sets_size - 1))
+   {
+      set = &chk->sets[pos];
+      if ( (set->hash == hash) && (set->classes_len == len) && (!(memcmp(set->classes, chk->classes, sizeof(size_t) * len))) )
+         return(set);
+   };
+
+   // grows table, or forgets previous combinations once limit is reached
+   if ((chk->sets_len * 2) >= chk->sets_size)
+   {
+      size = (chk->sets_size < (LDAPSCHEMA_CHECK_SETS * 2)) ? (chk->sets_size * 2) : chk->sets_size;
+      if ((sets = malloc(sizeof(LDAPSchemaCheckSet) * size)) == NULL)
+         return(NULL);
+      bzero(sets, sizeof(LDAPSchemaCheckSet) * size);
+      for(x = 0; (x < chk->sets_size); x++)
+      {
+         if (!(chk->sets[x].classes))
+            continue;
+         if (size == chk->sets_size)
+         {
+            free(chk->sets[x].classes);
+            free(chk->sets[x].must);
+            continue;
+         };
+         for(y = chk->sets[x].hash & (size - 1); ((sets[y].classes)); y = (y + 1) & (size - 1));
+         sets[y] = chk->sets[x];
+      };
+      free(chk->sets);
+      chk->sets      = sets;
+      chk->sets_len  = (size == chk->sets_size) ? 0 : chk->sets_len;
+      chk->sets_size = size;
+      for(pos = hash & (size - 1); ((chk->sets[pos].classes)); pos = (pos + 1) & (size - 1));
+   };
+
+   // combines bitmaps of objectClasses
+   set = &chk->sets[pos];
+   if ((set->must = malloc(sizeof(uint64_t) * val->words * 2)) == NULL)
+      return(NULL);
+   if ((set->classes = malloc(sizeof(size_t) * len)) == NULL)
+   {
+      free(set->must);
+      set->must = NULL;
+      return(NULL);
+   };
+   memcpy(set->classes, chk->classes, sizeof(size_t) * len);
+   bzero(set->must, sizeof(uint64_t) * val->words * 2);
+   set->may         = &set->must[val->words];
+   set->classes_len = len;
+   set->hash        = hash;
+   set->structural  = 0;
+   set->extensible  = 0;
+   for(x = 0; (x < len); x++)
+   {
+      cls = &val->classes[set->classes[x]];
+      for(w = 0; (w < val->words); w++)
+      {
+         set->must[w] |= cls->must[w];
+         set->may[w]  |= cls->may[w];
+      };
+      if (cls->kind == LDAPSCHEMA_STRUCTURAL)
+         set->structural = 1;
+      if ((cls->extensible))
+         set->extensible = 1;
+   };
+   chk->sets_len++;
+
+   return(set);
+}
+
+
+/// checks value against syntax
+/// @param[in]  chk       reference to checker
+/// @param[in]  syntax    syntax of attributeType
+/// @param[in]  val       value
+///
+/// @return    Returns 0 if the value is valid, 1 if the value does not
+///            match the syntax, or -1 if out of memory.
+int ldapschema_check_value(LDAPSchemaChecker * chk,
+   const LDAPSchemaSyntax * syntax, const struct berval * val)
+{
+   size_t                  x;
+   size_t                  len;
+   const unsigned char   * str;
+#ifdef REG_STARTEND
+   regmatch_t              match[1];
+#else
+   void                  * ptr;
+#endif
+
+   assert(chk    != NULL);
+   assert(syntax != NULL);
+
+   str = (const unsigned char *)val->bv_val;
+   len = val->bv_len;
+
+   switch(syntax->data_class)
+   {
+      case LDAPSCHEMA_CLASS_ASCII:
+      for(x = 0; (x < len); x++)
+         if (str[x] > 0x7f)
+            return(1);
+      break;
+
+      case LDAPSCHEMA_CLASS_UTF8:
+      case LDAPSCHEMA_CLASS_UTF8_MULTILINE:
+      if (ldapschema_check_utf8(str, len) == -1)
+         return(1);
+      break;
+
+      case LDAPSCHEMA_CLASS_INTEGER:
+      x = ( (len > 1) && (str[0] == '-') ) ? 1 : 0;
+      if ( (x == len) || ( ((x)) && (str[x] == '0') ) )
+         return(1);
+      for(; (x < len); x++)
+         if ( (str[x] < '0') || (str[x] > '9') )
+            return(1);
+      break;
+
+      case LDAPSCHEMA_CLASS_UNSIGNED:
+      if (!(len))
+         return(1);
+      for(x = 0; (x < len); x++)
+         if ( (str[x] < '0') || (str[x] > '9') )
+            return(1);
+      break;
+
+      case LDAPSCHEMA_CLASS_BOOLEAN:
+      if ( (len == 4) && (!(memcmp(str, "TRUE", 4))) )
+         return(0);
+      if ( (len == 5) && (!(memcmp(str, "FALSE", 5))) )
+         return(0);
+      return(1);
+
+      default:
+      break;
+   };
+
+   if (!(syntax->re_compiled))
+      return(0);
+
+   // values are not terminated, so the match is bounded when supported
+#ifdef REG_STARTEND
+   match[0].rm_so = 0;
+   match[0].rm_eo = (regoff_t)len;
+   return(((regexec(&syntax->re, val->bv_val, 1, match, REG_STARTEND))) ? 1 : 0);
+#else
+   if (len >= chk->buff_size)
+   {
+      if ((ptr = realloc(chk->buff, len + 1)) == NULL)
+         return(-1);
+      chk->buff      = ptr;
+      chk->buff_size = len + 1;
+   };
+   memcpy(chk->buff, val->bv_val, len);
+   chk->buff[len] = '\0';
+   return(((regexec(&syntax->re, chk->buff, 0, NULL, 0))) ? 1 : 0);
+#endif
+}
+
+
+/// checks encoding of UTF-8 string
+/// @param[in]  str       string
+/// @param[in]  len       length of string
+///
+/// @return    Returns 0 if the string is valid UTF-8, otherwise -1.
+int ldapschema_check_utf8(const unsigned char * str, size_t len)
+{
+   size_t      x;
+   size_t      y;
+   size_t      n;
+   uint32_t    c;
+   uint32_t    min;
+
+   for(x = 0; (x < len); x += n)
+   {
+      if (str[x] < 0x80)
+      {
+         n = 1;
+         continue;
+      };
+      if      ((str[x] & 0xe0) == 0xc0) { n = 2; min = 0x80;    c = str[x] & 0x1f; }
+      else if ((str[x] & 0xf0) == 0xe0) { n = 3; min = 0x800;   c = str[x] & 0x0f; }
+      else if ((str[x] & 0xf8) == 0xf0) { n = 4; min = 0x10000; c = str[x] & 0x07; }
+      else
+         return(-1);
+      if ((x + n) > len)
+         return(-1);
+      for(y = 1; (y < n); y++)
+      {
+         if ((str[x+y] & 0xc0) != 0x80)
+            return(-1);
+         c = (c << 6) | (str[x+y] & 0x3f);
+      };
+
+      // rejects overlong encodings, surrogates, and values beyond Unicode
+      if ( (c < min) || (c > 0x10ffff) || ( (c >= 0xd800) && (c <= 0xdfff) ) )
+         return(-1);
+   };
+
+   return(0);
+}
+
+
+/// records schema violation of entry
+/// @param[in]  chk       reference to checker
+/// @param[in]  code      violation code
+/// @param[in]  name      attribute or objectClass
+/// @param[in]  len       length of name
+/// @param[in]  value     index of value
+///
+/// @return    Returns 0 on success, or -1 if out of memory.
+int ldapschema_check_violate(LDAPSchemaChecker * chk, int code,
+   const char * name, size_t len, size_t value)
+{
+   size_t                  size;
+   LDAPSchemaViolation   * viol;
+
+   if (chk->viols_len == chk->viols_size)
+   {
+      size = ((chk->viols_size)) ? (chk->viols_size * 2) : 8;
+      if ((viol = realloc(chk->viols, sizeof(LDAPSchemaViolation) * size)) == NULL)
+         return(-1);
+      chk->viols      = viol;
+      chk->viols_size = size;
+   };
+
+   viol               = &chk->viols[chk->viols_len++];
+   viol->code         = code;
+   viol->pad32        = 0;
+   viol->value        = value;
+   viol->name.bv_val  = (char *)name;
+   viol->name.bv_len  = len;
+
+   return(0);
+}
+
+
+/// retrieves schema violation of entry
+/// @param[in]  chk       reference to checker
+/// @param[in]  idx       index of violation
+/// @param[out] namep     attribute or objectClass, references the entry or
+///                       schema and is not terminated
+/// @param[out] valuep    index of value which does not match syntax
+///
+/// @return    Returns the violation code, or 0 if idx is beyond the
+///            violations of the entry.
+/// @see       ldapschema_check_end, ldapschema_violation2string
+int ldapschema_check_violation(LDAPSchemaChecker * chk, size_t idx,
+   struct berval * namep, size_t * valuep)
+{
+   assert(chk != NULL);
+
+   if (idx >= chk->viols_len)
+      return(0);
+   if ((namep))
+      *namep = chk->viols[idx].name;
+   if ((valuep))
+      *valuep = chk->viols[idx].value;
+
+   return(chk->viols[idx].code);
+}
+
+
+/// frees checker
+/// @param[in]  chk       reference to checker
+///
+/// @see       ldapschema_checker_initialize
+void ldapschema_checker_free(LDAPSchemaChecker * chk)
+{
+   size_t x;
+
+   if (!(chk))
+      return;
+
+   for(x = 0; ( ((chk->sets)) && (x < chk->sets_size) ); x++)
+   {
+      if ((chk->sets[x].classes))
+         free(chk->sets[x].classes);
+      if ((chk->sets[x].must))
+         free(chk->sets[x].must);
+   };
+   if ((chk->sets))
+      free(chk->sets);
+   if ((chk->present))
+      free(chk->present);
+   if ((chk->attrs))
+      free(chk->attrs);
+   if ((chk->classes))
+      free(chk->classes);
+   if ((chk->viols))
+      free(chk->viols);
+   if ((chk->buff))
+      free(chk->buff);
+   free(chk);
+
+   return;
+}
+
+
+/// initializes checker used by one thread
+/// @param[in]  val       reference to compiled validator
+/// @param[out] chkp      reference to store checker
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_checker_free, ldapschema_validator_initialize
+int ldapschema_checker_initialize(LDAPSchemaValidator * val, LDAPSchemaChecker ** chkp)
+{
+   LDAPSchemaChecker * chk;
+
+   assert(val  != NULL);
+   assert(chkp != NULL);
+
+   if ((chk = malloc(sizeof(LDAPSchemaChecker))) == NULL)
+      return(LDAPSCHEMA_NO_MEMORY);
+   bzero(chk, sizeof(LDAPSchemaChecker));
+   chk->val          = val;
+   chk->classes_size = 8;
+   chk->sets_size    = 64;
+
+   if ( ((chk->present = malloc(sizeof(uint64_t) * val->words))          == NULL) ||
+        ((chk->attrs   = malloc(sizeof(size_t) * (val->attrs_len + 1)))  == NULL) ||
+        ((chk->classes = malloc(sizeof(size_t) * chk->classes_size))     == NULL) ||
+        ((chk->sets    = malloc(sizeof(LDAPSchemaCheckSet) * chk->sets_size)) == NULL) )
+   {
+      ldapschema_checker_free(chk);
+      return(LDAPSCHEMA_NO_MEMORY);
+   };
+   bzero(chk->present, sizeof(uint64_t) * val->words);
+   bzero(chk->sets,    sizeof(LDAPSchemaCheckSet) * chk->sets_size);
+
+   *chkp = chk;
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+
+/// frees compiled validator
+/// @param[in]  val       reference to validator
+///
+/// @see       ldapschema_validator_initialize
+void ldapschema_validator_free(LDAPSchemaValidator * val)
+{
+   if (!(val))
+      return;
+
+   if ((val->attrs))
+      free(val->attrs);
+   if ((val->classes))
+      free(val->classes);
+   if ((val->attr_names))
+      free(val->attr_names);
+   if ((val->class_names))
+      free(val->class_names);
+   if ((val->bits))
+      free(val->bits);
+   free(val);
+
+   return;
+}
+
+
+/// compiles objectClass and attributeType checks of schema
+/// @param[in]  lsd       reference to schema, must not be modified or freed
+///                       while the validator is used
+/// @param[out] valp      reference to store validator
+///
+/// @return    Returns LDAPSCHEMA_SUCCESS, or LDAPSCHEMA_NO_MEMORY.
+/// @see       ldapschema_validator_free, ldapschema_checker_initialize
+int ldapschema_validator_initialize(LDAPSchema * lsd, LDAPSchemaValidator ** valp)
+{
+   size_t                     x;
+   size_t                     y;
+   size_t                     idx;
+   size_t                     depth;
+   size_t                     attr_names;
+   size_t                     class_names;
+   size_t                   * sups;
+   LDAPSchemaValidator      * val;
+   LDAPSchemaAttributeType  * attr;
+   LDAPSchemaAttributeType  * sup;
+   LDAPSchemaObjectclass    * objcls;
+   LDAPSchemaCheckAttr      * cattr;
+   LDAPSchemaCheckClass     * cls;
+
+   assert(lsd  != NULL);
+   assert(valp != NULL);
+
+   if ((val = malloc(sizeof(LDAPSchemaValidator))) == NULL)
+      return(LDAPSCHEMA_NO_MEMORY);
+   bzero(val, sizeof(LDAPSchemaValidator));
+   val->lsd = lsd;
+
+   // counts names of attributeTypes and objectClasses
+   attr_names  = 0;
+   class_names = 0;
+   for(x = 0; (x < lsd->oids_len); x++)
+   {
+      if (lsd->oids[x].model->type == LDAPSCHEMA_ATTRIBUTETYPE)
+      {
+         val->attrs_len++;
+         attr_names += lsd->oids[x].attributetype->names_len + 1;
+      };
+      if (lsd->oids[x].model->type == LDAPSCHEMA_OBJECTCLASS)
+      {
+         val->classes_len++;
+         class_names += lsd->oids[x].objectclass->names_len + 1;
+      };
+   };
+   val->words = (val->attrs_len / 64) + 1;
+
+   // hash tables are kept at most half full
+   for(val->attr_names_size  = 16; (val->attr_names_size  < (attr_names  * 2)); val->attr_names_size  *= 2);
+   for(val->class_names_size = 16; (val->class_names_size < (class_names * 2)); val->class_names_size *= 2);
+
+   sups = NULL;
+   if ( ((val->attrs       = malloc(sizeof(LDAPSchemaCheckAttr)  * (val->attrs_len   + 1)))  == NULL) ||
+        ((val->classes     = malloc(sizeof(LDAPSchemaCheckClass) * (val->classes_len + 1)))  == NULL) ||
+        ((val->attr_names  = malloc(sizeof(LDAPSchemaCheckName)  * val->attr_names_size))   == NULL) ||
+        ((val->class_names = malloc(sizeof(LDAPSchemaCheckName)  * val->class_names_size))  == NULL) ||
+        ((val->bits        = malloc(sizeof(uint64_t) * val->words * 2 * (val->classes_len + 1))) == NULL) ||
+        ((sups             = malloc(sizeof(size_t) * (val->attrs_len + 1)))                  == NULL) )
+   {
+      ldapschema_validator_free(val);
+      return(LDAPSCHEMA_NO_MEMORY);
+   };
+   bzero(val->attrs,       sizeof(LDAPSchemaCheckAttr)  * (val->attrs_len   + 1));
+   bzero(val->classes,     sizeof(LDAPSchemaCheckClass) * (val->classes_len + 1));
+   bzero(val->attr_names,  sizeof(LDAPSchemaCheckName)  * val->attr_names_size);
+   bzero(val->class_names, sizeof(LDAPSchemaCheckName)  * val->class_names_size);
+   bzero(val->bits,        sizeof(uint64_t) * val->words * 2 * (val->classes_len + 1));
+
+   // indexes attributeTypes by names and OID
+   for(x = 0, idx = 0; (x < lsd->oids_len); x++)
+   {
+      if (lsd->oids[x].model->type != LDAPSCHEMA_ATTRIBUTETYPE)
+         continue;
+      attr         = lsd->oids[x].attributetype;
+      cattr        = &val->attrs[idx];
+      cattr->attr  = attr;
+      cattr->name  = ((attr->names_len)) ? attr->names[0] : attr->model.oid;
+      cattr->flags = attr->model.flags;
+      cattr->usage = (uint32_t)attr->usage;
+      for(sup = attr, depth = 0; ( ((sup)) && (!(cattr->syntax)) && (depth < val->attrs_len) ); sup = sup->sup, depth++)
+         cattr->syntax = sup->syntax;
+      for(y = 0; (y < attr->names_len); y++)
+         ldapschema_check_name(val->attr_names, val->attr_names_size, attr->names[y], idx);
+      ldapschema_check_name(val->attr_names, val->attr_names_size, attr->model.oid, idx);
+      idx++;
+   };
+   val->objectclass = ldapschema_check_find(val->attr_names, val->attr_names_size, "objectClass", 11);
+
+   // maps superior of each attributeType to index
+   for(x = 0; (x < val->attrs_len); x++)
+   {
+      sups[x] = SIZE_MAX;
+      if ((sup = val->attrs[x].attr->sup) != NULL)
+         sups[x] = ldapschema_check_find(val->attr_names, val->attr_names_size, sup->model.oid, strlen(sup->model.oid));
+   };
+
+   // compiles required and allowed attributeTypes of each objectClass
+   for(x = 0, idx = 0; (x < lsd->oids_len); x++)
+   {
+      if (lsd->oids[x].model->type != LDAPSCHEMA_OBJECTCLASS)
+         continue;
+      objcls          = lsd->oids[x].objectclass;
+      cls             = &val->classes[idx];
+      cls->objcls     = objcls;
+      cls->kind       = objcls->kind;
+      cls->extensible = (!(strcmp(objcls->model.oid, LDAPSCHEMA_EXTENSIBLEOBJECT))) ? 1 : 0;
+      cls->must       = &val->bits[idx * val->words * 2];
+      cls->may        = &cls->must[val->words];
+      for(y = 0; (y < objcls->names_len); y++)
+         ldapschema_check_name(val->class_names, val->class_names_size, objcls->names[y], idx);
+      ldapschema_check_name(val->class_names, val->class_names_size, objcls->model.oid, idx);
+
+      ldapschema_check_bits(val, cls->must, objcls->must,         objcls->must_len);
+      ldapschema_check_bits(val, cls->must, objcls->inherit_must, objcls->inherit_must_len);
+      ldapschema_check_bits(val, cls->may,  objcls->may,          objcls->may_len);
+      ldapschema_check_bits(val, cls->may,  objcls->inherit_may,  objcls->inherit_may_len);
+      for(y = 0; (y < val->words); y++)
+         cls->may[y] |= cls->must[y];
+
+      // subtypes of allowed attributeTypes are allowed
+      for(y = 0; (y < val->attrs_len); y++)
+      {
+         if ((cls->may[y / 64] & (UINT64_C(1) << (y % 64))))
+            continue;
+         for(attr_names = sups[y], depth = 0; ( (attr_names != SIZE_MAX) && (depth < val->attrs_len) ); attr_names = sups[attr_names], depth++)
+         {
+            if ((cls->may[attr_names / 64] & (UINT64_C(1) << (attr_names % 64))))
+            {
+               cls->may[y / 64] |= UINT64_C(1) << (y % 64);
+               break;
+            };
+         };
+      };
+      idx++;
+   };
+
+   free(sups);
+
+   *valp = val;
+
+   return(LDAPSCHEMA_SUCCESS);
+}
+
+/* end of source file */
@@ -0,0 +1,117 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *   @file src/ldapschema/lvalidate.h  validates entries against schema
+ */
+#ifndef _LIB_LIBLDAPSCHEMA_LVALIDATE_H
+#define _LIB_LIBLDAPSCHEMA_LVALIDATE_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include "libldapschema.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#define LDAPSCHEMA_CHECK_SETS             4096     ///< maximum objectClass combinations resolved by each checker
+#define LDAPSCHEMA_EXTENSIBLEOBJECT       "1.3.6.1.4.1.1466.101.120.111"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+void
+ldapschema_check_bits(
+         LDAPSchemaValidator      * val,
+         uint64_t                 * bits,
+         LDAPSchemaAttributeType ** list,
+         size_t                     len );
+
+size_t
+ldapschema_check_find(
+         const LDAPSchemaCheckName * names,
+         size_t                     size,
+         const char               * name,
+         size_t                     len );
+
+size_t
+ldapschema_check_hash(
+         const char               * name,
+         size_t                     len );
+
+int
+ldapschema_check_name(
+         LDAPSchemaCheckName      * names,
+         size_t                     size,
+         const char               * name,
+         size_t                     idx );
+
+LDAPSchemaCheckSet *
+ldapschema_check_set(
+         LDAPSchemaChecker        * chk );
+
+int
+ldapschema_check_utf8(
+         const unsigned char      * str,
+         size_t                     len );
+
+int
+ldapschema_check_value(
+         LDAPSchemaChecker        * chk,
+         const LDAPSchemaSyntax   * syntax,
+         const struct berval      * val );
+
+int
+ldapschema_check_violate(
+         LDAPSchemaChecker        * chk,
+         int                        code,
+         const char               * name,
+         size_t                     len,
+         size_t                     value );
+
+
+#endif /* end of header file */
@@ -0,0 +1,901 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/larrow.c  Apache Arrow IPC stream writer
+ */
+/*
+ *  Writes the Arrow IPC streaming format without depending upon the Arrow
+ *  libraries.  The stream consists of a schema message followed by record
+ *  batch messages and an end of stream marker.  Message metadata is encoded
+ *  as flatbuffers which are laid out front to back, each table is written
+ *  before the strings, vectors and tables it references and the offsets are
+ *  patched once the referenced objects have been written.
+ */
+#define _LIB_LIBLDAPUTILS_LARROW_C 1
+#include "larrow.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <assert.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// appends value to column of current row
+/// @param[in] arrow   reference to Arrow stream writer
+/// @param[in] col     index of column
+/// @param[in] data    value
+/// @param[in] len     length of value
+int ldaputils_arrow_append(LDAPUtilsArrow * arrow, int col, const void * data, size_t len)
+{
+   LDAPUtilsArrowColumn * column;
+
+   assert(arrow != NULL);
+   assert(data  != NULL);
+   assert( (col >= 0) && ((size_t)col < arrow->cols_len) );
+
+   column = &arrow->cols[col];
+
+   // columns without lists hold a single value per row
+   if ( (!(column->flags & LDAPUTILS_ARROW_LIST)) && ((column->cell)) )
+   {
+      errno = EINVAL;
+      return(-1);
+   };
+   column->cell++;
+
+   return(ldaputils_arrow_value(column, data, len));
+}
+
+
+/// writes rows of current batch as record batch message
+/// @param[in] arrow   reference to Arrow stream writer
+int ldaputils_arrow_batch(LDAPUtilsArrow * arrow)
+{
+   int                     rc;
+   size_t                  x;
+   size_t                  pos;
+   size_t                  body;
+   size_t                  nodes_len;
+   size_t                  bufs_len;
+   int64_t               * nodes;
+   int64_t               * descs;
+   LDAPUtilsFBField        msg[4];
+   LDAPUtilsFBField        batch[3];
+   LDAPUtilsArrowBuff    * meta;
+   LDAPUtilsArrowBuff   ** bufs;
+   LDAPUtilsArrowColumn  * col;
+
+   assert(arrow != NULL);
+
+   // schema precedes first record batch
+   if ( (!(arrow->started)) && (ldaputils_arrow_schema(arrow) == -1) )
+      return(-1);
+   if (!(arrow->rows))
+      return(0);
+
+   // each column has at most two field nodes and five buffers
+   if ((bufs = malloc(sizeof(LDAPUtilsArrowBuff *) * arrow->cols_len * 5)) == NULL)
+      return(-1);
+   if ((nodes = malloc(sizeof(int64_t) * arrow->cols_len * 14)) == NULL)
+   {
+      free(bufs);
+      return(-1);
+   };
+   descs = &nodes[arrow->cols_len * 4];
+
+   // lists field nodes and buffers in depth first order, validity buffers
+   // of arrays without nulls are omitted
+   nodes_len = 0;
+   bufs_len  = 0;
+   for(x = 0; (x < arrow->cols_len); x++)
+   {
+      col = &arrow->cols[x];
+      if ((col->flags & LDAPUTILS_ARROW_LIST))
+      {
+         nodes[nodes_len++] = (int64_t)arrow->rows;
+         nodes[nodes_len++] = (int64_t)col->list_nulls;
+         bufs[bufs_len++]   = ((col->list_nulls)) ? &col->list_validity : NULL;
+         bufs[bufs_len++]   = &col->list_offsets;
+      };
+      nodes[nodes_len++] = (int64_t)col->count;
+      nodes[nodes_len++] = (int64_t)col->nulls;
+      bufs[bufs_len++]   = ((col->nulls)) ? &col->validity : NULL;
+      if ( (col->type == LDAPUTILS_ARROW_UTF8) || (col->type == LDAPUTILS_ARROW_BINARY) )
+         bufs[bufs_len++] = &col->offsets;
+      bufs[bufs_len++]   = &col->data;
+   };
+
+   // calculates location of buffers within message body
+   body = 0;
+   for(x = 0; (x < bufs_len); x++)
+   {
+      if ( ((bufs[x])) && ((bufs[x]->err)) )
+      {
+         errno = bufs[x]->err;
+         free(bufs);
+         free(nodes);
+         return(-1);
+      };
+      descs[(x*2)+0] = (int64_t)body;
+      descs[(x*2)+1] = ((bufs[x])) ? (int64_t)bufs[x]->len : 0;
+      body          += ((bufs[x])) ? ((bufs[x]->len + 7) & ~((size_t)7)) : 0;
+   };
+
+   // encodes Message and RecordBatch tables
+   meta = &arrow->meta;
+   meta->len = 0;
+   meta->err = 0;
+   ldaputils_arrow_buff(meta, NULL, 4);
+
+   memset(msg, 0, sizeof(msg));
+   msg[0].size  = 2;  msg[0].value = LDAPUTILS_ARROW_VERSION;
+   msg[1].size  = 1;  msg[1].value = LDAPUTILS_ARROW_MSG_BATCH;
+   msg[2].size  = 4;
+   msg[3].size  = 8;  msg[3].value = (uint64_t)body;
+   pos = ldaputils_fb_table(meta, msg, 4);
+   ldaputils_fb_patch(meta, 0, pos);
+
+   memset(batch, 0, sizeof(batch));
+   batch[0].size = 8;  batch[0].value = (uint64_t)arrow->rows;
+   batch[1].size = 4;
+   batch[2].size = 4;
+   pos = ldaputils_fb_table(meta, batch, 3);
+   ldaputils_fb_patch(meta, msg[2].pos, pos);
+
+   pos = ldaputils_fb_vector(meta, nodes, nodes_len/2, 16);
+   ldaputils_fb_patch(meta, batch[1].pos, pos);
+
+   pos = ldaputils_fb_vector(meta, descs, bufs_len, 16);
+   ldaputils_fb_patch(meta, batch[2].pos, pos);
+
+   rc = ldaputils_arrow_message(arrow, meta, bufs, bufs_len);
+
+   free(bufs);
+   free(nodes);
+
+   ldaputils_arrow_reset(arrow);
+
+   return(rc);
+}
+
+
+/// sets bit within bitmap, extending bitmap as needed
+/// @param[in] buff    reference to bitmap
+/// @param[in] idx     index of bit
+/// @param[in] val     value of bit
+void ldaputils_arrow_bit(LDAPUtilsArrowBuff * buff, size_t idx, int val)
+{
+   if ((buff->len <= (idx/8)) && (ldaputils_arrow_buff(buff, NULL, (idx/8) - buff->len + 1) == -1))
+      return;
+   if ((val))
+      buff->data[idx/8] |= (unsigned char)(1U << (idx % 8));
+   return;
+}
+
+
+/// appends data to buffer
+/// @param[in] buff    reference to buffer
+/// @param[in] data    data to append or NULL to append zeros
+/// @param[in] len     length of data
+int ldaputils_arrow_buff(LDAPUtilsArrowBuff * buff, const void * data, size_t len)
+{
+   size_t          size;
+   unsigned char * ptr;
+
+   if ((buff->err))
+      return(-1);
+
+   if ((buff->len + len) > buff->size)
+   {
+      for(size = ((buff->size)) ? buff->size : 1024; (size < (buff->len + len)); size *= 2);
+      if ((ptr = realloc(buff->data, size)) == NULL)
+      {
+         buff->err = ENOMEM;
+         return(-1);
+      };
+      buff->data = ptr;
+      buff->size = size;
+   };
+
+   if ((data))
+      memcpy(&buff->data[buff->len], data, len);
+   else
+      memset(&buff->data[buff->len], 0, len);
+   buff->len += len;
+
+   return(0);
+}
+
+
+/// adds column to schema
+/// @param[in] arrow   reference to Arrow stream writer
+/// @param[in] name    name of column
+/// @param[in] type    value type of column
+/// @param[in] flags   column flags
+int ldaputils_arrow_column(LDAPUtilsArrow * arrow, const char * name, int type, int flags)
+{
+   size_t                  x;
+   size_t                  idx;
+   size_t                  size;
+   int                   * hash;
+   LDAPUtilsArrowColumn  * cols;
+   LDAPUtilsArrowColumn  * col;
+
+   assert(arrow != NULL);
+   assert(name  != NULL);
+
+   // schema is fixed once the first row is started
+   if ( ((arrow->started)) || ((arrow->rows)) || (type < LDAPUTILS_ARROW_UTF8) || (type > LDAPUTILS_ARROW_BOOL) )
+   {
+      errno = EINVAL;
+      return(-1);
+   };
+   if (ldaputils_arrow_find(arrow, name, strlen(name)) != -1)
+   {
+      errno = EEXIST;
+      return(-1);
+   };
+
+   // grows hash table to keep it at most half full
+   for(size = 16; (size < ((arrow->cols_len + 1) * 2)); size *= 2);
+   if (size > (arrow->hash_mask + 1))
+   {
+      if ((hash = realloc(arrow->hash, sizeof(int) * size)) == NULL)
+         return(-1);
+      arrow->hash      = hash;
+      arrow->hash_mask = size - 1;
+      for(idx = 0; (idx < size); idx++)
+         hash[idx] = -1;
+      for(x = 0; (x < arrow->cols_len); x++)
+      {
+         col = &arrow->cols[x];
+         for(idx = ldaputils_arrow_hash(col->name, col->name_len) & arrow->hash_mask; (hash[idx] != -1); idx = (idx+1) & arrow->hash_mask);
+         hash[idx] = (int)x;
+      };
+   };
+
+   if ((cols = realloc(arrow->cols, sizeof(LDAPUtilsArrowColumn) * (arrow->cols_len + 1))) == NULL)
+      return(-1);
+   arrow->cols = cols;
+
+   col = &cols[arrow->cols_len];
+   memset(col, 0, sizeof(LDAPUtilsArrowColumn));
+   if ((col->name = strdup(name)) == NULL)
+      return(-1);
+   col->name_len = strlen(name);
+   col->type     = type;
+   col->flags    = flags;
+
+   for(idx = ldaputils_arrow_hash(col->name, col->name_len) & arrow->hash_mask; (arrow->hash[idx] != -1); idx = (idx+1) & arrow->hash_mask);
+   arrow->hash[idx] = (int)arrow->cols_len;
+
+   arrow->cols_len++;
+
+   ldaputils_arrow_reset(arrow);
+
+   return((int)arrow->cols_len - 1);
+}
+
+
+/// encodes Field table describing column
+/// @param[in] meta    reference to metadata buffer
+/// @param[in] name    name of field
+/// @param[in] len     length of name
+/// @param[in] type    value type of field
+/// @param[in] flags   column flags
+size_t ldaputils_arrow_field(LDAPUtilsArrowBuff * meta, const char * name, size_t len, int type, int flags)
+{
+   size_t             pos;
+   size_t             vec;
+   size_t             ntype;
+   LDAPUtilsFBField   field[6];
+   LDAPUtilsFBField   info[2];
+
+   memset(field, 0, sizeof(field));
+   memset(info,  0, sizeof(info));
+   ntype = 0;
+
+   field[0].size = 4;
+   field[1].size = 1;  field[1].value = 1;
+   field[2].size = 1;
+   field[3].size = 4;
+   field[5].size = 4;
+
+   switch(type)
+   {
+      case LDAPUTILS_ARROW_BINARY: field[2].value = LDAPUTILS_ARROW_FB_BINARY; break;
+      case LDAPUTILS_ARROW_BOOL:   field[2].value = LDAPUTILS_ARROW_FB_BOOL;   break;
+      case LDAPUTILS_ARROW_INT64:
+      field[2].value = LDAPUTILS_ARROW_FB_INT;
+      info[0].size   = 4;  info[0].value = 64;
+      info[1].size   = 1;  info[1].value = 1;
+      ntype          = 2;
+      break;
+      default:                     field[2].value = LDAPUTILS_ARROW_FB_UTF8;   break;
+   };
+   if ((flags & LDAPUTILS_ARROW_LIST))
+   {
+      field[2].value = LDAPUTILS_ARROW_FB_LIST;
+      ntype          = 0;
+   };
+
+   pos = ldaputils_fb_table(meta, field, 6);
+   ldaputils_fb_patch(meta, field[0].pos, ldaputils_fb_string(meta, name, len));
+   ldaputils_fb_patch(meta, field[3].pos, ldaputils_fb_table(meta, info, ntype));
+
+   // values of lists are described by a single child field
+   vec = ldaputils_fb_vector(meta, NULL, ((flags & LDAPUTILS_ARROW_LIST)) ? 1 : 0, 4);
+   ldaputils_fb_patch(meta, field[5].pos, vec);
+   if ((flags & LDAPUTILS_ARROW_LIST))
+      ldaputils_fb_patch(meta, vec+4, ldaputils_arrow_field(meta, "item", 4, type, 0));
+
+   return(pos);
+}
+
+
+/// returns index of column
+/// @param[in] arrow   reference to Arrow stream writer
+/// @param[in] name    name of column
+/// @param[in] len     length of name
+int ldaputils_arrow_find(LDAPUtilsArrow * arrow, const char * name, size_t len)
+{
+   int                    x;
+   size_t                 idx;
+   LDAPUtilsArrowColumn * col;
+
+   assert(arrow != NULL);
+   assert(name  != NULL);
+
+   if (!(arrow->hash))
+      return(-1);
+
+   for(idx = ldaputils_arrow_hash(name, len) & arrow->hash_mask; ((x = arrow->hash[idx]) != -1); idx = (idx+1) & arrow->hash_mask)
+   {
+      col = &arrow->cols[x];
+      if ( (col->name_len == len) && (strncasecmp(col->name, name, len) == 0) )
+         return(x);
+   };
+
+   return(-1);
+}
+
+
+/// writes remaining rows and end of stream marker
+/// @param[in] arrow   reference to Arrow stream writer
+int ldaputils_arrow_finish(LDAPUtilsArrow * arrow)
+{
+   uint32_t eos[2];
+
+   assert(arrow != NULL);
+
+   if (ldaputils_arrow_batch(arrow) == -1)
+      return(-1);
+
+   eos[0] = 0xFFFFFFFF;
+   eos[1] = 0;
+
+   return(ldaputils_sink_write(arrow->sink, eos, sizeof(eos)));
+}
+
+
+/// frees Arrow stream writer
+/// @param[in] arrow   reference to Arrow stream writer
+void ldaputils_arrow_free(LDAPUtilsArrow * arrow)
+{
+   size_t                 x;
+   LDAPUtilsArrowColumn * col;
+
+   if (!(arrow))
+      return;
+
+   for(x = 0; (x < arrow->cols_len); x++)
+   {
+      col = &arrow->cols[x];
+      free(col->name);
+      free(col->list_validity.data);
+      free(col->list_offsets.data);
+      free(col->validity.data);
+      free(col->offsets.data);
+      free(col->data.data);
+   };
+
+   free(arrow->cols);
+   free(arrow->hash);
+   free(arrow->meta.data);
+   free(arrow);
+
+   return;
+}
+
+
+/// calculates case-insensitive hash of column name
+/// @param[in] name    name of column
+/// @param[in] len     length of name
+size_t ldaputils_arrow_hash(const char * name, size_t len)
+{
+   size_t     x;
+   uint64_t   hash;
+
+   hash = 14695981039346656037ULL;
+   for(x = 0; (x < len); x++)
+   {
+      hash ^= (unsigned char)tolower((unsigned char)name[x]);
+      hash *= 1099511628211ULL;
+   };
+
+   return((size_t)(hash ^ (hash >> 32)));
+}
+
+
+/// initializes Arrow IPC stream writer
+/// @param[out] arrowp  reference to store stream writer
+/// @param[in]  sink    output sink for stream
+/// @param[in]  rows    number of rows per record batch or 0 for default
+int ldaputils_arrow_initialize(LDAPUtilsArrow ** arrowp, LDAPUtilsSink * sink, size_t rows)
+{
+   LDAPUtilsArrow * arrow;
+
+   assert(arrowp != NULL);
+   assert(sink   != NULL);
+
+   if ((arrow = calloc(1, sizeof(LDAPUtilsArrow))) == NULL)
+      return(-1);
+
+   arrow->sink       = sink;
+   arrow->batch_rows = ((rows)) ? rows : LDAPUTILS_ARROW_ROWS;
+
+   *arrowp = arrow;
+
+   return(0);
+}
+
+
+/// writes encapsulated message and message body
+/// @param[in] arrow     reference to Arrow stream writer
+/// @param[in] meta      flatbuffer encoded message metadata
+/// @param[in] bufs      buffers of message body, NULL for empty buffers
+/// @param[in] bufs_len  number of buffers
+int ldaputils_arrow_message(LDAPUtilsArrow * arrow, LDAPUtilsArrowBuff * meta, LDAPUtilsArrowBuff ** bufs, size_t bufs_len)
+{
+   size_t           x;
+   size_t           pad;
+   uint32_t         prefix[2];
+   static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+   // metadata is padded so the message body is 8 byte aligned
+   ldaputils_fb_align(meta, 8);
+   if ((meta->err))
+   {
+      errno = meta->err;
+      return(-1);
+   };
+
+   prefix[0] = 0xFFFFFFFF;
+   prefix[1] = (uint32_t)meta->len;
+   if (ldaputils_sink_write(arrow->sink, prefix, sizeof(prefix)) == -1)
+      return(-1);
+   if (ldaputils_sink_write(arrow->sink, meta->data, meta->len) == -1)
+      return(-1);
+
+   for(x = 0; (x < bufs_len); x++)
+   {
+      if (!(bufs[x]))
+         continue;
+      if (ldaputils_sink_write(arrow->sink, bufs[x]->data, bufs[x]->len) == -1)
+         return(-1);
+      if (((pad = (8 - (bufs[x]->len % 8)) % 8)) && (ldaputils_sink_write(arrow->sink, zeros, pad) == -1))
+         return(-1);
+   };
+
+   return(0);
+}
+
+
+/// completes current row and writes record batch when full
+/// @param[in] arrow   reference to Arrow stream writer
+int ldaputils_arrow_next(LDAPUtilsArrow * arrow)
+{
+   size_t                 x;
+   int32_t                off;
+   LDAPUtilsArrowColumn * col;
+
+   assert(arrow != NULL);
+
+   for(x = 0; (x < arrow->cols_len); x++)
+   {
+      col = &arrow->cols[x];
+
+      // columns without values are null
+      if ((col->flags & LDAPUTILS_ARROW_LIST))
+      {
+         ldaputils_arrow_bit(&col->list_validity, arrow->rows, ((col->cell)) ? 1 : 0);
+         if (!(col->cell))
+            col->list_nulls++;
+         off = (int32_t)col->count;
+         ldaputils_arrow_buff(&col->list_offsets, &off, sizeof(off));
+      }
+      else if (!(col->cell))
+      {
+         ldaputils_arrow_value(col, NULL, 0);
+      };
+
+      col->cell = 0;
+   };
+
+   if ((++arrow->rows) < arrow->batch_rows)
+      return(0);
+
+   return(ldaputils_arrow_batch(arrow));
+}
+
+
+/// empties column buffers for next record batch
+/// @param[in] arrow   reference to Arrow stream writer
+void ldaputils_arrow_reset(LDAPUtilsArrow * arrow)
+{
+   size_t                 x;
+   int32_t                off;
+   LDAPUtilsArrowColumn * col;
+
+   off         = 0;
+   arrow->rows = 0;
+
+   for(x = 0; (x < arrow->cols_len); x++)
+   {
+      col                    = &arrow->cols[x];
+      col->cell              = 0;
+      col->count             = 0;
+      col->nulls             = 0;
+      col->list_nulls        = 0;
+      col->list_validity.len = 0;
+      col->list_offsets.len  = 0;
+      col->validity.len      = 0;
+      col->offsets.len       = 0;
+      col->data.len          = 0;
+
+      // offset buffers start with offset of first value
+      if ((col->flags & LDAPUTILS_ARROW_LIST))
+         ldaputils_arrow_buff(&col->list_offsets, &off, sizeof(off));
+      ldaputils_arrow_buff(&col->offsets, &off, sizeof(off));
+   };
+
+   return;
+}
+
+
+/// writes schema message
+/// @param[in] arrow   reference to Arrow stream writer
+int ldaputils_arrow_schema(LDAPUtilsArrow * arrow)
+{
+   size_t                 x;
+   size_t                 pos;
+   size_t                 vec;
+   LDAPUtilsFBField       msg[4];
+   LDAPUtilsFBField       schema[2];
+   LDAPUtilsArrowBuff   * meta;
+   LDAPUtilsArrowColumn * col;
+
+   meta = &arrow->meta;
+   meta->len = 0;
+   meta->err = 0;
+   ldaputils_arrow_buff(meta, NULL, 4);
+
+   memset(msg, 0, sizeof(msg));
+   msg[0].size  = 2;  msg[0].value = LDAPUTILS_ARROW_VERSION;
+   msg[1].size  = 1;  msg[1].value = LDAPUTILS_ARROW_MSG_SCHEMA;
+   msg[2].size  = 4;
+   msg[3].size  = 8;
+   pos = ldaputils_fb_table(meta, msg, 4);
+   ldaputils_fb_patch(meta, 0, pos);
+
+   // buffers are written in host byte order
+   memset(schema, 0, sizeof(schema));
+   schema[0].size = 2;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+   schema[0].value = 1;
+#endif
+   schema[1].size = 4;
+   pos = ldaputils_fb_table(meta, schema, 2);
+   ldaputils_fb_patch(meta, msg[2].pos, pos);
+
+   vec = ldaputils_fb_vector(meta, NULL, arrow->cols_len, 4);
+   ldaputils_fb_patch(meta, schema[1].pos, vec);
+   for(x = 0; (x < arrow->cols_len); x++)
+   {
+      col = &arrow->cols[x];
+      pos = ldaputils_arrow_field(meta, col->name, col->name_len, col->type, col->flags);
+      ldaputils_fb_patch(meta, vec + 4 + (x * 4), pos);
+   };
+
+   arrow->started = 1;
+
+   return(ldaputils_arrow_message(arrow, meta, NULL, 0));
+}
+
+
+/// appends value to column, values which cannot be represented by the
+/// column's type are stored as null
+/// @param[in] col     reference to column
+/// @param[in] data    value or NULL for null value
+/// @param[in] len     length of value
+int ldaputils_arrow_value(LDAPUtilsArrowColumn * col, const void * data, size_t len)
+{
+   int            rc;
+   int            valid;
+   int            flag;
+   int            neg;
+   size_t         pos;
+   int32_t        off;
+   uint64_t       num;
+   uint64_t       limit;
+   const char   * str;
+
+   rc    = 0;
+   flag  = 0;
+   num   = 0;
+   valid = ((data)) ? 1 : 0;
+   str   = data;
+
+   // validates value
+   if ((valid)) switch(col->type)
+   {
+      case LDAPUTILS_ARROW_UTF8:
+      if (!(ldaputils_utf8_valid(data, len)))
+         rc = EINVAL;
+      break;
+
+      case LDAPUTILS_ARROW_INT64:
+      neg   = ( (len > 0) && (str[0] == '-') ) ? 1 : 0;
+      limit = ((neg)) ? ((uint64_t)INT64_MAX + 1) : (uint64_t)INT64_MAX;
+      pos   = ( (len > 0) && ((str[0] == '-') || (str[0] == '+')) ) ? 1 : 0;
+      if (pos >= len)
+         rc = EINVAL;
+      for(; ( (pos < len) && (!(rc)) ); pos++)
+      {
+         if ( (str[pos] < '0') || (str[pos] > '9') || (num > ((limit - (uint64_t)(str[pos] - '0')) / 10)) )
+            rc = EINVAL;
+         num = (num * 10) + (uint64_t)(str[pos] - '0');
+      };
+      if ((neg))
+         num = ~num + 1;
+      break;
+
+      case LDAPUTILS_ARROW_BOOL:
+      if ( (len == 4) && (strncasecmp(str, "TRUE", 4) == 0) )
+         flag = 1;
+      else if ( (len != 5) || (strncasecmp(str, "FALSE", 5) != 0) )
+         rc = EINVAL;
+      break;
+
+      default:
+      break;
+   };
+
+   // 32 bit offsets limit size of values within a single record batch
+   if ( (!(rc)) && ((valid)) && ((col->data.len + len) > INT32_MAX) )
+      rc = EOVERFLOW;
+   if ((rc))
+   {
+      valid = 0;
+      num   = 0;
+   };
+
+   ldaputils_arrow_bit(&col->validity, col->count, valid);
+   if (!(valid))
+      col->nulls++;
+
+   switch(col->type)
+   {
+      case LDAPUTILS_ARROW_INT64:
+      ldaputils_arrow_buff(&col->data, &num, sizeof(num));
+      break;
+
+      case LDAPUTILS_ARROW_BOOL:
+      ldaputils_arrow_bit(&col->data, col->count, ((valid)) && ((flag)));
+      break;
+
+      default:
+      if ((valid))
+         ldaputils_arrow_buff(&col->data, data, len);
+      off = (int32_t)col->data.len;
+      ldaputils_arrow_buff(&col->offsets, &off, sizeof(off));
+      break;
+   };
+
+   col->count++;
+
+   if ((rc))
+   {
+      errno = rc;
+      return(-1);
+   };
+
+   return(0);
+}
+
+
+/// pads buffer with zeros to alignment
+/// @param[in] buff    reference to buffer
+/// @param[in] align   alignment
+size_t ldaputils_fb_align(LDAPUtilsArrowBuff * buff, size_t align)
+{
+   if ((buff->len % align))
+      ldaputils_arrow_buff(buff, NULL, align - (buff->len % align));
+   return(buff->len);
+}
+
+
+/// stores offset from position to target
+/// @param[in] buff    reference to buffer
+/// @param[in] pos     position of offset
+/// @param[in] target  position of referenced object
+void ldaputils_fb_patch(LDAPUtilsArrowBuff * buff, size_t pos, size_t target)
+{
+   uint32_t off;
+   if ((buff->err))
+      return;
+   assert(target > pos);
+   off = (uint32_t)(target - pos);
+   memcpy(&buff->data[pos], &off, sizeof(off));
+   return;
+}
+
+
+/// appends flatbuffer string
+/// @param[in] buff    reference to buffer
+/// @param[in] str     string
+/// @param[in] len     length of string
+size_t ldaputils_fb_string(LDAPUtilsArrowBuff * buff, const char * str, size_t len)
+{
+   size_t     pos;
+   uint32_t   slen;
+
+   pos  = ldaputils_fb_align(buff, 4);
+   slen = (uint32_t)len;
+   ldaputils_arrow_buff(buff, &slen, sizeof(slen));
+   ldaputils_arrow_buff(buff, str,   len);
+   ldaputils_arrow_buff(buff, NULL,  1);
+
+   return(pos);
+}
+
+
+/// appends flatbuffer table, fields are placed in order of descending size
+/// so each field is naturally aligned
+/// @param[in] buff    reference to buffer
+/// @param[in] fields  fields of table, positions of fields are returned
+/// @param[in] len     number of fields
+size_t ldaputils_fb_table(LDAPUtilsArrowBuff * buff, LDAPUtilsFBField * fields, size_t len)
+{
+   size_t     x;
+   size_t     size;
+   size_t     off;
+   size_t     vt;
+   size_t     pos;
+   int32_t    soff;
+   uint16_t   vtable[LDAPUTILS_ARROW_FB_FIELDS + 2];
+   uint8_t    v8;
+   uint16_t   v16;
+   uint32_t   v32;
+
+   assert(len <= LDAPUTILS_ARROW_FB_FIELDS);
+
+   memset(vtable, 0, sizeof(vtable));
+
+   off = 4;
+   for(size = 8; (size > 0); size /= 2)
+   {
+      for(x = 0; (x < len); x++)
+      {
+         if (fields[x].size != size)
+            continue;
+         off           = (off + size - 1) & ~(size - 1);
+         vtable[x + 2] = (uint16_t)off;
+         off          += size;
+      };
+   };
+   vtable[0] = (uint16_t)((len + 2) * 2);
+   vtable[1] = (uint16_t)off;
+
+   // vtable precedes table
+   vt  = ldaputils_fb_align(buff, 2);
+   ldaputils_arrow_buff(buff, vtable, (len + 2) * 2);
+   pos  = ldaputils_fb_align(buff, 8);
+   soff = (int32_t)(pos - vt);
+   ldaputils_arrow_buff(buff, &soff, sizeof(soff));
+   ldaputils_arrow_buff(buff, NULL, off - 4);
+   if ((buff->err))
+      return(pos);
+
+   for(x = 0; (x < len); x++)
+   {
+      fields[x].pos = pos + vtable[x + 2];
+      switch(fields[x].size)
+      {
+         case 1: v8  = (uint8_t)fields[x].value;  memcpy(&buff->data[fields[x].pos], &v8,  1); break;
+         case 2: v16 = (uint16_t)fields[x].value; memcpy(&buff->data[fields[x].pos], &v16, 2); break;
+         case 4: v32 = (uint32_t)fields[x].value; memcpy(&buff->data[fields[x].pos], &v32, 4); break;
+         case 8: memcpy(&buff->data[fields[x].pos], &fields[x].value, 8); break;
+         default: break;
+      };
+   };
+
+   return(pos);
+}
+
+
+/// appends flatbuffer vector
+/// @param[in] buff    reference to buffer
+/// @param[in] data    elements of vector or NULL to zero elements
+/// @param[in] count   number of elements
+/// @param[in] size    size of each element
+size_t ldaputils_fb_vector(LDAPUtilsArrowBuff * buff, const void * data, size_t count, size_t size)
+{
+   size_t     pos;
+   size_t     align;
+   uint32_t   len;
+
+   // elements follow length and are aligned to size of largest scalar
+   align = (size >= 8) ? 8 : 4;
+   ldaputils_fb_align(buff, 4);
+   if (((buff->len + 4) % align))
+      ldaputils_arrow_buff(buff, NULL, 4);
+   pos = buff->len;
+   len = (uint32_t)count;
+   ldaputils_arrow_buff(buff, &len, sizeof(len));
+   ldaputils_arrow_buff(buff, data, count * size);
+
+   return(pos);
+}
+
+/* end of source file */
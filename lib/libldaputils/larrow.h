@@ -0,0 +1,104 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/larrow.h  Apache Arrow IPC stream writer
+ */
+#ifndef _LIB_LIBLDAPUTILS_LARROW_H
+#define _LIB_LIBLDAPUTILS_LARROW_H 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// Arrow MetadataVersion V5
+#define LDAPUTILS_ARROW_VERSION        4
+
+// Arrow MessageHeader union types
+#define LDAPUTILS_ARROW_MSG_SCHEMA     1
+#define LDAPUTILS_ARROW_MSG_BATCH      3
+
+// Arrow Type union types
+#define LDAPUTILS_ARROW_FB_INT         2
+#define LDAPUTILS_ARROW_FB_BINARY      4
+#define LDAPUTILS_ARROW_FB_UTF8        5
+#define LDAPUTILS_ARROW_FB_BOOL        6
+#define LDAPUTILS_ARROW_FB_LIST        12
+
+// number of flatbuffer fields in largest table written
+#define LDAPUTILS_ARROW_FB_FIELDS      6
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+int ldaputils_arrow_batch(LDAPUtilsArrow * arrow);
+void ldaputils_arrow_bit(LDAPUtilsArrowBuff * buff, size_t idx, int val);
+int ldaputils_arrow_buff(LDAPUtilsArrowBuff * buff, const void * data, size_t len);
+size_t ldaputils_arrow_field(LDAPUtilsArrowBuff * meta, const char * name, size_t len, int type, int flags);
+size_t ldaputils_arrow_hash(const char * name, size_t len);
+int ldaputils_arrow_message(LDAPUtilsArrow * arrow, LDAPUtilsArrowBuff * meta, LDAPUtilsArrowBuff ** bufs, size_t bufs_len);
+void ldaputils_arrow_reset(LDAPUtilsArrow * arrow);
+int ldaputils_arrow_schema(LDAPUtilsArrow * arrow);
+int ldaputils_arrow_value(LDAPUtilsArrowColumn * col, const void * data, size_t len);
+
+size_t ldaputils_fb_align(LDAPUtilsArrowBuff * buff, size_t align);
+void ldaputils_fb_patch(LDAPUtilsArrowBuff * buff, size_t pos, size_t target);
+size_t ldaputils_fb_string(LDAPUtilsArrowBuff * buff, const char * str, size_t len);
+size_t ldaputils_fb_table(LDAPUtilsArrowBuff * buff, LDAPUtilsFBField * fields, size_t len);
+size_t ldaputils_fb_vector(LDAPUtilsArrowBuff * buff, const void * data, size_t count, size_t size);
+
+#endif /* end of header file */
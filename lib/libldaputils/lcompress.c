@@ -0,0 +1,444 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lcompress.c  block parallel output compression
+ */
+#define _LIB_LIBLDAPUTILS_LCOMPRESS_C 1
+#include "lcompress.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+
+#ifdef LDAPUTILS_COMPRESS_GZIP_SUPPORT
+#include <zlib.h>
+#endif
+#ifdef LDAPUTILS_COMPRESS_ZSTD_SUPPORT
+#include <zstd.h>
+#endif
+
+#include "lsink.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// compresses block into an independent gzip member or zstd frame
+/// @param[in] comp    reference to compression state
+/// @param[in] job     block to compress
+int ldaputils_compress_block(LDAPUtilsCompress * comp, LDAPUtilsCompressJob * job)
+{
+   size_t     size;
+   char     * out;
+#ifdef LDAPUTILS_COMPRESS_GZIP_SUPPORT
+   int        rc;
+   z_stream   zs;
+#endif
+
+   assert(comp != NULL);
+   assert(job  != NULL);
+
+   job->out_len = 0;
+
+   switch(comp->type)
+   {
+#ifdef LDAPUTILS_COMPRESS_GZIP_SUPPORT
+      case LDAPUTILS_COMPRESS_GZIP:
+      bzero(&zs, sizeof(zs));
+      if (deflateInit2(&zs, comp->level, Z_DEFLATED, (MAX_WBITS + 16), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      {
+         job->err = ENOMEM;
+         return(-1);
+      };
+      if ((size = (size_t)deflateBound(&zs, (uLong)job->in_len)) > job->out_size)
+      {
+         if ((out = realloc(job->out, size)) == NULL)
+         {
+            deflateEnd(&zs);
+            job->err = ENOMEM;
+            return(-1);
+         };
+         job->out      = out;
+         job->out_size = size;
+      };
+      zs.next_in   = (Bytef *)job->in;
+      zs.avail_in  = (uInt)job->in_len;
+      zs.next_out  = (Bytef *)job->out;
+      zs.avail_out = (uInt)job->out_size;
+      rc           = deflate(&zs, Z_FINISH);
+      job->out_len = (size_t)zs.total_out;
+      deflateEnd(&zs);
+      if (rc != Z_STREAM_END)
+      {
+         job->err = EIO;
+         return(-1);
+      };
+      return(0);
+#endif
+
+#ifdef LDAPUTILS_COMPRESS_ZSTD_SUPPORT
+      case LDAPUTILS_COMPRESS_ZSTD:
+      if ((size = ZSTD_compressBound(job->in_len)) > job->out_size)
+      {
+         if ((out = realloc(job->out, size)) == NULL)
+         {
+            job->err = ENOMEM;
+            return(-1);
+         };
+         job->out      = out;
+         job->out_size = size;
+      };
+      size = ZSTD_compress(job->out, job->out_size, job->in, job->in_len, comp->level);
+      if ((ZSTD_isError(size)))
+      {
+         job->err = EIO;
+         return(-1);
+      };
+      job->out_len = size;
+      return(0);
+#endif
+
+      default:
+      break;
+   };
+
+   job->err = ENOTSUP;
+
+   return(-1);
+}
+
+
+/// writes compressed blocks in order
+/// @param[in] sink     reference to output sink
+/// @param[in] pending  number of outstanding blocks allowed before waiting
+int ldaputils_compress_drain(LDAPUtilsSink * sink, size_t pending)
+{
+   LDAPUtilsCompress     * comp;
+   LDAPUtilsCompressJob  * job;
+   struct iovec            iov;
+
+   assert(sink           != NULL);
+   assert(sink->compress != NULL);
+
+   comp = sink->compress;
+
+   while(comp->written < comp->next)
+   {
+      job = &comp->jobs[comp->written % comp->jobs_len];
+
+      // waits for oldest block only if too many blocks are outstanding
+      pthread_mutex_lock(&comp->mutex);
+      if ( (!(job->done)) && ((comp->next - comp->written) <= pending) )
+      {
+         pthread_mutex_unlock(&comp->mutex);
+         return(0);
+      };
+      while (!(job->done))
+         pthread_cond_wait(&comp->done, &comp->mutex);
+      pthread_mutex_unlock(&comp->mutex);
+
+      comp->written++;
+
+      if ((job->err))
+      {
+         if (!(sink->err))
+            sink->err = job->err;
+         errno = sink->err;
+         return(-1);
+      };
+
+      iov.iov_base = job->out;
+      iov.iov_len  = job->out_len;
+      if (ldaputils_sink_writev(sink, &iov, 1) == -1)
+         return(-1);
+   };
+
+   return(0);
+}
+
+
+/// stops worker threads and frees compression state
+/// @param[in] comp    reference to compression state
+void ldaputils_compress_free(LDAPUtilsCompress * comp)
+{
+   size_t x;
+
+   if (!(comp))
+      return;
+
+   pthread_mutex_lock(&comp->mutex);
+   comp->shutdown = 1;
+   pthread_cond_broadcast(&comp->cond);
+   pthread_mutex_unlock(&comp->mutex);
+
+   for(x = 0; x < comp->threads_len; x++)
+      pthread_join(comp->threads[x], NULL);
+   free(comp->threads);
+
+   for(x = 0; ( ((comp->jobs)) && (x < comp->jobs_len) ); x++)
+   {
+      free(comp->jobs[x].in);
+      free(comp->jobs[x].out);
+   };
+   free(comp->jobs);
+
+   pthread_cond_destroy(&comp->done);
+   pthread_cond_destroy(&comp->cond);
+   pthread_mutex_destroy(&comp->mutex);
+
+   free(comp);
+
+   return;
+}
+
+
+/// queues buffered output as a block for compression
+/// @param[in] sink    reference to output sink
+int ldaputils_compress_submit(LDAPUtilsSink * sink)
+{
+   LDAPUtilsCompress     * comp;
+   LDAPUtilsCompressJob  * job;
+   char                  * buff;
+
+   assert(sink           != NULL);
+   assert(sink->compress != NULL);
+
+   comp = sink->compress;
+
+   if ((sink->err))
+   {
+      errno = sink->err;
+      return(-1);
+   };
+
+   // writes oldest block if its slot in the ring is needed
+   if (ldaputils_compress_drain(sink, (comp->jobs_len - 1)) == -1)
+      return(-1);
+   job = &comp->jobs[comp->next % comp->jobs_len];
+
+   // swaps output buffer with idle input buffer of block
+   if ((buff = job->in) == NULL)
+   {
+      if ((buff = malloc(sink->buff_size)) == NULL)
+      {
+         sink->err = ENOMEM;
+         errno     = ENOMEM;
+         return(-1);
+      };
+   };
+   job->in        = sink->buff;
+   job->in_len    = sink->buff_len;
+   job->done      = 0;
+   job->err       = 0;
+   sink->buff     = buff;
+   sink->buff_len = 0;
+
+   // compresses block directly if worker threads are unavailable
+   if (!(comp->threads_len))
+   {
+      ldaputils_compress_block(comp, job);
+      job->done = 1;
+      comp->next++;
+      return(ldaputils_compress_drain(sink, 0));
+   };
+
+   pthread_mutex_lock(&comp->mutex);
+   comp->next++;
+   pthread_cond_signal(&comp->cond);
+   pthread_mutex_unlock(&comp->mutex);
+
+   // writes any blocks which have already been compressed
+   return(ldaputils_compress_drain(sink, comp->jobs_len));
+}
+
+
+/// compresses queued blocks
+/// @param[in] ptr     reference to compression state
+void * ldaputils_compress_worker(void * ptr)
+{
+   LDAPUtilsCompress     * comp;
+   LDAPUtilsCompressJob  * job;
+
+   comp = ptr;
+
+   pthread_mutex_lock(&comp->mutex);
+   while(1)
+   {
+      while ( (comp->claimed == comp->next) && (!(comp->shutdown)) )
+         pthread_cond_wait(&comp->cond, &comp->mutex);
+      if (comp->claimed == comp->next)
+         break;
+      job = &comp->jobs[comp->claimed % comp->jobs_len];
+      comp->claimed++;
+      pthread_mutex_unlock(&comp->mutex);
+
+      ldaputils_compress_block(comp, job);
+
+      pthread_mutex_lock(&comp->mutex);
+      job->done = 1;
+      pthread_cond_broadcast(&comp->done);
+   };
+   pthread_mutex_unlock(&comp->mutex);
+
+   return(NULL);
+}
+
+
+/// enables compression of output
+/// @param[in] sink     reference to output sink
+/// @param[in] spec     algorithm and optional level (gzip[:level] or zstd[:level])
+/// @param[in] threads  number of worker threads or 0 for number of CPUs
+int ldaputils_sink_compress(LDAPUtilsSink * sink, const char * spec, size_t threads)
+{
+   int                  type;
+   int                  level;
+   int                  min;
+   int                  max;
+   long                 num;
+   size_t               x;
+   char               * end;
+   LDAPUtilsCompress  * comp;
+
+   assert(sink != NULL);
+   assert(spec != NULL);
+
+   // compression must be enabled before output is buffered
+   if ( ((sink->compress)) || ((sink->buff_len)) || ((sink->offset)) )
+   {
+      errno = EINVAL;
+      return(-1);
+   };
+
+   // determines algorithm
+   if ( (!(strncasecmp(spec, "gzip", 4))) && ( (spec[4] == '\0') || (spec[4] == ':') ) )
+   {
+      type = LDAPUTILS_COMPRESS_GZIP;
+#ifdef LDAPUTILS_COMPRESS_GZIP_SUPPORT
+      level = 6;
+      min   = Z_BEST_SPEED;
+      max   = Z_BEST_COMPRESSION;
+#else
+      errno = ENOTSUP;
+      return(-1);
+#endif
+   }
+   else if ( (!(strncasecmp(spec, "zstd", 4))) && ( (spec[4] == '\0') || (spec[4] == ':') ) )
+   {
+      type = LDAPUTILS_COMPRESS_ZSTD;
+#ifdef LDAPUTILS_COMPRESS_ZSTD_SUPPORT
+      level = ZSTD_CLEVEL_DEFAULT;
+      min   = 1;
+      max   = ZSTD_maxCLevel();
+#else
+      errno = ENOTSUP;
+      return(-1);
+#endif
+   }
+   else
+   {
+      errno = EINVAL;
+      return(-1);
+   };
+
+   // parses level
+   if (spec[4] == ':')
+   {
+      num = strtol(&spec[5], &end, 10);
+      if ( (spec[5] == '\0') || (end[0] != '\0') || (num < min) || (num > max) )
+      {
+         errno = EINVAL;
+         return(-1);
+      };
+      level = (int)num;
+   };
+
+   if (threads == 0)
+   {
+      num     = sysconf(_SC_NPROCESSORS_ONLN);
+      threads = (num < 1) ? 1 : (size_t)num;
+   };
+   if (threads > LDAPUTILS_COMPRESS_MAX_THREADS)
+      threads = LDAPUTILS_COMPRESS_MAX_THREADS;
+
+   if ((comp = malloc(sizeof(LDAPUtilsCompress))) == NULL)
+      return(-1);
+   bzero(comp, sizeof(LDAPUtilsCompress));
+   comp->type  = type;
+   comp->level = level;
+   pthread_mutex_init(&comp->mutex, NULL);
+   pthread_cond_init(&comp->cond, NULL);
+   pthread_cond_init(&comp->done, NULL);
+
+   // allows each thread one block in progress and one block waiting
+   comp->jobs_len = threads * 2;
+   if ((comp->jobs = malloc(sizeof(LDAPUtilsCompressJob) * comp->jobs_len)) == NULL)
+   {
+      ldaputils_compress_free(comp);
+      return(-1);
+   };
+   bzero(comp->jobs, sizeof(LDAPUtilsCompressJob) * comp->jobs_len);
+
+   // starts worker threads, compressing in calling thread if none start
+   if ((comp->threads = malloc(sizeof(pthread_t) * threads)) != NULL)
+   {
+      for(x = 0; x < threads; x++)
+         if (pthread_create(&comp->threads[x], NULL, ldaputils_compress_worker, comp) != 0)
+            break;
+      comp->threads_len = x;
+   };
+
+   sink->compress = comp;
+
+   return(0);
+}
+
+/* end of source file */
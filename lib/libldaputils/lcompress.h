@@ -0,0 +1,89 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lcompress.h  block parallel output compression
+ */
+#ifndef _LIB_LIBLDAPUTILS_LCOMPRESS_H
+#define _LIB_LIBLDAPUTILS_LCOMPRESS_H 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#define LDAPUTILS_COMPRESS_GZIP_SUPPORT 1
+#endif
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+#define LDAPUTILS_COMPRESS_ZSTD_SUPPORT 1
+#endif
+
+#define LDAPUTILS_COMPRESS_GZIP         1
+#define LDAPUTILS_COMPRESS_ZSTD         2
+
+#define LDAPUTILS_COMPRESS_MAX_THREADS  32
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+int ldaputils_compress_block(LDAPUtilsCompress * comp, LDAPUtilsCompressJob * job);
+int ldaputils_compress_drain(LDAPUtilsSink * sink, size_t pending);
+void ldaputils_compress_free(LDAPUtilsCompress * comp);
+int ldaputils_compress_submit(LDAPUtilsSink * sink);
+void * ldaputils_compress_worker(void * ptr);
+
+#endif /* end of header file */
@@ -150,6 +150,10 @@ int ldaputils_getopt(LDAPUtils * lud, int c, const char * arg)
       lud->dryrun++;
       return(0);
 
+      case 'o':
+      lud->output = arg;
+      return(0);
+
       case 'P':
       valint = atoi(arg);
       if ((rc = ldap_set_option(lud->ld, LDAP_OPT_PROTOCOL_VERSION, &valint)) != LDAP_SUCCESS)
@@ -557,6 +561,7 @@ void ldaputils_usage_common(const char * short_options)
          case 'h': printf("  -h, --help                print this help and exit\n"); break;
          case 'H': printf("  -H URI                    LDAP Uniform Resource Identifier(s)\n"); break;
          case 'n': printf("  -n                        show what would be done but don't actually do it\n"); break;
+         case 'o': printf("  -o file                   write output to file\n"); break;
          //case 'p': printf("  -p port                  port on LDAP server\n"); break;
          case 'v': printf("  -v, --verbose             run in verbose mode\n"); break;
          case 'V': printf("  -V, --version             print version number and exit\n"); break;
@@ -0,0 +1,167 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lcsv.c  CSV field encoding
+ */
+#define _LIB_LIBLDAPUTILS_LCSV_C 1
+#include "lcsv.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// returns offset of first occurrence of any of three bytes
+/// @param[in] data    data to scan
+/// @param[in] len     length of data
+/// @param[in] c1      byte to find
+/// @param[in] c2      byte to find
+/// @param[in] c3      byte to find
+size_t ldaputils_csv_scan(const char * data, size_t len, char c1, char c2, char c3)
+{
+   size_t         pos;
+#if defined(__AVX2__)
+   unsigned       mask;
+   __m256i        v1;
+   __m256i        v2;
+   __m256i        v3;
+   __m256i        blk;
+#elif defined(__SSE2__)
+   unsigned       mask;
+   __m128i        v1;
+   __m128i        v2;
+   __m128i        v3;
+   __m128i        blk;
+#endif
+
+   pos = 0;
+
+#if defined(__AVX2__)
+   v1 = _mm256_set1_epi8(c1);
+   v2 = _mm256_set1_epi8(c2);
+   v3 = _mm256_set1_epi8(c3);
+   for(; ((pos + 32) <= len); pos += 32)
+   {
+      blk  = _mm256_loadu_si256((const __m256i *)(const void *)&data[pos]);
+      blk  = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(blk, v1), _mm256_cmpeq_epi8(blk, v2)), _mm256_cmpeq_epi8(blk, v3));
+      if ((mask = (unsigned)_mm256_movemask_epi8(blk)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask));
+   };
+#elif defined(__SSE2__)
+   v1 = _mm_set1_epi8(c1);
+   v2 = _mm_set1_epi8(c2);
+   v3 = _mm_set1_epi8(c3);
+   for(; ((pos + 16) <= len); pos += 16)
+   {
+      blk  = _mm_loadu_si128((const __m128i *)(const void *)&data[pos]);
+      blk  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(blk, v1), _mm_cmpeq_epi8(blk, v2)), _mm_cmpeq_epi8(blk, v3));
+      if ((mask = (unsigned)_mm_movemask_epi8(blk)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask));
+   };
+#endif
+
+   for(; (pos < len); pos++)
+      if ( (data[pos] == c1) || (data[pos] == c2) || (data[pos] == c3) )
+         return(pos);
+
+   return(len);
+}
+
+
+/// writes value as contents of quoted CSV field
+/// @param[in] sink    reference to output sink
+/// @param[in] data    value to encode
+/// @param[in] len     length of value
+/// @param[in] sep     multi-value separator, or '"' if field holds one value
+/// @param[in] flags   encoding flags
+int ldaputils_sink_csv(LDAPUtilsSink * sink, const void * data, size_t len, char sep, int flags)
+{
+   int            rc;
+   size_t         pos;
+   size_t         span;
+   const char   * str;
+
+   assert(sink != NULL);
+   assert((data != NULL) || (len == 0));
+
+   str = data;
+
+   // RFC 4180 only escapes quotes
+   if ((flags & LDAPUTILS_CSV_RFC4180))
+      sep = '"';
+
+   for(pos = 0; (pos < len); pos += span + 1)
+   {
+      span = ldaputils_csv_scan(&str[pos], (len - pos), '"', sep, sep);
+      if (ldaputils_sink_write(sink, &str[pos], span) == -1)
+         return(-1);
+      if ((pos + span) == len)
+         return(0);
+
+      // RFC 4180 doubles quotes, legacy mode replaces quotes and separators
+      if ((flags & LDAPUTILS_CSV_RFC4180))
+         rc = ldaputils_sink_write(sink, "\"\"", 2);
+      else
+         rc = ldaputils_sink_write(sink, ((str[pos+span] == '"') ? "'" : ":"), 1);
+      if (rc == -1)
+         return(-1);
+   };
+
+   return(0);
+}
+
+/* end of source file */
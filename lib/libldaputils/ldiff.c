@@ -0,0 +1,479 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/ldiff.c  change records between LDIF records
+ */
+/*
+ *  Records are decoded into attribute values which reference the decode
+ *  buffer of the entry, and each value is hashed.  Once the values of an
+ *  entry are sorted, values of each attribute are grouped and summarized
+ *  by the sum of the hashes of the values, so values are only compared
+ *  for attributes whose sums differ.  Change records are appended to a
+ *  sort buffer keyed by a phase byte followed by the normalized DN of the
+ *  entry.  Deletes sort first with the bytes of the DN inverted, so
+ *  children are deleted before their parents, followed by adds and
+ *  modifies in which parents precede their children.
+ */
+#define _LIB_LIBLDAPUTILS_LDIFF_C 1
+#include "ldiff.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// appends change record which adds decoded entry
+/// @param[in] buff    change records
+/// @param[in] ent     decoded entry
+/// @param[in] key     normalized DN of entry
+/// @param[in] key_len length of normalized DN
+int ldaputils_diff_add(LDAPUtilsSortBuff * buff, const LDAPUtilsDiffEntry * ent, const char * key, size_t key_len)
+{
+   size_t           x;
+   size_t           start;
+   char             phase;
+
+   start = buff->text_len;
+
+   // added entries sort in ascending order, so parents precede children
+   phase = LDAPUTILS_DIFF_PHASE_UPDATE;
+   if ( (ldaputils_sort_append(buff, &phase, 1) == -1) || (ldaputils_sort_append(buff, key, key_len) == -1) )
+      return(LDAP_NO_MEMORY);
+   if (ldaputils_diff_value(buff, "dn", ent->dn.bv_val, ent->dn.bv_len) == -1)
+      return(LDAP_NO_MEMORY);
+
+   // added entries keep the order of attributes
+   if (ldaputils_sort_append(buff, "changetype: add\n", 16) == -1)
+      return(LDAP_NO_MEMORY);
+   for(x = 0; (x < ent->vals_len); x++)
+      if (ldaputils_diff_value(buff, ent->vals[x].name, ent->vals[x].val, ent->vals[x].val_len) == -1)
+         return(LDAP_NO_MEMORY);
+   if (ldaputils_sort_append(buff, "\n", 1) == -1)
+      return(LDAP_NO_MEMORY);
+
+   return((ldaputils_sort_item(buff, start, key_len + 1) == -1) ? LDAP_NO_MEMORY : LDAP_SUCCESS);
+}
+
+
+/// compares attribute values by name, hash, and bytes
+/// @param[in] ptr1   pointer to first value
+/// @param[in] ptr2   pointer to second value
+int ldaputils_diff_cmp_value(const void * ptr1, const void * ptr2)
+{
+   int                        rc;
+   const LDAPUtilsDiffValue * v1;
+   const LDAPUtilsDiffValue * v2;
+
+   v1 = ptr1;
+   v2 = ptr2;
+
+   if ((rc = strcasecmp(v1->name, v2->name)))
+      return(rc);
+   if (v1->hash != v2->hash)
+      return((v1->hash < v2->hash) ? -1 : 1);
+   if (v1->val_len != v2->val_len)
+      return((v1->val_len < v2->val_len) ? -1 : 1);
+
+   return(memcmp(v1->val, v2->val, v1->val_len));
+}
+
+
+/// appends change record which deletes decoded entry
+/// @param[in] buff    change records
+/// @param[in] ent     decoded entry
+/// @param[in] key     normalized DN of entry
+/// @param[in] key_len length of normalized DN
+int ldaputils_diff_delete(LDAPUtilsSortBuff * buff, const LDAPUtilsDiffEntry * ent, const char * key, size_t key_len)
+{
+   size_t           x;
+   size_t           start;
+   char             c;
+
+   start = buff->text_len;
+
+   // deleted entries sort in descending order, so children precede parents
+   c = LDAPUTILS_DIFF_PHASE_DELETE;
+   if (ldaputils_sort_append(buff, &c, 1) == -1)
+      return(LDAP_NO_MEMORY);
+   for(x = 0; (x <= key_len); x++)
+   {
+      c = (x < key_len) ? (char)~key[x] : (char)0xff;
+      if (ldaputils_sort_append(buff, &c, 1) == -1)
+         return(LDAP_NO_MEMORY);
+   };
+
+   if (ldaputils_diff_value(buff, "dn", ent->dn.bv_val, ent->dn.bv_len) == -1)
+      return(LDAP_NO_MEMORY);
+   if (ldaputils_sort_append(buff, "changetype: delete\n\n", 20) == -1)
+      return(LDAP_NO_MEMORY);
+
+   return((ldaputils_sort_item(buff, start, key_len + 2) == -1) ? LDAP_NO_MEMORY : LDAP_SUCCESS);
+}
+
+
+/// frees buffers of decoded entry
+/// @param[in] ent     decoded entry
+void ldaputils_diff_free(LDAPUtilsDiffEntry * ent)
+{
+   if ((ent->buff))
+      free(ent->buff);
+   if ((ent->vals))
+      free(ent->vals);
+   if ((ent->attrs))
+      free(ent->attrs);
+   memset(ent, 0, sizeof(LDAPUtilsDiffEntry));
+   return;
+}
+
+
+/// sorts values and groups values by attribute
+/// @param[in] ent  decoded record
+int ldaputils_diff_group(LDAPUtilsDiffEntry * ent)
+{
+   size_t              x;
+   size_t              size;
+   void              * ptr;
+   LDAPUtilsDiffAttr * attr;
+
+   if (ent->vals_len > 1)
+      qsort(ent->vals, ent->vals_len, sizeof(LDAPUtilsDiffValue), ldaputils_diff_cmp_value);
+
+   ent->attrs_len = 0;
+   for(x = 0, attr = NULL; (x < ent->vals_len); x++)
+   {
+      if ( ((attr)) && (!(strcasecmp(attr->name, ent->vals[x].name))) )
+      {
+         attr->vals_len++;
+         attr->hash += ent->vals[x].hash;
+         continue;
+      };
+      if (ent->attrs_len >= ent->attrs_size)
+      {
+         size = (ent->attrs_size) ? (ent->attrs_size * 2) : 32;
+         if ((ptr = realloc(ent->attrs, sizeof(LDAPUtilsDiffAttr) * size)) == NULL)
+            return(-1);
+         ent->attrs      = ptr;
+         ent->attrs_size = size;
+      };
+      attr           = &ent->attrs[ent->attrs_len++];
+      attr->name     = ent->vals[x].name;
+      attr->vals     = &ent->vals[x];
+      attr->vals_len = 1;
+      attr->hash     = ent->vals[x].hash;
+   };
+
+   return(0);
+}
+
+
+/// calculates FNV-1a hash of bytes
+/// @param[in] data    bytes to hash
+/// @param[in] len     number of bytes
+uint64_t ldaputils_diff_hash(const char * data, size_t len)
+{
+   size_t     x;
+   uint64_t   hash;
+
+   for(x = 0, hash = 0xcbf29ce484222325ULL; (x < len); x++)
+      hash = (hash ^ (unsigned char)data[x]) * 0x100000001b3ULL;
+
+   return(hash);
+}
+
+
+/// compares decoded entries and appends modify change record if entries differ
+/// @param[in] buff    change records
+/// @param[in] p1      old decoded entry
+/// @param[in] p2      new decoded entry
+/// @param[in] key     normalized DN of entry
+/// @param[in] key_len length of normalized DN
+int ldaputils_diff_modify(LDAPUtilsSortBuff * buff, LDAPUtilsDiffEntry * p1, LDAPUtilsDiffEntry * p2, const char * key, size_t key_len)
+{
+   int              rc;
+   int              pass;
+   size_t           x;
+   size_t           y;
+   size_t           v;
+   size_t           w;
+   size_t           start;
+   size_t           text;
+   size_t           added;
+   size_t           removed;
+   char             phase;
+   LDAPUtilsDiffAttr * a1;
+   LDAPUtilsDiffAttr * a2;
+
+   start = buff->text_len;
+
+   if ( (ldaputils_diff_group(p1) == -1) || (ldaputils_diff_group(p2) == -1) )
+      return(LDAP_NO_MEMORY);
+
+   phase = LDAPUTILS_DIFF_PHASE_UPDATE;
+   if ( (ldaputils_sort_append(buff, &phase, 1) == -1) || (ldaputils_sort_append(buff, key, key_len) == -1) )
+      return(LDAP_NO_MEMORY);
+   if (ldaputils_diff_value(buff, "dn", p2->dn.bv_val, p2->dn.bv_len) == -1)
+      return(LDAP_NO_MEMORY);
+   if (ldaputils_sort_append(buff, "changetype: modify\n", 19) == -1)
+      return(LDAP_NO_MEMORY);
+   text = buff->text_len;
+
+   // attributes of both records are sorted by name
+   for(x = 0, y = 0; ( (x < p1->attrs_len) || (y < p2->attrs_len) ); )
+   {
+      a1 = (x < p1->attrs_len) ? &p1->attrs[x] : NULL;
+      a2 = (y < p2->attrs_len) ? &p2->attrs[y] : NULL;
+      rc = (!(a1)) ? 1 : (!(a2)) ? -1 : strcasecmp(a1->name, a2->name);
+
+      // attribute was removed
+      if (rc < 0)
+      {
+         if ( (ldaputils_sort_append(buff, "delete: ", 8) == -1) || (ldaputils_sort_append(buff, a1->name, strlen(a1->name)) == -1) || (ldaputils_sort_append(buff, "\n-\n", 3) == -1) )
+            return(LDAP_NO_MEMORY);
+         x++;
+         continue;
+      };
+
+      // attribute was added
+      if (rc > 0)
+      {
+         if ( (ldaputils_sort_append(buff, "add: ", 5) == -1) || (ldaputils_sort_append(buff, a2->name, strlen(a2->name)) == -1) || (ldaputils_sort_append(buff, "\n", 1) == -1) )
+            return(LDAP_NO_MEMORY);
+         for(w = 0; (w < a2->vals_len); w++)
+            if (ldaputils_diff_value(buff, a2->name, a2->vals[w].val, a2->vals[w].val_len) == -1)
+               return(LDAP_NO_MEMORY);
+         if (ldaputils_sort_append(buff, "-\n", 2) == -1)
+            return(LDAP_NO_MEMORY);
+         y++;
+         continue;
+      };
+      x++;
+      y++;
+
+      // values are only compared if the hashes of the attributes differ
+      if ( (a1->vals_len == a2->vals_len) && (a1->hash == a2->hash) )
+         continue;
+
+      // counts values which were removed and added
+      for(v = 0, w = 0, removed = 0, added = 0; ( (v < a1->vals_len) || (w < a2->vals_len) ); )
+      {
+         rc = (v >= a1->vals_len) ? 1 : (w >= a2->vals_len) ? -1 : ldaputils_diff_cmp_value(&a1->vals[v], &a2->vals[w]);
+         removed += (rc < 0) ? 1 : 0;
+         added   += (rc > 0) ? 1 : 0;
+         v       += (rc <= 0) ? 1 : 0;
+         w       += (rc >= 0) ? 1 : 0;
+      };
+      if ( (!(removed)) && (!(added)) )
+         continue;
+
+      // replaces attribute when none of the values remain
+      if (removed == a1->vals_len)
+      {
+         if ( (ldaputils_sort_append(buff, "replace: ", 9) == -1) || (ldaputils_sort_append(buff, a2->name, strlen(a2->name)) == -1) || (ldaputils_sort_append(buff, "\n", 1) == -1) )
+            return(LDAP_NO_MEMORY);
+         for(w = 0; (w < a2->vals_len); w++)
+            if (ldaputils_diff_value(buff, a2->name, a2->vals[w].val, a2->vals[w].val_len) == -1)
+               return(LDAP_NO_MEMORY);
+         if (ldaputils_sort_append(buff, "-\n", 2) == -1)
+            return(LDAP_NO_MEMORY);
+         continue;
+      };
+
+      // deletes removed values, then adds new values
+      for(pass = 0; (pass < 2); pass++)
+      {
+         if ( ((pass == 0) && (!(removed))) || ((pass == 1) && (!(added))) )
+            continue;
+         rc = (pass == 0) ? ldaputils_sort_append(buff, "delete: ", 8) : ldaputils_sort_append(buff, "add: ", 5);
+         if ( (rc == -1) || (ldaputils_sort_append(buff, a1->name, strlen(a1->name)) == -1) || (ldaputils_sort_append(buff, "\n", 1) == -1) )
+            return(LDAP_NO_MEMORY);
+         for(v = 0, w = 0; ( (v < a1->vals_len) || (w < a2->vals_len) ); )
+         {
+            rc = (v >= a1->vals_len) ? 1 : (w >= a2->vals_len) ? -1 : ldaputils_diff_cmp_value(&a1->vals[v], &a2->vals[w]);
+            if ( (rc < 0) && (pass == 0) && (ldaputils_diff_value(buff, a1->name, a1->vals[v].val, a1->vals[v].val_len) == -1) )
+               return(LDAP_NO_MEMORY);
+            if ( (rc > 0) && (pass == 1) && (ldaputils_diff_value(buff, a2->name, a2->vals[w].val, a2->vals[w].val_len) == -1) )
+               return(LDAP_NO_MEMORY);
+            v += (rc <= 0) ? 1 : 0;
+            w += (rc >= 0) ? 1 : 0;
+         };
+         if (ldaputils_sort_append(buff, "-\n", 2) == -1)
+            return(LDAP_NO_MEMORY);
+      };
+   };
+
+   // discards records which only differ by order, case of names, or encoding
+   if (buff->text_len == text)
+   {
+      buff->text_len = start;
+      return(LDAP_SUCCESS);
+   };
+
+   if ( (ldaputils_sort_append(buff, "\n", 1) == -1) || (ldaputils_sort_item(buff, start, key_len + 1) == -1) )
+      return(LDAP_NO_MEMORY);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// decodes LDIF content record into attribute values
+/// @param[in] ent     decoded entry
+/// @param[in] data    LDIF record
+/// @param[in] len     length of LDIF record
+int ldaputils_diff_parse(LDAPUtilsDiffEntry * ent, const char * data, size_t len)
+{
+   int                  err;
+   size_t               pos;
+   size_t               size;
+   char               * buff;
+   void               * ptr;
+   LDAPUtilsDiffValue * value;
+   struct berval        rec;
+   struct berval        name;
+   struct berval        val;
+
+   if (len >= ent->buff_size)
+   {
+      if ((ptr = realloc(ent->buff, len + 1)) == NULL)
+         return(LDAP_NO_MEMORY);
+      ent->buff      = ptr;
+      ent->buff_size = len + 1;
+   };
+
+   rec.bv_val       = (char *)data;
+   rec.bv_len       = len;
+   pos              = 0;
+   buff             = ent->buff;
+   ent->vals_len = 0;
+
+   // first attribute names entry
+   if ((err = ldaputils_ldif_next(&rec, &pos, &buff, &name, &ent->dn)) != LDAP_SUCCESS)
+      return(err);
+   if ( (!(name.bv_val)) || (strcasecmp(name.bv_val, "dn") != 0) )
+      return(LDAP_DECODING_ERROR);
+
+   while ((err = ldaputils_ldif_next(&rec, &pos, &buff, &name, &val)) == LDAP_SUCCESS)
+   {
+      if (!(name.bv_val))
+         return(LDAP_SUCCESS);
+
+      // change records name their changetype after the DN (RFC 2849)
+      if ( (!(ent->vals_len)) && (!(strcasecmp(name.bv_val, "changetype"))) )
+         return(LDAP_UNWILLING_TO_PERFORM);
+
+      if (ent->vals_len >= ent->vals_size)
+      {
+         size = (ent->vals_size) ? (ent->vals_size * 2) : 64;
+         if ((ptr = realloc(ent->vals, sizeof(LDAPUtilsDiffValue) * size)) == NULL)
+            return(LDAP_NO_MEMORY);
+         ent->vals      = ptr;
+         ent->vals_size = size;
+      };
+      value          = &ent->vals[ent->vals_len++];
+      value->name    = name.bv_val;
+      value->val     = val.bv_val;
+      value->val_len = val.bv_len;
+      value->hash    = ldaputils_diff_hash(val.bv_val, val.bv_len);
+   };
+
+   return(err);
+}
+
+
+/// appends attribute value as LDIF, base64 encoded if not safe
+/// @param[in] buff    change records
+/// @param[in] name    attribute description
+/// @param[in] val     value
+/// @param[in] len     length of value
+int ldaputils_diff_value(LDAPUtilsSortBuff * buff, const char * name, const char * val, size_t len)
+{
+   size_t            x;
+   size_t            n;
+   int               safe;
+   unsigned char     b[3];
+   char              out[4];
+   const unsigned char * ptr;
+
+   static const char map[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+   // RFC 2849 SAFE-STRING
+   ptr  = (const unsigned char *)val;
+   safe = ( (!(len)) || ( (ptr[0] != ' ') && (ptr[0] != ':') && (ptr[0] != '<') && (ptr[len-1] != ' ') ) );
+   for(x = 0; ( ((safe)) && (x < len) ); x++)
+      safe = ( (ptr[x] != '\0') && (ptr[x] != '\r') && (ptr[x] != '\n') && (ptr[x] < 0x80) );
+
+   if (ldaputils_sort_append(buff, name, strlen(name)) == -1)
+      return(-1);
+   if ((safe))
+   {
+      if ( (ldaputils_sort_append(buff, ": ", 2) == -1) || (ldaputils_sort_append(buff, val, len) == -1) )
+         return(-1);
+      return(ldaputils_sort_append(buff, "\n", 1));
+   };
+
+   if (ldaputils_sort_append(buff, ":: ", 3) == -1)
+      return(-1);
+   for(x = 0; (x < len); x += 3)
+   {
+      n      = ((len - x) < 3) ? (len - x) : 3;
+      b[0]   = ptr[x];
+      b[1]   = (n > 1) ? ptr[x+1] : 0;
+      b[2]   = (n > 2) ? ptr[x+2] : 0;
+      out[0] = map[b[0] >> 2];
+      out[1] = map[((b[0] & 0x03) << 4) | (b[1] >> 4)];
+      out[2] = (n > 1) ? map[((b[1] & 0x0f) << 2) | (b[2] >> 6)] : '=';
+      out[3] = (n > 2) ? map[b[2] & 0x3f] : '=';
+      if (ldaputils_sort_append(buff, out, 4) == -1)
+         return(-1);
+   };
+
+   return(ldaputils_sort_append(buff, "\n", 1));
+}
+
+/* end of source file */
@@ -0,0 +1,375 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/ldn.c  shared dictionary of DN components
+ */
+#define _LIB_LIBLDAPUTILS_LDN_C 1
+#include "ldn.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#define LDAPUTILS_DN_TABLE_SIZE 1024
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+// open addressing hash table of DN nodes keyed by parent and RDN
+static LDAPUtilsDNNode  ** ldaputils_dn_table       = NULL;
+static size_t              ldaputils_dn_table_size  = 0;
+static size_t              ldaputils_dn_table_count = 0;
+static pthread_mutex_t     ldaputils_dn_mutex       = PTHREAD_MUTEX_INITIALIZER;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+size_t ldaputils_dn_hash(LDAPUtilsDNNode * parent, const char * rdn, size_t len);
+LDAPUtilsDNNode * ldaputils_dn_node_lookup(LDAPUtilsDNNode * parent, const char * rdn);
+void ldaputils_dn_node_unref(LDAPUtilsDNNode * node);
+void ldaputils_dn_table_remove(LDAPUtilsDNNode * node);
+int ldaputils_dn_table_resize(size_t size);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// calculates hash of RDN within parent node
+/// @param[in] parent  parent node or NULL for top level RDN
+/// @param[in] rdn     RDN of node
+/// @param[in] len     length of RDN
+size_t ldaputils_dn_hash(LDAPUtilsDNNode * parent, const char * rdn, size_t len)
+{
+   size_t    x;
+   uint64_t  hash;
+
+   // FNV-1a
+   hash = 14695981039346656037ULL;
+   for(x = 0; x < len; x++)
+   {
+      hash ^= (unsigned char)rdn[x];
+      hash *= 1099511628211ULL;
+   };
+
+   // mix in parent
+   hash ^= (uint64_t)(uintptr_t)parent;
+   hash *= 0x9E3779B97F4A7C15ULL;
+
+   return((size_t)(hash ^ (hash >> 32)));
+}
+
+
+/// fills list of RDNs of DN starting with top level RDN
+/// @param[in] node        DN node
+/// @param[in] components  buffer to fill with references to RDNs
+/// @param[in] len         number of elements in buffer
+int ldaputils_dn_node_components(LDAPUtilsDNNode * node, const char ** components, size_t len)
+{
+   size_t idx;
+
+   assert(components != NULL);
+
+   if (!(node))
+      return(0);
+   if (node->depth > len)
+      return(-1);
+
+   for(idx = node->depth; ((node)); node = node->parent)
+      components[--idx] = node->rdn;
+
+   return(0);
+}
+
+
+/// retrieves shared node of DN
+/// @param[in] components  RDNs of DN starting with top level RDN
+/// @param[in] len         number of RDNs
+LDAPUtilsDNNode * ldaputils_dn_node_get(char ** components, size_t len)
+{
+   size_t            x;
+   size_t            idx;
+   size_t            rdn_len;
+   size_t            hash;
+   LDAPUtilsDNNode * node;
+   LDAPUtilsDNNode * parent;
+
+   assert(components != NULL);
+
+   if (len == 0)
+      return(NULL);
+
+   pthread_mutex_lock(&ldaputils_dn_mutex);
+
+   parent = NULL;
+   for(x = 0; x < len; x++)
+   {
+      // check for existing node
+      if ((node = ldaputils_dn_node_lookup(parent, components[x])) != NULL)
+      {
+         parent = node;
+         continue;
+      };
+
+      // grow table
+      if ((ldaputils_dn_table_count*2) >= ldaputils_dn_table_size)
+      {
+         if (ldaputils_dn_table_resize((ldaputils_dn_table_size) ? ldaputils_dn_table_size*2 : LDAPUTILS_DN_TABLE_SIZE) != LDAP_SUCCESS)
+            break;
+      };
+
+      // allocate node
+      rdn_len = strlen(components[x]);
+      if ((node = malloc(sizeof(LDAPUtilsDNNode) + rdn_len + 1)) == NULL)
+         break;
+      bzero(node, sizeof(LDAPUtilsDNNode));
+      memcpy(node->rdn, components[x], rdn_len+1);
+      node->len    = rdn_len;
+      node->hash   = ldaputils_dn_hash(parent, node->rdn, rdn_len);
+      node->depth  = x + 1;
+      node->parent = parent;
+      if ((parent))
+         parent->refcount++;
+
+      // store node in table
+      hash = node->hash;
+      for(idx = hash & (ldaputils_dn_table_size-1); ((ldaputils_dn_table[idx])); idx = (idx+1) & (ldaputils_dn_table_size-1));
+      ldaputils_dn_table[idx] = node;
+      ldaputils_dn_table_count++;
+
+      parent = node;
+   };
+
+   // releases partial DN on error
+   if (x < len)
+   {
+      if ((parent))
+      {
+         parent->refcount++;
+         ldaputils_dn_node_unref(parent);
+      };
+      pthread_mutex_unlock(&ldaputils_dn_mutex);
+      return(NULL);
+   };
+
+   parent->refcount++;
+
+   pthread_mutex_unlock(&ldaputils_dn_mutex);
+
+   return(parent);
+}
+
+
+/// searches table for node
+/// @param[in] parent  parent node or NULL for top level RDN
+/// @param[in] rdn     RDN of node
+LDAPUtilsDNNode * ldaputils_dn_node_lookup(LDAPUtilsDNNode * parent, const char * rdn)
+{
+   size_t            len;
+   size_t            idx;
+   size_t            hash;
+   LDAPUtilsDNNode * node;
+
+   if (!(ldaputils_dn_table_size))
+      return(NULL);
+
+   len  = strlen(rdn);
+   hash = ldaputils_dn_hash(parent, rdn, len);
+
+   for(idx = hash & (ldaputils_dn_table_size-1); ((node = ldaputils_dn_table[idx])); idx = (idx+1) & (ldaputils_dn_table_size-1))
+   {
+      if ( (node->hash != hash) || (node->parent != parent) || (node->len != len) )
+         continue;
+      if (!(memcmp(node->rdn, rdn, len)))
+         return(node);
+   };
+
+   return(NULL);
+}
+
+
+/// releases reference to DN node and frees unreferenced nodes
+/// @param[in] node    DN node
+void ldaputils_dn_node_release(LDAPUtilsDNNode * node)
+{
+   if (!(node))
+      return;
+
+   pthread_mutex_lock(&ldaputils_dn_mutex);
+   ldaputils_dn_node_unref(node);
+   pthread_mutex_unlock(&ldaputils_dn_mutex);
+
+   return;
+}
+
+
+/// adds reference to DN node
+/// @param[in] node    DN node
+LDAPUtilsDNNode * ldaputils_dn_node_retain(LDAPUtilsDNNode * node)
+{
+   if (!(node))
+      return(NULL);
+   pthread_mutex_lock(&ldaputils_dn_mutex);
+   node->refcount++;
+   pthread_mutex_unlock(&ldaputils_dn_mutex);
+   return(node);
+}
+
+
+/// releases reference to DN node while holding DN table lock
+/// @param[in] node    DN node
+void ldaputils_dn_node_unref(LDAPUtilsDNNode * node)
+{
+   LDAPUtilsDNNode * parent;
+
+   while((node))
+   {
+      if ((--node->refcount))
+         break;
+      parent = node->parent;
+      ldaputils_dn_table_remove(node);
+      free(node);
+      node = parent;
+   };
+
+   // frees empty table
+   if (!(ldaputils_dn_table_count))
+   {
+      free(ldaputils_dn_table);
+      ldaputils_dn_table      = NULL;
+      ldaputils_dn_table_size = 0;
+   };
+
+   return;
+}
+
+
+/// removes node from table
+/// @param[in] node    DN node
+void ldaputils_dn_table_remove(LDAPUtilsDNNode * node)
+{
+   size_t   idx;
+   size_t   next;
+   size_t   home;
+   size_t   mask;
+
+   assert(node != NULL);
+
+   mask = ldaputils_dn_table_size - 1;
+   for(idx = node->hash & mask; (ldaputils_dn_table[idx] != node); idx = (idx+1) & mask);
+   ldaputils_dn_table[idx] = NULL;
+   ldaputils_dn_table_count--;
+
+   // shifts following entries of cluster into the empty slot
+   for(next = (idx+1) & mask; ((ldaputils_dn_table[next])); next = (next+1) & mask)
+   {
+      home = ldaputils_dn_table[next]->hash & mask;
+      if (((next - home) & mask) < ((next - idx) & mask))
+         continue;
+      ldaputils_dn_table[idx]  = ldaputils_dn_table[next];
+      ldaputils_dn_table[next] = NULL;
+      idx = next;
+   };
+
+   return;
+}
+
+
+/// resizes hash table
+/// @param[in] size    new number of slots, must be a power of two
+int ldaputils_dn_table_resize(size_t size)
+{
+   size_t             x;
+   size_t             idx;
+   LDAPUtilsDNNode ** table;
+
+   if ((table = malloc(sizeof(LDAPUtilsDNNode *) * size)) == NULL)
+      return(LDAP_NO_MEMORY);
+   bzero(table, sizeof(LDAPUtilsDNNode *) * size);
+
+   for(x = 0; x < ldaputils_dn_table_size; x++)
+   {
+      if (!(ldaputils_dn_table[x]))
+         continue;
+      for(idx = ldaputils_dn_table[x]->hash & (size-1); ((table[idx])); idx = (idx+1) & (size-1));
+      table[idx] = ldaputils_dn_table[x];
+   };
+
+   free(ldaputils_dn_table);
+   ldaputils_dn_table      = table;
+   ldaputils_dn_table_size = size;
+
+   return(LDAP_SUCCESS);
+}
+
+/* end of source file */
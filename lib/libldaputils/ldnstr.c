@@ -0,0 +1,656 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/ldnstr.c  allocation free DN parser and formatter
+ */
+/*
+ *  A DN is parsed once into spans which reference the original string.  Each
+ *  format is then rendered from the spans directly into a caller supplied
+ *  buffer, decoding the escapes of the source and applying the escapes of the
+ *  target format as values are copied.  Neither step allocates memory unless
+ *  a DN has more than LDAPUTILS_DN_AVAS attribute value assertions, which
+ *  allows every special column of an entry to be produced from one parse.
+ *  Values are escaped the same as ldap_dn2str(), except that DCE-style names
+ *  escape control characters and are written for any value.
+ */
+#define _LIB_LIBLDAPUTILS_LDNSTR_C 1
+#include "ldnstr.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// returns length of escape sequence, or zero if escape is invalid
+/// @param[in] str     DN string
+/// @param[in] len     length of DN string
+/// @param[in] pos     offset of backslash
+size_t ldaputils_dn_escape(const char * str, size_t len, size_t pos)
+{
+   if ((pos+1) >= len)
+      return(0);
+   if ( ((pos+2) < len) && (ldaputils_dn_hex(str[pos+1]) != -1) && (ldaputils_dn_hex(str[pos+2]) != -1) )
+      return(3);
+   if ( (str[pos+1] != '\0') && ((strchr(LDAPUTILS_DN_SPECIALS " #=", str[pos+1]))) )
+      return(2);
+   return(0);
+}
+
+
+/// returns how byte is written within value of format
+/// @param[in] c       decoded byte
+/// @param[in] format  format of DN, or zero to write value without escapes
+/// @param[in] lead    byte is first byte of value
+/// @param[in] trail   byte is last byte of value
+/// @return 0 if byte is copied, 1 if byte follows a backslash, or 2 if byte
+///         is written as a backslash and hex pair
+int ldaputils_dn_escaped(int c, int format, int lead, int trail)
+{
+   if (c == '\0')
+      return(2);
+
+   switch(format)
+   {
+      case 0:
+      return(0);
+
+      case LDAPUTILS_DN_ADC:
+      return(((strchr(LDAPUTILS_DN_SPECIALS_ADC, c))) ? 1 : 0);
+
+      case LDAPUTILS_DN_DCE:
+      if ( (c < 0x20) || (c == 0x7f) )
+         return(2);
+      return(((strchr(LDAPUTILS_DN_SPECIALS_DCE, c))) ? 1 : 0);
+
+      default:
+      break;
+   };
+
+   // RFC 4514 strings escape specials, leading and trailing spaces, a
+   // leading '#', and bytes of multibyte characters as hex pairs
+   if ( (c >= 0x80) || ((strchr(LDAPUTILS_DN_SPECIALS, c))) )
+      return(2);
+   if ( (c == ' ') && ( ((lead)) || ((trail)) ) )
+      return(2);
+   if ( (c == '#') && ((lead)) )
+      return(2);
+   return(0);
+}
+
+
+/// renders parsed DN into buffer, returns length of complete string
+/// @param[in] dn      parsed DN
+/// @param[in] format  one of LDAPUTILS_DN_DN, LDAPUTILS_DN_RDN, LDAPUTILS_DN_UFN,
+///                    LDAPUTILS_DN_ADC, LDAPUTILS_DN_DCE, LDAPUTILS_DN_IDN, or
+///                    LDAPUTILS_DN_KEY
+/// @param[in] buff    buffer which receives NUL terminated string
+/// @param[in] size    size of buffer, string is truncated to fit
+size_t ldaputils_dn_format(const LDAPUtilsDN * dn, int format, char * buff, size_t size)
+{
+   size_t            x;
+   size_t            y;
+   size_t            domain;
+   LDAPUtilsDNBuff   out;
+
+   assert(dn != NULL);
+   assert( (buff != NULL) || (size == 0) );
+
+   out.buff = buff;
+   out.size = size;
+   out.len  = 0;
+
+   switch(format)
+   {
+      case LDAPUTILS_DN_RDN:
+      if ((dn->rdns_len))
+         ldaputils_dn_put_rdn(&out, dn, 0, LDAPUTILS_DN_DN);
+      break;
+
+      case LDAPUTILS_DN_UFN:
+      // trailing domain components are joined into a DNS name, the same as
+      // ldap_dn2ufn()
+      for(domain = 0; ( (domain < dn->rdns_len) && ((ldaputils_dn_is_dc(dn, dn->rdns_len-domain-1))) ); domain++);
+      for(x = 0; (x < dn->rdns_len); x++)
+      {
+         if (x > (dn->rdns_len-domain))
+            ldaputils_dn_put(&out, ".", 1);
+         else if ((x))
+            ldaputils_dn_put(&out, ", ", 2);
+         if (x < (dn->rdns_len-domain))
+            ldaputils_dn_put_rdn(&out, dn, x, LDAPUTILS_DN_UFN);
+         else
+            ldaputils_dn_put_val(&out, &dn->avas[dn->rdns[x]], 0);
+      };
+      break;
+
+      case LDAPUTILS_DN_ADC:
+      // trailing domain components are written as a DNS name, a DN without
+      // a domain is written starting with its last RDN, and the name of a
+      // DN which is entirely a domain ends with a slash
+      for(domain = 0; ( (domain < dn->rdns_len) && ((ldaputils_dn_is_dc(dn, dn->rdns_len-domain-1))) ); domain++);
+      if (dn->rdns_len < 2)
+         domain = 0;
+      for(x = dn->rdns_len-domain; (x < dn->rdns_len); x++)
+      {
+         if (x > (dn->rdns_len-domain))
+            ldaputils_dn_put(&out, ".", 1);
+         ldaputils_dn_put_val(&out, &dn->avas[dn->rdns[x]], 0);
+      };
+      for(x = dn->rdns_len-domain; (x > 0); x--)
+      {
+         if ( ((domain)) || (x < dn->rdns_len) )
+            ldaputils_dn_put(&out, "/", 1);
+         ldaputils_dn_put_rdn(&out, dn, x-1, LDAPUTILS_DN_ADC);
+      };
+      if ( ((dn->rdns_len)) && ( (!(domain)) || (domain == dn->rdns_len) ) )
+         ldaputils_dn_put(&out, "/", 1);
+      break;
+
+      case LDAPUTILS_DN_DCE:
+      for(x = dn->rdns_len; (x > 0); x--)
+      {
+         ldaputils_dn_put(&out, "/", 1);
+         ldaputils_dn_put_rdn(&out, dn, x-1, LDAPUTILS_DN_DCE);
+      };
+      break;
+
+      case LDAPUTILS_DN_IDN:
+      for(x = dn->rdns_len; (x > 0); x--)
+      {
+         if (x < dn->rdns_len)
+            ldaputils_dn_put(&out, ",", 1);
+         ldaputils_dn_put_rdn(&out, dn, x-1, LDAPUTILS_DN_DN);
+      };
+      break;
+
+      case LDAPUTILS_DN_KEY:
+      // case folded RDNs starting with the top level RDN are each terminated
+      // by a NUL, which never occurs within a formatted RDN, and the key ends
+      // with a second NUL, so memcmp() orders keys the same as comparing RDNs
+      // with strcasecmp() and places a parent before its children
+      for(x = dn->rdns_len; (x > 0); x--)
+      {
+         y = out.len;
+         ldaputils_dn_put_rdn(&out, dn, x-1, LDAPUTILS_DN_DN);
+         for(; ( (y < out.len) && (y < out.size) ); y++)
+            buff[y] = (char)tolower((unsigned char)buff[y]);
+         ldaputils_dn_put(&out, "", 1);
+      };
+      ldaputils_dn_put(&out, "", 1);
+      break;
+
+      default:
+      for(x = 0; (x < dn->rdns_len); x++)
+      {
+         if ((x))
+            ldaputils_dn_put(&out, ",", 1);
+         ldaputils_dn_put_rdn(&out, dn, x, LDAPUTILS_DN_DN);
+      };
+      break;
+   };
+
+   if ((size))
+      buff[(out.len < size) ? out.len : (size-1)] = '\0';
+
+   return(out.len);
+}
+
+
+/// frees memory allocated for DN with many attribute value assertions
+/// @param[in] dn      parsed DN
+void ldaputils_dn_free(LDAPUtilsDN * dn)
+{
+   assert(dn != NULL);
+
+   if (dn->avas != dn->avas_buff)
+   {
+      free(dn->avas);
+      free(dn->rdns);
+   };
+   dn->avas      = dn->avas_buff;
+   dn->rdns      = dn->rdns_buff;
+   dn->avas_size = LDAPUTILS_DN_AVAS;
+
+   return;
+}
+
+
+/// doubles number of attribute value assertions which fit within DN
+/// @param[in] dn      parsed DN
+int ldaputils_dn_grow(LDAPUtilsDN * dn)
+{
+   size_t            size;
+   size_t          * rdns;
+   LDAPUtilsDNAva  * avas;
+
+   size = dn->avas_size * 2;
+
+   // spans are moved from the stack on first growth
+   if (dn->avas == dn->avas_buff)
+   {
+      if ((avas = malloc(sizeof(LDAPUtilsDNAva) * size)) == NULL)
+         return(-1);
+      if ((rdns = malloc(sizeof(size_t) * (size+1))) == NULL)
+      {
+         free(avas);
+         return(-1);
+      };
+      memcpy(avas, dn->avas, (sizeof(LDAPUtilsDNAva) * dn->avas_len));
+      memcpy(rdns, dn->rdns, (sizeof(size_t) * (dn->rdns_len+1)));
+   } else {
+      if ((avas = realloc(dn->avas, (sizeof(LDAPUtilsDNAva) * size))) == NULL)
+         return(-1);
+      dn->avas = avas;
+      if ((rdns = realloc(dn->rdns, (sizeof(size_t) * (size+1)))) == NULL)
+         return(-1);
+   };
+
+   dn->avas      = avas;
+   dn->rdns      = rdns;
+   dn->avas_size = size;
+
+   return(0);
+}
+
+
+/// returns value of hex digit, or -1 if character is not a hex digit
+/// @param[in] c       character
+int ldaputils_dn_hex(int c)
+{
+   if ( (c >= '0') && (c <= '9') )
+      return(c - '0');
+   if ( (c >= 'a') && (c <= 'f') )
+      return(c - 'a' + 10);
+   if ( (c >= 'A') && (c <= 'F') )
+      return(c - 'A' + 10);
+   return(-1);
+}
+
+
+/// tests if RDN is a single domain component
+/// @param[in] dn      parsed DN
+/// @param[in] rdn     index of RDN
+int ldaputils_dn_is_dc(const LDAPUtilsDN * dn, size_t rdn)
+{
+   const LDAPUtilsDNAva * ava;
+
+   if ((dn->rdns[rdn+1] - dn->rdns[rdn]) != 1)
+      return(0);
+   ava = &dn->avas[dn->rdns[rdn]];
+   if ((ava->hex))
+      return(0);
+   if ( (ava->type_len == 2) && (!(strncasecmp(ava->type, "dc", 2))) )
+      return(1);
+   if ( (ava->type_len == strlen(LDAPUTILS_DN_DC_OID)) && (!(memcmp(ava->type, LDAPUTILS_DN_DC_OID, ava->type_len))) )
+      return(1);
+   return(0);
+}
+
+
+/// decodes next byte of escaped value
+/// @param[in] val     value as escaped within DN
+/// @param[in] len     length of value
+/// @param[in] posp    offset of next byte, advanced past decoded byte
+int ldaputils_dn_next(const char * val, size_t len, size_t * posp)
+{
+   size_t pos;
+
+   pos = *posp;
+
+   if ( (val[pos] != '\\') || ((pos+1) >= len) )
+   {
+      *posp = pos + 1;
+      return((unsigned char)val[pos]);
+   };
+
+   if ( ((pos+2) < len) && (ldaputils_dn_hex(val[pos+1]) != -1) && (ldaputils_dn_hex(val[pos+2]) != -1) )
+   {
+      *posp = pos + 3;
+      return((ldaputils_dn_hex(val[pos+1]) << 4) | ldaputils_dn_hex(val[pos+2]));
+   };
+
+   *posp = pos + 2;
+   return((unsigned char)val[pos+1]);
+}
+
+
+/// parses RFC 4514 DN, only allocating memory for very long DNs
+/// @param[out] dn     receives spans of RDNs and attribute value assertions,
+///                    released with ldaputils_dn_free()
+/// @param[in]  str    DN string, must remain valid while spans are used
+/// @param[in]  len    length of DN string
+int ldaputils_dn_parse(LDAPUtilsDN * dn, const char * str, size_t len)
+{
+   int                rc;
+
+   assert(dn  != NULL);
+   assert( (str != NULL) || (len == 0) );
+
+   dn->rdns_len  = 0;
+   dn->avas_len  = 0;
+   dn->avas_size = LDAPUTILS_DN_AVAS;
+   dn->avas      = dn->avas_buff;
+   dn->rdns      = dn->rdns_buff;
+   dn->rdns[0]   = 0;
+
+   if ((rc = ldaputils_dn_parse_avas(dn, str, len)) == -1)
+      ldaputils_dn_free(dn);
+
+   return(rc);
+}
+
+
+/// parses attribute value assertions of DN
+/// @param[out] dn     initialized DN which receives spans
+/// @param[in]  str    DN string
+/// @param[in]  len    length of DN string
+int ldaputils_dn_parse_avas(LDAPUtilsDN * dn, const char * str, size_t len)
+{
+   size_t             pos;
+   size_t             end;
+   size_t             esc;
+   LDAPUtilsDNAva   * ava;
+
+   // the empty DN has no RDNs, but a DN of only spaces is invalid
+   if (!(len))
+      return(0);
+
+   pos = 0;
+   while(1)
+   {
+      if ( (dn->avas_len >= dn->avas_size) && (ldaputils_dn_grow(dn) == -1) )
+         return(-1);
+      ava = &dn->avas[dn->avas_len];
+
+      // attribute type is a descriptor (ALPHA *(ALPHA / DIGIT / '-')) or a
+      // numeric OID (number *('.' number))
+      for(; ( (pos < len) && (str[pos] == ' ') ); pos++);
+      ava->type = &str[pos];
+      if ( (pos < len) && ((isalpha((unsigned char)str[pos]))) )
+      {
+         for(pos++; (pos < len); pos++)
+            if ( (!(isalnum((unsigned char)str[pos]))) && (str[pos] != '-') )
+               break;
+      }
+      else while ( (pos < len) && ((isdigit((unsigned char)str[pos]))) )
+      {
+         for(pos++; ( (pos < len) && ((isdigit((unsigned char)str[pos]))) ); pos++);
+         if ( ((pos+1) >= len) || (str[pos] != '.') || (!(isdigit((unsigned char)str[pos+1]))) )
+            break;
+         pos++;
+      };
+      ava->type_len = (size_t)(&str[pos] - ava->type);
+      if (!(ava->type_len))
+      {
+         errno = EINVAL;
+         return(-1);
+      };
+      for(; ( (pos < len) && (str[pos] == ' ') ); pos++);
+      if ( (pos >= len) || (str[pos] != '=') )
+      {
+         errno = EINVAL;
+         return(-1);
+      };
+      for(pos++; ( (pos < len) && (str[pos] == ' ') ); pos++);
+
+      ava->hex = 0;
+      ava->val = &str[pos];
+      if ( (pos < len) && (str[pos] == '#') )
+      {
+         // hex encoded BER value
+         for(pos++; ( (pos < len) && (ldaputils_dn_hex(str[pos]) != -1) ); pos++);
+         ava->val_len = (size_t)(&str[pos] - ava->val);
+         if ( (ava->val_len < 3) || (!(ava->val_len & 1)) )
+         {
+            errno = EINVAL;
+            return(-1);
+         };
+         ava->hex = 1;
+      }
+      else if ( (pos < len) && (str[pos] == '"') )
+      {
+         // quoted value accepted for compatibility with RFC 2253
+         ava->val = &str[++pos];
+         while ( (pos < len) && (str[pos] != '"') )
+         {
+            if (str[pos] != '\\')
+            {
+               pos++;
+               continue;
+            };
+            if ((esc = ldaputils_dn_escape(str, len, pos)) == 0)
+            {
+               errno = EINVAL;
+               return(-1);
+            };
+            pos += esc;
+         };
+         if (pos >= len)
+         {
+            errno = EINVAL;
+            return(-1);
+         };
+         ava->val_len = (size_t)(&str[pos++] - ava->val);
+      }
+      else
+      {
+         // string value ends before unescaped trailing spaces
+         for(end = pos; (pos < len); )
+         {
+            if ( (str[pos] == ',') || (str[pos] == '+') || (str[pos] == ';') )
+               break;
+            if ( (str[pos] == '"') || (str[pos] == '<') || (str[pos] == '>') || (str[pos] == '\0') )
+            {
+               errno = EINVAL;
+               return(-1);
+            };
+            if (str[pos] == '\\')
+            {
+               if ((esc = ldaputils_dn_escape(str, len, pos)) == 0)
+               {
+                  errno = EINVAL;
+                  return(-1);
+               };
+               pos += esc;
+               end  = pos;
+               continue;
+            };
+            if (str[pos++] != ' ')
+               end = pos;
+         };
+         ava->val_len = (size_t)(&str[end] - ava->val);
+      };
+      dn->avas_len++;
+
+      // separator of next attribute value assertion or RDN
+      for(; ( (pos < len) && (str[pos] == ' ') ); pos++);
+      if (pos >= len)
+         break;
+      if (str[pos] == '+')
+      {
+         pos++;
+         continue;
+      };
+      if ( (str[pos] != ',') && (str[pos] != ';') )
+      {
+         errno = EINVAL;
+         return(-1);
+      };
+      pos++;
+      dn->rdns[++dn->rdns_len] = dn->avas_len;
+   };
+   dn->rdns[++dn->rdns_len] = dn->avas_len;
+
+   return(0);
+}
+
+
+/// appends bytes to formatted DN
+/// @param[in] out     formatter output
+/// @param[in] str     bytes to append
+/// @param[in] len     number of bytes
+void ldaputils_dn_put(LDAPUtilsDNBuff * out, const char * str, size_t len)
+{
+   size_t n;
+
+   if (out->len < out->size)
+   {
+      n = out->size - out->len;
+      memcpy(&out->buff[out->len], str, ((len < n) ? len : n));
+   };
+   out->len += len;
+
+   return;
+}
+
+
+/// appends RDN to formatted DN
+/// @param[in] out     formatter output
+/// @param[in] dn      parsed DN
+/// @param[in] rdn     index of RDN
+/// @param[in] format  format of DN
+void ldaputils_dn_put_rdn(LDAPUtilsDNBuff * out, const LDAPUtilsDN * dn, size_t rdn, int format)
+{
+   size_t                  x;
+   const LDAPUtilsDNAva  * ava;
+
+   for(x = dn->rdns[rdn]; (x < dn->rdns[rdn+1]); x++)
+   {
+      ava = &dn->avas[x];
+
+      // separates attribute value assertions of multi-valued RDN
+      if (x > dn->rdns[rdn])
+      {
+         switch(format)
+         {
+            case LDAPUTILS_DN_UFN: ldaputils_dn_put(out, " + ", 3); break;
+            case LDAPUTILS_DN_ADC:
+            case LDAPUTILS_DN_DCE: ldaputils_dn_put(out, ",", 1);   break;
+            default:               ldaputils_dn_put(out, "+", 1);   break;
+         };
+      };
+
+      // user friendly and canonical names omit attribute types
+      if ( (format == LDAPUTILS_DN_DN) || (format == LDAPUTILS_DN_DCE) )
+      {
+         ldaputils_dn_put(out, ava->type, ava->type_len);
+         ldaputils_dn_put(out, "=", 1);
+      };
+
+      ldaputils_dn_put_val(out, ava, format);
+   };
+
+   return;
+}
+
+
+/// appends value to formatted DN using escapes of format
+/// @param[in] out     formatter output
+/// @param[in] ava     attribute value assertion
+/// @param[in] format  format of DN, or zero to append value without escapes
+void ldaputils_dn_put_val(LDAPUtilsDNBuff * out, const LDAPUtilsDNAva * ava, int format)
+{
+   int            c;
+   size_t         pos;
+   size_t         run;
+   size_t         start;
+   char           esc[3];
+
+   // BER values are written as received
+   if ((ava->hex))
+   {
+      ldaputils_dn_put(out, ava->val, ava->val_len);
+      return;
+   };
+
+   for(pos = 0, run = 0; (pos < ava->val_len); )
+   {
+      // copies runs of bytes which are escaped in neither source nor target
+      c = (unsigned char)ava->val[pos];
+      if ( (c != '\\') && (!(ldaputils_dn_escaped(c, format, (pos == 0), ((pos+1) == ava->val_len)))) )
+      {
+         pos++;
+         continue;
+      };
+      ldaputils_dn_put(out, &ava->val[run], pos - run);
+
+      // decodes byte and escapes it for target
+      start = pos;
+      c     = ldaputils_dn_next(ava->val, ava->val_len, &pos);
+      run   = pos;
+      esc[0] = '\\';
+      switch(ldaputils_dn_escaped(c, format, (start == 0), (pos >= ava->val_len)))
+      {
+         case 0:
+         esc[0] = (char)c;
+         ldaputils_dn_put(out, esc, 1);
+         break;
+
+         case 1:
+         esc[1] = (char)c;
+         ldaputils_dn_put(out, esc, 2);
+         break;
+
+         default:
+         esc[1] = "0123456789ABCDEF"[(c >> 4) & 0x0f];
+         esc[2] = "0123456789ABCDEF"[c & 0x0f];
+         ldaputils_dn_put(out, esc, 3);
+         break;
+      };
+   };
+   ldaputils_dn_put(out, &ava->val[run], pos - run);
+
+   return;
+}
+
+/* end of source file */
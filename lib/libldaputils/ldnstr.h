@@ -0,0 +1,92 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/ldnstr.h  allocation free DN parser and formatter
+ */
+#ifndef _LIB_LIBLDAPUTILS_LDNSTR_H
+#define _LIB_LIBLDAPUTILS_LDNSTR_H 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// characters escaped within RFC 4514 values
+#define LDAPUTILS_DN_SPECIALS       "\"+,;<=>\\"
+
+// characters escaped within Active Directory canonical names and DCE-style DNs
+#define LDAPUTILS_DN_SPECIALS_ADC   "\\/,"
+#define LDAPUTILS_DN_SPECIALS_DCE   "\\/,="
+
+// OID of domainComponent
+#define LDAPUTILS_DN_DC_OID         "0.9.2342.19200300.100.1.25"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+size_t ldaputils_dn_escape(const char * str, size_t len, size_t pos);
+int ldaputils_dn_escaped(int c, int format, int lead, int trail);
+int ldaputils_dn_grow(LDAPUtilsDN * dn);
+int ldaputils_dn_hex(int c);
+int ldaputils_dn_is_dc(const LDAPUtilsDN * dn, size_t rdn);
+int ldaputils_dn_next(const char * val, size_t len, size_t * posp);
+int ldaputils_dn_parse_avas(LDAPUtilsDN * dn, const char * str, size_t len);
+void ldaputils_dn_put(LDAPUtilsDNBuff * out, const char * str, size_t len);
+void ldaputils_dn_put_rdn(LDAPUtilsDNBuff * out, const LDAPUtilsDN * dn, size_t rdn, int format);
+void ldaputils_dn_put_val(LDAPUtilsDNBuff * out, const LDAPUtilsDNAva * ava, int format);
+
+#endif /* end of header file */
@@ -52,6 +52,7 @@
 #include <assert.h>
 
 #include "lconfig.h"
+#include "ldn.h"
 
 
 //////////////////
@@ -441,8 +442,17 @@ int ldaputils_entry_cmp_dn(const void * ptr1, const void * ptr2)
    if (!(e2))
       return(1);
 
+   // entries with the same DN share DN node
+   if (e1->dnnode == e2->dnnode)
+      return(0);
+
+   // materialize DN components
+   ldaputils_entry_components((LDAPUtilsEntry *)e1);
+   ldaputils_entry_components((LDAPUtilsEntry *)e2);
    if ( (!(e1->components)) || (!(e2->components)) )
    {
+      if ( (!(ldaputils_get_dn((LDAPUtilsEntry *)e1))) || (!(ldaputils_get_dn((LDAPUtilsEntry *)e2))) )
+         return(0);
       if ((rc = strcasecmp(e1->dn, e2->dn)))
          return(rc);
       return(strcmp(e1->dn, e2->dn));
@@ -471,6 +481,36 @@ int ldaputils_entry_cmp_dn(const void * ptr1, const void * ptr2)
 }
 
 
+/// creates a private copy of an entry before the entry is modified
+/// @param[in] entryp  reference to entry which is replaced by the copy if the entry is shared
+int ldaputils_entry_detach(LDAPUtilsEntry ** entryp)
+{
+   LDAPUtilsEntry * entry;
+
+   assert(entryp  != NULL);
+   assert(*entryp != NULL);
+
+   if (atomic_load(&(*entryp)->refcount) < 2)
+      return(LDAP_SUCCESS);
+
+   if ((entry = ldaputils_entry_copy(*entryp)) == NULL)
+      return(LDAP_NO_MEMORY);
+   if (((*entryp)->sortval))
+   {
+      if ((entry->sortval = strdup((*entryp)->sortval)) == NULL)
+      {
+         ldaputils_entry_free(entry);
+         return(LDAP_NO_MEMORY);
+      };
+   };
+
+   ldaputils_entry_free(*entryp);
+   *entryp = entry;
+
+   return(LDAP_SUCCESS);
+}
+
+
 LDAPUtilsEntry * ldaputils_entry_copy(LDAPUtilsEntry * entry)
 {
    size_t           x;
@@ -480,8 +520,13 @@ LDAPUtilsEntry * ldaputils_entry_copy(LDAPUtilsEntry * entry)
    assert(entry != NULL);
 
    // initialize
-   if ((new = ldaputils_entry_initialize(entry->dn)) == NULL)
+   if ((new = ldaputils_entry_initialize_dnnode(ldaputils_dn_node_retain(entry->dnnode))) == NULL)
       return(NULL);
+   if ((new->dn = strdup(entry->dn)) == NULL)
+   {
+      ldaputils_entry_free(new);
+      return(NULL);
+   };
 
    // initialize  attributes list
    size = sizeof(LDAPUtilsEntry *) * (entry->attrs_count+1);
@@ -507,17 +552,25 @@ LDAPUtilsEntry * ldaputils_entry_copy(LDAPUtilsEntry * entry)
 }
 
 
-// initializes list of entries
+/// releases reference to entry and frees entry after last reference is released
+/// @param[in] entry   reference to entry
 void ldaputils_entry_free(LDAPUtilsEntry * entry)
 {
    int  y;
 
    assert(entry != NULL);
 
+   if (atomic_fetch_sub(&entry->refcount, 1) > 1)
+      return;
+
    if (entry->dn != NULL)
-      ldap_memfree(entry->dn);
+      free(entry->dn);
    entry->dn = NULL;
 
+   // releases DN node
+   ldaputils_dn_node_release(entry->dnnode);
+   entry->dnnode = NULL;
+
    // frees sort value
    if (entry->sortval != NULL)
       free(entry->sortval);
@@ -552,46 +605,102 @@ void ldaputils_entry_free(LDAPUtilsEntry * entry)
 }
 
 
+/// materializes list of DN components starting with top level RDN
+/// @param[in] entry   reference to entry
+char ** ldaputils_entry_components(LDAPUtilsEntry * entry)
+{
+   assert(entry != NULL);
+
+   if ((entry->components))
+      return(entry->components);
+
+   if ((entry->components = malloc(sizeof(char *) * (entry->components_len+1))) == NULL)
+      return(NULL);
+   ldaputils_dn_node_components(entry->dnnode, (const char **)entry->components, entry->components_len);
+   entry->components[entry->components_len] = NULL;
+
+   return(entry->components);
+}
+
+
 // initializes list of entries
 LDAPUtilsEntry * ldaputils_entry_initialize(const char * dn)
 {
-   size_t           len;
-   size_t           u;
-   char           * str;
-   LDAPUtilsEntry * entry;
+   size_t            len;
+   size_t            u;
+   char            * str;
+   char           ** components;
+   LDAPUtilsEntry  * entry;
+   LDAPUtilsDNNode * dnnode;
 
-   // initialize memory
-   if ((entry = malloc(sizeof(LDAPUtilsEntry))) == NULL)
+   assert(dn != NULL);
+
+   // breaks DN into components and reverse order
+   if ((components = ldap_explode_dn(dn, 0)) == NULL)
+      return(NULL);
+   for(len = 0; (components[len] != NULL); len++);
+   for(u = 0; (u < (len/2)); u++)
+   {
+      str                  = components[u];
+      components[u]        = components[len-u-1];
+      components[len-u-1]  = str;
+   };
+
+   // retrieves shared DN node
+   dnnode = ldaputils_dn_node_get(components, len);
+   ldap_value_free(components);
+   if ( ((len)) && (!(dnnode)) )
       return(NULL);
-   bzero(entry, sizeof(LDAPUtilsEntry));
 
-   // copy dn
+   // keeps DN as returned by the server
+   if ((entry = ldaputils_entry_initialize_dnnode(dnnode)) == NULL)
+      return(NULL);
    if ((entry->dn = strdup(dn)) == NULL)
    {
-      free(entry);
+      ldaputils_entry_free(entry);
       return(NULL);
    };
 
-   // breaks DN into components
-   if ((entry->components = ldap_explode_dn(entry->dn, 0)) == NULL)
+   return(entry);
+}
+
+
+/// initializes entry from shared DN node
+/// @param[in] dnnode  reference to DN node, reference is owned by entry
+LDAPUtilsEntry * ldaputils_entry_initialize_dnnode(LDAPUtilsDNNode * dnnode)
+{
+   LDAPUtilsEntry * entry;
+
+   // initialize memory
+   if ((entry = malloc(sizeof(LDAPUtilsEntry))) == NULL)
    {
-      ldaputils_entry_free(entry);
+      ldaputils_dn_node_release(dnnode);
       return(NULL);
    };
-   entry->rdn = entry->components[0];
-   for(len = 0; (entry->components[len] != NULL); len++);
-   entry->components_len = len;
-   for(u = 0; (u < (len/2)); u++)
+   bzero(entry, sizeof(LDAPUtilsEntry));
+   atomic_init(&entry->refcount, 1);
+   entry->dnnode   = dnnode;
+
+   if ((dnnode))
    {
-      str                        = entry->components[u];
-      entry->components[u]       = entry->components[len-u-1];
-      entry->components[len-u-1] = str;
+      entry->rdn            = dnnode->rdn;
+      entry->components_len = dnnode->depth;
    };
 
    return(entry);
 }
 
 
+/// adds reference to entry, shared entries are detached before being modified
+/// @param[in] entry   reference to entry
+LDAPUtilsEntry * ldaputils_entry_retain(LDAPUtilsEntry * entry)
+{
+   assert(entry != NULL);
+   atomic_fetch_add(&entry->refcount, 1);
+   return(entry);
+}
+
+
 LDAPUtilsEntry * ldaputils_first_entry(LDAPUtilsEntries * entries)
 {
    assert(entries != NULL);
@@ -695,7 +804,7 @@ const char * const * ldaputils_get_dn_components(LDAPUtilsEntry * entry, size_t
    assert(entry != NULL);
    if ((lenp))
       *lenp = entry->components_len;
-   return((const char * const *)entry->components);
+   return((const char * const *)ldaputils_entry_components(entry));
 }
 
 
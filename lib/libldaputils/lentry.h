@@ -70,7 +70,10 @@
 #endif
 
 LDAPUtilsEntry * ldaputils_entry_copy(LDAPUtilsEntry * entry);
+int ldaputils_entry_detach(LDAPUtilsEntry ** entryp);
 int ldaputils_entry_add_attribute(LDAPUtilsEntry * entry, const char * name, struct berval ** vals);
+char ** ldaputils_entry_components(LDAPUtilsEntry * entry);
 LDAPUtilsEntry * ldaputils_entry_initialize(const char * dn);
+LDAPUtilsEntry * ldaputils_entry_initialize_dnnode(LDAPUtilsDNNode * dnnode);
 
 #endif /* end of header file */
@@ -46,6 +46,10 @@
 #pragma mark - Functions
 #endif
 
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
 #define LDAP_DEPRECATED 1
 #include <ldap.h>
 #include <ldaputils.h>
@@ -70,6 +74,167 @@
 #pragma mark - Datatypes
 #endif
 
+typedef struct ldap_utils_dn_node LDAPUtilsDNNode;
+typedef struct ldap_utils_dn_buff LDAPUtilsDNBuff;
+typedef struct ldap_utils_arrow_buff LDAPUtilsArrowBuff;
+typedef struct ldap_utils_arrow_column LDAPUtilsArrowColumn;
+typedef struct ldap_utils_fb_field LDAPUtilsFBField;
+typedef struct ldap_utils_compress LDAPUtilsCompress;
+typedef struct ldap_utils_compress_job LDAPUtilsCompressJob;
+typedef struct ldap_utils_batch LDAPUtilsBatch;
+typedef struct ldap_utils_ring LDAPUtilsRing;
+
+struct ldap_utils_arrow_buff
+{
+   unsigned char       * data;
+   size_t                len;
+   size_t                size;
+   int                   err;             // errno of first failed allocation
+   int                   pad0;
+};
+
+
+struct ldap_utils_arrow_column
+{
+   char                * name;
+   size_t                name_len;
+   int                   type;            // value type
+   int                   flags;           // column flags
+   size_t                cell;            // number of values appended to current row
+   size_t                list_nulls;      // number of null lists in batch
+   size_t                count;           // number of values in batch
+   size_t                nulls;           // number of null values in batch
+   LDAPUtilsArrowBuff    list_validity;
+   LDAPUtilsArrowBuff    list_offsets;
+   LDAPUtilsArrowBuff    validity;
+   LDAPUtilsArrowBuff    offsets;
+   LDAPUtilsArrowBuff    data;
+};
+
+
+struct ldap_utils_arrow
+{
+   LDAPUtilsSink       * sink;
+   size_t                rows;            // number of rows in current batch
+   size_t                batch_rows;      // number of rows per record batch
+   size_t                cols_len;
+   size_t                hash_mask;
+   int                 * hash;            // column name to column index
+   LDAPUtilsArrowColumn * cols;
+   LDAPUtilsArrowBuff    meta;            // flatbuffer encoded message metadata
+   int                   started;         // schema has been written
+   int                   pad0;
+};
+
+
+struct ldap_utils_fb_field
+{
+   size_t                size;            // size of scalar or offset, 0 if field is absent
+   size_t                pos;             // position of field within buffer
+   uint64_t              value;
+};
+
+
+struct ldap_utils_compress_job
+{
+   char                * in;              // uncompressed block
+   size_t                in_len;
+   char                * out;             // compressed frame
+   size_t                out_len;
+   size_t                out_size;
+   int                   done;            // block has been compressed
+   int                   err;             // errno of failed compression
+};
+
+
+struct ldap_utils_compress
+{
+   pthread_mutex_t       mutex;
+   pthread_cond_t        cond;            // signals queued blocks and shutdown
+   pthread_cond_t        done;            // signals compressed blocks
+   pthread_t           * threads;
+   size_t                threads_len;
+   LDAPUtilsCompressJob * jobs;           // ring of blocks indexed by sequence number
+   size_t                jobs_len;
+   size_t                next;            // sequence number of next submitted block
+   size_t                claimed;         // sequence number of next unclaimed block
+   size_t                written;         // sequence number of next block to write
+   int                   type;            // compression algorithm
+   int                   level;           // compression level
+   int                   shutdown;        // worker threads should exit
+   int                   pad0;
+};
+
+
+struct ldap_utils_ring
+{
+   atomic_size_t         head;            // next slot read by consumer
+   char                  pad0[56];        // keeps head and tail on separate cache lines
+   atomic_size_t         tail;            // next slot written by producer
+   char                  pad1[56];
+   atomic_int            waiting;         // consumer is blocked on cond
+   int                   pad2;
+   size_t                mask;
+   void               ** slots;
+   pthread_mutex_t       mutex;
+   pthread_cond_t        cond;
+};
+
+
+struct ldap_utils_batch
+{
+   LDAPUtilsRow        * rows;
+   size_t                rows_len;
+   size_t                rows_size;
+   LDAPUtilsRowAttr    * attrs;
+   size_t              * attrs_vals;      // index of first value of each attribute
+   size_t                attrs_len;
+   size_t                attrs_size;
+   struct berval       * vals;
+   size_t                vals_len;
+   size_t                vals_size;
+   char               ** chunks;          // copies of decoded strings
+   size_t              * chunks_size;
+   size_t                chunks_len;
+   size_t                chunk;           // chunk currently being filled
+   size_t                chunk_len;       // bytes used in current chunk
+   size_t                bytes;           // bytes used in all chunks
+   LDAPUtilsSink       * out;             // formatted entries
+   struct berval         ldif;            // LDIF records parsed by formatter
+   size_t                ldif_off;        // byte offset of LDIF records within file
+   size_t                erroff;          // byte offset of LDIF record, or index of entry, which failed
+   struct berval       * lines;           // values of current LDIF record
+   size_t              * lines_attr;      // attribute of each value of current LDIF record
+   size_t                lines_size;
+   int                   err;             // error returned by format callback
+   int                   pad0;
+};
+
+
+struct ldap_utils_pipeline
+{
+   LDAPUtilsPipelineOpts opts;
+   LDAPUtilsSink       * sink;
+   LDAPUtilsBatch      * batches;
+   size_t                batches_len;
+   LDAPUtilsBatch      * batch;           // batch being decoded
+   LDAPUtilsRing         free;            // batches returned by writer
+   LDAPUtilsRing       * input;           // batches queued for each formatter
+   LDAPUtilsRing       * output;          // batches formatted by each formatter
+   pthread_t           * threads;
+   size_t                threads_len;
+   size_t                seq;             // number of batches queued
+   size_t                count;           // number of entries decoded
+   atomic_size_t         workers;         // assigns ring to each formatter
+   pthread_t             writer;
+   atomic_int            err;             // first error of any stage
+   int                   errnum;          // errno of failed write
+   int                   writing;         // writer thread has been started
+   int                   pad0;
+   size_t                erroff;          // byte offset of LDIF record, or index of entry, which failed
+};
+
+
 struct ldap_utils_attribute
 {
    char           * name;
@@ -78,15 +243,53 @@ struct ldap_utils_attribute
 };
 
 
+// output of DN formatter, bytes beyond size are counted but not written
+struct ldap_utils_dn_buff
+{
+   char                 * buff;
+   size_t                 size;
+   size_t                 len;
+};
+
+
+struct ldap_utils_dn_node
+{
+   LDAPUtilsDNNode     * parent;
+   size_t                refcount;        // number of entries and child nodes referencing node
+   size_t                depth;           // number of RDNs in DN
+   size_t                hash;
+   size_t                len;
+   char                  rdn[];
+};
+
+
 struct ldap_utils_entry
 {
-   char                * dn;
+   char                * dn;              // DN as returned by the server
    const char          * rdn;
    char                * sortval;
+   atomic_size_t         refcount;        // number of lists and trees referencing entry
    size_t                components_len;
    size_t                attrs_count;
-   char               ** components;
+   char               ** components;      // materialized from dnnode when requested
    LDAPUtilsAttribute ** attrs;
+   LDAPUtilsDNNode     * dnnode;
+};
+
+
+struct ldap_utils_sink
+{
+   int                   fd;
+   int                   close_fd;        // close file descriptor when sink is closed
+   int                   err;             // errno of first failed write
+   int                   truncate;        // truncate preallocated space when sink is closed
+   char                * buff;
+   size_t                buff_len;
+   size_t                buff_size;
+   size_t                offset;          // number of bytes written to file descriptor
+   size_t                prealloc;        // number of bytes to preallocate at a time
+   size_t                reserved;        // number of bytes preallocated
+   LDAPUtilsCompress   * compress;        // block compression state or NULL
 };
 
 
@@ -98,6 +301,16 @@ struct ldap_utils_entries
 };
 
 
+struct ldap_utils_ldif
+{
+   char                * data;            // mapped file or contents read from stdin
+   size_t                size;
+   size_t                pos;             // start of next chunk
+   int                   mapped;          // data was mapped with mmap()
+   int                   pad0;
+};
+
+
 //////////////////
 //              //
 //  Prototypes  //
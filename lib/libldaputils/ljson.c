@@ -0,0 +1,356 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/ljson.c  JSON value encoding
+ */
+#define _LIB_LIBLDAPUTILS_LJSON_C 1
+#include "ljson.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+static const char ldaputils_base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char ldaputils_hex_chars[]    = "0123456789abcdef";
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// returns offset of first byte which must be escaped in a JSON string
+/// @param[in] data    data to scan
+/// @param[in] len     length of data
+size_t ldaputils_json_scan(const unsigned char * data, size_t len)
+{
+   size_t         pos;
+#if defined(__AVX2__)
+   unsigned       mask;
+   __m256i        quote;
+   __m256i        bslash;
+   __m256i        ctrl;
+   __m256i        blk;
+#elif defined(__SSE2__)
+   unsigned       mask;
+   __m128i        quote;
+   __m128i        bslash;
+   __m128i        ctrl;
+   __m128i        blk;
+#endif
+
+   pos = 0;
+
+#if defined(__AVX2__)
+   quote  = _mm256_set1_epi8('"');
+   bslash = _mm256_set1_epi8('\\');
+   ctrl   = _mm256_set1_epi8(0x1f);
+   for(; ((pos + 32) <= len); pos += 32)
+   {
+      blk  = _mm256_loadu_si256((const __m256i *)(const void *)&data[pos]);
+      blk  = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(blk, quote), _mm256_cmpeq_epi8(blk, bslash)), _mm256_cmpeq_epi8(_mm256_max_epu8(blk, ctrl), ctrl));
+      if ((mask = (unsigned)_mm256_movemask_epi8(blk)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask));
+   };
+#elif defined(__SSE2__)
+   quote  = _mm_set1_epi8('"');
+   bslash = _mm_set1_epi8('\\');
+   ctrl   = _mm_set1_epi8(0x1f);
+   for(; ((pos + 16) <= len); pos += 16)
+   {
+      blk  = _mm_loadu_si128((const __m128i *)(const void *)&data[pos]);
+      blk  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(blk, quote), _mm_cmpeq_epi8(blk, bslash)), _mm_cmpeq_epi8(_mm_max_epu8(blk, ctrl), ctrl));
+      if ((mask = (unsigned)_mm_movemask_epi8(blk)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask));
+   };
+#endif
+
+   for(; (pos < len); pos++)
+      if ( (data[pos] == '"') || (data[pos] == '\\') || (data[pos] < 0x20) )
+         return(pos);
+
+   return(len);
+}
+
+
+/// appends data to output as base64 encoded text
+/// @param[in] sink    reference to output sink
+/// @param[in] data    data to encode
+/// @param[in] len     length of data
+int ldaputils_sink_base64(LDAPUtilsSink * sink, const void * data, size_t len)
+{
+   size_t                  pos;
+   size_t                  off;
+   uint32_t                bits;
+   char                    buff[4096];
+   const unsigned char   * src;
+
+   assert(sink != NULL);
+   assert((data != NULL) || (len == 0));
+
+   src = data;
+   off = 0;
+
+   for(pos = 0; ((pos + 3) <= len); pos += 3)
+   {
+      bits = ((uint32_t)src[pos] << 16) | ((uint32_t)src[pos+1] << 8) | (uint32_t)src[pos+2];
+      buff[off++] = ldaputils_base64_chars[(bits >> 18) & 0x3f];
+      buff[off++] = ldaputils_base64_chars[(bits >> 12) & 0x3f];
+      buff[off++] = ldaputils_base64_chars[(bits >>  6) & 0x3f];
+      buff[off++] = ldaputils_base64_chars[bits & 0x3f];
+      if (off == sizeof(buff))
+      {
+         if (ldaputils_sink_write(sink, buff, off) == -1)
+            return(-1);
+         off = 0;
+      };
+   };
+
+   // encodes remaining bytes with padding
+   if (pos < len)
+   {
+      bits = (uint32_t)src[pos] << 16;
+      if ((pos + 1) < len)
+         bits |= (uint32_t)src[pos+1] << 8;
+      buff[off++] = ldaputils_base64_chars[(bits >> 18) & 0x3f];
+      buff[off++] = ldaputils_base64_chars[(bits >> 12) & 0x3f];
+      buff[off++] = ((pos + 1) < len) ? ldaputils_base64_chars[(bits >> 6) & 0x3f] : '=';
+      buff[off++] = '=';
+   };
+
+   return(ldaputils_sink_write(sink, buff, off));
+}
+
+
+/// appends data to output as quoted and escaped JSON string
+/// @param[in] sink    reference to output sink
+/// @param[in] data    UTF-8 string to encode
+/// @param[in] len     length of string
+int ldaputils_sink_json_string(LDAPUtilsSink * sink, const void * data, size_t len)
+{
+   size_t                  pos;
+   size_t                  span;
+   char                    esc[6];
+   const unsigned char   * str;
+
+   assert(sink != NULL);
+   assert((data != NULL) || (len == 0));
+
+   str = data;
+
+   if (ldaputils_sink_write(sink, "\"", 1) == -1)
+      return(-1);
+
+   for(pos = 0; (pos < len); pos += span + 1)
+   {
+      span = ldaputils_json_scan(&str[pos], (len - pos));
+      if (ldaputils_sink_write(sink, &str[pos], span) == -1)
+         return(-1);
+      if ((pos + span) == len)
+         break;
+
+      esc[0] = '\\';
+      switch(str[pos+span])
+      {
+         case '"':  esc[1] = '"';  break;
+         case '\\': esc[1] = '\\'; break;
+         case '\b': esc[1] = 'b';  break;
+         case '\f': esc[1] = 'f';  break;
+         case '\n': esc[1] = 'n';  break;
+         case '\r': esc[1] = 'r';  break;
+         case '\t': esc[1] = 't';  break;
+         default:
+         esc[1] = 'u';
+         esc[2] = '0';
+         esc[3] = '0';
+         esc[4] = ldaputils_hex_chars[str[pos+span] >> 4];
+         esc[5] = ldaputils_hex_chars[str[pos+span] & 0x0f];
+         if (ldaputils_sink_write(sink, esc, 6) == -1)
+            return(-1);
+         continue;
+      };
+      if (ldaputils_sink_write(sink, esc, 2) == -1)
+         return(-1);
+   };
+
+   return(ldaputils_sink_write(sink, "\"", 1));
+}
+
+
+/// appends value to output as JSON string or as base64 encoded object
+/// @param[in] sink    reference to output sink
+/// @param[in] data    value to encode
+/// @param[in] len     length of value
+/// @param[in] flags   encoding flags
+int ldaputils_sink_json_value(LDAPUtilsSink * sink, const void * data, size_t len, int flags)
+{
+   assert(sink != NULL);
+
+   if ( (!(flags & LDAPUTILS_JSON_BINARY)) && ((ldaputils_utf8_valid(data, len))) )
+      return(ldaputils_sink_json_string(sink, data, len));
+
+   if (ldaputils_sink_write(sink, "{ \"base64\": \"", 13) == -1)
+      return(-1);
+   if (ldaputils_sink_base64(sink, data, len) == -1)
+      return(-1);
+   return(ldaputils_sink_write(sink, "\" }", 3));
+}
+
+
+/// tests whether data is valid UTF-8 without NUL bytes
+/// @param[in] data    data to test
+/// @param[in] len     length of data
+int ldaputils_utf8_valid(const void * data, size_t len)
+{
+   size_t                  pos;
+   size_t                  seq;
+   uint32_t                cp;
+   uint32_t                min;
+   const unsigned char   * str;
+
+   assert((data != NULL) || (len == 0));
+
+   str = data;
+   pos = 0;
+
+   while (pos < len)
+   {
+      // skips ASCII runs
+      pos += ldaputils_utf8_ascii(&str[pos], (len - pos));
+      if (pos == len)
+         break;
+      if (str[pos] == '\0')
+         return(0);
+      if (str[pos] < 0x80)
+      {
+         pos++;
+         continue;
+      };
+
+      // determines length of multi-byte sequence
+      if      ((str[pos] & 0xe0) == 0xc0) { seq = 2; min = 0x80;    cp = str[pos] & 0x1f; }
+      else if ((str[pos] & 0xf0) == 0xe0) { seq = 3; min = 0x800;   cp = str[pos] & 0x0f; }
+      else if ((str[pos] & 0xf8) == 0xf0) { seq = 4; min = 0x10000; cp = str[pos] & 0x07; }
+      else
+         return(0);
+      if ((pos + seq) > len)
+         return(0);
+
+      // decodes continuation bytes
+      for(pos++, seq--; (seq > 0); pos++, seq--)
+      {
+         if ((str[pos] & 0xc0) != 0x80)
+            return(0);
+         cp = (cp << 6) | (str[pos] & 0x3f);
+      };
+
+      // rejects overlong encodings, surrogates, and out of range code points
+      if ( (cp < min) || (cp > 0x10ffff) || ((cp >= 0xd800) && (cp <= 0xdfff)) )
+         return(0);
+   };
+
+   return(1);
+}
+
+
+/// returns length of leading run of non-NUL ASCII bytes
+/// @param[in] data    data to scan
+/// @param[in] len     length of data
+size_t ldaputils_utf8_ascii(const unsigned char * data, size_t len)
+{
+   size_t         pos;
+#if defined(__AVX2__)
+   __m256i        zero;
+   __m256i        blk;
+#elif defined(__SSE2__)
+   __m128i        zero;
+   __m128i        blk;
+#endif
+
+   pos = 0;
+
+#if defined(__AVX2__)
+   zero = _mm256_setzero_si256();
+   for(; ((pos + 32) <= len); pos += 32)
+   {
+      blk = _mm256_loadu_si256((const __m256i *)(const void *)&data[pos]);
+      if ( ((_mm256_movemask_epi8(blk))) || ((_mm256_movemask_epi8(_mm256_cmpeq_epi8(blk, zero)))) )
+         break;
+   };
+#elif defined(__SSE2__)
+   zero = _mm_setzero_si128();
+   for(; ((pos + 16) <= len); pos += 16)
+   {
+      blk = _mm_loadu_si128((const __m128i *)(const void *)&data[pos]);
+      if ( ((_mm_movemask_epi8(blk))) || ((_mm_movemask_epi8(_mm_cmpeq_epi8(blk, zero)))) )
+         break;
+   };
+#endif
+
+   for(; (pos < len); pos++)
+      if ( (data[pos] >= 0x80) || (data[pos] == '\0') )
+         return(pos);
+
+   return(len);
+}
+
+/* end of source file */
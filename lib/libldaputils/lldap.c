@@ -124,4 +124,58 @@ int ldaputils_search(LDAPUtils * lud, LDAPMessage ** resp)
    return(LDAP_SUCCESS);
 }
 
+
+/// performs LDAP search and passes each entry to callback as it is received
+/// @param[in] lud     reference to LDAP utilities struct
+/// @param[in] func    callback, a non-zero return abandons the search
+/// @param[in] ctx     context passed to callback
+int ldaputils_search_each(LDAPUtils * lud, int (*func)(void * ctx, LDAP * ld, LDAPMessage * entry), void * ctx)
+{
+   int            rc;
+   int            err;
+   int            msgid;
+   LDAP         * ld;
+   LDAPMessage  * msg;
+
+   assert(lud  != NULL);
+   assert(func != NULL);
+
+   ld  = lud->ld;
+
+   if ((err = ldap_search_ext(ld, NULL, lud->scope, lud->filter, lud->attrs, 0, NULL, NULL, NULL, -1, &msgid)) != LDAP_SUCCESS)
+      return(err);
+
+   while((rc = ldap_result(ld, msgid, LDAP_MSG_ONE, NULL, &msg)) != -1)
+   {
+      switch(rc)
+      {
+         case 0:
+         continue;
+
+         case LDAP_RES_SEARCH_ENTRY:
+         if ((err = func(ctx, ld, msg)) != 0)
+         {
+            ldap_msgfree(msg);
+            ldap_abandon_ext(ld, msgid, NULL, NULL);
+            return(err);
+         };
+         ldap_msgfree(msg);
+         break;
+
+         case LDAP_RES_SEARCH_RESULT:
+         if ((rc = ldap_parse_result(ld, msg, &err, NULL, NULL, NULL, NULL, 1)) != LDAP_SUCCESS)
+            return(rc);
+         return(err);
+
+         default:
+         ldap_msgfree(msg);
+         break;
+      };
+   };
+
+   ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &err);
+
+   return(err);
+}
+
 /* end of source file */
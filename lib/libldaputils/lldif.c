@@ -0,0 +1,803 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lldif.c  memory mapped LDIF reader
+ */
+/*
+ *  The LDIF file is mapped into memory and split into chunks which end on
+ *  blank lines.  Since a folded line is continued by a line starting with a
+ *  space, a blank line always terminates a record and chunks can be located
+ *  without parsing any records.  Each chunk is handed to a formatter thread
+ *  of the pipeline which unfolds lines and decodes base64 values directly
+ *  into the string space of its batch, so the file is never copied through
+ *  a read buffer and the only serial work is finding the end of each chunk.
+ */
+#define _LIB_LIBLDAPUTILS_LLDIF_C 1
+#include "lldif.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "lpipeline.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// splits line into attribute description and value, decoding value in place
+/// @param[in] buff    unfolded line, at least one byte longer than line
+/// @param[in] len     length of line
+/// @param[out] name   NUL terminated attribute description
+/// @param[out] val    NUL terminated value
+int ldaputils_ldif_attr(char * buff, size_t len, struct berval * name, struct berval * val)
+{
+   size_t         x;
+   char         * ptr;
+
+   if ( ((ptr = memchr(buff, ':', len)) == NULL) || (ptr == buff) )
+      return(LDAP_DECODING_ERROR);
+   name->bv_val = buff;
+   name->bv_len = (size_t)(ptr - buff);
+   val->bv_val  = &ptr[1];
+   val->bv_len  = len - name->bv_len - 1;
+   if ( ((val->bv_len)) && (val->bv_val[0] == '<') )
+      return(LDAP_NOT_SUPPORTED);
+   if ( ((val->bv_len)) && (val->bv_val[0] == ':') )
+   {
+      for(x = 1; ( (x < val->bv_len) && (val->bv_val[x] == ' ') ); x++);
+      val->bv_val = &val->bv_val[x];
+      if (ldaputils_ldif_base64(val->bv_val, val->bv_len - x, &val->bv_len) == -1)
+         return(LDAP_DECODING_ERROR);
+   } else {
+      for(x = 0; ( (x < val->bv_len) && (val->bv_val[x] == ' ') ); x++);
+      val->bv_val  = &val->bv_val[x];
+      val->bv_len -= x;
+   };
+   name->bv_val[name->bv_len] = '\0';
+   val->bv_val[val->bv_len]   = '\0';
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// decodes base64 value in place
+/// @param[in] buff    encoded value, replaced with decoded value
+/// @param[in] len     length of encoded value
+/// @param[out] lenp   length of decoded value
+int ldaputils_ldif_base64(char * buff, size_t len, size_t * lenp)
+{
+   int            c;
+   size_t         x;
+   size_t         n;
+   size_t         out;
+   uint32_t       bits;
+
+   bits = 0;
+   n    = 0;
+   out  = 0;
+
+   for(x = 0; (x < len); x++)
+   {
+      c = (unsigned char)buff[x];
+      if      ( (c >= 'A') && (c <= 'Z') ) c = c - 'A';
+      else if ( (c >= 'a') && (c <= 'z') ) c = c - 'a' + 26;
+      else if ( (c >= '0') && (c <= '9') ) c = c - '0' + 52;
+      else if (c == '+')                   c = 62;
+      else if (c == '/')                   c = 63;
+      else if (c == '=')                   break;
+      else if (c == ' ')                   continue;
+      else                                 return(-1);
+
+      bits = (bits << 6) | (uint32_t)c;
+      if (++n < 4)
+         continue;
+      buff[out++] = (char)((bits >> 16) & 0xff);
+      buff[out++] = (char)((bits >>  8) & 0xff);
+      buff[out++] = (char)( bits        & 0xff);
+      bits = 0;
+      n    = 0;
+   };
+
+   // only padding may follow padding
+   for(; (x < len); x++)
+      if ( (buff[x] != '=') && (buff[x] != ' ') )
+         return(-1);
+
+   switch(n)
+   {
+      case 1:
+      return(-1);
+
+      case 2:
+      buff[out++] = (char)((bits >> 4) & 0xff);
+      break;
+
+      case 3:
+      buff[out++] = (char)((bits >> 10) & 0xff);
+      buff[out++] = (char)((bits >>  2) & 0xff);
+      break;
+
+      default:
+      break;
+   };
+
+   *lenp = out;
+
+   return(0);
+}
+
+
+/// returns next chunk of complete LDIF records
+/// @param[in] ldif    reference to LDIF file
+/// @param[in] size    minimum size of chunk
+/// @param[out] chunk  chunk of records
+/// @param[out] offp   byte offset of chunk within file
+int ldaputils_ldif_chunk(LDAPUtilsLDIF * ldif, size_t size, struct berval * chunk, size_t * offp)
+{
+   size_t         pos;
+   size_t         end;
+   const char   * ptr;
+
+   assert(ldif  != NULL);
+   assert(chunk != NULL);
+
+   if (ldif->pos >= ldif->size)
+      return(0);
+
+   // extends chunk past blank line which follows split point
+   end = ((ldif->size - ldif->pos) > size) ? (ldif->pos + size) : ldif->size;
+   pos = ((end > ldif->pos)) ? (end - 1) : end;
+   while (end < ldif->size)
+   {
+      if ((ptr = memchr(&ldif->data[pos], '\n', ldif->size - pos)) == NULL)
+      {
+         end = ldif->size;
+         break;
+      };
+      pos = (size_t)(ptr - ldif->data) + 1;
+      if ( (pos < ldif->size) && (ldif->data[pos] == '\n') )
+      {
+         end = pos + 1;
+         break;
+      };
+      if ( ((pos+1) < ldif->size) && (ldif->data[pos] == '\r') && (ldif->data[pos+1] == '\n') )
+      {
+         end = pos + 2;
+         break;
+      };
+   };
+
+   chunk->bv_val = &ldif->data[ldif->pos];
+   chunk->bv_len = end - ldif->pos;
+   if ((offp))
+      *offp = ldif->pos;
+   ldif->pos = end;
+
+   return(1);
+}
+
+
+/// unmaps LDIF file and frees resources
+/// @param[in] ldif    reference to LDIF file
+void ldaputils_ldif_close(LDAPUtilsLDIF * ldif)
+{
+   if (!(ldif))
+      return;
+
+   if ((ldif->mapped))
+      munmap(ldif->data, ldif->size);
+   else
+      free(ldif->data);
+
+   free(ldif);
+
+   return;
+}
+
+
+/// returns description of error encountered while reading LDIF records
+/// @param[in] err     LDAP error code
+const char * ldaputils_ldif_err2string(int err)
+{
+   switch(err)
+   {
+      case LDAP_DECODING_ERROR:        return("invalid LDIF record");
+      case LDAP_NOT_SUPPORTED:         return("URL values not supported");
+      case LDAP_UNWILLING_TO_PERFORM:  return("change records not supported");
+      default:                         break;
+   };
+   return(ldap_err2string(err));
+}
+
+
+/// returns next logical line, which may span folded lines
+/// @param[in] buff    LDIF records
+/// @param[in] len     length of LDIF records
+/// @param[in] posp    offset of line, updated to offset of following line
+/// @param[out] line   line without line ending
+/// @param[out] foldedp  line contains continuation lines
+int ldaputils_ldif_line(const char * buff, size_t len, size_t * posp, struct berval * line, int * foldedp)
+{
+   size_t         pos;
+   size_t         end;
+   const char   * ptr;
+
+   if ((pos = *posp) >= len)
+      return(0);
+
+   line->bv_val = (char *)&buff[pos];
+   *foldedp     = 0;
+
+   for(;;)
+   {
+      if ((ptr = memchr(&buff[pos], '\n', len - pos)) == NULL)
+      {
+         end = len;
+         pos = len;
+         break;
+      };
+      end = (size_t)(ptr - buff);
+      pos = end + 1;
+      if ( (pos >= len) || (buff[pos] != ' ') )
+         break;
+      *foldedp = 1;
+   };
+
+   line->bv_len = end - (size_t)(line->bv_val - buff);
+   if ( ((line->bv_len)) && (line->bv_val[line->bv_len-1] == '\r') )
+      line->bv_len--;
+   *posp = pos;
+
+   return(1);
+}
+
+
+/// decodes next attribute of LDIF record, the first attribute is the DN
+/// @param[in] rec     LDIF record
+/// @param[in] posp    offset of next line, zero for first line of record
+/// @param[in] buffp   buffer of at least one byte longer than record, advanced
+///                    past the decoded attribute description and value
+/// @param[out] name   NUL terminated attribute description, bv_val is NULL
+///                    after the last attribute
+/// @param[out] val    NUL terminated value
+int ldaputils_ldif_next(const struct berval * rec, size_t * posp, char ** buffp, struct berval * name, struct berval * val)
+{
+   int             err;
+   int             first;
+   int             folded;
+   size_t          n;
+   struct berval   line;
+
+   assert(rec   != NULL);
+   assert(posp  != NULL);
+   assert(buffp != NULL);
+   assert(name  != NULL);
+   assert(val   != NULL);
+
+   first        = (*posp == 0);
+   name->bv_val = NULL;
+   name->bv_len = 0;
+
+   while (ldaputils_ldif_line(rec->bv_val, rec->bv_len, posp, &line, &folded) == 1)
+   {
+      // skips comments and version
+      if ( (!(line.bv_len)) || (line.bv_val[0] == '#') )
+         continue;
+      if ( ((first)) && (line.bv_len >= 8) && (!(strncasecmp(line.bv_val, "version:", 8))) )
+         continue;
+
+      if ((folded))
+         n = ldaputils_ldif_unfold(line.bv_val, line.bv_len, *buffp);
+      else
+         memcpy(*buffp, line.bv_val, (n = line.bv_len));
+      if ((err = ldaputils_ldif_attr(*buffp, n, name, val)) != LDAP_SUCCESS)
+         return(err);
+      *buffp = &(*buffp)[n+1];
+
+      return(LDAP_SUCCESS);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// maps LDIF file into memory, NULL or "-" reads stdin
+/// @param[out] ldifp  reference to store LDIF file
+/// @param[in] file    name of file
+int ldaputils_ldif_open(LDAPUtilsLDIF ** ldifp, const char * file)
+{
+   int              fd;
+   int              err;
+   ssize_t          rc;
+   size_t           size;
+   void           * ptr;
+   struct stat      sb;
+   LDAPUtilsLDIF  * ldif;
+
+   assert(ldifp != NULL);
+
+   if ((ldif = malloc(sizeof(LDAPUtilsLDIF))) == NULL)
+      return(-1);
+   bzero(ldif, sizeof(LDAPUtilsLDIF));
+
+   if ( (!(file)) || (!(strcmp(file, "-"))) )
+      fd = STDIN_FILENO;
+   else if ((fd = open(file, O_RDONLY)) == -1)
+   {
+      free(ldif);
+      return(-1);
+   };
+
+   // maps regular files
+   if ( (fstat(fd, &sb) == 0) && (S_ISREG(sb.st_mode)) && (sb.st_size > 0) )
+   {
+      if ((ptr = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+      {
+         err = errno;
+         if (fd != STDIN_FILENO)
+            close(fd);
+         free(ldif);
+         errno = err;
+         return(-1);
+      };
+      madvise(ptr, (size_t)sb.st_size, MADV_SEQUENTIAL);
+      ldif->data   = ptr;
+      ldif->size   = (size_t)sb.st_size;
+      ldif->mapped = 1;
+      if (fd != STDIN_FILENO)
+         close(fd);
+      *ldifp = ldif;
+      return(0);
+   };
+
+   // reads pipes and other files which cannot be mapped
+   size = 0;
+   do
+   {
+      if (ldif->size == size)
+      {
+         size = ((size)) ? (size * 2) : LDAPUTILS_LDIF_READ_LEN;
+         if ((ptr = realloc(ldif->data, size)) == NULL)
+         {
+            rc = -1;
+            break;
+         };
+         ldif->data = ptr;
+      };
+      if ( ((rc = read(fd, &ldif->data[ldif->size], size - ldif->size)) == -1) && (errno == EINTR) )
+         continue;
+      if (rc > 0)
+         ldif->size += (size_t)rc;
+   } while (rc > 0);
+
+   err = errno;
+   if (fd != STDIN_FILENO)
+      close(fd);
+   if (rc == -1)
+   {
+      ldaputils_ldif_close(ldif);
+      errno = err;
+      return(-1);
+   };
+
+   *ldifp = ldif;
+
+   return(0);
+}
+
+
+/// parses chunk of LDIF records into batch, called by formatter threads
+/// @param[in] pipe    reference to pipeline
+/// @param[in] batch   batch containing chunk of LDIF records
+/// @return error of first invalid record, whose offset is stored in batch,
+///         the records preceding it remain in batch
+int ldaputils_ldif_parse(LDAPUtilsPipeline * pipe, LDAPUtilsBatch * batch)
+{
+   int             rc;
+   size_t          pos;
+   size_t          attrs_len;
+   struct berval   rec;
+
+   assert(pipe  != NULL);
+   assert(batch != NULL);
+
+   rc  = LDAP_SUCCESS;
+   pos = 0;
+   while (ldaputils_ldif_record(batch->ldif.bv_val, batch->ldif.bv_len, &pos, &rec) == 1)
+   {
+      // attributes of invalid record are discarded
+      attrs_len = batch->attrs_len;
+      if ((rc = ldaputils_ldif_parse_record(pipe, batch, &rec, batch->ldif_off + (size_t)(rec.bv_val - batch->ldif.bv_val))) != LDAP_SUCCESS)
+      {
+         batch->attrs_len = attrs_len;
+         batch->erroff    = batch->ldif_off + (size_t)(rec.bv_val - batch->ldif.bv_val);
+         break;
+      };
+   };
+
+   ldaputils_batch_resolve(batch);
+
+   return(rc);
+}
+
+
+/// parses LDIF record into row of batch
+/// @param[in] pipe    reference to pipeline
+/// @param[in] batch   batch receiving row
+/// @param[in] rec     LDIF record
+/// @param[in] off     byte offset of record within file
+int ldaputils_ldif_parse_record(LDAPUtilsPipeline * pipe, LDAPUtilsBatch * batch, const struct berval * rec, size_t off)
+{
+   int                  err;
+   int                  col;
+   int                  change;
+   int                  folded;
+   size_t               x;
+   size_t               n;
+   size_t               pos;
+   size_t               idx;
+   size_t               last;
+   size_t               size;
+   size_t               lines;
+   size_t               columns;
+   size_t               attrs_start;
+   char               * buff;
+   void               * list;
+   struct berval        dn;
+   struct berval        line;
+   struct berval        name;
+   struct berval        val;
+   LDAPUtilsRowAttr   * a;
+   LDAPUtilsRow       * row;
+
+   columns     = pipe->opts.columns;
+   attrs_start = batch->attrs_len;
+
+   // prepares empty columns and space for unfolded and decoded strings, which never exceed the record
+   if (ldaputils_batch_reserve(batch, columns, 0) == -1)
+      return(LDAP_NO_MEMORY);
+   if ((buff = ldaputils_batch_alloc(batch, rec->bv_len + 1)) == NULL)
+      return(LDAP_NO_MEMORY);
+   for(x = 0; (x < columns); x++)
+   {
+      bzero(&batch->attrs[attrs_start+x], sizeof(LDAPUtilsRowAttr));
+      batch->attrs_vals[attrs_start+x] = 0;
+   };
+   batch->attrs_len += columns;
+
+   dn.bv_val = NULL;
+   dn.bv_len = 0;
+   change    = 0;
+   lines     = 0;
+   last      = attrs_start;
+   pos       = 0;
+
+   while (ldaputils_ldif_line(rec->bv_val, rec->bv_len, &pos, &line, &folded) == 1)
+   {
+      // change operations of skipped change records are not decoded
+      if (change == 2)
+         break;
+
+      // skips comments and version
+      if ( (!(line.bv_len)) || (line.bv_val[0] == '#') )
+         continue;
+      if ( (!(dn.bv_val)) && (line.bv_len >= 8) && (!(strncasecmp(line.bv_val, "version:", 8))) )
+         continue;
+
+      // copies line into batch
+      if ((folded))
+         n = ldaputils_ldif_unfold(line.bv_val, line.bv_len, buff);
+      else
+         memcpy(buff, line.bv_val, (n = line.bv_len));
+
+      // splits attribute description from value
+      if ((err = ldaputils_ldif_attr(buff, n, &name, &val)) != LDAP_SUCCESS)
+         return(err);
+      buff = &buff[n+1];
+
+      // first line of record names entry
+      if (!(dn.bv_val))
+      {
+         if ( (name.bv_len != 2) || (strcasecmp(name.bv_val, "dn") != 0) )
+            return(LDAP_DECODING_ERROR);
+         dn = val;
+         continue;
+      };
+
+      // change records name their changetype after the DN and controls (RFC 2849)
+      if (!(change))
+      {
+         if ( (name.bv_len == 7) && (!(strcasecmp(name.bv_val, "control"))) )
+            continue;
+         change = 1;
+         if ( (name.bv_len == 10) && (!(strcasecmp(name.bv_val, "changetype"))) && ( (val.bv_len != 3) || ((strcasecmp(val.bv_val, "add"))) ) )
+         {
+            if (!(pipe->opts.flags & LDAPUTILS_PIPELINE_CHANGES))
+               return(LDAP_UNWILLING_TO_PERFORM);
+            change = 2;
+         };
+      };
+
+      // locates attribute of value
+      if ((columns))
+      {
+         col = pipe->opts.column(pipe->opts.ctx, &name);
+         if ( (col < 0) || ((size_t)col >= columns) )
+            continue;
+         idx = attrs_start + (size_t)col;
+         a   = &batch->attrs[idx];
+         if (!(a->name.bv_val))
+            a->name = name;
+         else if ( (a->name.bv_len != name.bv_len) || (strcasecmp(a->name.bv_val, name.bv_val) != 0) )
+            continue;
+      } else {
+         for(idx = last; (idx < batch->attrs_len); idx++)
+            if ( (batch->attrs[idx].name.bv_len == name.bv_len) && (!(strcasecmp(batch->attrs[idx].name.bv_val, name.bv_val))) )
+               break;
+         for(x = attrs_start; ( (idx == batch->attrs_len) && (x < last) ); x++)
+            if ( (batch->attrs[x].name.bv_len == name.bv_len) && (!(strcasecmp(batch->attrs[x].name.bv_val, name.bv_val))) )
+               idx = x;
+         if (idx == batch->attrs_len)
+         {
+            if (ldaputils_batch_reserve(batch, 1, 0) == -1)
+               return(LDAP_NO_MEMORY);
+            bzero(&batch->attrs[idx], sizeof(LDAPUtilsRowAttr));
+            batch->attrs[idx].name = name;
+            batch->attrs_len++;
+         };
+         last = idx;
+      };
+
+      // records value until all values of record are known
+      if (lines >= batch->lines_size)
+      {
+         size = (batch->lines_size) ? (batch->lines_size * 2) : 64;
+         if ((list = realloc(batch->lines, sizeof(struct berval) * size)) == NULL)
+            return(LDAP_NO_MEMORY);
+         batch->lines = list;
+         if ((list = realloc(batch->lines_attr, sizeof(size_t) * size)) == NULL)
+            return(LDAP_NO_MEMORY);
+         batch->lines_attr = list;
+         batch->lines_size = size;
+      };
+      batch->lines[lines]      = val;
+      batch->lines_attr[lines] = idx;
+      batch->attrs[idx].vals_len++;
+      lines++;
+   };
+   if (!(dn.bv_val))
+      return(LDAP_DECODING_ERROR);
+
+   // groups values of each attribute
+   if (ldaputils_batch_reserve(batch, 0, lines) == -1)
+      return(LDAP_NO_MEMORY);
+   for(idx = attrs_start, n = batch->vals_len; (idx < batch->attrs_len); idx++)
+   {
+      batch->attrs_vals[idx]     = n;
+      n                         += batch->attrs[idx].vals_len;
+      batch->attrs[idx].vals_len = 0;
+   };
+   for(x = 0; (x < lines); x++)
+   {
+      a = &batch->attrs[batch->lines_attr[x]];
+      batch->vals[batch->attrs_vals[batch->lines_attr[x]] + a->vals_len++] = batch->lines[x];
+   };
+   batch->vals_len = n;
+
+   row            = &batch->rows[batch->rows_len++];
+   row->idx       = off;
+   row->src       = 0;
+   row->dn        = dn;
+   row->attrs     = NULL;
+   row->attrs_len = batch->attrs_len - attrs_start;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// locates next LDIF record, skipping blank lines, comments and version
+/// @param[in] buff    LDIF records
+/// @param[in] len     length of LDIF records
+/// @param[in] posp    offset to start search, updated to offset following record
+/// @param[out] rec    record including comments, excluding terminating blank line
+int ldaputils_ldif_record(const char * buff, size_t len, size_t * posp, struct berval * rec)
+{
+   int             folded;
+   int             content;
+   size_t          pos;
+   size_t          start;
+   size_t          end;
+   struct berval   line;
+
+   assert(posp != NULL);
+   assert(rec  != NULL);
+
+   pos = *posp;
+
+   while (pos < len)
+   {
+      start   = pos;
+      end     = pos;
+      content = 0;
+
+      // reads lines until blank line
+      while ( (ldaputils_ldif_line(buff, len, &pos, &line, &folded) == 1) && ((line.bv_len)) )
+      {
+         end = pos;
+         if (line.bv_val[0] == '#')
+            continue;
+         if ( (!(content)) && (line.bv_len >= 8) && (!(strncasecmp(line.bv_val, "version:", 8))) )
+            continue;
+         content = 1;
+      };
+
+      if ((content))
+      {
+         rec->bv_val = (char *)&buff[start];
+         rec->bv_len = end - start;
+         *posp       = pos;
+         return(1);
+      };
+   };
+
+   *posp = pos;
+
+   return(0);
+}
+
+
+/// returns size of LDIF file in bytes
+/// @param[in] ldif    reference to LDIF file
+size_t ldaputils_ldif_size(LDAPUtilsLDIF * ldif)
+{
+   assert(ldif != NULL);
+   return(ldif->size);
+}
+
+
+/// copies folded line without line breaks and leading spaces of continuation lines
+/// @param[in] src     folded line
+/// @param[in] len     length of folded line
+/// @param[out] dst    buffer large enough to hold folded line
+size_t ldaputils_ldif_unfold(const char * src, size_t len, char * dst)
+{
+   size_t         pos;
+   size_t         end;
+   size_t         out;
+   const char   * ptr;
+
+   for(pos = 0, out = 0; (pos < len); pos = end + 2)
+   {
+      if ((ptr = memchr(&src[pos], '\n', len - pos)) == NULL)
+      {
+         memcpy(&dst[out], &src[pos], len - pos);
+         out += len - pos;
+         break;
+      };
+      end = (size_t)(ptr - src);
+      memcpy(&dst[out], &src[pos], end - pos);
+      out += end - pos;
+      if ( ((out)) && (dst[out-1] == '\r') )
+         out--;
+   };
+
+   return(out);
+}
+
+
+/// copies first value of attribute within LDIF record, unfolded and decoded
+/// @param[in] rec     LDIF record
+/// @param[in] attr    attribute description, or "dn" for DN of record
+/// @param[out] buff   buffer of at least one byte longer than record
+/// @param[out] val    NUL terminated value stored in buffer
+int ldaputils_ldif_value(const struct berval * rec, const char * attr, char * buff, struct berval * val)
+{
+   int             err;
+   int             dn;
+   int             folded;
+   size_t          n;
+   size_t          pos;
+   size_t          len;
+   const char    * ptr;
+   struct berval   line;
+   struct berval   name;
+
+   assert(rec  != NULL);
+   assert(attr != NULL);
+   assert(buff != NULL);
+   assert(val  != NULL);
+
+   len = strlen(attr);
+   dn  = 0;
+   pos = 0;
+
+   while (ldaputils_ldif_line(rec->bv_val, rec->bv_len, &pos, &line, &folded) == 1)
+   {
+      // skips comments and version
+      if ( (!(line.bv_len)) || (line.bv_val[0] == '#') )
+         continue;
+      if ( (!(dn)) && (line.bv_len >= 8) && (!(strncasecmp(line.bv_val, "version:", 8))) )
+         continue;
+
+      // only lines of the requested attribute are copied
+      if ((folded))
+      {
+         n = ldaputils_ldif_unfold(line.bv_val, line.bv_len, buff);
+      } else {
+         if ( ((dn)) && ( ((ptr = memchr(line.bv_val, ':', line.bv_len)) == NULL) || ((size_t)(ptr - line.bv_val) != len) || ((strncasecmp(line.bv_val, attr, len))) ) )
+            continue;
+         memcpy(buff, line.bv_val, (n = line.bv_len));
+      };
+      if ((err = ldaputils_ldif_attr(buff, n, &name, val)) != LDAP_SUCCESS)
+         return(err);
+
+      // first line of record names entry
+      if (!(dn))
+      {
+         if ( (name.bv_len != 2) || (strcasecmp(name.bv_val, "dn") != 0) )
+            return(LDAP_DECODING_ERROR);
+         if ( (len == 2) && (!(strcasecmp(attr, "dn"))) )
+            return(LDAP_SUCCESS);
+         dn = 1;
+         continue;
+      };
+
+      if ( (name.bv_len == len) && (!(strcasecmp(name.bv_val, attr))) )
+         return(LDAP_SUCCESS);
+   };
+
+   return((dn) ? LDAP_NO_SUCH_ATTRIBUTE : LDAP_DECODING_ERROR);
+}
+
+/* end of source file */
@@ -0,0 +1,945 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lpipeline.c  staged decode, format and write pipeline
+ */
+/*
+ *  Entries are decoded by the calling thread into batches which are handed
+ *  round robin to formatter threads through single-producer/single-consumer
+ *  rings.  Each formatter returns its batches through its own output ring,
+ *  and the writer thread reads the output rings in the same round robin
+ *  order, which preserves the order of entries without any shared queue.
+ *  Written batches are returned to the decoding thread through a free ring,
+ *  which bounds the number of batches in flight.  Chunks of LDIF records are
+ *  queued without being decoded and are parsed by the formatter threads.
+ */
+#define _LIB_LIBLDAPUTILS_LPIPELINE_C 1
+#include "lpipeline.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "lldif.h"
+#include "lsink.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// allocates space for decoded strings which remains valid until batch is reset
+/// @param[in] batch   reference to batch
+/// @param[in] len     number of bytes
+char * ldaputils_batch_alloc(LDAPUtilsBatch * batch, size_t len)
+{
+   size_t    size;
+   char    * ptr;
+   void    * list;
+
+   assert(batch != NULL);
+
+   while(batch->chunk < batch->chunks_len)
+   {
+      // grows chunk which does not yet hold any strings
+      if ( (!(batch->chunk_len)) && (batch->chunks_size[batch->chunk] < len) )
+      {
+         if ((ptr = realloc(batch->chunks[batch->chunk], len)) == NULL)
+            return(NULL);
+         batch->chunks[batch->chunk]      = ptr;
+         batch->chunks_size[batch->chunk] = len;
+      };
+      if ((batch->chunks_size[batch->chunk] - batch->chunk_len) >= len)
+      {
+         ptr               = &batch->chunks[batch->chunk][batch->chunk_len];
+         batch->chunk_len += len;
+         batch->bytes     += len;
+         return(ptr);
+      };
+      batch->chunk++;
+      batch->chunk_len = 0;
+   };
+
+   // appends new chunk
+   if ((list = realloc(batch->chunks, sizeof(char *) * (batch->chunks_len+1))) == NULL)
+      return(NULL);
+   batch->chunks = list;
+   if ((list = realloc(batch->chunks_size, sizeof(size_t) * (batch->chunks_len+1))) == NULL)
+      return(NULL);
+   batch->chunks_size = list;
+   size = (len > LDAPUTILS_PIPELINE_CHUNK) ? len : LDAPUTILS_PIPELINE_CHUNK;
+   if ((ptr = malloc(size)) == NULL)
+      return(NULL);
+   batch->chunks[batch->chunks_len]      = ptr;
+   batch->chunks_size[batch->chunks_len] = size;
+   batch->chunk                          = batch->chunks_len;
+   batch->chunks_len++;
+
+   batch->chunk_len  = len;
+   batch->bytes     += len;
+
+   return(ptr);
+}
+
+
+/// copies string into space allocated from batch
+/// @param[in] bv      string to copy, updated to reference copy
+/// @param[in] buff    space allocated from batch
+char * ldaputils_batch_copy(struct berval * bv, char * buff)
+{
+   if ((bv->bv_len))
+      memcpy(buff, bv->bv_val, bv->bv_len);
+   buff[bv->bv_len] = '\0';
+   bv->bv_val       = buff;
+   return(&buff[bv->bv_len+1]);
+}
+
+
+/// frees memory of batch
+/// @param[in] batch   reference to batch
+void ldaputils_batch_free(LDAPUtilsBatch * batch)
+{
+   size_t x;
+
+   assert(batch != NULL);
+
+   for(x = 0; (x < batch->chunks_len); x++)
+      free(batch->chunks[x]);
+   free(batch->chunks);
+   free(batch->chunks_size);
+   free(batch->rows);
+   free(batch->attrs);
+   free(batch->attrs_vals);
+   free(batch->vals);
+   free(batch->lines);
+   free(batch->lines_attr);
+   ldaputils_sink_close(batch->out);
+
+   return;
+}
+
+
+/// ensures batch can hold another entry
+/// @param[in] batch   reference to batch
+/// @param[in] attrs   number of attributes to add
+/// @param[in] vals    number of values to add
+int ldaputils_batch_reserve(LDAPUtilsBatch * batch, size_t attrs, size_t vals)
+{
+   size_t    size;
+   void    * ptr;
+
+   assert(batch != NULL);
+
+   if (batch->rows_len >= batch->rows_size)
+   {
+      size = (batch->rows_size) ? (batch->rows_size * 2) : 64;
+      if ((ptr = realloc(batch->rows, sizeof(LDAPUtilsRow) * size)) == NULL)
+         return(-1);
+      batch->rows      = ptr;
+      batch->rows_size = size;
+   };
+
+   if ((batch->attrs_len + attrs) > batch->attrs_size)
+   {
+      for(size = ((batch->attrs_size) ? batch->attrs_size : 64); (size < (batch->attrs_len + attrs)); size *= 2);
+      if ((ptr = realloc(batch->attrs, sizeof(LDAPUtilsRowAttr) * size)) == NULL)
+         return(-1);
+      batch->attrs = ptr;
+      if ((ptr = realloc(batch->attrs_vals, sizeof(size_t) * size)) == NULL)
+         return(-1);
+      batch->attrs_vals = ptr;
+      batch->attrs_size = size;
+   };
+
+   if ((batch->vals_len + vals) > batch->vals_size)
+   {
+      for(size = ((batch->vals_size) ? batch->vals_size : 256); (size < (batch->vals_len + vals)); size *= 2);
+      if ((ptr = realloc(batch->vals, sizeof(struct berval) * size)) == NULL)
+         return(-1);
+      batch->vals      = ptr;
+      batch->vals_size = size;
+   };
+
+   return(0);
+}
+
+
+/// resolves references into lists which may have moved while decoding
+/// @param[in] batch   reference to batch
+void ldaputils_batch_resolve(LDAPUtilsBatch * batch)
+{
+   size_t x;
+   size_t pos;
+
+   assert(batch != NULL);
+
+   for(x = 0, pos = 0; (x < batch->rows_len); x++)
+   {
+      batch->rows[x].attrs = &batch->attrs[pos];
+      pos += batch->rows[x].attrs_len;
+   };
+   for(x = 0; (x < batch->attrs_len); x++)
+      batch->attrs[x].vals = ((batch->attrs[x].vals_len)) ? &batch->vals[batch->attrs_vals[x]] : NULL;
+
+   return;
+}
+
+
+/// empties batch while retaining allocated memory
+/// @param[in] batch   reference to batch
+void ldaputils_batch_reset(LDAPUtilsBatch * batch)
+{
+   assert(batch != NULL);
+
+   batch->rows_len      = 0;
+   batch->attrs_len     = 0;
+   batch->vals_len      = 0;
+   batch->chunk         = 0;
+   batch->chunk_len     = 0;
+   batch->bytes         = 0;
+   batch->err           = 0;
+   batch->erroff        = 0;
+   batch->ldif.bv_val   = NULL;
+   batch->ldif.bv_len   = 0;
+   batch->ldif_off      = 0;
+   batch->out->buff_len = 0;
+
+   return;
+}
+
+
+/// copies DN and queues it for formatting as entry without attributes
+/// @param[in] pipe    reference to pipeline
+/// @param[in] dn      DN string, does not need to be terminated
+/// @param[in] len     length of DN
+/// @param[in] src     index of input containing DN, reported by formatter
+/// @param[in] idx     position of DN within input, reported by formatter
+int ldaputils_pipeline_dn(LDAPUtilsPipeline * pipe, const char * dn, size_t len, size_t src, size_t idx)
+{
+   int                  rc;
+   size_t               x;
+   size_t               columns;
+   char               * buff;
+   LDAPUtilsRow       * row;
+   LDAPUtilsBatch     * batch;
+
+   assert(pipe != NULL);
+   assert( (dn != NULL) || (!(len)) );
+
+   // stops queuing once any stage has failed
+   if ((rc = atomic_load(&pipe->err)) != LDAP_SUCCESS)
+      return(rc);
+
+   // waits for batch to be returned by writer
+   if (!(pipe->batch))
+   {
+      pipe->batch = ldaputils_ring_pop(&pipe->free);
+      ldaputils_batch_reset(pipe->batch);
+   };
+   batch   = pipe->batch;
+   columns = pipe->opts.columns;
+
+   // prepares empty columns
+   if (ldaputils_batch_reserve(batch, columns, 0) == -1)
+      return(LDAP_NO_MEMORY);
+   if ((buff = ldaputils_batch_alloc(batch, len+1)) == NULL)
+      return(LDAP_NO_MEMORY);
+   for(x = 0; (x < columns); x++)
+   {
+      bzero(&batch->attrs[batch->attrs_len+x], sizeof(LDAPUtilsRowAttr));
+      batch->attrs_vals[batch->attrs_len+x] = 0;
+   };
+   batch->attrs_len += columns;
+
+   if ((len))
+      memcpy(buff, dn, len);
+   buff[len] = '\0';
+
+   row               = &batch->rows[batch->rows_len++];
+   row->idx          = idx;
+   row->src          = src;
+   row->dn.bv_val    = buff;
+   row->dn.bv_len    = len;
+   row->attrs        = NULL;
+   row->attrs_len    = columns;
+
+   if ( (batch->rows_len >= pipe->opts.rows) || (batch->bytes >= LDAPUTILS_PIPELINE_BYTES) )
+      ldaputils_pipeline_submit(pipe);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// decodes entry and queues it for formatting
+/// @param[in] ptr     reference to pipeline
+/// @param[in] ld      LDAP descriptor
+/// @param[in] msg     LDAP entry
+int ldaputils_pipeline_entry(void * ptr, LDAP * ld, LDAPMessage * msg)
+{
+   int                  rc;
+   int                  col;
+   size_t               x;
+   size_t               n;
+   size_t               idx;
+   size_t               total;
+   size_t               columns;
+   size_t               attrs_start;
+   size_t               vals_start;
+   char               * buff;
+   BerElement         * ber;
+   struct berval        dn;
+   struct berval        attr;
+   struct berval      * vals;
+   LDAPUtilsRowAttr   * a;
+   LDAPUtilsRow       * row;
+   LDAPUtilsBatch     * batch;
+   LDAPUtilsPipeline  * pipe;
+
+   assert(ptr != NULL);
+   assert(msg != NULL);
+
+   pipe = ptr;
+
+   // stops decoding once any stage has failed
+   if ((rc = atomic_load(&pipe->err)) != LDAP_SUCCESS)
+      return(rc);
+
+   // waits for batch to be returned by writer
+   if (!(pipe->batch))
+   {
+      pipe->batch = ldaputils_ring_pop(&pipe->free);
+      ldaputils_batch_reset(pipe->batch);
+   };
+   batch       = pipe->batch;
+   columns     = pipe->opts.columns;
+   attrs_start = batch->attrs_len;
+   vals_start  = batch->vals_len;
+
+   if ((rc = ldap_get_dn_ber(ld, msg, &ber, &dn)) != LDAP_SUCCESS)
+      return(rc);
+   total = dn.bv_len + 1;
+
+   // prepares empty columns
+   if (ldaputils_batch_reserve(batch, columns, 0) == -1)
+   {
+      ber_free(ber, 0);
+      return(LDAP_NO_MEMORY);
+   };
+   for(x = 0; (x < columns); x++)
+   {
+      bzero(&batch->attrs[attrs_start+x], sizeof(LDAPUtilsRowAttr));
+      batch->attrs_vals[attrs_start+x] = 0;
+   };
+   batch->attrs_len += columns;
+
+   // collects attributes and values which still reference BER buffer
+   while ( ((rc = ldap_get_attribute_ber(ld, msg, ber, &attr, &vals)) == LDAP_SUCCESS) && ((attr.bv_val)) )
+   {
+      idx = batch->attrs_len;
+      if ((columns))
+      {
+         col = pipe->opts.column(pipe->opts.ctx, &attr);
+         if ( (col < 0) || ((size_t)col >= columns) || ((batch->attrs[attrs_start+(size_t)col].name.bv_val)) )
+         {
+            if ((vals))
+               ber_memfree(vals);
+            continue;
+         };
+         idx = attrs_start + (size_t)col;
+      };
+
+      for(n = 0; ( ((vals)) && ((vals[n].bv_val)) ); n++);
+      if (ldaputils_batch_reserve(batch, ((columns)) ? 0 : 1, n) == -1)
+      {
+         if ((vals))
+            ber_memfree(vals);
+         rc = LDAP_NO_MEMORY;
+         break;
+      };
+      if (!(columns))
+         batch->attrs_len++;
+
+      a                        = &batch->attrs[idx];
+      a->name                  = attr;
+      a->vals                  = NULL;
+      a->vals_len              = n;
+      batch->attrs_vals[idx]   = batch->vals_len;
+      total                   += attr.bv_len + 1;
+      for(x = 0; (x < n); x++)
+      {
+         batch->vals[batch->vals_len++] = vals[x];
+         total += vals[x].bv_len + 1;
+      };
+
+      if ((vals))
+         ber_memfree(vals);
+   };
+
+   // copies strings out of BER buffer
+   buff = NULL;
+   if ( (rc == LDAP_SUCCESS) && ((buff = ldaputils_batch_alloc(batch, total)) == NULL) )
+      rc = LDAP_NO_MEMORY;
+   if (rc != LDAP_SUCCESS)
+   {
+      batch->attrs_len = attrs_start;
+      batch->vals_len  = vals_start;
+      ber_free(ber, 0);
+      return(rc);
+   };
+   buff = ldaputils_batch_copy(&dn, buff);
+   for(idx = attrs_start; (idx < batch->attrs_len); idx++)
+   {
+      a = &batch->attrs[idx];
+      if (!(a->name.bv_val))
+         continue;
+      buff = ldaputils_batch_copy(&a->name, buff);
+      for(x = 0; (x < a->vals_len); x++)
+         buff = ldaputils_batch_copy(&batch->vals[batch->attrs_vals[idx]+x], buff);
+   };
+   ber_free(ber, 0);
+
+   row            = &batch->rows[batch->rows_len++];
+   row->idx       = pipe->count++;
+   row->src       = 0;
+   row->dn        = dn;
+   row->attrs     = NULL;
+   row->attrs_len = batch->attrs_len - attrs_start;
+
+   if ( (batch->rows_len >= pipe->opts.rows) || (batch->bytes >= LDAPUTILS_PIPELINE_BYTES) )
+      ldaputils_pipeline_submit(pipe);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// records first error of any stage
+/// @param[in] pipe    reference to pipeline
+/// @param[in] err     LDAP error code
+void ldaputils_pipeline_error(LDAPUtilsPipeline * pipe, int err)
+{
+   int expected;
+
+   expected = LDAP_SUCCESS;
+   atomic_compare_exchange_strong(&pipe->err, &expected, err);
+
+   return;
+}
+
+
+/// formats remaining entries, waits for output to be written and stops threads
+/// @param[in] pipe    reference to pipeline
+int ldaputils_pipeline_finish(LDAPUtilsPipeline * pipe)
+{
+   int err;
+
+   assert(pipe != NULL);
+
+   ldaputils_pipeline_flush(pipe);
+   ldaputils_pipeline_stop(pipe);
+
+   if ((err = atomic_load(&pipe->err)) != LDAP_SUCCESS)
+      errno = pipe->errnum;
+
+   return(err);
+}
+
+
+/// queues partially filled batch so entries already received are written
+/// @param[in] pipe    reference to pipeline
+void ldaputils_pipeline_flush(LDAPUtilsPipeline * pipe)
+{
+   assert(pipe != NULL);
+
+   if ( ((pipe->batch)) && ((pipe->batch->rows_len)) )
+      ldaputils_pipeline_submit(pipe);
+
+   return;
+}
+
+
+/// stops threads and frees pipeline
+/// @param[in] pipe    reference to pipeline
+void ldaputils_pipeline_free(LDAPUtilsPipeline * pipe)
+{
+   size_t x;
+
+   if (!(pipe))
+      return;
+
+   ldaputils_pipeline_stop(pipe);
+
+   for(x = 0; ( ((pipe->batches)) && (x < pipe->batches_len) ); x++)
+      ldaputils_batch_free(&pipe->batches[x]);
+   free(pipe->batches);
+
+   ldaputils_ring_free(&pipe->free);
+   for(x = 0; (x < pipe->opts.threads); x++)
+   {
+      if ((pipe->input))
+         ldaputils_ring_free(&pipe->input[x]);
+      if ((pipe->output))
+         ldaputils_ring_free(&pipe->output[x]);
+   };
+   free(pipe->input);
+   free(pipe->output);
+   free(pipe->threads);
+
+   free(pipe);
+
+   return;
+}
+
+
+/// starts decode, format and write pipeline
+/// @param[out] pipep  reference to store pipeline
+/// @param[in]  sink   output written by writer thread
+/// @param[in]  opts   pipeline options and callbacks
+int ldaputils_pipeline_initialize(LDAPUtilsPipeline ** pipep, LDAPUtilsSink * sink, const LDAPUtilsPipelineOpts * opts)
+{
+   size_t              x;
+   long                num;
+   LDAPUtilsPipeline * pipe;
+
+   assert(pipep        != NULL);
+   assert(sink         != NULL);
+   assert(opts         != NULL);
+   assert(opts->format != NULL);
+   assert( (!(opts->columns)) || ((opts->column)) );
+
+   if ((pipe = malloc(sizeof(LDAPUtilsPipeline))) == NULL)
+      return(-1);
+   bzero(pipe, sizeof(LDAPUtilsPipeline));
+   pipe->opts = *opts;
+   pipe->sink = sink;
+   atomic_init(&pipe->err, LDAP_SUCCESS);
+   atomic_init(&pipe->workers, 0);
+
+   if (!(pipe->opts.rows))
+      pipe->opts.rows = LDAPUTILS_PIPELINE_ROWS;
+   if (!(pipe->opts.threads))
+   {
+      num               = sysconf(_SC_NPROCESSORS_ONLN);
+      pipe->opts.threads = (num < 1) ? 1 : (size_t)num;
+   };
+   if (pipe->opts.threads > LDAPUTILS_PIPELINE_MAX_THREADS)
+      pipe->opts.threads = LDAPUTILS_PIPELINE_MAX_THREADS;
+
+   // allows each formatter one batch in progress and one batch queued
+   pipe->batches_len = (pipe->opts.threads * 2) + 2;
+   if ((pipe->batches = malloc(sizeof(LDAPUtilsBatch) * pipe->batches_len)) == NULL)
+   {
+      ldaputils_pipeline_free(pipe);
+      return(-1);
+   };
+   bzero(pipe->batches, sizeof(LDAPUtilsBatch) * pipe->batches_len);
+   for(x = 0; (x < pipe->batches_len); x++)
+   {
+      if (ldaputils_sink_fdopen(&pipe->batches[x].out, -1) == -1)
+      {
+         ldaputils_pipeline_free(pipe);
+         return(-1);
+      };
+   };
+
+   // rings are large enough to hold every batch and end of stream marker
+   if ((pipe->input = malloc(sizeof(LDAPUtilsRing) * pipe->opts.threads)) != NULL)
+      bzero(pipe->input, sizeof(LDAPUtilsRing) * pipe->opts.threads);
+   if ((pipe->output = malloc(sizeof(LDAPUtilsRing) * pipe->opts.threads)) != NULL)
+      bzero(pipe->output, sizeof(LDAPUtilsRing) * pipe->opts.threads);
+   if ( (!(pipe->input)) || (!(pipe->output)) || (ldaputils_ring_initialize(&pipe->free, pipe->batches_len+1) == -1) )
+   {
+      ldaputils_pipeline_free(pipe);
+      return(-1);
+   };
+   for(x = 0; (x < pipe->opts.threads); x++)
+   {
+      if ( (ldaputils_ring_initialize(&pipe->input[x],  pipe->batches_len+1) == -1) ||
+           (ldaputils_ring_initialize(&pipe->output[x], pipe->batches_len+1) == -1) )
+      {
+         ldaputils_pipeline_free(pipe);
+         return(-1);
+      };
+   };
+   for(x = 0; (x < pipe->batches_len); x++)
+      ldaputils_ring_push(&pipe->free, &pipe->batches[x]);
+
+   // starts formatter threads
+   if ((pipe->threads = malloc(sizeof(pthread_t) * pipe->opts.threads)) == NULL)
+   {
+      ldaputils_pipeline_free(pipe);
+      return(-1);
+   };
+   for(x = 0; (x < pipe->opts.threads); x++)
+      if (pthread_create(&pipe->threads[x], NULL, ldaputils_pipeline_worker, pipe) != 0)
+         break;
+   pipe->threads_len = x;
+   if (!(pipe->threads_len))
+   {
+      ldaputils_pipeline_free(pipe);
+      return(-1);
+   };
+
+   // starts writer thread
+   if (pthread_create(&pipe->writer, NULL, ldaputils_pipeline_writer, pipe) != 0)
+   {
+      ldaputils_pipeline_free(pipe);
+      return(-1);
+   };
+   pipe->writing = 1;
+
+   *pipep = pipe;
+
+   return(0);
+}
+
+
+/// queues LDIF records for parsing and formatting by formatter threads
+/// @param[in] pipe    reference to pipeline
+/// @param[in] ldif    reference to LDIF file
+int ldaputils_pipeline_ldif(LDAPUtilsPipeline * pipe, LDAPUtilsLDIF * ldif)
+{
+   int             rc;
+   size_t          off;
+   struct berval   chunk;
+
+   assert(pipe != NULL);
+   assert(ldif != NULL);
+
+   // entries already queued are written before records of file
+   ldaputils_pipeline_flush(pipe);
+
+   while (ldaputils_ldif_chunk(ldif, LDAPUTILS_PIPELINE_BYTES, &chunk, &off) == 1)
+   {
+      if ((rc = atomic_load(&pipe->err)) != LDAP_SUCCESS)
+         return(rc);
+      // reuses empty batch left by ldaputils_pipeline_flush()
+      if (!(pipe->batch))
+         pipe->batch = ldaputils_ring_pop(&pipe->free);
+      ldaputils_batch_reset(pipe->batch);
+      pipe->batch->ldif     = chunk;
+      pipe->batch->ldif_off = off;
+      ldaputils_pipeline_submit(pipe);
+   };
+
+   return(atomic_load(&pipe->err));
+}
+
+
+/// returns byte offset of first LDIF record which could not be parsed or
+/// formatted
+/// @param[in] pipe    reference to pipeline
+size_t ldaputils_pipeline_offset(LDAPUtilsPipeline * pipe)
+{
+   assert(pipe != NULL);
+   return(pipe->erroff);
+}
+
+
+/// signals end of stream and waits for threads to exit
+/// @param[in] pipe    reference to pipeline
+void ldaputils_pipeline_stop(LDAPUtilsPipeline * pipe)
+{
+   size_t x;
+
+   assert(pipe != NULL);
+
+   for(x = 0; (x < pipe->threads_len); x++)
+      ldaputils_ring_push(&pipe->input[x], NULL);
+   for(x = 0; (x < pipe->threads_len); x++)
+      pthread_join(pipe->threads[x], NULL);
+
+   // writer reads output rings until it receives end of stream marker
+   if ((pipe->writing))
+      pthread_join(pipe->writer, NULL);
+   pipe->writing     = 0;
+   pipe->threads_len = 0;
+
+   return;
+}
+
+
+/// queues current batch for formatting
+/// @param[in] pipe    reference to pipeline
+void ldaputils_pipeline_submit(LDAPUtilsPipeline * pipe)
+{
+   LDAPUtilsBatch    * batch;
+
+   assert(pipe        != NULL);
+   assert(pipe->batch != NULL);
+
+   batch       = pipe->batch;
+   pipe->batch = NULL;
+
+   ldaputils_batch_resolve(batch);
+
+   ldaputils_ring_push(&pipe->input[pipe->seq % pipe->threads_len], batch);
+   pipe->seq++;
+
+   return;
+}
+
+
+/// formats batches of entries
+/// @param[in] ptr     reference to pipeline
+void * ldaputils_pipeline_worker(void * ptr)
+{
+   int                  rc;
+   int                  err;
+   size_t               x;
+   size_t               idx;
+   size_t               len;
+   void               * ctx;
+   LDAPUtilsBatch     * batch;
+   LDAPUtilsPipeline  * pipe;
+
+   pipe = ptr;
+   idx  = atomic_fetch_add(&pipe->workers, 1);
+
+   // allows formatters to use state which is not shared between threads
+   ctx = ((pipe->opts.worker)) ? pipe->opts.worker(pipe->opts.ctx, idx) : pipe->opts.ctx;
+
+   while((batch = ldaputils_ring_pop(&pipe->input[idx])) != NULL)
+   {
+      // parses LDIF records before formatting them, records preceding an
+      // invalid record are formatted before the error is reported
+      err = LDAP_SUCCESS;
+      if ( ((batch->ldif.bv_val)) && (!(atomic_load(&pipe->err))) )
+         err = ldaputils_ldif_parse(pipe, batch);
+
+      // output of entry which could not be formatted is discarded
+      for(x = 0; ( (x < batch->rows_len) && (!(batch->err)) && (!(atomic_load(&pipe->err))) ); x++)
+      {
+         len = batch->out->buff_len;
+         if ((rc = pipe->opts.format(ctx, &batch->rows[x], batch->out)) != LDAP_SUCCESS)
+         {
+            batch->out->buff_len = len;
+            batch->err           = rc;
+            batch->erroff        = batch->rows[x].idx;
+            break;
+         };
+      };
+      if ( (err != LDAP_SUCCESS) && (!(batch->err)) )
+         batch->err = err;
+      ldaputils_ring_push(&pipe->output[idx], batch);
+   };
+
+   ldaputils_ring_push(&pipe->output[idx], NULL);
+
+   return(NULL);
+}
+
+
+/// writes formatted batches in order
+/// @param[in] ptr     reference to pipeline
+void * ldaputils_pipeline_writer(void * ptr)
+{
+   size_t               seq;
+   LDAPUtilsRing      * ring;
+   LDAPUtilsBatch     * batch;
+   LDAPUtilsPipeline  * pipe;
+
+   pipe = ptr;
+
+   for(seq = 0; ; seq++)
+   {
+      ring = &pipe->output[seq % pipe->threads_len];
+
+      // makes output available before waiting for more entries
+      if ( ((pipe->opts.flags & LDAPUTILS_PIPELINE_FLUSH)) && ((ldaputils_ring_empty(ring))) && (!(atomic_load(&pipe->err))) )
+      {
+         if (ldaputils_sink_flush(pipe->sink) == -1)
+         {
+            pipe->errnum = errno;
+            ldaputils_pipeline_error(pipe, LDAP_OTHER);
+         };
+      };
+
+      if ((batch = ldaputils_ring_pop(ring)) == NULL)
+         break;
+
+      // entries preceding an error within batch are written before the
+      // error is reported
+      if ((batch->out->err))
+      {
+         pipe->errnum = batch->out->err;
+         ldaputils_pipeline_error(pipe, LDAP_NO_MEMORY);
+      }
+      else if ( (!(atomic_load(&pipe->err))) && (ldaputils_sink_write(pipe->sink, batch->out->buff, batch->out->buff_len) == -1) )
+      {
+         pipe->errnum = errno;
+         ldaputils_pipeline_error(pipe, LDAP_OTHER);
+      };
+      if ((batch->err))
+      {
+         if (!(atomic_load(&pipe->err)))
+            pipe->erroff = batch->erroff;
+         ldaputils_pipeline_error(pipe, batch->err);
+      };
+
+      ldaputils_ring_push(&pipe->free, batch);
+   };
+
+   return(NULL);
+}
+
+
+/// tests if ring is empty, may only be called by consumer
+/// @param[in] ring    reference to ring
+int ldaputils_ring_empty(LDAPUtilsRing * ring)
+{
+   return(atomic_load(&ring->tail) == atomic_load_explicit(&ring->head, memory_order_relaxed));
+}
+
+
+/// frees ring
+/// @param[in] ring    reference to ring
+void ldaputils_ring_free(LDAPUtilsRing * ring)
+{
+   if (!(ring->slots))
+      return;
+   free(ring->slots);
+   pthread_cond_destroy(&ring->cond);
+   pthread_mutex_destroy(&ring->mutex);
+   ring->slots = NULL;
+   return;
+}
+
+
+/// initializes single-producer/single-consumer ring
+/// @param[in] ring    reference to ring
+/// @param[in] len     maximum number of items queued at once
+int ldaputils_ring_initialize(LDAPUtilsRing * ring, size_t len)
+{
+   size_t size;
+
+   assert(ring != NULL);
+
+   for(size = 1; (size < len); size *= 2);
+
+   bzero(ring, sizeof(LDAPUtilsRing));
+   if ((ring->slots = malloc(sizeof(void *) * size)) == NULL)
+      return(-1);
+   ring->mask = size - 1;
+   atomic_init(&ring->head,    0);
+   atomic_init(&ring->tail,    0);
+   atomic_init(&ring->waiting, 0);
+   pthread_mutex_init(&ring->mutex, NULL);
+   pthread_cond_init(&ring->cond, NULL);
+
+   return(0);
+}
+
+
+/// removes item from ring, waiting if ring is empty
+/// @param[in] ring    reference to ring
+void * ldaputils_ring_pop(LDAPUtilsRing * ring)
+{
+   size_t   head;
+   size_t   spins;
+   void   * item;
+
+   assert(ring != NULL);
+
+   head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+   for(spins = 0; (atomic_load_explicit(&ring->tail, memory_order_acquire) == head); spins++)
+   {
+      if (spins < LDAPUTILS_RING_SPINS)
+      {
+         sched_yield();
+         continue;
+      };
+
+      // blocks until producer signals, the flag is checked by the producer
+      // after publishing each item
+      pthread_mutex_lock(&ring->mutex);
+      atomic_store(&ring->waiting, 1);
+      while (atomic_load(&ring->tail) == head)
+         pthread_cond_wait(&ring->cond, &ring->mutex);
+      atomic_store(&ring->waiting, 0);
+      pthread_mutex_unlock(&ring->mutex);
+   };
+
+   item = ring->slots[head & ring->mask];
+   atomic_store_explicit(&ring->head, (head + 1), memory_order_release);
+
+   return(item);
+}
+
+
+/// appends item to ring, ring must not be full
+/// @param[in] ring    reference to ring
+/// @param[in] item    item to append
+void ldaputils_ring_push(LDAPUtilsRing * ring, void * item)
+{
+   size_t tail;
+
+   assert(ring != NULL);
+
+   tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+   assert((tail - atomic_load(&ring->head)) <= ring->mask);
+
+   ring->slots[tail & ring->mask] = item;
+   atomic_store(&ring->tail, (tail + 1));
+
+   if ((atomic_load(&ring->waiting)))
+   {
+      pthread_mutex_lock(&ring->mutex);
+      pthread_cond_signal(&ring->cond);
+      pthread_mutex_unlock(&ring->mutex);
+   };
+
+   return;
+}
+
+/* end of source file */
@@ -0,0 +1,96 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lpipeline.h  staged decode, format and write pipeline
+ */
+#ifndef _LIB_LIBLDAPUTILS_LPIPELINE_H
+#define _LIB_LIBLDAPUTILS_LPIPELINE_H 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#define LDAPUTILS_PIPELINE_BYTES        (1024 * 1024)
+#define LDAPUTILS_PIPELINE_CHUNK        (64 * 1024)
+
+// number of times an empty ring is polled before blocking
+#define LDAPUTILS_RING_SPINS            64
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+char * ldaputils_batch_alloc(LDAPUtilsBatch * batch, size_t len);
+char * ldaputils_batch_copy(struct berval * bv, char * buff);
+void ldaputils_batch_free(LDAPUtilsBatch * batch);
+int ldaputils_batch_reserve(LDAPUtilsBatch * batch, size_t attrs, size_t vals);
+void ldaputils_batch_resolve(LDAPUtilsBatch * batch);
+void ldaputils_batch_reset(LDAPUtilsBatch * batch);
+
+void ldaputils_pipeline_error(LDAPUtilsPipeline * pipe, int err);
+void ldaputils_pipeline_stop(LDAPUtilsPipeline * pipe);
+void ldaputils_pipeline_submit(LDAPUtilsPipeline * pipe);
+void * ldaputils_pipeline_worker(void * ptr);
+void * ldaputils_pipeline_writer(void * ptr);
+
+int ldaputils_ring_empty(LDAPUtilsRing * ring);
+void ldaputils_ring_free(LDAPUtilsRing * ring);
+int ldaputils_ring_initialize(LDAPUtilsRing * ring, size_t len);
+void * ldaputils_ring_pop(LDAPUtilsRing * ring);
+void ldaputils_ring_push(LDAPUtilsRing * ring, void * item);
+
+#endif /* end of header file */
@@ -0,0 +1,438 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lsink.c  buffered output
+ */
+#define _LIB_LIBLDAPUTILS_LSINK_C 1
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#include "lsink.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <stdint.h>
+
+#include "lcompress.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// flushes buffered output and frees sink
+/// @param[in] sink    reference to output sink
+int ldaputils_sink_close(LDAPUtilsSink * sink)
+{
+   int rc;
+
+   if (!(sink))
+      return(0);
+
+   // writes empty frame so compressed output is never an empty file
+   rc = 0;
+   if ( ((sink->compress)) && (!(sink->compress->next)) )
+      rc = ldaputils_compress_submit(sink);
+
+   if ( (ldaputils_sink_flush(sink) == -1) && (!(rc)) )
+      rc = -1;
+   ldaputils_compress_free(sink->compress);
+
+   if ((sink->close_fd))
+   {
+      // removes space preallocated beyond end of output
+      if ( ((sink->truncate)) && (ftruncate(sink->fd, (off_t)sink->offset) == -1) && (!(rc)) )
+         rc = -1;
+      if ( (close(sink->fd) == -1) && (!(rc)) )
+         rc = -1;
+   };
+
+   free(sink->buff);
+   free(sink);
+
+   return(rc);
+}
+
+
+/// writes buffered output to file descriptor
+/// @param[in] sink    reference to output sink
+int ldaputils_sink_flush(LDAPUtilsSink * sink)
+{
+   assert(sink != NULL);
+
+   // output of memory sinks remains in buffer
+   if (sink->fd == -1)
+      return(0);
+
+   if (ldaputils_sink_spill(sink) == -1)
+      return(-1);
+
+   // waits for outstanding compressed blocks
+   if ((sink->compress))
+      return(ldaputils_compress_drain(sink, 0));
+
+   return(0);
+}
+
+
+/// opens buffered output sink
+/// @param[out] sinkp     reference to store sink
+/// @param[in]  path      output file or NULL for standard output
+/// @param[in]  prealloc  number of bytes to preallocate at a time or 0
+int ldaputils_sink_open(LDAPUtilsSink ** sinkp, const char * path, size_t prealloc)
+{
+   int             fd;
+   LDAPUtilsSink * sink;
+
+   assert(sinkp != NULL);
+
+   if (!(path))
+      return(ldaputils_sink_fdopen(sinkp, STDOUT_FILENO));
+
+   if ((fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644)) == -1)
+      return(-1);
+
+   if (ldaputils_sink_fdopen(&sink, fd) == -1)
+   {
+      close(fd);
+      return(-1);
+   };
+   sink->close_fd = 1;
+   sink->prealloc = prealloc;
+
+   *sinkp = sink;
+
+   return(0);
+}
+
+
+/// opens buffered output sink for file descriptor
+/// @param[out] sinkp     reference to store sink
+/// @param[in]  fd        file descriptor or -1 to keep output in memory
+int ldaputils_sink_fdopen(LDAPUtilsSink ** sinkp, int fd)
+{
+   LDAPUtilsSink * sink;
+
+   assert(sinkp != NULL);
+
+   if ((sink = malloc(sizeof(LDAPUtilsSink))) == NULL)
+      return(-1);
+   bzero(sink, sizeof(LDAPUtilsSink));
+   sink->fd = fd;
+
+   if ((sink->buff = malloc(LDAPUTILS_SINK_BUFF_LEN)) == NULL)
+   {
+      free(sink);
+      return(-1);
+   };
+   sink->buff_size = LDAPUTILS_SINK_BUFF_LEN;
+
+   *sinkp = sink;
+
+   return(0);
+}
+
+
+/// appends formatted string to output
+/// @param[in] sink    reference to output sink
+/// @param[in] fmt     printf style format string
+int ldaputils_sink_printf(LDAPUtilsSink * sink, const char * fmt, ...)
+{
+   va_list   args;
+   int       len;
+   char    * str;
+
+   assert(sink != NULL);
+   assert(fmt  != NULL);
+
+   // attempts to format string directly into buffer
+   va_start(args, fmt);
+   len = vsnprintf(&sink->buff[sink->buff_len], (sink->buff_size - sink->buff_len), fmt, args);
+   va_end(args);
+   if (len < 0)
+      return(-1);
+   if ((size_t)len < (sink->buff_size - sink->buff_len))
+   {
+      sink->buff_len += (size_t)len;
+      return(0);
+   };
+
+   // formats string into buffer after flushing buffer
+   if ((size_t)len < sink->buff_size)
+   {
+      if (ldaputils_sink_spill(sink) == -1)
+         return(-1);
+      va_start(args, fmt);
+      vsnprintf(&sink->buff[sink->buff_len], (sink->buff_size - sink->buff_len), fmt, args);
+      va_end(args);
+      sink->buff_len += (size_t)len;
+      return(0);
+   };
+
+   // formats strings larger than buffer
+   if ((str = malloc((size_t)len + 1)) == NULL)
+      return(-1);
+   va_start(args, fmt);
+   vsnprintf(str, (size_t)len + 1, fmt, args);
+   va_end(args);
+   len = ldaputils_sink_write(sink, str, (size_t)len);
+   free(str);
+
+   return(len);
+}
+
+
+/// appends string to output
+/// @param[in] sink    reference to output sink
+/// @param[in] str     string to append
+int ldaputils_sink_puts(LDAPUtilsSink * sink, const char * str)
+{
+   assert(str != NULL);
+   return(ldaputils_sink_write(sink, str, strlen(str)));
+}
+
+
+/// extends preallocated space of output file
+/// @param[in] sink    reference to output sink
+/// @param[in] len     number of bytes about to be written
+int ldaputils_sink_reserve(LDAPUtilsSink * sink, size_t len)
+{
+   off_t size;
+
+   assert(sink != NULL);
+
+   if ( (!(sink->prealloc)) || ((sink->offset + len) <= sink->reserved) )
+      return(0);
+
+   size = (off_t)sink->prealloc;
+   while ((sink->reserved + (size_t)size) < (sink->offset + len))
+      size += (off_t)sink->prealloc;
+
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+   if (fallocate(sink->fd, FALLOC_FL_KEEP_SIZE, (off_t)sink->reserved, size) == 0)
+   {
+      sink->reserved += (size_t)size;
+      sink->truncate  = 1;
+      return(0);
+   };
+#endif
+#ifdef HAVE_POSIX_FALLOCATE
+   if (posix_fallocate(sink->fd, (off_t)sink->reserved, size) == 0)
+   {
+      sink->reserved += (size_t)size;
+      sink->truncate  = 1;
+      return(0);
+   };
+#endif
+
+   // file system does not support preallocation
+   sink->prealloc = 0;
+
+   return(0);
+}
+
+
+/// empties full buffer by writing or queuing it for compression
+/// @param[in] sink    reference to output sink
+int ldaputils_sink_spill(LDAPUtilsSink * sink)
+{
+   char       * buff;
+   struct iovec iov;
+
+   assert(sink != NULL);
+
+   if (!(sink->buff_len))
+      return((sink->err) ? -1 : 0);
+
+   // grows buffer of memory sinks
+   if (sink->fd == -1)
+   {
+      if ((buff = realloc(sink->buff, (sink->buff_size * 2))) == NULL)
+      {
+         sink->err = ENOMEM;
+         return(-1);
+      };
+      sink->buff       = buff;
+      sink->buff_size *= 2;
+      return(0);
+   };
+
+   if ((sink->compress))
+      return(ldaputils_compress_submit(sink));
+
+   iov.iov_base   = sink->buff;
+   iov.iov_len    = sink->buff_len;
+   sink->buff_len = 0;
+
+   return(ldaputils_sink_writev(sink, &iov, 1));
+}
+
+
+/// appends data to output
+/// @param[in] sink    reference to output sink
+/// @param[in] data    data to append
+/// @param[in] len     length of data
+int ldaputils_sink_write(LDAPUtilsSink * sink, const void * data, size_t len)
+{
+   size_t       size;
+   struct iovec iov[2];
+
+   assert(sink != NULL);
+
+   if (len == 0)
+      return(0);
+
+   // copies small writes into buffer
+   if (len <= (sink->buff_size - sink->buff_len))
+   {
+      memcpy(&sink->buff[sink->buff_len], data, len);
+      sink->buff_len += len;
+      return(0);
+   };
+   if (len < (sink->buff_size / 2))
+   {
+      if (ldaputils_sink_spill(sink) == -1)
+         return(-1);
+      memcpy(&sink->buff[sink->buff_len], data, len);
+      sink->buff_len += len;
+      return(0);
+   };
+
+   // splits large data into blocks for compression or memory sinks
+   if ( ((sink->compress)) || (sink->fd == -1) )
+   {
+      while (len > 0)
+      {
+         size = sink->buff_size - sink->buff_len;
+         size = (len < size) ? len : size;
+         memcpy(&sink->buff[sink->buff_len], data, size);
+         sink->buff_len += size;
+         data            = (const char *)data + size;
+         len            -= size;
+         if ( (sink->buff_len == sink->buff_size) && (ldaputils_sink_spill(sink) == -1) )
+            return(-1);
+      };
+      return(0);
+   };
+
+   // writes buffer and large data with single system call
+   iov[0].iov_base = sink->buff;
+   iov[0].iov_len  = sink->buff_len;
+   iov[1].iov_base = (void *)(uintptr_t)data;
+   iov[1].iov_len  = len;
+   sink->buff_len  = 0;
+
+   return(ldaputils_sink_writev(sink, iov, 2));
+}
+
+
+/// writes list of buffers to file descriptor
+/// @param[in] sink    reference to output sink
+/// @param[in] iov     list of buffers
+/// @param[in] iovcnt  number of buffers
+int ldaputils_sink_writev(LDAPUtilsSink * sink, struct iovec * iov, int iovcnt)
+{
+   ssize_t  rc;
+   size_t   len;
+   int      x;
+
+   assert(sink != NULL);
+   assert(iov  != NULL);
+
+   if ((sink->err))
+   {
+      errno = sink->err;
+      return(-1);
+   };
+
+   for(x = 0, len = 0; x < iovcnt; x++)
+      len += iov[x].iov_len;
+   ldaputils_sink_reserve(sink, len);
+
+   while(iovcnt > 0)
+   {
+      // skips empty buffers
+      if (iov->iov_len == 0)
+      {
+         iov++;
+         iovcnt--;
+         continue;
+      };
+
+      if ((rc = writev(sink->fd, iov, iovcnt)) == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         sink->err = errno;
+         return(-1);
+      };
+      sink->offset += (size_t)rc;
+
+      // advances past written data
+      while ( (iovcnt > 0) && ((size_t)rc >= iov->iov_len) )
+      {
+         rc -= (ssize_t)iov->iov_len;
+         iov++;
+         iovcnt--;
+      };
+      if (iovcnt > 0)
+      {
+         iov->iov_base  = (char *)iov->iov_base + rc;
+         iov->iov_len  -= (size_t)rc;
+      };
+   };
+
+   return(0);
+}
+
+/* end of source file */
@@ -0,0 +1,480 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lsort.c  external sort of keyed records
+ */
+/*
+ *  Records are appended to one buffer as a binary sort key followed by the
+ *  record.  Since the buffer is reallocated as it grows, records refer to
+ *  their key and data by offset until the buffer is complete.  Records
+ *  which exceed the memory of a tool are sorted and written as runs to
+ *  unlinked temporary files, each record preceded by the lengths of its
+ *  key and data.  Runs kept in memory and runs stored in files are merged
+ *  by a tournament tree whose internal nodes store the loser of each
+ *  match, so advancing the merge replays one match per level of the tree.
+ *  The leading bytes of each key are kept as an integer, which decides
+ *  most comparisons without reading the keys.
+ */
+#define _LIB_LIBLDAPUTILS_LSORT_C 1
+#include "lsort.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// appends bytes to buffer of records
+/// @param[in] buff    records
+/// @param[in] data    bytes to append
+/// @param[in] len     number of bytes
+int ldaputils_sort_append(LDAPUtilsSortBuff * buff, const void * data, size_t len)
+{
+   if (ldaputils_sort_grow(buff, len) == -1)
+      return(-1);
+   memcpy(&buff->text[buff->text_len], data, len);
+   buff->text_len += len;
+   return(0);
+}
+
+
+/// compares keys of records
+/// @param[in] ptr1   pointer to first record
+/// @param[in] ptr2   pointer to second record
+int ldaputils_sort_cmp(const void * ptr1, const void * ptr2)
+{
+   int                         rc;
+   const LDAPUtilsSortItem   * i1;
+   const LDAPUtilsSortItem   * i2;
+
+   i1 = ptr1;
+   i2 = ptr2;
+
+   if (i1->prefix != i2->prefix)
+      return((i1->prefix < i2->prefix) ? -1 : 1);
+   if ((rc = memcmp(i1->key, i2->key, ((i1->key_len < i2->key_len) ? i1->key_len : i2->key_len))))
+      return(rc);
+   if (i1->key_len != i2->key_len)
+      return((i1->key_len < i2->key_len) ? -1 : 1);
+
+   return(0);
+}
+
+
+/// frees bytes and records of buffer
+/// @param[in] buff    records
+void ldaputils_sort_free(LDAPUtilsSortBuff * buff)
+{
+   if ((buff->text))
+      free(buff->text);
+   if ((buff->items))
+      free(buff->items);
+   memset(buff, 0, sizeof(LDAPUtilsSortBuff));
+   return;
+}
+
+
+/// ensures space is available for appended bytes
+/// @param[in] buff    records
+/// @param[in] len     number of bytes which will be appended
+int ldaputils_sort_grow(LDAPUtilsSortBuff * buff, size_t len)
+{
+   size_t     size;
+   void     * ptr;
+
+   if ((buff->text_len + len) <= buff->text_size)
+      return(0);
+
+   size = (buff->text_size) ? (buff->text_size * 2) : LDAPUTILS_SORT_TEXT_LEN;
+   while (size < (buff->text_len + len))
+      size *= 2;
+   if ((ptr = realloc(buff->text, size)) == NULL)
+      return(-1);
+   buff->text      = ptr;
+   buff->text_size = size;
+
+   return(0);
+}
+
+
+/// adds record which was appended to buffer
+/// @param[in] buff    records
+/// @param[in] start   offset of key, followed by data which ends at end of buffer
+/// @param[in] key_len length of key
+int ldaputils_sort_item(LDAPUtilsSortBuff * buff, size_t start, size_t key_len)
+{
+   size_t                size;
+   void                * ptr;
+   LDAPUtilsSortItem   * item;
+
+   if (buff->items_len >= buff->items_size)
+   {
+      size = (buff->items_size) ? (buff->items_size * 2) : 256;
+      if ((ptr = realloc(buff->items, sizeof(LDAPUtilsSortItem) * size)) == NULL)
+         return(-1);
+      buff->items      = ptr;
+      buff->items_size = size;
+   };
+
+   // pointers are assigned once all records are appended
+   item           = &buff->items[buff->items_len++];
+   memset(item, 0, sizeof(LDAPUtilsSortItem));
+   item->key_off  = start;
+   item->key_len  = key_len;
+   item->data_off = start + key_len;
+   item->data_len = buff->text_len - item->data_off;
+
+   return(0);
+}
+
+
+/// tests if current record of first run sorts before second run
+/// @param[in] runs    runs being merged
+/// @param[in] a       index of first run
+/// @param[in] b       index of second run
+int ldaputils_sort_less(LDAPUtilsSortRun * runs, int a, int b)
+{
+   if ((runs[a].done))
+      return(0);
+   if ((runs[b].done))
+      return(1);
+   return(ldaputils_sort_cmp(&runs[a].item, &runs[b].item) < 0);
+}
+
+
+/// frees tournament tree and read buffers of runs
+/// @param[in] merge   merged runs
+void ldaputils_sort_merge_free(LDAPUtilsSortMerge * merge)
+{
+   int        x;
+
+   for(x = 0; ( ((merge->runs)) && (x < merge->k) ); x++)
+      if ((merge->runs[x].buff))
+         free(merge->runs[x].buff);
+   if ((merge->tree))
+      free(merge->tree);
+   memset(merge, 0, sizeof(LDAPUtilsSortMerge));
+
+   return;
+}
+
+
+/// reads first record of each run and plays initial tournament
+/// @param[in] merge   merged runs
+/// @param[in] runs    sorted runs
+/// @param[in] len     number of runs
+int ldaputils_sort_merge_init(LDAPUtilsSortMerge * merge, LDAPUtilsSortRun * runs, size_t len)
+{
+   int        k;
+   int        n;
+   int      * win;
+   size_t     x;
+
+   memset(merge, 0, sizeof(LDAPUtilsSortMerge));
+   merge->runs = runs;
+   merge->k    = k = (int)len;
+
+   if ((merge->tree = malloc(sizeof(int) * len)) == NULL)
+      return(-1);
+   if ((win = malloc(sizeof(int) * len * 2)) == NULL)
+      return(-1);
+
+   // reads first record of each run
+   for(x = 0; (x < len); x++)
+   {
+      if ( ((runs[x].fp)) && (fseeko(runs[x].fp, 0, SEEK_SET) == -1) )
+      {
+         free(win);
+         return(-1);
+      };
+      if (ldaputils_sort_next(&runs[x]) == -1)
+      {
+         free(win);
+         return(-1);
+      };
+   };
+
+   // each internal node stores the loser of its match
+   for(n = 0; (n < k); n++)
+      win[k+n] = n;
+   for(n = k-1; (n > 0); n--)
+   {
+      if ((ldaputils_sort_less(runs, win[2*n], win[2*n+1])))
+      {
+         win[n]         = win[2*n];
+         merge->tree[n] = win[2*n+1];
+      } else {
+         win[n]         = win[2*n+1];
+         merge->tree[n] = win[2*n];
+      };
+   };
+   merge->tree[0] = win[1];
+   free(win);
+
+   return(0);
+}
+
+
+/// returns current record of merged runs
+/// @param[in] merge   merged runs
+const LDAPUtilsSortItem * ldaputils_sort_merge_item(LDAPUtilsSortMerge * merge)
+{
+   if ((merge->runs[merge->tree[0]].done))
+      return(NULL);
+   return(&merge->runs[merge->tree[0]].item);
+}
+
+
+/// advances winning run and replays its matches
+/// @param[in] merge   merged runs
+int ldaputils_sort_merge_next(LDAPUtilsSortMerge * merge)
+{
+   int        n;
+   int        s;
+   int        t;
+
+   s = merge->tree[0];
+   if ((merge->runs[s].done))
+      return(0);
+   if (ldaputils_sort_next(&merge->runs[s]) == -1)
+      return(-1);
+
+   for(n = (s + merge->k) / 2; (n > 0); n /= 2)
+   {
+      if ((ldaputils_sort_less(merge->runs, merge->tree[n], s)))
+      {
+         t              = merge->tree[n];
+         merge->tree[n] = s;
+         s              = t;
+      };
+   };
+   merge->tree[0] = s;
+
+   return(0);
+}
+
+
+/// reads next record of run
+/// @param[in] run     sorted records
+int ldaputils_sort_next(LDAPUtilsSortRun * run)
+{
+   size_t     len;
+   size_t     hdr[2];
+   void     * ptr;
+
+   // records kept in memory
+   if (!(run->fp))
+   {
+      if ( (!(run->mem)) || (run->pos >= run->mem->items_len) )
+      {
+         run->done = 1;
+         return(0);
+      };
+      run->item = run->mem->items[run->pos++];
+      return(0);
+   };
+
+   if (fread(hdr, sizeof(hdr), 1, run->fp) != 1)
+   {
+      if ((ferror(run->fp)))
+         return(-1);
+      run->done = 1;
+      return(0);
+   };
+
+   len = hdr[0] + hdr[1];
+   if (len > run->size)
+   {
+      if ((ptr = realloc(run->buff, len)) == NULL)
+         return(-1);
+      run->buff = ptr;
+      run->size = len;
+   };
+   if (fread(run->buff, 1, len, run->fp) != len)
+   {
+      if (!(ferror(run->fp)))
+         errno = EIO;
+      return(-1);
+   };
+
+   run->item.key      = run->buff;
+   run->item.key_len  = hdr[0];
+   run->item.data     = &run->buff[hdr[0]];
+   run->item.data_len = hdr[1];
+   run->item.prefix   = ldaputils_sort_prefix(run->item.key, run->item.key_len);
+
+   return(0);
+}
+
+
+/// returns leading bytes of key as an integer
+/// @param[in] key     sort key
+/// @param[in] len     length of key
+uint64_t ldaputils_sort_prefix(const char * key, size_t len)
+{
+   size_t     x;
+   uint64_t   prefix;
+
+   for(x = 0, prefix = 0; (x < sizeof(prefix)); x++)
+      prefix = (prefix << 8) | ((x < len) ? (unsigned char)key[x] : 0);
+
+   return(prefix);
+}
+
+
+/// writes key and data of record to run
+/// @param[in] fp      temporary file of run
+/// @param[in] item    record
+int ldaputils_sort_put(FILE * fp, const LDAPUtilsSortItem * item)
+{
+   size_t     hdr[2];
+
+   hdr[0] = item->key_len;
+   hdr[1] = item->data_len;
+   if (fwrite(hdr, sizeof(hdr), 1, fp) != 1)
+      return(-1);
+   if (fwrite(item->key, 1, item->key_len, fp) != item->key_len)
+      return(-1);
+   if (fwrite(item->data, 1, item->data_len, fp) != item->data_len)
+      return(-1);
+
+   return(0);
+}
+
+
+/// assigns pointers of records and sorts records by key
+/// @param[in] buff    records
+void ldaputils_sort_records(LDAPUtilsSortBuff * buff)
+{
+   ldaputils_sort_resolve(buff);
+   if (buff->items_len > 1)
+      qsort(buff->items, buff->items_len, sizeof(LDAPUtilsSortItem), ldaputils_sort_cmp);
+   return;
+}
+
+
+/// assigns pointers of records once records are no longer appended
+/// @param[in] buff    records
+void ldaputils_sort_resolve(LDAPUtilsSortBuff * buff)
+{
+   size_t                x;
+   LDAPUtilsSortItem   * item;
+
+   for(x = 0; (x < buff->items_len); x++)
+   {
+      item         = &buff->items[x];
+      item->key    = &buff->text[item->key_off];
+      item->data   = &buff->text[item->data_off];
+      item->prefix = ldaputils_sort_prefix(item->key, item->key_len);
+   };
+
+   return;
+}
+
+
+/// parses size with optional K, M, or G suffix
+/// @param[in] str     size string
+/// @param[out] sizep  parsed size in bytes
+int ldaputils_sort_size(const char * str, size_t * sizep)
+{
+   char                 * end;
+   unsigned long long     size;
+
+   errno = 0;
+   size  = strtoull(str, &end, 10);
+   if ( ((errno)) || (end == str) )
+      return(-1);
+
+   switch(end[0])
+   {
+      case 'g': case 'G': size *= 1024; // fall through
+      case 'm': case 'M': size *= 1024; // fall through
+      case 'k': case 'K': size *= 1024; end++; break;
+      default: break;
+   };
+   if (end[0] != '\0')
+      return(-1);
+   *sizep = (size_t)size;
+
+   return(0);
+}
+
+
+/// creates unlinked temporary file for run
+/// @param[in] tmpdir   directory of temporary files
+/// @param[in] prefix   leading name of temporary file
+/// @param[in] buff_len size of stdio buffer
+FILE * ldaputils_sort_temp(const char * tmpdir, const char * prefix, size_t buff_len)
+{
+   int        fd;
+   FILE     * fp;
+   char       path[LDAPUTILS_BUFF_LEN];
+
+   if (snprintf(path, sizeof(path), "%s/%s.XXXXXX", tmpdir, prefix) >= (int)sizeof(path))
+   {
+      errno = ENAMETOOLONG;
+      return(NULL);
+   };
+   if ((fd = mkstemp(path)) == -1)
+      return(NULL);
+   unlink(path);
+
+   if ((fp = fdopen(fd, "w+")) == NULL)
+   {
+      close(fd);
+      return(NULL);
+   };
+   setvbuf(fp, NULL, _IOFBF, buff_len);
+
+   return(fp);
+}
+
+/* end of source file */
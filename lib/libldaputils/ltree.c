@@ -49,7 +49,10 @@
 #include <string.h>
 #include <ldap.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "lconfig.h"
 #include "lentry.h"
@@ -67,6 +70,13 @@
 #define LDAPUTILS_TREE_SPACE 0
 #define LDAPUTILS_TREE_DATA 1
 
+#define LDAPUTILS_SUBORD_UNKNOWN 0
+#define LDAPUTILS_SUBORD_COUNT   1
+#define LDAPUTILS_SUBORD_BOOLEAN 2
+
+#define LDAPUTILS_TREE_BUFF_LEN     65536
+#define LDAPUTILS_TREE_MAX_THREADS  64
+
 /////////////////
 //             //
 //  Datatypes  //
@@ -83,6 +93,9 @@ struct ldap_utils_tree
    LDAPUtilsTree     * parent;
    size_t              children_len;
    LDAPUtilsTree    ** children;
+   size_t              subordinates;      // value of numSubordinates or hasSubordinates
+   int                 subordinates_type;
+   int                 pad0;
 };
 
 typedef struct ldap_utils_tree_recur LDAPUtilsTreeRecursion;
@@ -90,8 +103,40 @@ typedef struct ldap_utils_tree_recur LDAPUtilsTreeRecursion;
 struct ldap_utils_tree_recur
 {
    char                * map;
+   size_t                map_size;
    size_t                lastline;   // last line contained data
    LDAPUtilsTreeOpts   * opts;
+   size_t                threads;    // number of threads available for rendering
+   char                * buff;       // rendered output
+   size_t                buff_len;
+   size_t                buff_size;
+   LDAPUtilsSink       * sink;       // output sink or NULL to buffer all output
+   int                   err;
+   int                   pad0;
+};
+
+typedef struct ldap_utils_tree_job LDAPUtilsTreeJob;
+
+struct ldap_utils_tree_job
+{
+   LDAPUtilsTree          * tree;     // parent of subtree
+   size_t                   idx;      // index of subtree within parent
+   size_t                   level;
+   size_t                   stop;
+   LDAPUtilsTreeRecursion   recur;
+   int                      done;
+   int                      err;
+};
+
+typedef struct ldap_utils_tree_pool LDAPUtilsTreePool;
+
+struct ldap_utils_tree_pool
+{
+   pthread_mutex_t          mutex;
+   pthread_cond_t           cond;
+   size_t                   next;     // next unclaimed job
+   size_t                   jobs_len;
+   LDAPUtilsTreeJob       * jobs;
 };
 
 
@@ -112,18 +157,40 @@ LDAPUtilsTree * ldaputils_tree_child_init(LDAPUtilsTree * tree, const char * rdn
 
 int ldaputils_tree_cmp(const void * ptr1, const void * ptr2);
 
+int ldaputils_tree_has_children(LDAPUtilsTree * tree);
+
 void ldaputils_tree_level_count_recursive(LDAPUtilsTree * tree, size_t level, size_t * depthp);
 
 void ldaputils_tree_print_bullets(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts);
 
 void ldaputils_tree_print_bullets_recursive(LDAPUtilsTree * tree, size_t level);
 
+void ldaputils_tree_print_child(LDAPUtilsTree * tree, size_t x, size_t level, LDAPUtilsTreeRecursion * recur, size_t stop);
+
+void ldaputils_tree_print_count(LDAPUtilsTree * tree, size_t level, LDAPUtilsTreeRecursion * recur);
+
 void ldaputils_tree_print_entry(LDAPUtilsTree * tree, size_t level, LDAPUtilsTreeRecursion * recur, size_t stop);
 
+void ldaputils_tree_print_flush(LDAPUtilsTreeRecursion * recur);
+
 void ldaputils_tree_print_indent(LDAPUtilsTree * tree, size_t level, LDAPUtilsTreeRecursion * recur);
 
+void ldaputils_tree_print_parallel(LDAPUtilsTreeJob * jobs, size_t jobs_len, LDAPUtilsTreeRecursion * recur);
+
 void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtilsTreeRecursion * recur);
 
+char * ldaputils_tree_print_reserve(LDAPUtilsTreeRecursion * recur, size_t len);
+
+size_t ldaputils_tree_print_threads(void);
+
+void * ldaputils_tree_print_worker(void * ptr);
+
+void ldaputils_tree_printf(LDAPUtilsTreeRecursion * recur, const char * fmt, ...);
+
+void ldaputils_tree_set_subordinates(LDAPUtilsTree * tree, struct berval ** vals);
+
+void ldaputils_tree_write(LDAPUtilsTreeRecursion * recur, const void * data, size_t len);
+
 /////////////////
 //             //
 //  Functions  //
@@ -135,10 +202,12 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
 
 
 /// retrieves LDAP entries from result
-/// @param[in] ld      refernce to LDAP socket data
-/// @param[in] res     refernce to LDAP result message
+/// @param[in] ld         refernce to LDAP socket data
+/// @param[in] res        refernce to LDAP result message
+/// @param[in] copy       copy attributes of entries into tree
+/// @param[in] countattr  attribute containing number of subordinates or NULL
 LDAPUtilsTree * ldaputils_get_tree(LDAP * ld, LDAPMessage * res,
-   int copy)
+   int copy, const char * countattr)
 {
    int                   err;
    char                * name;
@@ -172,6 +241,16 @@ LDAPUtilsTree * ldaputils_get_tree(LDAP * ld, LDAPMessage * res,
          return(NULL);
       };
 
+      // store number of subordinates
+      if ((countattr))
+      {
+         if ((vals = ldap_get_values_len(ld, msg, countattr)) != NULL)
+         {
+            ldaputils_tree_set_subordinates(node, vals);
+            ldap_value_free_len(vals);
+         };
+      };
+
       // copy entry
       if ((copy))
       {
@@ -188,6 +267,13 @@ LDAPUtilsTree * ldaputils_get_tree(LDAP * ld, LDAPMessage * res,
          name = ldap_first_attribute(ld, msg, &ber);
          while(name != NULL)
          {
+            // skip subordinate count
+            if ( ((countattr)) && (!(strcasecmp(name, countattr))) )
+            {
+               name = ldap_next_attribute(ld, msg, ber);
+               continue;
+            };
+
             // retrieve values
             if ((vals = ldap_get_values_len(ld, msg, name)) != NULL)
             {
@@ -257,10 +343,7 @@ int ldaputils_tree_add_dn_components(LDAPUtilsTree * tree, char ** components, s
       child = NULL;
 
       if ((child = ldaputils_tree_child_init(tree, components[cur_comp])) == NULL)
-      {
-         ldap_value_free(components);
          return(LDAP_NO_MEMORY);
-      };
 
       // step up to child
       tree = child;
@@ -273,6 +356,10 @@ int ldaputils_tree_add_dn_components(LDAPUtilsTree * tree, char ** components, s
 }
 
 
+/// adds entry to tree
+/// @param[in] tree    reference to root of tree
+/// @param[in] entry   entry to add
+/// @param[in] copy    store reference to entry in tree instead of only DN
 int ldaputils_tree_add_entry(LDAPUtilsTree * tree, LDAPUtilsEntry * entry, int copy)
 {
    LDAPUtilsTree * child;
@@ -281,15 +368,18 @@ int ldaputils_tree_add_entry(LDAPUtilsTree * tree, LDAPUtilsEntry * entry, int c
    assert(tree  != NULL);
    assert(entry != NULL);
 
+   if (ldaputils_entry_components(entry) == NULL)
+      return(LDAP_NO_MEMORY);
    if ((err = ldaputils_tree_add_dn_components(tree, entry->components, entry->components_len, &child)) != LDAP_SUCCESS)
       return(LDAP_NO_MEMORY);
 
    if (!(copy))
       return(LDAP_SUCCESS);
 
-   // copy entry into tree
-   if ((tree->entry = ldaputils_entry_copy(entry)) == NULL)
-      return(LDAP_NO_MEMORY);
+   // share entry with tree
+   if ((child->entry))
+      ldaputils_entry_free(child->entry);
+   child->entry = ldaputils_entry_retain(entry);
 
    return(LDAP_SUCCESS);
 }
@@ -330,6 +420,17 @@ int ldaputils_tree_cmp(const void * ptr1, const void * ptr2)
 }
 
 
+/// determines if node has children either in tree or on server
+/// @param[in] tree    reference to tree node
+int ldaputils_tree_has_children(LDAPUtilsTree * tree)
+{
+   assert(tree != NULL);
+   if (tree->children_len > 0)
+      return(1);
+   return((tree->subordinates > 0) ? 1 : 0);
+}
+
+
 LDAPUtilsTree * ldaputils_tree_child_find(LDAPUtilsTree * tree, const char * rdn, size_t * idxp)
 {
    size_t          low;
@@ -488,6 +589,9 @@ void ldaputils_tree_free(LDAPUtilsTree * tree)
 }
 
 
+/// initializes tree from list of entries
+/// @param[in] entries  list of entries or NULL
+/// @param[in] copy     share entries from list with tree
 LDAPUtilsTree * ldaputils_tree_initialize(LDAPUtilsEntries * entries, int copy)
 {
    LDAPUtilsTree   * tree;
@@ -563,7 +667,11 @@ void ldaputils_tree_level_count_recursive(LDAPUtilsTree * tree, size_t level, si
 }
 
 
-void ldaputils_tree_print(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts)
+/// prints tree to output sink
+/// @param[in] tree    reference to root of tree
+/// @param[in] opts    display options
+/// @param[in] sink    output sink
+int ldaputils_tree_print(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts, LDAPUtilsSink * sink)
 {
    size_t                    x;
    size_t                    depth;
@@ -574,16 +682,23 @@ void ldaputils_tree_print(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts)
 
    assert(tree != NULL);
    assert(opts != NULL);
+   assert(sink != NULL);
 
-   recur.opts = opts;
+   bzero(&recur, sizeof(recur));
+   recur.opts    = opts;
+   recur.sink    = sink;
+   recur.threads = opts->threads;
+   if (recur.threads == 0)
+      recur.threads = ldaputils_tree_print_threads();
 
    // initializes delmiter map
    depth = ldaputils_tree_level_count(tree, opts);
    if ((recur.map = malloc(depth+1)) == NULL)
-      return;
+      return(-1);
    for(x = 0; x < depth; x++)
       recur.map[x] = ' ';
    recur.map[x] = '\0';
+   recur.map_size = depth + 1;
 
    // loops through root DNs
    for(x = 0; x < tree->children_len; x++)
@@ -600,18 +715,99 @@ void ldaputils_tree_print(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts)
          };
       };
       if (opts->style == LDAPUTILS_TREE_BULLETS)
-         printf("* %s\n", dn);
+         ldaputils_tree_printf(&recur, "* %s", dn);
       else
-         printf("+--%s\n", dn);
+         ldaputils_tree_printf(&recur, "+--%s", dn);
+      ldaputils_tree_print_count(child, 0, &recur);
+      ldaputils_tree_write(&recur, "\n", 1);
       recur.lastline = LDAPUTILS_TREE_DATA;
       ldaputils_tree_print_entry(child, 0, &recur, 1);
       ldaputils_tree_print_recursive(child, 0, &recur);
 
-      printf("\n");
+      ldaputils_tree_write(&recur, "\n", 1);
    };
 
+   ldaputils_tree_print_flush(&recur);
+
+   free(recur.buff);
    free(recur.map);
 
+   return(((recur.err)) ? -1 : 0);
+}
+
+
+/// renders a child of a node along with its attributes and descendants
+/// @param[in] tree    reference to parent node
+/// @param[in] x       index of child to render
+/// @param[in] level   depth of child within displayed tree
+/// @param[in] recur   reference to recursion state
+/// @param[in] stop    child is the last child to be displayed
+void ldaputils_tree_print_child(LDAPUtilsTree * tree, size_t x, size_t level, LDAPUtilsTreeRecursion * recur, size_t stop)
+{
+   assert(tree  != NULL);
+   assert(recur != NULL);
+
+   // prints indent string
+   ldaputils_tree_print_indent(tree, level, recur);
+
+   // print RDN and update indent map
+   if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
+   {
+      ldaputils_tree_printf(recur, "* %s", tree->children[x]->rdn);
+   } else if ( ((x+1) < tree->children_len) && (!(stop)) ) {
+      recur->map[level] = '|';
+      ldaputils_tree_printf(recur, "  +--%s", tree->children[x]->rdn);
+   } else {
+      recur->map[level] = ' ';
+      ldaputils_tree_printf(recur, "  \\--%s", tree->children[x]->rdn);
+   };
+   ldaputils_tree_print_count(tree->children[x], level, recur);
+   ldaputils_tree_write(recur, "\n", 1);
+   recur->lastline = LDAPUTILS_TREE_DATA;
+
+   // prints requested attributes
+   ldaputils_tree_print_entry(tree->children[x], level, recur, stop);
+
+   // recurses to next child
+   ldaputils_tree_print_recursive(tree->children[x], level, recur);
+
+   return;
+}
+
+
+/// prints number of subordinates of a collapsed branch
+/// @param[in] tree    reference to tree node
+/// @param[in] level   depth of node within displayed tree
+/// @param[in] recur   reference to recursion state
+void ldaputils_tree_print_count(LDAPUtilsTree * tree, size_t level, LDAPUtilsTreeRecursion * recur)
+{
+   assert(tree  != NULL);
+   assert(recur != NULL);
+
+   if (!(recur->opts->subordinates))
+      return;
+   if (tree->subordinates == 0)
+      return;
+
+   // only display count if children of node are not all displayed
+   if ( (!(recur->opts->maxdepth)) || ((level+1) < recur->opts->maxdepth) )
+      if (tree->children_len >= tree->subordinates)
+         return;
+
+   switch(tree->subordinates_type)
+   {
+      case LDAPUTILS_SUBORD_COUNT:
+      ldaputils_tree_printf(recur, " (%zu %s)", tree->subordinates, (tree->subordinates == 1) ? "child" : "children");
+      break;
+
+      case LDAPUTILS_SUBORD_BOOLEAN:
+      ldaputils_tree_write(recur, " (+)", 4);
+      break;
+
+      default:
+      break;
+   };
+
    return;
 }
 
@@ -646,7 +842,7 @@ void ldaputils_tree_print_entry(LDAPUtilsTree * tree, size_t level, LDAPUtilsTre
    if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
    {
       ldaputils_tree_print_indent(tree, level, recur);
-      printf("  * Attributes\n");
+      ldaputils_tree_write(recur, "  * Attributes\n", 15);
    };
 
    // loops through attributes
@@ -658,15 +854,11 @@ void ldaputils_tree_print_entry(LDAPUtilsTree * tree, size_t level, LDAPUtilsTre
          ldaputils_tree_print_indent(tree, level+1, recur);
          // prints attribute and value
          if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
-         {
-            printf("  - %s: ", entry->attrs[attr]->name);
-            fwrite(entry->attrs[attr]->vals[val]->bv_val, 1, entry->attrs[attr]->vals[val]->bv_len, stdout);
-            printf("\n");
-         } else {
-            printf("  %c  %s: ", (have_children) ? '|' : ' ', entry->attrs[attr]->name);
-            fwrite(entry->attrs[attr]->vals[val]->bv_val, 1, entry->attrs[attr]->vals[val]->bv_len, stdout);
-            printf("\n");
-         };
+            ldaputils_tree_printf(recur, "  - %s: ", entry->attrs[attr]->name);
+         else
+            ldaputils_tree_printf(recur, "  %c  %s: ", (have_children) ? '|' : ' ', entry->attrs[attr]->name);
+         ldaputils_tree_write(recur, entry->attrs[attr]->vals[val]->bv_val, entry->attrs[attr]->vals[val]->bv_len);
+         ldaputils_tree_write(recur, "\n", 1);
       };
    };
    recur->lastline = LDAPUTILS_TREE_DATA;
@@ -677,7 +869,7 @@ void ldaputils_tree_print_entry(LDAPUtilsTree * tree, size_t level, LDAPUtilsTre
       if (!(recur->opts->compact))
       {
          ldaputils_tree_print_indent(tree, level, recur);
-         printf("\n");
+         ldaputils_tree_write(recur, "\n", 1);
          recur->lastline = LDAPUTILS_TREE_SPACE;
       };
    } else if ((entry->attrs_count > 0) && (!(recur->opts->compact)))
@@ -686,9 +878,9 @@ void ldaputils_tree_print_entry(LDAPUtilsTree * tree, size_t level, LDAPUtilsTre
       {
          ldaputils_tree_print_indent(tree, level+1, recur);
          if ((have_children))
-            printf("  |\n");
+            ldaputils_tree_write(recur, "  |\n", 4);
          else
-            printf("\n");
+            ldaputils_tree_write(recur, "\n", 1);
       };
       recur->lastline = LDAPUTILS_TREE_SPACE;
    };
@@ -697,27 +889,60 @@ void ldaputils_tree_print_entry(LDAPUtilsTree * tree, size_t level, LDAPUtilsTre
 }
 
 
+/// writes buffered output of tree
+/// @param[in] recur   reference to recursion state
+void ldaputils_tree_print_flush(LDAPUtilsTreeRecursion * recur)
+{
+   assert(recur != NULL);
+
+   if ( (!(recur->sink)) || (!(recur->buff_len)) )
+      return;
+
+   if (ldaputils_sink_write(recur->sink, recur->buff, recur->buff_len) == -1)
+      recur->err = 1;
+   recur->buff_len = 0;
+
+   return;
+}
+
+
 void ldaputils_tree_print_indent(LDAPUtilsTree * tree, size_t level, LDAPUtilsTreeRecursion * recur)
 {
-   size_t y;
+   size_t   y;
+   char   * ptr;
 
    assert(tree  != NULL);
    assert(recur != NULL);
 
+   // reserves space for indent string
+   if ((ptr = ldaputils_tree_print_reserve(recur, (level * 3) + 1)) == NULL)
+      return;
+
    // prints indent string
    switch(recur->opts->style)
    {
       case LDAPUTILS_TREE_BULLETS:
       for(y = 0; y < level; y++)
-         printf("  ");
+      {
+         *ptr++ = ' ';
+         *ptr++ = ' ';
+      };
       break;
 
       default:
-      printf(" ");
+      *ptr++ = ' ';
       for(y = 1; y < level; y++)
-         printf("  %c", recur->map[y]);
+      {
+         *ptr++ = ' ';
+         *ptr++ = ' ';
+         *ptr++ = recur->map[y];
+      };
       break;
    };
+
+   recur->buff_len = (size_t)(ptr - recur->buff);
+
+   return;
 }
 
 
@@ -729,6 +954,8 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
    size_t noleaf;
    size_t leaf_count;
    size_t children_count;
+   size_t jobs_len;
+   LDAPUtilsTreeJob * jobs;
 
    assert(tree != NULL);
 
@@ -737,6 +964,15 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
    if ((level >= recur->opts->maxdepth) && ((recur->opts->maxdepth)))
       return;
 
+   // renders subtrees of children in parallel
+   jobs     = NULL;
+   jobs_len = 0;
+   if ( (recur->threads > 1) && (tree->children_len > 1) )
+   {
+      if ((jobs = malloc(sizeof(LDAPUtilsTreeJob) * tree->children_len)) != NULL)
+         bzero(jobs, sizeof(LDAPUtilsTreeJob) * tree->children_len);
+   };
+
    // loops through children
    noleaf         = recur->opts->noleaf;
    stop           = 0;
@@ -744,7 +980,7 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
    leaf_count     = 0;
    for(x = 0; ((x < tree->children_len) && (!(stop))); x++)
    {
-      if (tree->children[x]->children_len == 0)
+      if (!(ldaputils_tree_has_children(tree->children[x])))
       {
          if ((noleaf))
             continue;
@@ -754,15 +990,12 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
       };
       children_count++;
 
-      // prints indent string
-      ldaputils_tree_print_indent(tree, level, recur);
-
       // checks for last non-leaf node
       if ((noleaf))
       {
          stop = 1;
          for(y = (x+1); y < tree->children_len; y++)
-            if (tree->children[y]->children_len != 0)
+            if ((ldaputils_tree_has_children(tree->children[y])))
             {
                y = tree->children_len;
                stop = 0;
@@ -773,24 +1006,24 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
       if ( ((recur->opts->maxchildren)) && (children_count >= recur->opts->maxchildren))
          stop = 1;
 
-      // print RDN and update indent map
-      if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
+      // queues child for worker threads
+      if ((jobs))
       {
-         printf("* %s\n", tree->children[x]->rdn);
-      } else if ( ((x+1) < tree->children_len) && (!(stop)) ) {
-         recur->map[level] = '|';
-         printf("  +--%s\n", tree->children[x]->rdn);
-      } else {
-         recur->map[level] = ' ';
-         printf("  \\--%s\n", tree->children[x]->rdn);
+         jobs[jobs_len].tree  = tree;
+         jobs[jobs_len].idx   = x;
+         jobs[jobs_len].level = level;
+         jobs[jobs_len].stop  = stop;
+         jobs_len++;
+         continue;
       };
-      recur->lastline = LDAPUTILS_TREE_DATA;
 
-      // prints requested attributes
-      ldaputils_tree_print_entry(tree->children[x], level, recur, stop);
+      ldaputils_tree_print_child(tree, x, level, recur, stop);
+   };
 
-      // recurses to next child
-      ldaputils_tree_print_recursive(tree->children[x], level, recur);
+   if ((jobs))
+   {
+      ldaputils_tree_print_parallel(jobs, jobs_len, recur);
+      free(jobs);
    };
 
    if ((recur->opts->compact))
@@ -804,7 +1037,287 @@ void ldaputils_tree_print_recursive(LDAPUtilsTree * tree, size_t level, LDAPUtil
       return;
    recur->lastline = LDAPUTILS_TREE_SPACE;
    ldaputils_tree_print_indent(tree, level, recur);
-   printf("\n");
+   ldaputils_tree_write(recur, "\n", 1);
+
+   return;
+}
+
+
+/// renders queued subtrees using worker threads and writes results in order
+/// @param[in] jobs       list of queued children
+/// @param[in] jobs_len   number of queued children
+/// @param[in] recur      reference to recursion state
+void ldaputils_tree_print_parallel(LDAPUtilsTreeJob * jobs, size_t jobs_len, LDAPUtilsTreeRecursion * recur)
+{
+   size_t              x;
+   size_t              threads_len;
+   size_t              threads_max;
+   pthread_t         * threads;
+   LDAPUtilsTreeJob  * job;
+   LDAPUtilsTreePool   pool;
+
+   assert(jobs  != NULL);
+   assert(recur != NULL);
+
+   bzero(&pool, sizeof(pool));
+   pool.jobs     = jobs;
+   pool.jobs_len = jobs_len;
+   pthread_mutex_init(&pool.mutex, NULL);
+   pthread_cond_init(&pool.cond, NULL);
+
+   // prepares state of each job
+   for(x = 0; x < jobs_len; x++)
+   {
+      jobs[x].recur.opts     = recur->opts;
+      jobs[x].recur.threads  = 1;
+      jobs[x].recur.map_size = recur->map_size;
+      if ((jobs[x].recur.map = malloc(recur->map_size)) == NULL)
+         continue;
+      memcpy(jobs[x].recur.map, recur->map, recur->map_size);
+   };
+
+   // starts worker threads
+   threads_max = recur->threads;
+   threads_len = (recur->threads < jobs_len) ? recur->threads : jobs_len;
+   if ((threads = malloc(sizeof(pthread_t) * threads_len)) == NULL)
+      threads_len = 0;
+   for(x = 0; x < threads_len; x++)
+      if (pthread_create(&threads[x], NULL, ldaputils_tree_print_worker, &pool) != 0)
+         break;
+   threads_len = x;
+
+   // writes results in order, rendering unclaimed or failed jobs directly
+   for(x = 0; x < jobs_len; x++)
+   {
+      job = &jobs[x];
+
+      pthread_mutex_lock(&pool.mutex);
+      if (pool.next <= x)
+      {
+         pool.next = x + 1;
+         job->err  = 1;
+      };
+      while ( (!(job->done)) && (!(job->err)) )
+         pthread_cond_wait(&pool.cond, &pool.mutex);
+      pthread_mutex_unlock(&pool.mutex);
+
+      if ((job->err))
+      {
+         recur->threads = 1;
+         ldaputils_tree_print_child(job->tree, job->idx, job->level, recur, job->stop);
+         recur->threads = threads_max;
+      } else {
+         ldaputils_tree_print_flush(recur);
+         if ((recur->sink))
+         {
+            if (ldaputils_sink_write(recur->sink, job->recur.buff, job->recur.buff_len) == -1)
+               recur->err = 1;
+         }
+         else
+            ldaputils_tree_write(recur, job->recur.buff, job->recur.buff_len);
+         recur->lastline = job->recur.lastline;
+      };
+
+      free(job->recur.buff);
+      free(job->recur.map);
+      job->recur.buff = NULL;
+      job->recur.map  = NULL;
+   };
+
+   for(x = 0; x < threads_len; x++)
+      pthread_join(threads[x], NULL);
+   free(threads);
+
+   pthread_cond_destroy(&pool.cond);
+   pthread_mutex_destroy(&pool.mutex);
+
+   return;
+}
+
+
+/// reserves space in output buffer
+/// @param[in] recur   reference to recursion state
+/// @param[in] len     number of bytes to reserve
+char * ldaputils_tree_print_reserve(LDAPUtilsTreeRecursion * recur, size_t len)
+{
+   size_t   size;
+   void   * ptr;
+
+   assert(recur != NULL);
+
+   if ((recur->buff_len + len) <= recur->buff_size)
+      return(&recur->buff[recur->buff_len]);
+
+   // flush buffer to sink
+   if ((recur->sink))
+   {
+      ldaputils_tree_print_flush(recur);
+      if (len <= recur->buff_size)
+         return(recur->buff);
+   };
+
+   // grow buffer
+   size = (recur->buff_size) ? recur->buff_size : LDAPUTILS_TREE_BUFF_LEN;
+   while (size < (recur->buff_len + len))
+      size *= 2;
+   if ((ptr = realloc(recur->buff, size)) == NULL)
+   {
+      recur->err = 1;
+      return(NULL);
+   };
+   recur->buff      = ptr;
+   recur->buff_size = size;
+
+   return(&recur->buff[recur->buff_len]);
+}
+
+
+/// determines default number of rendering threads
+size_t ldaputils_tree_print_threads(void)
+{
+   long num;
+
+   if ((num = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+      return(1);
+   if (num > LDAPUTILS_TREE_MAX_THREADS)
+      return(LDAPUTILS_TREE_MAX_THREADS);
+   return((size_t)num);
+}
+
+
+/// renders queued subtrees into private buffers
+/// @param[in] ptr     reference to worker pool
+void * ldaputils_tree_print_worker(void * ptr)
+{
+   size_t              x;
+   LDAPUtilsTreeJob  * job;
+   LDAPUtilsTreePool * pool;
+
+   assert(ptr != NULL);
+
+   pool = ptr;
+
+   while(1)
+   {
+      pthread_mutex_lock(&pool->mutex);
+      x = pool->next++;
+      pthread_mutex_unlock(&pool->mutex);
+      if (x >= pool->jobs_len)
+         return(NULL);
+      job = &pool->jobs[x];
+
+      if ((job->recur.map))
+         ldaputils_tree_print_child(job->tree, job->idx, job->level, &job->recur, job->stop);
+
+      pthread_mutex_lock(&pool->mutex);
+      if ( (!(job->recur.map)) || ((job->recur.err)) )
+         job->err = 1;
+      else
+         job->done = 1;
+      pthread_cond_broadcast(&pool->cond);
+      pthread_mutex_unlock(&pool->mutex);
+   };
+
+   return(NULL);
+}
+
+
+/// appends formatted string to output buffer
+/// @param[in] recur   reference to recursion state
+/// @param[in] fmt     printf style format string
+void ldaputils_tree_printf(LDAPUtilsTreeRecursion * recur, const char * fmt, ...)
+{
+   va_list   args;
+   int       len;
+   char    * ptr;
+
+   assert(recur != NULL);
+   assert(fmt   != NULL);
+
+   va_start(args, fmt);
+   len = vsnprintf(NULL, 0, fmt, args);
+   va_end(args);
+   if (len < 1)
+      return;
+
+   if ((ptr = ldaputils_tree_print_reserve(recur, (size_t)len + 1)) == NULL)
+      return;
+
+   va_start(args, fmt);
+   vsnprintf(ptr, (size_t)len + 1, fmt, args);
+   va_end(args);
+   recur->buff_len += (size_t)len;
+
+   return;
+}
+
+
+/// appends data to output buffer
+/// @param[in] recur   reference to recursion state
+/// @param[in] data    data to append
+/// @param[in] len     length of data
+void ldaputils_tree_write(LDAPUtilsTreeRecursion * recur, const void * data, size_t len)
+{
+   char * ptr;
+
+   assert(recur != NULL);
+
+   if (len == 0)
+      return;
+
+   // writes large values directly to sink
+   if ( ((recur->sink)) && (len >= LDAPUTILS_TREE_BUFF_LEN) )
+   {
+      ldaputils_tree_print_flush(recur);
+      if (ldaputils_sink_write(recur->sink, data, len) == -1)
+         recur->err = 1;
+      return;
+   };
+
+   if ((ptr = ldaputils_tree_print_reserve(recur, len)) == NULL)
+      return;
+   memcpy(ptr, data, len);
+   recur->buff_len += len;
+
+   return;
+}
+
+
+/// stores number of subordinates reported by server
+/// @param[in] tree    reference to tree node
+/// @param[in] vals    values of numSubordinates or hasSubordinates attribute
+void ldaputils_tree_set_subordinates(LDAPUtilsTree * tree, struct berval ** vals)
+{
+   char     buff[32];
+   size_t   len;
+
+   assert(tree != NULL);
+
+   if ( (!(vals)) || (!(vals[0])) )
+      return;
+
+   len = vals[0]->bv_len;
+   if (len >= sizeof(buff))
+      len = sizeof(buff) - 1;
+   memcpy(buff, vals[0]->bv_val, len);
+   buff[len] = '\0';
+
+   // hasSubordinates is a boolean attribute
+   if (!(strcasecmp(buff, "TRUE")))
+   {
+      tree->subordinates      = 1;
+      tree->subordinates_type = LDAPUTILS_SUBORD_BOOLEAN;
+      return;
+   };
+   if (!(strcasecmp(buff, "FALSE")))
+   {
+      tree->subordinates      = 0;
+      tree->subordinates_type = LDAPUTILS_SUBORD_BOOLEAN;
+      return;
+   };
+
+   tree->subordinates      = (size_t)strtoull(buff, NULL, 10);
+   tree->subordinates_type = LDAPUTILS_SUBORD_COUNT;
 
    return;
 }
@@ -0,0 +1,668 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldap2arrow.c export LDAP data as Apache Arrow IPC stream
+ */
+/*
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldap2arrow" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldap2arrow.c
+ *     gcc ${CFLAGS} -lldap -o ldap2arrow ldap2arrow.o ../lib/libldaputils.a ../lib/libldapschema.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldap2arrow" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldap2arrow.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -o ldap2arrow \
+ *             ldap2arrow.lo ../lib/libldaputils.a ../lib/libldapschema.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldap2arrow.lo ldap2arrow
+ */
+#define _LDAP_UTILS_SRC_LDAP2ARROW 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <getopt.h>
+#include <assert.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+#include <ldapschema.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldap2arrow"
+#endif
+
+#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:9:8:"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+/* configuration union */
+typedef struct my_config MyConfig;
+struct my_config
+{
+   LDAPUtils       * lud;
+   const char      * prog_name;
+   LDAPSchema      * lsd;
+   LDAPUtilsSink   * out;
+   LDAPUtilsArrow  * arrow;
+   const char      * cache_dir;    // directory of cached schemas
+   size_t            rows;         // rows per record batch
+   int               dncol;        // column of entry's DN
+   int               pad0;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// adds columns for requested attributes
+int my_columns(MyConfig * cnf);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// appends entry as row
+int my_entry(MyConfig * cnf, LDAP * ld, LDAPMessage * msg);
+
+// appends results as rows
+int my_results(MyConfig * cnf, LDAPMessage * res);
+
+// appends entry as row as entry is received
+int my_stream(void * ctx, LDAP * ld, LDAPMessage * msg);
+
+// determines column type from attribute's syntax
+void my_type(MyConfig * cnf, const char * name, int * typep, int * flagsp);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] [filter] attributes...\n", PROGRAM_NAME);
+   ldaputils_usage_search(MY_SHORT_OPTIONS);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Special Attributes:\n");
+   printf("  dn                        entry's DN\n");
+   printf("Arrow Options:\n");
+   printf("  --rows=num                number of rows per record batch (default: %i)\n", LDAPUTILS_ARROW_ROWS);
+   printf("  --schema-cache=dir        reuse schema cached in dir until server's schema changes\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int                    err;
+   MyConfig             * cnf;
+   LDAPMessage          * res;
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(1);
+   if (!(cnf))
+      return(0);
+
+   // starts TLS and binds to LDAP
+   if ((err = ldaputils_bind_s(cnf->lud)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldap_sasl_bind_s(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // fetches schema used to type columns
+   if ( ((err = ldapschema_fetch_cache(cnf->lsd, cnf->lud->ld, cnf->cache_dir)) != LDAP_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+   {
+      fprintf(stderr, "%s: ldapschema_fetch_cache(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // defines columns of Arrow schema
+   if (my_columns(cnf) == -1)
+   {
+      fprintf(stderr, "%s: %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // streams entries unless sorting requires complete result
+   if (!(cnf->lud->sortattr))
+   {
+      if ((err = ldaputils_search_each(cnf->lud, my_stream, cnf)) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: ldaputils_search_each(): %s\n", cnf->prog_name, ldap_err2string(err));
+         my_unbind(cnf);
+         return(1);
+      };
+   }
+   else
+   {
+      if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: ldaputils_search(): %s\n", cnf->prog_name, ldap_err2string(err));
+         my_unbind(cnf);
+         return(1);
+      };
+      err = my_results(cnf, res);
+      ldap_msgfree(res);
+      if (err != LDAP_SUCCESS)
+      {
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // writes remaining rows and output
+   if ( (ldaputils_arrow_finish(cnf->arrow) == -1) || (ldaputils_sink_flush(cnf->out) == -1) )
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   my_unbind(cnf);
+
+   return(0);
+}
+
+
+/// adds columns for requested attributes
+/// @param[in] cnf    reference to configuration
+int my_columns(MyConfig * cnf)
+{
+   int      x;
+   int      col;
+   int      type;
+   int      flags;
+   char  ** attrs;
+
+   attrs = cnf->lud->attrs;
+
+   for(x = 0; ((attrs[x])); x++)
+   {
+      // attributes listed more than once share a column
+      if (ldaputils_arrow_find(cnf->arrow, attrs[x], strlen(attrs[x])) != -1)
+         continue;
+
+      if (strcasecmp("dn", attrs[x]) == 0)
+      {
+         type  = LDAPUTILS_ARROW_UTF8;
+         flags = 0;
+      }
+      else
+      {
+         my_type(cnf, attrs[x], &type, &flags);
+      };
+
+      if ((col = ldaputils_arrow_column(cnf->arrow, attrs[x], type, flags)) == -1)
+         return(-1);
+      if (strcasecmp("dn", attrs[x]) == 0)
+         cnf->dncol = col;
+   };
+
+   return(0);
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int        c;
+   int        err;
+   int        option_index;
+   char     * end;
+   MyConfig * cnf;
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"rows",          required_argument, 0, '9'},
+      {"schema-cache",  required_argument, 0, '8'},
+      {NULL,            0,                 0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+   cnf->dncol = -1;
+
+   // initialize ldap utilities
+   if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldaputils_initialize(): %s\n", PROGRAM_NAME, ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // initialize schema
+   if ((err = ldapschema_initialize(&cnf->lsd)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldapschema_initialize(): %s\n", PROGRAM_NAME, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(ldaputils_getopt(cnf->lud, c, optarg))
+      {
+         // shared option exit without error
+         case -2:
+         my_unbind(cnf);
+         return(0);
+
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         // shared option error
+         case 1:
+         my_unbind(cnf);
+         return(1);
+
+         case '9':
+         cnf->rows = (size_t)strtoul(optarg, &end, 10);
+         if ( (end == optarg) || (end[0] != '\0') || (!(cnf->rows)) )
+         {
+            fprintf(stderr, "%s: invalid number of rows `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         case '8':
+         cnf->cache_dir = optarg;
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   cnf->prog_name = ldaputils_get_prog_name(cnf->lud);
+
+   // checks for required arguments
+   if (argc < (optind+1))
+   {
+      fprintf(stderr, "%s: missing required arguments\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // saves filter
+   cnf->lud->filter = "(objectclass=*)";
+   if ((index(argv[optind], '=')) != NULL)
+   {
+      cnf->lud->filter = argv[optind];
+      optind++;
+   };
+
+   // configures LDAP attributes to return in results
+   if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * (size_t)(argc-optind+1))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   for(c = 0; c < (argc-optind); c++)
+      cnf->lud->attrs[c] = argv[optind+c];
+   cnf->lud->attrs[c] = NULL;
+
+   // reads password
+   if ((err = ldaputils_pass(cnf->lud)) != 0)
+   {
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // initializes Arrow stream
+   if (ldaputils_arrow_initialize(&cnf->arrow, cnf->out, cnf->rows) == -1)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// appends entry as row
+/// @param[in] cnf    reference to configuration
+/// @param[in] ld     LDAP handle
+/// @param[in] msg    LDAP entry
+int my_entry(MyConfig * cnf, LDAP * ld, LDAPMessage * msg)
+{
+   int               x;
+   int               y;
+   int               rc;
+   BerElement      * ber;
+   struct berval     dn;
+   struct berval     attr;
+   struct berval   * vals;
+
+   // decodes DN and attributes in a single pass over the entry
+   if ((rc = ldap_get_dn_ber(ld, msg, &ber, &dn)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldap_get_dn_ber(): %s\n", cnf->prog_name, ldap_err2string(rc));
+      return(rc);
+   };
+   if ( (cnf->dncol != -1) && (ldaputils_arrow_append(cnf->arrow, cnf->dncol, dn.bv_val, dn.bv_len) == -1) && (errno != EINVAL) )
+   {
+      fprintf(stderr, "%s: %s\n", cnf->prog_name, strerror(errno));
+      ber_free(ber, 0);
+      return(LDAP_NO_MEMORY);
+   };
+
+   while ( ((rc = ldap_get_attribute_ber(ld, msg, ber, &attr, &vals)) == LDAP_SUCCESS) && ((attr.bv_val)) )
+   {
+      if ((x = ldaputils_arrow_find(cnf->arrow, attr.bv_val, attr.bv_len)) == -1)
+      {
+         ber_memfree(vals);
+         continue;
+      };
+      for(y = 0; ( ((vals)) && ((vals[y].bv_val)) ); y++)
+      {
+         if (ldaputils_arrow_append(cnf->arrow, x, vals[y].bv_val, vals[y].bv_len) == 0)
+            continue;
+         if (errno != EINVAL)
+         {
+            fprintf(stderr, "%s: %s\n", cnf->prog_name, strerror(errno));
+            ber_memfree(vals);
+            ber_free(ber, 0);
+            return(LDAP_NO_MEMORY);
+         };
+         fprintf(stderr, "%s: %.*s: %.*s: value does not match attribute syntax, storing null\n", cnf->prog_name, (int)dn.bv_len, dn.bv_val, (int)attr.bv_len, attr.bv_val);
+      };
+      ber_memfree(vals);
+   };
+   ber_free(ber, 0);
+
+   if (rc != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldap_get_attribute_ber(): %s\n", cnf->prog_name, ldap_err2string(rc));
+      return(rc);
+   };
+
+   // completes row, writing record batch when full
+   if (ldaputils_arrow_next(cnf->arrow) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      return(LDAP_OTHER);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// appends results as rows
+/// @param[in] cnf    reference to configuration
+/// @param[in] res    LDAP result
+int my_results(MyConfig * cnf, LDAPMessage * res)
+{
+   int               err;
+   LDAPMessage     * msg;
+   LDAP            * ld;
+
+   assert(cnf != NULL);
+   assert(res != NULL);
+
+   ld = ldaputils_get_ld(cnf->lud);
+
+   // sorts entries
+   if ((cnf->lud->sortattr))
+      ldap_sort_entries(ld, &res, cnf->lud->sortattr, strcasecmp);
+
+   // loops through entries
+   for(msg = ldap_first_entry(ld, res); ((msg)); msg = ldap_next_entry(ld, msg))
+      if ((err = my_entry(cnf, ld, msg)) != LDAP_SUCCESS)
+         return(err);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// appends entry as row as entry is received
+/// @param[in] ctx    reference to configuration
+/// @param[in] ld     LDAP handle
+/// @param[in] msg    LDAP entry
+int my_stream(void * ctx, LDAP * ld, LDAPMessage * msg)
+{
+   return(my_entry(ctx, ld, msg));
+}
+
+
+/// determines column type from attribute's syntax
+/// @param[in]  cnf     reference to configuration
+/// @param[in]  name    attribute description
+/// @param[out] typep   reference to store value type
+/// @param[out] flagsp  reference to store column flags
+void my_type(MyConfig * cnf, const char * name, int * typep, int * flagsp)
+{
+   int                        flags;
+   int                        data_class;
+   size_t                     len;
+   char                       type[LDAPUTILS_OPT_LEN];
+   const char               * opt;
+   LDAPSchemaAttributeType  * attr;
+   LDAPSchemaAttributeType  * attrsup;
+   LDAPSchemaSyntax         * syntax;
+
+   *typep  = LDAPUTILS_ARROW_UTF8;
+   *flagsp = LDAPUTILS_ARROW_LIST;
+
+   // strips attribute options, ";binary" requests values as binary
+   len = strlen(name);
+   if ((opt = index(name, ';')) != NULL)
+      len = (size_t)(opt - name);
+   for(; ((opt)); opt = index(&opt[1], ';'))
+      if ( (strncasecmp(opt, ";binary", 7) == 0) && ((opt[7] == '\0') || (opt[7] == ';')) )
+         *typep = LDAPUTILS_ARROW_BINARY;
+   if ( (*typep == LDAPUTILS_ARROW_BINARY) || (len >= sizeof(type)) )
+      return;
+   memcpy(type, name, len);
+   type[len] = '\0';
+
+   if ((attr = ldapschema_find_attributetype(cnf->lsd, type)) == NULL)
+      return;
+
+   // single-valued attributes are not stored as lists
+   flags = 0;
+   ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_FLAGS, &flags);
+   if ((flags & LDAPSCHEMA_O_SINGLEVALUE))
+      *flagsp = 0;
+
+   // syntax may be inherited from superior attribute type
+   syntax  = NULL;
+   attrsup = NULL;
+   ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_SYNTAX,   &syntax);
+   ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_SUPERIOR, &attrsup);
+   while ( (!(syntax)) && ((attrsup)) )
+   {
+      attr    = attrsup;
+      attrsup = NULL;
+      ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_SYNTAX,   &syntax);
+      ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_SUPERIOR, &attrsup);
+   };
+   if (!(syntax))
+      return;
+
+   data_class = LDAPSCHEMA_CLASS_UNKNOWN;
+   ldapschema_get_info_ldapsyntax(cnf->lsd, syntax, LDAPSCHEMA_FLD_CLASS, &data_class);
+   switch(data_class)
+   {
+      case LDAPSCHEMA_CLASS_INTEGER:
+      case LDAPSCHEMA_CLASS_UNSIGNED:
+      *typep = LDAPUTILS_ARROW_INT64;
+      break;
+
+      case LDAPSCHEMA_CLASS_BOOLEAN:
+      *typep = LDAPUTILS_ARROW_BOOL;
+      break;
+
+      case LDAPSCHEMA_CLASS_DATA:
+      case LDAPSCHEMA_CLASS_IMAGE:
+      case LDAPSCHEMA_CLASS_AUDIO:
+      *typep = LDAPUTILS_ARROW_BINARY;
+      break;
+
+      default:
+      break;
+   };
+
+   return;
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   assert(cnf != NULL);
+
+   if ((cnf->lud))
+      ldaputils_unbind(cnf->lud);
+
+   if ((cnf->lsd))
+      ldapschema_free(cnf->lsd);
+
+   if ((cnf->arrow))
+      ldaputils_arrow_free(cnf->arrow);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   free(cnf);
+
+   return;
+}
+
+/* end of source file */
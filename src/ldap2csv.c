@@ -61,10 +61,13 @@
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <strings.h>
+#include <ctype.h>
+#include <stdint.h>
 #include <time.h>
 #include <getopt.h>
 #include <assert.h>
@@ -87,7 +90,16 @@
 #define PROGRAM_NAME "ldap2csv"
 #endif
 
-#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:"
+#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:98:7:6:"
+
+// column types
+#define MY_COL_ATTR     0                  // attribute values
+#define MY_COL_DN       LDAPUTILS_DN_DN    // entry's DN
+#define MY_COL_RDN      LDAPUTILS_DN_RDN   // entry's relative DN
+#define MY_COL_UFN      LDAPUTILS_DN_UFN   // entry's User Friendly Name
+#define MY_COL_ADC      LDAPUTILS_DN_ADC   // entry's Active Directory canonical name
+#define MY_COL_DCE      LDAPUTILS_DN_DCE   // entry's DN in DCE-style
+#define MY_COL_MAX      6
 
 
 /////////////////
@@ -99,15 +111,35 @@
 #pragma mark - Datatypes
 #endif
 
+/* output column */
+typedef struct my_column MyColumn;
+struct my_column
+{
+   const char      * name;
+   size_t            name_len;
+   int               type;         // column type
+   int               head;         // first column of same attribute
+};
+
+
 /* configuration union */
 typedef struct my_config MyConfig;
 struct my_config
 {
-   LDAPUtils   * lud;
-   const char  * filter;
-   const char  * prog_name;
-   const char ** defvals;
-   char          output[LDAPUTILS_OPT_LEN];
+   LDAPUtils       * lud;
+   const char      * filter;
+   const char      * prog_name;
+   const char     ** defvals;
+   LDAPUtilsSink   * out;
+   LDAPUtilsPipeline * pipe;
+   const char      * compress;     // output compression algorithm and level
+   size_t            threads;      // number of formatting and compression threads
+   int               flags;        // CSV encoding flags
+   int               separator;    // multi-value separator
+   MyColumn        * cols;         // output columns
+   size_t            cols_len;
+   int             * hash;         // attribute name to column index
+   size_t            hash_mask;
 };
 
 
@@ -123,11 +155,27 @@ struct my_config
 // main statement
 int main(int argc, char * argv[]);
 
+// finds column of attribute
+int my_column(void * ctx, const struct berval * attr);
+
+// builds column map
+int my_columns(MyConfig * cnf);
+
 // parses configuration
 int my_config(int argc, char * argv[], MyConfig ** cnfp);
 
+// appends DN transform of entry as CSV field
+int my_dnstr(MyConfig * cnf, const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out);
+
+// calculates case-insensitive hash of attribute name
+size_t my_hash(const char * name, size_t len);
+
+// queues results for formatting
 int my_results(MyConfig * cnf, LDAPMessage * res);
 
+// formats entry
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+
 // fress resources
 void my_unbind(MyConfig * cnf);
 
@@ -153,6 +201,11 @@ void ldaputils_usage(void)
    printf("  ufn                       entry's User Friendly Name\n");
    printf("  adc                       entry's Active Directory canonical name\n");
    printf("  dce                       entry's DN in DCE-style\n");
+   printf("CSV Options:\n");
+   printf("  --rfc4180                 RFC 4180 quoting of fields\n");
+   printf("  --separator=char          separator between multiple values (default: %c)\n", LDAPUTILS_CSV_SEPARATOR);
+   printf("  --compress=type[:level]   compress output using gzip or zstd\n");
+   printf("  --threads=num             number of threads used to format entries (default: number of CPUs)\n");
    printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
    return;
 }
@@ -168,6 +221,7 @@ int main(int argc, char * argv[])
    MyConfig             * cnf;
    LDAPMessage          * res;
    const char * const   * attrs;
+   LDAPUtilsPipelineOpts  opts;
 
    cnf = NULL;
 
@@ -185,35 +239,162 @@ int main(int argc, char * argv[])
       return(1);
    };
 
-   // performs LDAP search
-   if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+   // prints attribute names
+   attrs = ldaputils_get_attribute_list(cnf->lud);
+   for(x = 0; attrs[x]; x++)
+   {
+      ldaputils_sink_puts(cnf->out, ((x)) ? ",\"" : "\"");
+      ldaputils_sink_csv(cnf->out, attrs[x], strlen(attrs[x]), '"', cnf->flags);
+      ldaputils_sink_puts(cnf->out, "\"");
+   };
+   ldaputils_sink_puts(cnf->out, ((cnf->flags & LDAPUTILS_CSV_RFC4180)) ? "\r\n" : "\n");
+
+   // starts threads which format entries and write output in order
+   memset(&opts, 0, sizeof(opts));
+   opts.threads = cnf->threads;
+   opts.columns = cnf->cols_len;
+   opts.ctx     = cnf;
+   opts.column  = my_column;
+   opts.format  = my_row;
+   if (ldaputils_pipeline_initialize(&cnf->pipe, cnf->out, &opts) == -1)
    {
-      fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      fprintf(stderr, "%s: ldaputils_pipeline_initialize(): %s\n", cnf->prog_name, strerror(errno));
       my_unbind(cnf);
       return(1);
    };
 
-   // prints attribute names
-   attrs = ldaputils_get_attribute_list(cnf->lud);
-   printf("\"%s\"", attrs[0]);
-   for(x = 1; attrs[x]; x++)
-      printf(",\"%s\"", attrs[x]);
-   printf("\n");
+   // decodes entries as they are received unless sorting requires all results
+   if (!(cnf->lud->sortattr))
+   {
+      if ((err = ldaputils_search_each(cnf->lud, ldaputils_pipeline_entry, cnf->pipe)) != LDAP_SUCCESS)
+      {
+         // reports search errors which were not caused by a failed stage
+         if ((x = ldaputils_pipeline_finish(cnf->pipe)) == LDAP_OTHER)
+            fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+         else if ( (x == LDAP_SUCCESS) && (err != LDAP_NO_MEMORY) )
+            fprintf(stderr, "%s: ldaputils_search_each(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+         my_unbind(cnf);
+         return(1);
+      };
+   } else {
+      // performs LDAP search
+      if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+         my_unbind(cnf);
+         return(1);
+      };
 
-   // prints values
-   if ((err = my_results(cnf, res)) != LDAP_SUCCESS)
+      // queues values
+      if ((err = my_results(cnf, res)) != LDAP_SUCCESS)
+      {
+         ldap_msgfree(res);
+         my_unbind(cnf);
+         return(1);
+      };
+
+      ldap_msgfree(res);
+   };
+
+   // waits for formatted entries to be written
+   if ((err = ldaputils_pipeline_finish(cnf->pipe)) != LDAP_SUCCESS)
    {
+      if (err == LDAP_OTHER)
+         fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
       my_unbind(cnf);
       return(1);
    };
 
-   ldap_msgfree(res);
    my_unbind(cnf);
 
    return(0);
 }
 
 
+/// finds column of attribute
+/// @param[in] ctx    reference to configuration
+/// @param[in] attr   attribute description returned by server
+int my_column(void * ctx, const struct berval * attr)
+{
+   size_t     idx;
+   int        x;
+   MyColumn * col;
+   MyConfig * cnf;
+
+   cnf = ctx;
+
+   for(idx = my_hash(attr->bv_val, attr->bv_len) & cnf->hash_mask; ((x = cnf->hash[idx]) != -1); idx = (idx+1) & cnf->hash_mask)
+   {
+      col = &cnf->cols[x];
+      if ( (col->name_len == attr->bv_len) && (strncasecmp(col->name, attr->bv_val, attr->bv_len) == 0) )
+         return(x);
+   };
+
+   return(-1);
+}
+
+
+/// builds column map
+/// @param[in] cnf    reference to configuration
+int my_columns(MyConfig * cnf)
+{
+   size_t          x;
+   size_t          y;
+   size_t          idx;
+   size_t          size;
+   MyColumn      * col;
+   struct berval   attr;
+
+   static const char * names[MY_COL_MAX] = { NULL, "dn", "rdn", "ufn", "adc", "dce" };
+
+   for(cnf->cols_len = 0; ((cnf->lud->attrs[cnf->cols_len])); cnf->cols_len++);
+   for(size = 16; (size < (cnf->cols_len * 2)); size <<= 1);
+
+   if ((cnf->cols = calloc(cnf->cols_len+1, sizeof(MyColumn))) == NULL)
+      return(-1);
+   if ((cnf->hash = malloc(sizeof(int) * size)) == NULL)
+      return(-1);
+   for(idx = 0; (idx < size); idx++)
+      cnf->hash[idx] = -1;
+   cnf->hash_mask = size - 1;
+
+   for(x = 0; (x < cnf->cols_len); x++)
+   {
+      col           = &cnf->cols[x];
+      col->name     = cnf->lud->attrs[x];
+      col->name_len = strlen(col->name);
+      col->head     = (int)x;
+
+      // special attributes derived from the DN
+      for(y = 1; (y < MY_COL_MAX); y++)
+         if (strcasecmp(names[y], col->name) == 0)
+            col->type = (int)y;
+      if (col->type != MY_COL_ATTR)
+         continue;
+
+      // attribute requested more than once shares the first column's values
+      attr.bv_val = (char *)col->name;
+      attr.bv_len = col->name_len;
+      if ((col->head = my_column(cnf, &attr)) != -1)
+         continue;
+      col->head = (int)x;
+
+      for(idx = my_hash(col->name, col->name_len) & cnf->hash_mask; (cnf->hash[idx] != -1); idx = (idx+1) & cnf->hash_mask);
+      cnf->hash[idx] = (int)x;
+   };
+
+   return(0);
+}
+
+
 /// parses configuration
 /// @param[in] argc   number of arguments
 /// @param[in] argv   array of arguments
@@ -229,10 +410,14 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
    static char   short_options[] = MY_SHORT_OPTIONS;
    static struct option long_options[] =
    {
-      {"help",          no_argument, 0, 'h'},
-      {"verbose",       no_argument, 0, 'v'},
-      {"version",       no_argument, 0, 'V'},
-      {NULL,            0,           0, 0  }
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"rfc4180",       no_argument,       0, '9'},
+      {"separator",     required_argument, 0, '8'},
+      {"compress",      required_argument, 0, '7'},
+      {"threads",       required_argument, 0, '6'},
+      {NULL,            0,                 0, 0  }
    };
 
    // allocates memory for configuration
@@ -242,6 +427,7 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
    memset(cnf, 0, sizeof(MyConfig));
+   cnf->separator = LDAPUTILS_CSV_SEPARATOR;
 
    // initialize ldap utilities
    if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
@@ -275,6 +461,28 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          my_unbind(cnf);
          return(1);
 
+         case '9':
+         cnf->flags |= LDAPUTILS_CSV_RFC4180;
+         break;
+
+         case '8':
+         if ( (strlen(optarg) != 1) || (optarg[0] == '"') )
+         {
+            fprintf(stderr, "%s: separator must be a single character other than quote\n", PROGRAM_NAME);
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->separator = optarg[0];
+         break;
+
+         case '7':
+         cnf->compress = optarg;
+         break;
+
+         case '6':
+         cnf->threads = (size_t)atoll(optarg);
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -335,6 +543,14 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
    cnf->lud->attrs[c] = NULL;
    cnf->defvals[c]    = NULL;
 
+   // maps attribute names to columns
+   if (my_columns(cnf) == -1)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
    // reads password
    if ((err = ldaputils_pass(cnf->lud)) != 0)
    {
@@ -342,187 +558,179 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
 
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+   if ( ((cnf->compress)) && (ldaputils_sink_compress(cnf->out, cnf->compress, cnf->threads) == -1) )
+   {
+      fprintf(stderr, "%s: --compress=%s: %s\n", cnf->prog_name, cnf->compress, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    *cnfp = cnf;
 
    return(0);
 }
 
 
-// prints results
+/// appends DN transform of entry as CSV field
+/// @param[in] cnf     reference to configuration
+/// @param[in] dn      parsed DN of entry
+/// @param[in] type    column type
+/// @param[in] out     formatted output of batch
+int my_dnstr(MyConfig * cnf, const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out)
+{
+   int      rc;
+   size_t   len;
+   char   * str;
+   char     buff[LDAPUTILS_BUFF_LEN];
+
+   if ((len = ldaputils_dn_format(dn, type, buff, sizeof(buff))) < sizeof(buff))
+      return(ldaputils_sink_csv(out, buff, len, '"', cnf->flags));
+
+   // DN exceeds stack buffer
+   if ((str = malloc(len+1)) == NULL)
+      return(-1);
+   ldaputils_dn_format(dn, type, str, len+1);
+   rc = ldaputils_sink_csv(out, str, len, '"', cnf->flags);
+   free(str);
+
+   return(rc);
+}
+
+
+/// calculates case-insensitive hash of attribute name
+/// @param[in] name   attribute name
+/// @param[in] len    length of attribute name
+size_t my_hash(const char * name, size_t len)
+{
+   size_t     x;
+   uint64_t   hash;
+
+   hash = 14695981039346656037ULL;
+   for(x = 0; (x < len); x++)
+   {
+      hash ^= (unsigned char)tolower((unsigned char)name[x]);
+      hash *= 1099511628211ULL;
+   };
+
+   return((size_t)(hash ^ (hash >> 32)));
+}
+
+
+// queues results for formatting
 int my_results(MyConfig * cnf, LDAPMessage * res)
 {
-   int               x;
-   int               y;
-   void            * ptr;
-   char            * buff;
-   size_t            bufflen;
-   char            * dn;
-   char           ** dns;
-   char            * dnstr;
-   char            * delim;
+   int               err;
    LDAPMessage     * msg;
-   struct berval  ** vals;
    LDAP            * ld;
 
    assert(cnf != NULL);
    assert(res != NULL);
 
-   ld      = ldaputils_get_ld(cnf->lud);
-
-   // initialize buffer
-   bufflen = 32;
-   if ((buff = malloc(bufflen)) == NULL)
-   {
-      fprintf(stderr, "%s: malloc(): out of virtual memory\n", cnf->prog_name);
-      return(LDAP_NO_MEMORY);
-   };
+   ld = ldaputils_get_ld(cnf->lud);
 
    // sorts entries
    if ((cnf->lud->sortattr))
       ldap_sort_entries(ld, &res, cnf->lud->sortattr, strcasecmp);
 
    // loops through entries
-   msg = ldap_first_entry(ld, res);
-   while ((msg))
-   {
-      printf("\"");
+   for(msg = ldap_first_entry(ld, res); ((msg)); msg = ldap_next_entry(ld, msg))
+      if ((err = ldaputils_pipeline_entry(cnf->pipe, ld, msg)) != LDAP_SUCCESS)
+         return(err);
 
-      // retrieve DN and make CSV safe
-      if ((dn = ldap_get_dn(ld, msg)) == NULL)
-      {
-         fprintf(stderr, "%s: malloc(): out of virtual memory\n", cnf->prog_name);
-         free(buff);
-         return(LDAP_NO_MEMORY);
-      };
-      delim = dn;
-      while((delim = index(delim, '"')) != NULL)
-         delim[0] = '\'';
+   return(LDAP_SUCCESS);
+}
 
-      // loop through attributes
-      for(x = 0; (cnf->lud->attrs[x] != NULL); x++)
-      {
-         // print delimiter
-         if (x > 0)
-            printf("\",\"");
 
-         // prints dn if specified
-         if (strcasecmp("dn", cnf->lud->attrs[x]) == 0)
-         {
-            printf("%s", dn);
-            continue;
-         };
+/// formats entry, called by formatter threads
+/// @param[in] ctx    reference to configuration
+/// @param[in] row    decoded entry with attributes mapped onto columns
+/// @param[in] out    formatted output of batch
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out)
+{
+   int                      x;
+   size_t                   y;
+   int                      rc;
+   int                      parsed;
+   char                     sep;
+   MyConfig               * cnf;
+   MyColumn               * col;
+   const LDAPUtilsRowAttr * attr;
+   LDAPUtilsDN              dn;
+
+   cnf    = ctx;
+   sep    = (char)cnf->separator;
+   rc     = LDAP_SUCCESS;
+   parsed = 0;
+
+   // prints columns
+   ldaputils_sink_puts(out, "\"");
+   for(x = 0; ( (x < (int)cnf->cols_len) && (rc == LDAP_SUCCESS) ); x++)
+   {
+      col = &cnf->cols[x];
 
-         // print RDN
-         if (strcasecmp("rdn", cnf->lud->attrs[x]) == 0)
-         {
-            if ((dns = ldap_explode_dn(dn, 0)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_explode_dn(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dns[0]);
-            ldap_value_free(dns);
-            continue;
-         };
+      // print delimiter
+      if (x > 0)
+         ldaputils_sink_puts(out, "\",\"");
 
-         // print DN in UFN format
-         if (strcasecmp("ufn", cnf->lud->attrs[x]) == 0)
+      switch(col->type)
+      {
+         case MY_COL_ATTR:
+         attr = &row->attrs[col->head];
+         if (!(attr->vals_len))
          {
-            if ((dnstr = ldap_dn2ufn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2ufn(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dnstr);
-            ldap_memfree(dnstr);
-            continue;
+            ldaputils_sink_csv(out, cnf->defvals[x], strlen(cnf->defvals[x]), '"', cnf->flags);
+            break;
          };
-
-         // print DN in DCE format
-         if (strcasecmp("dce", cnf->lud->attrs[x]) == 0)
+         for(y = 0; (y < attr->vals_len); y++)
          {
-            if ((dnstr = ldap_dn2dcedn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2dcedn(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dnstr);
-            ldap_memfree(dnstr);
-            continue;
+            if (y > 0)
+               ldaputils_sink_write(out, &sep, 1);
+            ldaputils_sink_csv(out, attr->vals[y].bv_val, attr->vals[y].bv_len, sep, cnf->flags);
          };
+         break;
+
+         case MY_COL_DN:
+         ldaputils_sink_csv(out, row->dn.bv_val, row->dn.bv_len, '"', cnf->flags);
+         break;
 
-         // print DN in AD canonical format
-         if (strcasecmp("adc", cnf->lud->attrs[x]) == 0)
+         default:
+         // DN is parsed once for all columns derived from it, columns of a
+         // DN which cannot be parsed repeat the DN as received
+         if (!(parsed))
          {
-            if ((dnstr = ldap_dn2ad_canonical(dn)) == NULL)
+            parsed = (ldaputils_dn_parse(&dn, row->dn.bv_val, row->dn.bv_len) == 0) ? 1 : -1;
+            if ( (parsed == -1) && (errno == ENOMEM) )
             {
-               fprintf(stderr, "%s: ldap_dn2ad_canonical(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
+               fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+               rc = LDAP_NO_MEMORY;
+               break;
             };
-            printf("%s", dnstr);
-            ldap_memfree(dnstr);
-            continue;
          };
-
-         // retrieves values
-         if ((vals = ldap_get_values_len(ld, msg, cnf->lud->attrs[x])) == NULL)
+         if (parsed == -1)
          {
-            printf("%s", cnf->defvals[x]);
-            continue;
+            ldaputils_sink_csv(out, row->dn.bv_val, row->dn.bv_len, '"', cnf->flags);
+            break;
          };
-
-         // processes values
-         for(y = 0; (y < ldap_count_values_len(vals)); y++)
+         if (my_dnstr(cnf, &dn, col->type, out) == -1)
          {
-            // adjusts size of buffer
-            if (bufflen < (vals[y]->bv_len + 1))
-            {
-               bufflen = vals[y]->bv_len + 1;
-               if ((ptr = realloc(buff, bufflen)) == NULL)
-               {
-                  fprintf(stderr, "%s: realloc(): out of virtual memory\n", cnf->prog_name);
-                  free(buff);
-                  return(LDAP_NO_MEMORY);
-               };
-               buff = ptr;
-            };
-
-            // copies value into buffer
-            memcpy(buff, vals[y]->bv_val, vals[y]->bv_len);
-            buff[vals[y]->bv_len] = '\0';
-
-            // replace double quotation character with single quotation character
-            delim = buff;
-            while((delim = index(delim, '"')) != NULL)
-               delim[0] = '\'';
-            delim = buff;
-            while((delim = index(delim, '|')) != NULL)
-               delim[0] = ':';
-
-            // print value
-            if (y > 0)
-               printf("|%s", buff);
-            else
-               printf("%s", buff);
+            fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+            rc = LDAP_NO_MEMORY;
          };
-         ldap_value_free_len(vals);
+         break;
       };
-      printf("\"\n");
-
-      // frees DN
-      ldap_memfree(dn);
-
-      // retrieves next entry
-      msg = ldap_next_entry(ld, msg);
    };
+   ldaputils_sink_puts(out, ((cnf->flags & LDAPUTILS_CSV_RFC4180)) ? "\"\r\n" : "\"\n");
+   if (parsed == 1)
+      ldaputils_dn_free(&dn);
 
-   free(buff);
-
-   return(LDAP_SUCCESS);
+   return(rc);
 }
 
 
@@ -537,6 +745,18 @@ void my_unbind(MyConfig * cnf)
    if ((cnf->defvals))
       free(cnf->defvals);
 
+   if ((cnf->pipe))
+      ldaputils_pipeline_free(cnf->pipe);
+
+   if ((cnf->cols))
+      free(cnf->cols);
+
+   if ((cnf->hash))
+      free(cnf->hash);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
    free(cnf);
 
    return;
@@ -58,6 +58,7 @@
 #pragma mark - Headers
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -82,7 +83,7 @@
 #define PROGRAM_NAME "ldap2json"
 #endif
 
-#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:"
+#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:98:7:"
 
 
 /////////////////
@@ -96,12 +97,18 @@
 typedef struct my_config MyConfig;
 struct my_config
 {
-   size_t        attrs_len;
-   LDAPUtils   * lud;
-   const char  * filter;
-   const char  * prog_name;
-   const char ** defvals;
-   char          output[LDAPUTILS_OPT_LEN];
+   size_t            attrs_len;
+   LDAPUtils       * lud;
+   const char      * filter;
+   const char      * prog_name;
+   const char     ** defvals;
+   LDAPUtilsSink   * out;
+   LDAPUtilsPipeline * pipe;
+   const char      * compress;     // output compression algorithm and level
+   size_t            threads;      // number of formatting and compression threads
+   int               ndjson;       // print one object per line
+   int               pad0;
+   size_t            count;        // number of entries queued
 };
 
 
@@ -120,8 +127,24 @@ int main(int argc, char * argv[]);
 // parses configuration
 int my_config(int argc, char * argv[], MyConfig ** cnfp);
 
+// appends DN transform of entry as JSON value
+int my_dnstr(const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out);
+
+// returns DN format of psuedo attribute
+int my_dntype(const char * name);
+
+// prints separator and name of entry member
+void my_member(MyConfig * cnf, LDAPUtilsSink * out, size_t * countp, const char * name);
+
+// queues search results for formatting
 int my_results(MyConfig * cnf, LDAPMessage * res);
 
+// formats entry
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+
+// queues entry as it is received
+int my_stream(void * ctx, LDAP * ld, LDAPMessage * msg);
+
 // fress resources
 void my_unbind(MyConfig * cnf);
 
@@ -147,6 +170,10 @@ void ldaputils_usage(void)
    printf("  ufn                       entry's User Friendly Name\n");
    printf("  adc                       entry's Active Directory canonical name\n");
    printf("  dce                       entry's DN in DCE-style\n");
+   printf("JSON Options:\n");
+   printf("  --ndjson                  print each entry as a JSON object on a single line\n");
+   printf("  --compress=type[:level]   compress output using gzip or zstd\n");
+   printf("  --threads=num             number of threads used to format entries (default: number of CPUs)\n");
    printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
    return;
 }
@@ -158,8 +185,10 @@ void ldaputils_usage(void)
 int main(int argc, char * argv[])
 {
    int                    err;
+   int                    rc;
    MyConfig             * cnf;
    LDAPMessage          * res;
+   LDAPUtilsPipelineOpts  opts;
 
    cnf = NULL;
 
@@ -177,22 +206,66 @@ int main(int argc, char * argv[])
       return(1);
    };
 
-   // performs LDAP search
-   if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+   // print header
+   if (!(cnf->ndjson))
+      ldaputils_sink_puts(cnf->out, "[\n");
+
+   // starts threads which format entries and write output in order
+   memset(&opts, 0, sizeof(opts));
+   opts.threads = cnf->threads;
+   opts.ctx     = cnf;
+   opts.format  = my_row;
+   if ( ((cnf->ndjson)) && (!(cnf->compress)) )
+   {
+      // makes each line available to consumers as soon as it is complete,
+      // compressed output is instead written as each block fills
+      opts.rows  = 1;
+      opts.flags = LDAPUTILS_PIPELINE_FLUSH;
+   };
+   if (ldaputils_pipeline_initialize(&cnf->pipe, cnf->out, &opts) == -1)
+   {
+      fprintf(stderr, "%s: ldaputils_pipeline_initialize(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // decodes entries as they are received unless sorting requires all results
+   if (!(cnf->lud->sortattr))
+      err = ldaputils_search_each(cnf->lud, my_stream, cnf);
+   else if ((err = ldaputils_search(cnf->lud, &res)) == LDAP_SUCCESS)
+   {
+      err = my_results(cnf, res);
+      ldap_msgfree(res);
+   };
+
+   // waits for formatted entries to be written, a failed stage also fails
+   // the search so write errors are only reported here
+   if ((rc = ldaputils_pipeline_finish(cnf->pipe)) != LDAP_SUCCESS)
+   {
+      if (rc == LDAP_OTHER)
+         fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+   if (err != LDAP_SUCCESS)
    {
-      fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      fprintf(stderr, "%s: %s: %s\n", ldaputils_get_prog_name(cnf->lud), ((cnf->lud->sortattr)) ? "ldaputils_search()" : "ldaputils_search_each()", ldap_err2string(err));
       my_unbind(cnf);
       return(1);
    };
 
-   // prints values
-   if ((err = my_results(cnf, res)) != LDAP_SUCCESS)
+   // print trailer
+   if (!(cnf->ndjson))
+      ldaputils_sink_puts(cnf->out, ((cnf->count)) ? "\n]\n" : "]\n");
+
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
    {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
       my_unbind(cnf);
       return(1);
    };
 
-   ldap_msgfree(res);
    my_unbind(cnf);
 
    return(0);
@@ -217,6 +290,9 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       {"help",          no_argument, 0, 'h'},
       {"verbose",       no_argument, 0, 'v'},
       {"version",       no_argument, 0, 'V'},
+      {"ndjson",        no_argument, 0, '9'},
+      {"compress",      required_argument, 0, '8'},
+      {"threads",       required_argument, 0, '7'},
       {NULL,            0,           0, 0  }
    };
 
@@ -260,6 +336,18 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          my_unbind(cnf);
          return(1);
 
+         case '9':
+         cnf->ndjson = 1;
+         break;
+
+         case '8':
+         cnf->compress = optarg;
+         break;
+
+         case '7':
+         cnf->threads = (size_t)atoll(optarg);
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -326,26 +414,93 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
 
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+   if ( ((cnf->compress)) && (ldaputils_sink_compress(cnf->out, cnf->compress, cnf->threads) == -1) )
+   {
+      fprintf(stderr, "%s: --compress=%s: %s\n", cnf->prog_name, cnf->compress, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    *cnfp = cnf;
 
    return(0);
 }
 
 
-// prints results
+/// appends DN transform of entry as JSON value
+/// @param[in] dn      parsed DN of entry
+/// @param[in] type    DN format
+/// @param[in] out     formatted output of batch
+int my_dnstr(const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out)
+{
+   int      rc;
+   size_t   len;
+   char   * str;
+   char     buff[LDAPUTILS_BUFF_LEN];
+
+   if ((len = ldaputils_dn_format(dn, type, buff, sizeof(buff))) < sizeof(buff))
+      return(ldaputils_sink_json_value(out, buff, len, 0));
+
+   // DN exceeds stack buffer
+   if ((str = malloc(len+1)) == NULL)
+      return(-1);
+   ldaputils_dn_format(dn, type, str, len+1);
+   rc = ldaputils_sink_json_value(out, str, len, 0);
+   free(str);
+
+   return(rc);
+}
+
+
+/// returns DN format of psuedo attribute
+/// @param[in] name    name of requested attribute
+int my_dntype(const char * name)
+{
+   if (strcasecmp("rdn", name) == 0)
+      return(LDAPUTILS_DN_RDN);
+   if (strcasecmp("ufn", name) == 0)
+      return(LDAPUTILS_DN_UFN);
+   if (strcasecmp("adc", name) == 0)
+      return(LDAPUTILS_DN_ADC);
+   if (strcasecmp("dce", name) == 0)
+      return(LDAPUTILS_DN_DCE);
+   return(0);
+}
+
+
+/// prints separator and name of entry member
+/// @param[in] cnf     reference to configuration
+/// @param[in] out     output of entry
+/// @param[in] countp  number of members printed for current entry
+/// @param[in] name    name of member
+void my_member(MyConfig * cnf, LDAPUtilsSink * out, size_t * countp, const char * name)
+{
+   if ((cnf->ndjson))
+      ldaputils_sink_puts(out, ((*countp)) ? ", " : "");
+   else
+      ldaputils_sink_puts(out, ((*countp)) ? ",\n      " : "\n      ");
+   ldaputils_sink_json_string(out, name, strlen(name));
+   ldaputils_sink_puts(out, ": ");
+   (*countp)++;
+   return;
+}
+
+
+/// queues search results for formatting
+/// @param[in] cnf     reference to configuration
+/// @param[in] res     search results
 int my_results(MyConfig * cnf, LDAPMessage * res)
 {
-   int               x;
-   int               y;
-   char            * dnstr;
-   char            * dn;
-   char           ** dns;
-   char            * delim;
+   int               err;
    LDAPMessage     * msg;
-   char           ** vals;
    LDAP            * ld;
-   BerElement      * ber;
-   char            * attr;
 
    assert(cnf != NULL);
    assert(res != NULL);
@@ -356,137 +511,152 @@ int my_results(MyConfig * cnf, LDAPMessage * res)
    if ((cnf->lud->sortattr))
       ldap_sort_entries(ld, &res, cnf->lud->sortattr, strcasecmp);
 
-   // print header
-   printf("[\n");
-
    // loops through entries
-   msg = ldap_first_entry(ld, res);
-   while ((msg))
-   {
-      // retrieve first attribute
-      attr = ldap_first_attribute(ld, msg, &ber);
+   for(msg = ldap_first_entry(ld, res); ((msg)); msg = ldap_next_entry(ld, msg))
+      if ((err = my_stream(cnf, ld, msg)) != LDAP_SUCCESS)
+         return(err);
 
-      // retrieve DN and make CSV safe
-      if ((dn = ldap_get_dn(ld, msg)) == NULL)
-      {
-         fprintf(stderr, "%s: malloc(): out of virtual memory\n", cnf->prog_name);
-         return(LDAP_NO_MEMORY);
-      };
-      delim = dn;
-      while((delim = index(delim, '"')) != NULL)
-         delim[0] = '\'';
+   return(LDAP_SUCCESS);
+}
 
-      // start entry
-      if ((dns = ldap_explode_dn(dn, 0)) == NULL)
+
+/// formats entry, called by formatter threads
+/// @param[in] ctx     reference to configuration
+/// @param[in] row     decoded entry in order attributes were received
+/// @param[in] out     formatted output of batch
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out)
+{
+   int                      x;
+   int                      flags;
+   int                      type;
+   int                      parsed;
+   size_t                   y;
+   size_t                   count;
+   const char             * opt;
+   MyConfig               * cnf;
+   const LDAPUtilsRowAttr * attr;
+   LDAPUtilsDN              dn;
+
+   static const char * names[] = { NULL, "dn", "rdn", "ufn", "adc", "dce" };
+
+   cnf    = ctx;
+   parsed = 0;
+
+   // start entry
+   if ( (!(cnf->ndjson)) && ((row->idx)) )
+      ldaputils_sink_puts(out, ",\n");
+   ldaputils_sink_puts(out, ((cnf->ndjson)) ? "{" : "   {");
+   count = 0;
+
+   // loop through psuedo attributes
+   for(x = 0; (((cnf->lud->attrs)) && ((cnf->lud->attrs[x]))); x++)
+   {
+      if (strcasecmp("dn", cnf->lud->attrs[x]) == 0)
       {
-         fprintf(stderr, "%s: ldap_explode_dn(): out of virtual memory\n", cnf->prog_name);
-         return(LDAP_NO_MEMORY);
+         my_member(cnf, out, &count, "dn");
+         ldaputils_sink_json_value(out, row->dn.bv_val, row->dn.bv_len, 0);
+         continue;
       };
-      printf("   {\n");
 
-      // loop through psuedo attributes
-      for(x = 0; (((cnf->lud->attrs)) && ((cnf->lud->attrs[x]))); x++)
+      // DN is parsed once for all members derived from it, members of a DN
+      // which cannot be parsed repeat the DN as received
+      if ((type = my_dntype(cnf->lud->attrs[x])) != 0)
       {
-         if (strcasecmp("dn", cnf->lud->attrs[x]) == 0)
-            printf("      \"dn\": \"%s\"", dn);
-         else if (strcasecmp("rdn", cnf->lud->attrs[x]) == 0)
-            printf("      \"rdn\": \"%s\"", dns[0]);
-         else if (strcasecmp("ufn", cnf->lud->attrs[x]) == 0)
+         if (!(parsed))
          {
-            if ((dnstr = ldap_dn2ufn(dn)) == NULL)
+            parsed = (ldaputils_dn_parse(&dn, row->dn.bv_val, row->dn.bv_len) == 0) ? 1 : -1;
+            if ( (parsed == -1) && (errno == ENOMEM) )
             {
-               fprintf(stderr, "%s: ldap_dn2ufn(): out of virtual memory\n", cnf->prog_name);
+               fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
                return(LDAP_NO_MEMORY);
             };
-            printf("      \"ufn\": \"%s\"", dnstr);
-            ldap_memfree(dnstr);
-         }
-         else if (strcasecmp("dce", cnf->lud->attrs[x]) == 0)
-         {
-            if ((dnstr = ldap_dn2dcedn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2dcedn(): out of virtual memory\n", cnf->prog_name);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("      \"dce\": \"%s\"", dnstr);
-            ldap_memfree(dnstr);
-         }
-         else if (strcasecmp("adc", cnf->lud->attrs[x]) == 0)
+         };
+         my_member(cnf, out, &count, names[type]);
+         if (parsed == -1)
          {
-            if ((dnstr = ldap_dn2ad_canonical(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2ad_canonical(): out of virtual memory\n", cnf->prog_name);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("      \"adc\": \"%s\"", dnstr);
-            ldap_memfree(dnstr);
-         }
-         else
+            ldaputils_sink_json_value(out, row->dn.bv_val, row->dn.bv_len, 0);
+            continue;
+         };
+         if (my_dnstr(&dn, type, out) == -1)
          {
-            if ((vals = ldap_get_values(ld, msg, cnf->lud->attrs[x])) != NULL)
-            {
-               ldap_value_free(vals);
-               continue;
-            };
-            if (cnf->defvals[x] == NULL)
-               continue;
-            printf("      \"%s\": \"%s\"", cnf->lud->attrs[x], cnf->defvals[x]);
+            fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+            ldaputils_dn_free(&dn);
+            return(LDAP_NO_MEMORY);
          };
-
-         if ( ((cnf->lud->attrs[x+1])) || ((attr)) )
-            printf(",\n");
-         else
-            printf("\n");
+         continue;
       };
 
-      ldap_value_free(dns);
-      ldap_memfree(dn);
+      // prints default value of attributes missing from entry
+      for(y = 0; (y < row->attrs_len); y++)
+         if (strcasecmp(row->attrs[y].name.bv_val, cnf->lud->attrs[x]) == 0)
+            break;
+      if ( (y < row->attrs_len) && ((row->attrs[y].vals_len)) )
+         continue;
+      if (cnf->defvals[x] == NULL)
+         continue;
+      my_member(cnf, out, &count, cnf->lud->attrs[x]);
+      ldaputils_sink_json_value(out, cnf->defvals[x], strlen(cnf->defvals[x]), 0);
+   };
+   if (parsed == 1)
+      ldaputils_dn_free(&dn);
+
+   // loop through attributes
+   for(y = 0; (y < row->attrs_len); y++)
+   {
+      attr = &row->attrs[y];
+      my_member(cnf, out, &count, attr->name.bv_val);
 
-      // loop through attributes
-      while ((attr))
+      // values of attributes transferred with the binary option are always encoded
+      flags = 0;
+      for(opt = index(attr->name.bv_val, ';'); ((opt)); opt = index(&opt[1], ';'))
+         if ( (!(strncasecmp(opt, ";binary", 7))) && ((opt[7] == '\0') || (opt[7] == ';')) )
+            flags = LDAPUTILS_JSON_BINARY;
+
+      // prints values
+      if (!(attr->vals_len))
       {
-         // retrieves values
-         if ((vals = ldap_get_values(ld, msg, attr)) == NULL)
-         {
-            for(x = 0; ( ((cnf->lud->attrs[x])) && (!(strcasecmp(attr, cnf->lud->attrs[x])))); x++);
-            if ((cnf->defvals[x]))
-                printf("      \"%s\": \"%s\"", attr, cnf->defvals[x]);
-            else
-               printf("      \"%s\": null", attr);
-         }
-         else if (vals[1] == NULL)
-         {
-            printf("      \"%s\": \"%s\"", attr, vals[0]);
-            ldap_value_free(vals);
-         }
-         else
+         ldaputils_sink_puts(out, "null");
+      }
+      else if (attr->vals_len == 1)
+      {
+         ldaputils_sink_json_value(out, attr->vals[0].bv_val, attr->vals[0].bv_len, flags);
+      }
+      else
+      {
+         ldaputils_sink_puts(out, "[");
+         for(x = 0; ((size_t)x < attr->vals_len); x++)
          {
-            printf("      \"%s\": [", attr);
-            for(y = 0; (y < ldap_count_values(vals)); y++)
-            {
-               if (y > 0)
-                  printf(", \"%s\"", vals[y]);
-               else
-                  printf(" \"%s\"", vals[y]);
-            };
-            printf(" ]");
-            ldap_value_free(vals);
+            ldaputils_sink_puts(out, ((x)) ? ", " : " ");
+            ldaputils_sink_json_value(out, attr->vals[x].bv_val, attr->vals[x].bv_len, flags);
          };
-         if ((attr = ldap_next_attribute(ld, msg, ber)) == NULL)
-            printf("\n");
-         else
-            printf(",\n");
+         ldaputils_sink_puts(out, " ]");
       };
-      ber_free(ber, 0);
-
-      // retrieves next entry
-      if ((msg = ldap_next_entry(ld, msg)) == NULL)
-         printf("   }\n");
-      else
-         printf("   },\n");
    };
 
-   printf("]\n");
+   // ends entry
+   if ((cnf->ndjson))
+      ldaputils_sink_puts(out, "}\n");
+   else
+      ldaputils_sink_puts(out, "\n   }");
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// queues entry as it is received
+/// @param[in] ctx     reference to configuration
+/// @param[in] ld      LDAP descriptor
+/// @param[in] msg     entry to queue
+int my_stream(void * ctx, LDAP * ld, LDAPMessage * msg)
+{
+   int          err;
+   MyConfig   * cnf;
+
+   cnf = ctx;
+
+   if ((err = ldaputils_pipeline_entry(cnf->pipe, ld, msg)) != LDAP_SUCCESS)
+      return(err);
+   cnf->count++;
 
    return(LDAP_SUCCESS);
 }
@@ -503,6 +673,12 @@ void my_unbind(MyConfig * cnf)
    if ((cnf->defvals))
       free(cnf->defvals);
 
+   if ((cnf->pipe))
+      ldaputils_pipeline_free(cnf->pipe);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
    free(cnf);
 
    return;
@@ -0,0 +1,1747 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldapdiff.c compares entries of two LDAP servers or subtrees
+ */
+/*
+ *  The top level entries below the base DN of both servers are listed and
+ *  each subtree is compared by one of the worker threads.  A worker opens
+ *  its own connections and searches the subtree of both servers at once
+ *  using paged results.  The searches ask the server to sort entries by
+ *  entryDN, which allows both streams to be merge joined one entry at a time
+ *  in constant memory.  The order of the received entries is verified, and
+ *  when a server is unable to sort the entries, both streams of each
+ *  remaining subtree are read concurrently and sorted locally, spilling
+ *  sorted runs to temporary files once the memory budget is exceeded.
+ *  Entries which are identical byte for byte are skipped without being
+ *  decoded, otherwise values are compared as in ldifdiff.  The change
+ *  records of each subtree are sorted and merged so the output deletes
+ *  children before their parents, then adds parents before their children.
+ *
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldapdiff" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldapdiff.c
+ *     gcc ${CFLAGS} -lldap -lpthread -o ldapdiff ldapdiff.o ../lib/libldaputils.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldapdiff" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldapdiff.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -lpthread -o ldapdiff \
+ *             ldapdiff.lo ../lib/libldaputils.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldapdiff.lo ldapdiff
+ */
+#define _LDAP_UTILS_SRC_LDAPDIFF 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldapdiff"
+#endif
+
+#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON "b:l:Ls:z:" "o:9:8:7:6:5:4:3"
+
+#define MY_MEMORY        (256 * 1024 * 1024)   // default memory used to sort entries locally
+#define MY_MEMORY_MIN    (1024 * 1024)
+#define MY_PAGE_SIZE     1000                  // default number of entries of each page of results
+#define MY_FILE_BUFF_LEN (64 * 1024)           // stdio buffer of each temporary file
+#define MY_THREADS_MAX   256
+#define MY_SUBTREES_MAX  1024                  // top level entries compared as separate subtrees
+#define MY_FANIN         128                   // sorted runs merged at once
+#define MY_SORT_ATTR     "entryDN"             // attribute used to request entries sorted by DN
+
+#define MY_OLD           0
+#define MY_NEW           1
+
+// order in which entries of a stream are received
+#define MY_MODE_SERVER   0                     // sorted by server, joined as received
+#define MY_MODE_CLIENT   1                     // read completely and sorted locally
+#define MY_MODE_LIST     2                     // unordered top level entries
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+/* search results of one server */
+typedef struct my_stream MyStream;
+struct my_stream
+{
+   struct my_config * cnf;
+   LDAP            * ld;
+   char            * base;         // DN of searched subtree
+   const char      * filter;
+   char           ** attrs;
+   int               side;
+   int               mode;         // MY_MODE_SERVER, MY_MODE_CLIENT, or MY_MODE_LIST
+   int               scope;
+   int               msgid;        // outstanding search, or -1
+   int               done;         // all pages were received
+   int               merged;       // first record of sorted runs was returned
+   int               err;
+   int               errnum;
+   size_t            count;        // number of entries returned
+   struct berval     cookie;       // paged results cookie of next page
+   LDAPUtilsSortBuff res;          // current entry, or entries being sorted
+   char            * prev;         // join key of previous entry
+   size_t            prev_size;
+   size_t            prev_len;
+   char            * buff;         // rewritten DN or attribute description
+   size_t            buff_size;
+   FILE           ** fps;          // sorted runs stored in temporary files
+   size_t            fps_len;
+   size_t            fps_size;
+   LDAPUtilsSortRun  * runs;
+   LDAPUtilsSortMerge merge;
+   pthread_t         thread;
+};
+
+
+/* subtree compared by one worker */
+typedef struct my_subtree MySubtree;
+struct my_subtree
+{
+   char            * rdn;          // top level entry, or NULL for base DN
+   char            * key;          // normalized RDN
+   size_t            key_len;
+   int               scope;
+   int               pad0;
+   LDAPUtilsSortBuff res;          // sorted change records
+};
+
+
+/* state of thread which compares subtrees */
+typedef struct my_work MyWork;
+struct my_work
+{
+   struct my_config * cnf;
+   LDAP            * lds[2];
+   MyStream          streams[2];
+   LDAPUtilsDiffEntry parsed[2];
+   pthread_t         thread;
+   int               side;         // server which returned an error
+   int               pad0;
+};
+
+
+/* configuration union */
+typedef struct my_config MyConfig;
+struct my_config
+{
+   LDAPUtils       * lud;
+   const char      * prog_name;
+   const char      * tmpdir;       // directory of temporary files
+   char            * uris[2];      // URIs of both servers
+   char            * bases[2];     // base DN of both servers
+   size_t            base_rdns[2]; // number of RDNs of each base DN
+   size_t            memory;       // memory used to sort entries locally
+   size_t            threads;      // number of threads which compare subtrees
+   int               page_size;
+   int               client_sort;  // entries are always sorted locally
+   int               rewrite;      // base DNs differ, DNs of new entries are rewritten
+   int               verbose;
+   MySubtree       * subtrees;
+   size_t            subtrees_len;
+   size_t            subtrees_size;
+   MyWork          * works;
+   LDAPUtilsSink   * out;
+   atomic_size_t     next;         // next subtree to compare
+   atomic_size_t     changes;      // number of change records
+   atomic_int        err;          // result code of first subtree which failed
+   atomic_int        unsorted;     // a server did not sort entries
+   int               errnum;
+   int               errside;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// appends change record which deletes or adds an entry
+int my_change(MyWork * work, LDAPUtilsSortBuff * res, MyStream * stream, const LDAPUtilsSortItem * item);
+
+// lists top level entries below base DN of one server
+int my_children(MyWork * work, int side);
+
+// ensures buffer of stream holds bytes
+int my_buff(MyStream * stream, size_t len);
+
+// ends searches and discards entries of stream
+void my_close(MyStream * stream);
+
+// compares keys of subtrees
+int my_cmp_subtree(const void * ptr1, const void * ptr2);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// connects and binds to server
+int my_connect(MyConfig * cnf, int side, LDAP ** ldp);
+
+// returns normalized DN of entry relative to base DN
+const char * my_dnkey(MyStream * stream, const LDAPUtilsSortItem * item, size_t * lenp);
+
+// reads and sorts all entries of stream, called by stream threads
+void * my_drain(void * ptr);
+
+// returns next entry of stream in join order
+const LDAPUtilsSortItem * my_fetch(MyStream * stream);
+
+// merge joins entries of both servers
+int my_join(MyWork * work, MySubtree * sub);
+
+// prepares stream and starts search of subtree
+int my_open(MyWork * work, int side, MySubtree * sub, int mode);
+
+// merges sorted change records of all subtrees into output
+int my_output(MyConfig * cnf);
+
+// reads next entry of stream
+int my_read(MyStream * stream);
+
+// appends join key, normalized DN, and LDIF record of entry
+int my_record(MyStream * stream, LDAPMessage * msg);
+
+// merges first sorted runs stored in temporary files into one run
+int my_reduce(MyStream * stream);
+
+// requests next page of results
+int my_search(MyStream * stream);
+
+// sorts entries of stream and writes sorted run to temporary file
+int my_spill(MyStream * stream);
+
+// compares one subtree of both servers
+int my_subtree(MyWork * work, MySubtree * sub);
+
+// divides the compared entries into subtrees
+int my_subtrees(MyConfig * cnf);
+
+// appends formatted DN to records
+int my_text_dn(LDAPUtilsSortBuff * res, const LDAPUtilsDN * dn, int format);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+// compares subtrees, called by worker threads
+void * my_worker(void * ptr);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] [filter] [attributes...]\n", PROGRAM_NAME);
+   ldaputils_usage_search(MY_SHORT_OPTIONS);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Diff Options:\n");
+   printf("  --new-uri=uri             URI of new server (default: -H)\n");
+   printf("  --new-base=dn             base DN of new server (default: -b)\n");
+   printf("  --threads=num             number of threads used to compare subtrees (default: number of CPUs)\n");
+   printf("  --page-size=num           number of entries of each page of results (default: %i)\n", MY_PAGE_SIZE);
+   printf("  --memory=size             memory used to sort entries locally (default: %iM)\n", (MY_MEMORY / 1024 / 1024));
+   printf("  --tmpdir=dir              directory for temporary files (default: $TMPDIR or /tmp)\n");
+   printf("  --client-sort             sort entries locally instead of by server\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int              x;
+   int              err;
+   size_t           y;
+   size_t           started;
+   MyConfig       * cnf;
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(2);
+   if (!(cnf))
+      return(0);
+
+   // connects to both servers
+   for(x = 0; (x < 2); x++)
+   {
+      if ((err = my_connect(cnf, x, &cnf->works[0].lds[x])) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: %s: ldap_sasl_bind_s(): %s\n", cnf->prog_name, ((cnf->uris[x])) ? cnf->uris[x] : "ldap", ldap_err2string(err));
+         my_unbind(cnf);
+         return(2);
+      };
+   };
+
+   // lists top level entries of both servers
+   if ((err = my_subtrees(cnf)) != LDAP_SUCCESS)
+   {
+      if (err == LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      else
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->uris[cnf->works[0].side])) ? cnf->uris[cnf->works[0].side] : "ldap", ldap_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+   if (cnf->threads > cnf->subtrees_len)
+      cnf->threads = cnf->subtrees_len;
+   if ((cnf->verbose))
+      fprintf(stderr, "%s: comparing %zu subtrees with %zu threads\n", cnf->prog_name, cnf->subtrees_len, cnf->threads);
+
+   // compares subtrees
+   for(started = 0; (started < cnf->threads); started++)
+   {
+      if ((err = pthread_create(&cnf->works[started].thread, NULL, my_worker, &cnf->works[started])) != 0)
+      {
+         fprintf(stderr, "%s: pthread_create(): %s\n", cnf->prog_name, strerror(err));
+         atomic_store(&cnf->next, cnf->subtrees_len);
+         break;
+      };
+   };
+   for(y = 0; (y < started); y++)
+      pthread_join(cnf->works[y].thread, NULL);
+   if ( ((err = atomic_load(&cnf->err)) != LDAP_SUCCESS) || (started < cnf->threads) )
+   {
+      if (err == LDAP_LOCAL_ERROR)
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(cnf->errnum));
+      else if (err == LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      else if (err != LDAP_SUCCESS)
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->uris[cnf->errside])) ? cnf->uris[cnf->errside] : "ldap", ldap_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // writes change records in order
+   if ( (my_output(cnf) == -1) || (ldaputils_sink_flush(cnf->out) == -1) )
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // exit status matches diff(1)
+   x = ((atomic_load(&cnf->changes))) ? 1 : 0;
+
+   my_unbind(cnf);
+
+   return(x);
+}
+
+
+/// appends change record which deletes or adds an entry
+/// @param[in] work    state of thread
+/// @param[in] res     change records of subtree
+/// @param[in] stream  old server to delete entry, new server to add entry
+/// @param[in] item    record of entry
+int my_change(MyWork * work, LDAPUtilsSortBuff * res, MyStream * stream, const LDAPUtilsSortItem * item)
+{
+   int                   err;
+   size_t                dnkey_len;
+   const char          * dnkey;
+   LDAPUtilsDiffEntry  * parsed;
+
+   dnkey  = my_dnkey(stream, item, &dnkey_len);
+   parsed = &work->parsed[stream->side];
+   if ((err = ldaputils_diff_parse(parsed, item->data, item->data_len)) != LDAP_SUCCESS)
+      return(err);
+
+   if (stream->side == MY_OLD)
+      return(ldaputils_diff_delete(res, parsed, dnkey, dnkey_len));
+   return(ldaputils_diff_add(res, parsed, dnkey, dnkey_len));
+}
+
+
+/// ensures buffer of stream holds bytes
+/// @param[in] stream  search results of one server
+/// @param[in] len     number of bytes
+int my_buff(MyStream * stream, size_t len)
+{
+   void     * ptr;
+
+   if (len <= stream->buff_size)
+      return(0);
+   if ((ptr = realloc(stream->buff, len)) == NULL)
+      return(-1);
+   stream->buff      = ptr;
+   stream->buff_size = len;
+
+   return(0);
+}
+
+
+/// lists top level entries below base DN of one server
+/// @param[in] work    state of first thread
+/// @param[in] side    MY_OLD or MY_NEW
+int my_children(MyWork * work, int side)
+{
+   int              err;
+   size_t           size;
+   void           * ptr;
+   size_t           dnkey_len;
+   const char     * dnkey;
+   MyStream       * stream;
+   MyConfig       * cnf;
+   MySubtree        base;
+   const LDAPUtilsSortItem * item;
+   MySubtree      * sub;
+
+   cnf    = work->cnf;
+   stream = &work->streams[side];
+
+   memset(&base, 0, sizeof(base));
+   base.scope = LDAP_SCOPE_ONE;
+   if ((err = my_open(work, side, &base, MY_MODE_LIST)) != LDAP_SUCCESS)
+   {
+      my_close(stream);
+      return(err);
+   };
+
+   // stops listing once there are too many entries to compare separately
+   while ( ((item = my_fetch(stream)) != NULL) && (cnf->subtrees_len <= MY_SUBTREES_MAX) )
+   {
+      if (cnf->subtrees_len >= cnf->subtrees_size)
+      {
+         size = (cnf->subtrees_size) ? (cnf->subtrees_size * 2) : 64;
+         if ((ptr = realloc(cnf->subtrees, sizeof(MySubtree) * size)) == NULL)
+         {
+            my_close(stream);
+            return(LDAP_NO_MEMORY);
+         };
+         cnf->subtrees      = ptr;
+         cnf->subtrees_size = size;
+      };
+      sub   = &cnf->subtrees[cnf->subtrees_len];
+      dnkey = my_dnkey(stream, item, &dnkey_len);
+      memset(sub, 0, sizeof(MySubtree));
+      if ( ((sub->rdn = strndup(item->key, item->key_len)) == NULL) || ((sub->key = malloc(dnkey_len)) == NULL) )
+      {
+         if ((sub->rdn))
+            free(sub->rdn);
+         my_close(stream);
+         return(LDAP_NO_MEMORY);
+      };
+      memcpy(sub->key, dnkey, dnkey_len);
+      sub->key_len = dnkey_len;
+      cnf->subtrees_len++;
+   };
+
+   err = stream->err;
+   my_close(stream);
+
+   return(err);
+}
+
+
+/// ends searches and discards entries of stream
+/// @param[in] stream  search results of one server
+void my_close(MyStream * stream)
+{
+   size_t     x;
+
+   if (stream->msgid != -1)
+      ldap_abandon_ext(stream->ld, stream->msgid, NULL, NULL);
+   stream->msgid = -1;
+
+   if ((stream->cookie.bv_val))
+      ber_memfree(stream->cookie.bv_val);
+   stream->cookie.bv_val = NULL;
+   stream->cookie.bv_len = 0;
+
+   if ((stream->runs))
+   {
+      ldaputils_sort_merge_free(&stream->merge);
+      free(stream->runs);
+   };
+   stream->runs = NULL;
+   memset(&stream->merge, 0, sizeof(LDAPUtilsSortMerge));
+
+   for(x = 0; (x < stream->fps_len); x++)
+      fclose(stream->fps[x]);
+   stream->fps_len = 0;
+
+   stream->res.text_len  = 0;
+   stream->res.items_len = 0;
+
+   return;
+}
+
+
+/// compares keys of subtrees
+/// @param[in] ptr1   pointer to first subtree
+/// @param[in] ptr2   pointer to second subtree
+int my_cmp_subtree(const void * ptr1, const void * ptr2)
+{
+   int                 rc;
+   const MySubtree   * s1;
+   const MySubtree   * s2;
+
+   s1 = ptr1;
+   s2 = ptr2;
+
+   if ((rc = memcmp(s1->key, s2->key, ((s1->key_len < s2->key_len) ? s1->key_len : s2->key_len))))
+      return(rc);
+   if (s1->key_len != s2->key_len)
+      return((s1->key_len < s2->key_len) ? -1 : 1);
+
+   return(0);
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int           c;
+   int           x;
+   int           err;
+   int           option_index;
+   size_t        y;
+   size_t        size;
+   long          cpus;
+   const char  * new_uri;
+   const char  * new_base;
+   MyConfig    * cnf;
+   LDAPUtilsDN   dn;
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"new-uri",       required_argument, 0, '9'},
+      {"new-base",      required_argument, 0, '8'},
+      {"threads",       required_argument, 0, '7'},
+      {"page-size",     required_argument, 0, '6'},
+      {"memory",        required_argument, 0, '5'},
+      {"tmpdir",        required_argument, 0, '4'},
+      {"client-sort",   no_argument,       0, '3'},
+      {NULL,            0,                 0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+   cnf->prog_name = PROGRAM_NAME;
+   cnf->memory    = MY_MEMORY;
+   cnf->page_size = MY_PAGE_SIZE;
+   if ((cnf->tmpdir = getenv("TMPDIR")) == NULL)
+      cnf->tmpdir = "/tmp";
+   atomic_init(&cnf->next,     0);
+   atomic_init(&cnf->changes,  0);
+   atomic_init(&cnf->err,      LDAP_SUCCESS);
+   atomic_init(&cnf->unsorted, 0);
+   new_uri  = NULL;
+   new_base = NULL;
+
+   // initialize ldap utilities
+   if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldaputils_initialize(): %s\n", PROGRAM_NAME, ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(ldaputils_getopt(cnf->lud, c, optarg))
+      {
+         // shared option exit without error
+         case -2:
+         my_unbind(cnf);
+         return(0);
+
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         // shared option error
+         case 1:
+         my_unbind(cnf);
+         return(1);
+
+         case '9':
+         new_uri = optarg;
+         break;
+
+         case '8':
+         new_base = optarg;
+         break;
+
+         case '7':
+         if ( (ldaputils_sort_size(optarg, &cnf->threads) == -1) || (!(cnf->threads)) || (cnf->threads > MY_THREADS_MAX) )
+         {
+            fprintf(stderr, "%s: invalid number of threads `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         case '6':
+         if ( (ldaputils_sort_size(optarg, &size) == -1) || (!(size)) || (size > 0x7fffffff) )
+         {
+            fprintf(stderr, "%s: invalid page size `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->page_size = (int)size;
+         break;
+
+         case '5':
+         if ( (ldaputils_sort_size(optarg, &cnf->memory) == -1) || (cnf->memory < MY_MEMORY_MIN) )
+         {
+            fprintf(stderr, "%s: invalid memory size `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         case '4':
+         cnf->tmpdir = optarg;
+         break;
+
+         case '3':
+         cnf->client_sort = 1;
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   cnf->prog_name = ldaputils_get_prog_name(cnf->lud);
+   cnf->verbose   = cnf->lud->verbose;
+
+   // saves filter
+   cnf->lud->filter = "(objectclass=*)";
+   if ( (optind < argc) && ((index(argv[optind], '=')) != NULL) )
+   {
+      cnf->lud->filter = argv[optind];
+      optind++;
+   };
+
+   // configures LDAP attributes to return in results
+   if ((optind < argc))
+   {
+      if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * (size_t)(argc-optind+1))))
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+         my_unbind(cnf);
+         return(1);
+      };
+      for(c = 0; c < (argc-optind); c++)
+         cnf->lud->attrs[c] = argv[optind+c];
+      cnf->lud->attrs[c] = NULL;
+   };
+
+   // the old server is configured by -H and -b, the new server defaults to the same
+   ldap_get_option(cnf->lud->ld, LDAP_OPT_URI,     &cnf->uris[MY_OLD]);
+   ldap_get_option(cnf->lud->ld, LDAP_OPT_DEFBASE, &cnf->bases[MY_OLD]);
+   if (!(cnf->bases[MY_OLD]))
+   {
+      fprintf(stderr, "%s: missing required base DN\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   if ((new_uri = ((new_uri)) ? new_uri : cnf->uris[MY_OLD]) != NULL)
+      cnf->uris[MY_NEW] = strdup(new_uri);
+   cnf->bases[MY_NEW] = strdup(((new_base)) ? new_base : cnf->bases[MY_OLD]);
+   if ( ((new_uri)) && (!(cnf->uris[MY_NEW])) )
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   if (!(cnf->bases[MY_NEW]))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   for(x = 0; (x < 2); x++)
+   {
+      if (ldaputils_dn_parse(&dn, cnf->bases[x], strlen(cnf->bases[x])) == -1)
+      {
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->bases[x], ldap_err2string(LDAP_INVALID_DN_SYNTAX));
+         my_unbind(cnf);
+         return(1);
+      };
+      cnf->base_rdns[x] = dn.rdns_len;
+      ldaputils_dn_free(&dn);
+   };
+   cnf->rewrite = (strcasecmp(cnf->bases[MY_OLD], cnf->bases[MY_NEW]) != 0);
+
+   // reads password
+   if ((err = ldaputils_pass(cnf->lud)) != 0)
+   {
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // determines number of threads
+   if (!(cnf->threads))
+   {
+      cpus         = sysconf(_SC_NPROCESSORS_ONLN);
+      cnf->threads = (cpus < 1) ? 1 : (cpus > MY_THREADS_MAX) ? MY_THREADS_MAX : (size_t)cpus;
+   };
+   if ((cnf->works = calloc(cnf->threads, sizeof(MyWork))) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   for(y = 0; (y < cnf->threads); y++)
+   {
+      cnf->works[y].cnf = cnf;
+      for(x = 0; (x < 2); x++)
+      {
+         cnf->works[y].streams[x].cnf   = cnf;
+         cnf->works[y].streams[x].side  = x;
+         cnf->works[y].streams[x].msgid = -1;
+      };
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// connects and binds to server
+/// @param[in]  cnf    reference to configuration
+/// @param[in]  side   MY_OLD or MY_NEW
+/// @param[out] ldp    receives LDAP descriptor, which is freed by caller
+int my_connect(MyConfig * cnf, int side, LDAP ** ldp)
+{
+   int              err;
+   int              opt;
+   LDAP           * ld;
+   LDAPUtils      * lud;
+   struct berval  * servercredp;
+
+   lud = cnf->lud;
+
+   if ((err = ldap_initialize(ldp, cnf->uris[side])) != LDAP_SUCCESS)
+      return(err);
+   ld = *ldp;
+
+   // copies protocol version and limits of -l and -z
+   opt = 3;
+   ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &opt);
+   if (ldap_get_option(lud->ld, LDAP_OPT_TIMELIMIT, &opt) == LDAP_OPT_SUCCESS)
+      ldap_set_option(ld, LDAP_OPT_TIMELIMIT, &opt);
+   if (ldap_get_option(lud->ld, LDAP_OPT_SIZELIMIT, &opt) == LDAP_OPT_SUCCESS)
+      ldap_set_option(ld, LDAP_OPT_SIZELIMIT, &opt);
+
+   // starts TLS
+   if (lud->tls_req > 0)
+      if ((err = ldap_start_tls_s(ld, NULL, NULL)) != LDAP_SUCCESS)
+         if (lud->tls_req > 1)
+            return(err);
+
+   // binds to LDAP
+   servercredp = NULL;
+   err = ldap_sasl_bind_s(ld, lud->binddn, lud->sasl_mech, &lud->passwd, NULL, NULL, &servercredp);
+   if ((servercredp))
+      ber_bvfree(servercredp);
+
+   return(err);
+}
+
+
+/// returns normalized DN of entry relative to base DN
+/// @param[in] stream  search results of one server
+/// @param[in] item    entry
+/// @param[out] lenp   length of normalized DN
+const char * my_dnkey(MyStream * stream, const LDAPUtilsSortItem * item, size_t * lenp)
+{
+   // entries sorted locally are keyed by the normalized DN, other entries
+   // are keyed by the join key followed by the normalized DN
+   if (stream->mode == MY_MODE_CLIENT)
+      *lenp = item->key_len;
+   else
+      *lenp = (size_t)(item->data - item->key) - item->key_len;
+   return(item->data - *lenp);
+}
+
+
+/// reads and sorts all entries of stream, called by stream threads
+/// @param[in] ptr     search results of one server
+void * my_drain(void * ptr)
+{
+   int              rc;
+   size_t           x;
+   size_t           len;
+   size_t           share;
+   MyStream       * stream;
+
+   stream = ptr;
+   share  = stream->cnf->memory / (stream->cnf->threads * 2);
+
+   // writes sorted runs once the share of memory of the stream is used
+   while ((rc = my_read(stream)) == 1)
+   {
+      if ((stream->res.text_len + (stream->res.items_len * sizeof(LDAPUtilsSortItem))) < share)
+         continue;
+      if ( (my_spill(stream) == -1) || ( (stream->fps_len >= MY_FANIN) && (my_reduce(stream) == -1) ) )
+      {
+         stream->err    = LDAP_LOCAL_ERROR;
+         stream->errnum = errno;
+         return(NULL);
+      };
+   };
+   if (rc == -1)
+      return(NULL);
+
+   // remaining entries are sorted in memory and merged with runs of temporary files
+   ldaputils_sort_records(&stream->res);
+   len = stream->fps_len + 1;
+   if ((stream->runs = calloc(len, sizeof(LDAPUtilsSortRun))) == NULL)
+   {
+      stream->err = LDAP_NO_MEMORY;
+      return(NULL);
+   };
+   for(x = 0; (x < stream->fps_len); x++)
+      stream->runs[x].fp = stream->fps[x];
+   stream->runs[x].mem = &stream->res;
+   if (ldaputils_sort_merge_init(&stream->merge, stream->runs, len) == -1)
+   {
+      stream->err    = LDAP_LOCAL_ERROR;
+      stream->errnum = errno;
+      return(NULL);
+   };
+
+   return(NULL);
+}
+
+
+/// returns next entry of stream in join order
+/// @param[in] stream  search results of one server
+const LDAPUtilsSortItem * my_fetch(MyStream * stream)
+{
+   int                         rc;
+   const LDAPUtilsSortItem   * item;
+
+   if (stream->err != LDAP_SUCCESS)
+      return(NULL);
+
+   // entries sorted locally are merged from sorted runs
+   if ((stream->runs))
+   {
+      if ( ((stream->merged)) && (ldaputils_sort_merge_next(&stream->merge) == -1) )
+      {
+         stream->err    = LDAP_LOCAL_ERROR;
+         stream->errnum = errno;
+         return(NULL);
+      };
+      stream->merged = 1;
+      return(ldaputils_sort_merge_item(&stream->merge));
+   };
+
+   // other entries are joined one at a time as they are received
+   stream->res.text_len  = 0;
+   stream->res.items_len = 0;
+   if (my_read(stream) != 1)
+      return(NULL);
+   ldaputils_sort_resolve(&stream->res);
+   item = &stream->res.items[0];
+   if (stream->mode != MY_MODE_SERVER)
+      return(item);
+
+   // verifies the server returned entries in the order of the join
+   if ((stream->count))
+   {
+      rc = memcmp(stream->prev, item->key, ((stream->prev_len < item->key_len) ? stream->prev_len : item->key_len));
+      if ( (rc > 0) || ( (rc == 0) && (stream->prev_len >= item->key_len) ) )
+      {
+         stream->err = LDAP_SORT_CONTROL_MISSING;
+         return(NULL);
+      };
+   };
+   if (item->key_len > stream->prev_size)
+   {
+      if ((stream->prev = realloc(stream->prev, item->key_len)) == NULL)
+      {
+         stream->prev_size = 0;
+         stream->err       = LDAP_NO_MEMORY;
+         return(NULL);
+      };
+      stream->prev_size = item->key_len;
+   };
+   memcpy(stream->prev, item->key, item->key_len);
+   stream->prev_len = item->key_len;
+   stream->count++;
+
+   return(item);
+}
+
+
+/// merge joins entries of both servers
+/// @param[in] work    state of thread
+/// @param[in] sub     subtree being compared
+int my_join(MyWork * work, MySubtree * sub)
+{
+   int              rc;
+   int              err;
+   size_t           dnkey_len;
+   const char     * dnkey;
+   MyStream       * old;
+   MyStream       * new;
+   const LDAPUtilsSortItem * a;
+   const LDAPUtilsSortItem * b;
+
+   old = &work->streams[MY_OLD];
+   new = &work->streams[MY_NEW];
+   err = LDAP_SUCCESS;
+
+   a = my_fetch(old);
+   b = my_fetch(new);
+   while ( ( ((a)) || ((b)) ) && (old->err == LDAP_SUCCESS) && (new->err == LDAP_SUCCESS) )
+   {
+      rc = (!(a)) ? 1 : (!(b)) ? -1 : ldaputils_sort_cmp(a, b);
+
+      // entry only exists on old server
+      if (rc < 0)
+      {
+         if ((err = my_change(work, &sub->res, old, a)) != LDAP_SUCCESS)
+            break;
+         a = my_fetch(old);
+         continue;
+      };
+
+      // entry only exists on new server
+      if (rc > 0)
+      {
+         if ((err = my_change(work, &sub->res, new, b)) != LDAP_SUCCESS)
+            break;
+         b = my_fetch(new);
+         continue;
+      };
+
+      // entries are only decoded if the records differ
+      if ( (a->data_len != b->data_len) || ((memcmp(a->data, b->data, a->data_len))) )
+      {
+         if ((err = ldaputils_diff_parse(&work->parsed[MY_OLD], a->data, a->data_len)) != LDAP_SUCCESS)
+            break;
+         if ((err = ldaputils_diff_parse(&work->parsed[MY_NEW], b->data, b->data_len)) != LDAP_SUCCESS)
+            break;
+         dnkey = my_dnkey(new, b, &dnkey_len);
+         if ((err = ldaputils_diff_modify(&sub->res, &work->parsed[MY_OLD], &work->parsed[MY_NEW], dnkey, dnkey_len)) != LDAP_SUCCESS)
+            break;
+      };
+      a = my_fetch(old);
+      b = my_fetch(new);
+   };
+
+   if (err != LDAP_SUCCESS)
+      return(err);
+   if (old->err != LDAP_SUCCESS)
+   {
+      work->side = MY_OLD;
+      errno      = old->errnum;
+      return(old->err);
+   };
+   if (new->err != LDAP_SUCCESS)
+   {
+      work->side = MY_NEW;
+      errno      = new->errnum;
+      return(new->err);
+   };
+
+   ldaputils_sort_records(&sub->res);
+   atomic_fetch_add(&work->cnf->changes, sub->res.items_len);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// prepares stream and starts search of subtree
+/// @param[in] work    state of thread
+/// @param[in] side    MY_OLD or MY_NEW
+/// @param[in] sub     subtree to search
+/// @param[in] mode    MY_MODE_SERVER, MY_MODE_CLIENT, or MY_MODE_LIST
+int my_open(MyWork * work, int side, MySubtree * sub, int mode)
+{
+   size_t           len;
+   MyStream       * stream;
+   MyConfig       * cnf;
+
+   static char      attr_none[]  = "1.1";
+   static char    * attrs_none[] = { attr_none, NULL };
+
+   cnf    = work->cnf;
+   stream = &work->streams[side];
+
+   stream->ld       = work->lds[side];
+   stream->mode     = mode;
+   stream->scope    = sub->scope;
+   stream->msgid    = -1;
+   stream->done     = 0;
+   stream->merged   = 0;
+   stream->err      = LDAP_SUCCESS;
+   stream->errnum   = 0;
+   stream->count    = 0;
+   stream->prev_len = 0;
+   stream->filter   = (mode == MY_MODE_LIST) ? "(objectclass=*)" : cnf->lud->filter;
+   stream->attrs    = (mode == MY_MODE_LIST) ? attrs_none : cnf->lud->attrs;
+
+   // subtrees are searched below the base DN of each server
+   if ((stream->base))
+      free(stream->base);
+   len = strlen(cnf->bases[side]) + (((sub->rdn)) ? (strlen(sub->rdn) + 1) : 0) + 1;
+   if ((stream->base = malloc(len)) == NULL)
+      return(LDAP_NO_MEMORY);
+   if ((sub->rdn))
+      snprintf(stream->base, len, "%s%s%s", sub->rdn, ((cnf->bases[side][0])) ? "," : "", cnf->bases[side]);
+   else
+      snprintf(stream->base, len, "%s", cnf->bases[side]);
+
+   return(my_search(stream));
+}
+
+
+/// merges sorted change records of all subtrees into output
+/// @param[in] cnf     reference to configuration
+int my_output(MyConfig * cnf)
+{
+   int        rc;
+   size_t     x;
+   LDAPUtilsSortRun          * runs;
+   LDAPUtilsSortMerge          merge;
+   const LDAPUtilsSortItem   * item;
+
+   if ((runs = calloc(cnf->subtrees_len, sizeof(LDAPUtilsSortRun))) == NULL)
+      return(-1);
+   for(x = 0; (x < cnf->subtrees_len); x++)
+      runs[x].mem = &cnf->subtrees[x].res;
+
+   rc = -1;
+   if (ldaputils_sort_merge_init(&merge, runs, cnf->subtrees_len) == -1)
+      goto done;
+   if ( ((atomic_load(&cnf->changes))) && (ldaputils_sink_puts(cnf->out, "version: 1\n\n") == -1) )
+      goto done;
+   while ((item = ldaputils_sort_merge_item(&merge)) != NULL)
+   {
+      if (ldaputils_sink_write(cnf->out, item->data, item->data_len) == -1)
+         goto done;
+      if (ldaputils_sort_merge_next(&merge) == -1)
+         goto done;
+   };
+   rc = 0;
+
+   done:
+   ldaputils_sort_merge_free(&merge);
+   free(runs);
+
+   return(rc);
+}
+
+
+/// reads next entry of stream
+/// @param[in] stream  search results of one server
+int my_read(MyStream * stream)
+{
+   int              rc;
+   int              err;
+   ber_int_t        count;
+   LDAP           * ld;
+   LDAPMessage    * msg;
+   LDAPControl    * ctrl;
+   LDAPControl   ** ctrls;
+
+   ld = stream->ld;
+
+   while (!(stream->done))
+   {
+      // requests next page
+      if ( (stream->msgid == -1) && ((stream->err = my_search(stream)) != LDAP_SUCCESS) )
+         return(-1);
+
+      if ((rc = ldap_result(ld, stream->msgid, LDAP_MSG_ONE, NULL, &msg)) < 1)
+      {
+         stream->err = LDAP_TIMEOUT;
+         if (rc == -1)
+            ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &stream->err);
+         return(-1);
+      };
+
+      switch(ldap_msgtype(msg))
+      {
+         case LDAP_RES_SEARCH_ENTRY:
+         err = my_record(stream, msg);
+         ldap_msgfree(msg);
+         if ((stream->err = err) != LDAP_SUCCESS)
+            return(-1);
+         return(1);
+
+         case LDAP_RES_SEARCH_RESULT:
+         stream->msgid = -1;
+         ctrls         = NULL;
+         if ((stream->err = ldap_parse_result(ld, msg, &err, NULL, NULL, NULL, &ctrls, 1)) != LDAP_SUCCESS)
+            return(-1);
+
+         // subtrees which only exist on the other server have no entries
+         if ( (err != LDAP_SUCCESS) && (err != LDAP_NO_SUCH_OBJECT) )
+         {
+            stream->err = err;
+            ldap_controls_free(ctrls);
+            return(-1);
+         };
+
+         // saves cookie of next page
+         if ((stream->cookie.bv_val))
+            ber_memfree(stream->cookie.bv_val);
+         stream->cookie.bv_val = NULL;
+         stream->cookie.bv_len = 0;
+         if ( ((ctrls)) && ((ctrl = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, ctrls, NULL)) != NULL) )
+            ldap_parse_pageresponse_control(ld, ctrl, &count, &stream->cookie);
+         if ((ctrls))
+            ldap_controls_free(ctrls);
+         stream->done = ( (err == LDAP_NO_SUCH_OBJECT) || (!(stream->cookie.bv_len)) );
+         break;
+
+         default:
+         ldap_msgfree(msg);
+         break;
+      };
+   };
+
+   return(0);
+}
+
+
+/// appends join key, normalized DN, and LDIF record of entry
+/// @param[in] stream  search results of one server
+/// @param[in] msg     entry
+int my_record(MyStream * stream, LDAPMessage * msg)
+{
+   int              err;
+   size_t           x;
+   size_t           len;
+   size_t           start;
+   size_t           text;
+   size_t           key_len;
+   MyConfig       * cnf;
+   LDAPUtilsSortBuff * res;
+   BerElement     * ber;
+   struct berval    dn;
+   struct berval    attr;
+   struct berval  * vals;
+   LDAPUtilsDN      parsed;
+
+   cnf   = stream->cnf;
+   res   = &stream->res;
+   start = res->text_len;
+
+   // DN and attributes reference the BER buffer of the entry
+   if ((err = ldap_get_dn_ber(stream->ld, msg, &ber, &dn)) != LDAP_SUCCESS)
+      return(err);
+   if (ldaputils_dn_parse(&parsed, dn.bv_val, dn.bv_len) == -1)
+   {
+      ber_free(ber, 0);
+      return(((errno == ENOMEM)) ? LDAP_NO_MEMORY : LDAP_INVALID_DN_SYNTAX);
+   };
+   if (parsed.rdns_len < cnf->base_rdns[stream->side])
+   {
+      ldaputils_dn_free(&parsed);
+      ber_free(ber, 0);
+      return(LDAP_INVALID_DN_SYNTAX);
+   };
+   err = LDAP_NO_MEMORY;
+
+   // RDNs of the base DN are the last RDNs, so entries are keyed relative to the base DN
+   parsed.rdns_len -= cnf->base_rdns[stream->side];
+
+   // entries sorted by server are joined by the case folded relative DN, and
+   // listed top level entries keep their RDN
+   key_len = 0;
+   if (stream->mode != MY_MODE_CLIENT)
+   {
+      if (my_text_dn(res, &parsed, LDAPUTILS_DN_DN) == -1)
+         goto done;
+      for(x = start; ( (stream->mode == MY_MODE_SERVER) && (x < res->text_len) ); x++)
+         res->text[x] = (char)tolower((unsigned char)res->text[x]);
+
+      // a trailing comma orders keys as the full DNs are ordered
+      if ( (stream->mode == MY_MODE_SERVER) && (ldaputils_sort_append(res, ",", 1) == -1) )
+         goto done;
+      key_len = res->text_len - start;
+   };
+   if (my_text_dn(res, &parsed, LDAPUTILS_DN_KEY) == -1)
+      goto done;
+   text = res->text_len;
+
+   // entries of new server are written with DN of old server
+   if ( ((cnf->rewrite)) && (stream->side == MY_NEW) )
+   {
+      len = ldaputils_dn_format(&parsed, LDAPUTILS_DN_DN, NULL, 0) + strlen(cnf->bases[MY_OLD]) + 2;
+      if (my_buff(stream, len) == -1)
+         goto done;
+      x = ldaputils_dn_format(&parsed, LDAPUTILS_DN_DN, stream->buff, len);
+      snprintf(&stream->buff[x], len - x, "%s%s", ( ((x)) && ((cnf->bases[MY_OLD][0])) ) ? "," : "", cnf->bases[MY_OLD]);
+      if (ldaputils_diff_value(res, "dn", stream->buff, strlen(stream->buff)) == -1)
+         goto done;
+   }
+   else if (ldaputils_diff_value(res, "dn", dn.bv_val, dn.bv_len) == -1)
+   {
+      goto done;
+   };
+
+   // values are written in the order received
+   while ( ((err = ldap_get_attribute_ber(stream->ld, msg, ber, &attr, &vals)) == LDAP_SUCCESS) && ((attr.bv_val)) )
+   {
+      // attribute descriptions are not terminated within the BER buffer
+      if (my_buff(stream, attr.bv_len + 1) == 0)
+      {
+         memcpy(stream->buff, attr.bv_val, attr.bv_len);
+         stream->buff[attr.bv_len] = '\0';
+      }
+      else
+      {
+         err = LDAP_NO_MEMORY;
+      };
+      for(x = 0; ( ((vals)) && ((vals[x].bv_val)) && (err == LDAP_SUCCESS) ); x++)
+         if (ldaputils_diff_value(res, stream->buff, vals[x].bv_val, vals[x].bv_len) == -1)
+            err = LDAP_NO_MEMORY;
+      if ((vals))
+         ber_memfree(vals);
+      if (err != LDAP_SUCCESS)
+         goto done;
+   };
+   if (err != LDAP_SUCCESS)
+      goto done;
+   err = LDAP_NO_MEMORY;
+   if (ldaputils_sort_append(res, "\n", 1) == -1)
+      goto done;
+
+   // records are stored as the join key, normalized DN, and LDIF record,
+   // the normalized DN is located by my_dnkey()
+   if (ldaputils_sort_item(res, start, text - start) == -1)
+      goto done;
+   if (stream->mode != MY_MODE_CLIENT)
+      res->items[res->items_len-1].key_len = key_len;
+   err = LDAP_SUCCESS;
+
+   done:
+   ldaputils_dn_free(&parsed);
+   ber_free(ber, 0);
+
+   return(err);
+}
+
+
+/// merges first sorted runs stored in temporary files into one run
+/// @param[in] stream  search results of one server
+int my_reduce(MyStream * stream)
+{
+   int        rc;
+   int        errnum;
+   size_t     x;
+   FILE     * fp;
+   LDAPUtilsSortRun          * runs;
+   LDAPUtilsSortMerge          merge;
+   const LDAPUtilsSortItem   * item;
+
+   if ((runs = calloc(MY_FANIN, sizeof(LDAPUtilsSortRun))) == NULL)
+      return(-1);
+   for(x = 0; (x < MY_FANIN); x++)
+      runs[x].fp = stream->fps[x];
+
+   rc = -1;
+   fp = NULL;
+   if (ldaputils_sort_merge_init(&merge, runs, MY_FANIN) == -1)
+      goto done;
+   if ((fp = ldaputils_sort_temp(stream->cnf->tmpdir, PROGRAM_NAME, MY_FILE_BUFF_LEN)) == NULL)
+      goto done;
+   while ((item = ldaputils_sort_merge_item(&merge)) != NULL)
+   {
+      if (ldaputils_sort_put(fp, item) == -1)
+         goto done;
+      if (ldaputils_sort_merge_next(&merge) == -1)
+         goto done;
+   };
+   if (fflush(fp) == EOF)
+      goto done;
+
+   // merged run replaces the runs which were merged
+   for(x = 0; (x < MY_FANIN); x++)
+      fclose(stream->fps[x]);
+   memmove(stream->fps, &stream->fps[MY_FANIN], sizeof(FILE *) * (stream->fps_len - MY_FANIN));
+   stream->fps_len -= MY_FANIN;
+   stream->fps[stream->fps_len++] = fp;
+   fp = NULL;
+   rc = 0;
+
+   done:
+   errnum = errno;
+   if ((fp))
+      fclose(fp);
+   ldaputils_sort_merge_free(&merge);
+   free(runs);
+   errno = errnum;
+
+   return(rc);
+}
+
+
+/// requests next page of results
+/// @param[in] stream  search results of one server
+int my_search(MyStream * stream)
+{
+   int              err;
+   int              x;
+   LDAPSortKey   ** keys;
+   LDAPControl    * ctrls[3];
+
+   static char      sort_attr[] = MY_SORT_ATTR;
+
+   memset(ctrls, 0, sizeof(ctrls));
+   stream->msgid = -1;
+
+   if ((err = ldap_create_page_control(stream->ld, stream->cnf->page_size, ((stream->cookie.bv_len)) ? &stream->cookie : NULL, 0, &ctrls[0])) != LDAP_SUCCESS)
+      return(err);
+
+   // asks server to sort entries by DN, which fails if the server is unable
+   if (stream->mode == MY_MODE_SERVER)
+   {
+      if ((err = ldap_create_sort_keylist(&keys, sort_attr)) != LDAP_SUCCESS)
+      {
+         ldap_control_free(ctrls[0]);
+         return(err);
+      };
+      err = ldap_create_sort_control(stream->ld, keys, 1, &ctrls[1]);
+      ldap_free_sort_keylist(keys);
+      if (err != LDAP_SUCCESS)
+      {
+         ldap_control_free(ctrls[0]);
+         return(err);
+      };
+   };
+
+   // top level entries are listed without the size limit
+   err = ldap_search_ext(stream->ld, stream->base, stream->scope, stream->filter, stream->attrs, 0, ctrls, NULL, NULL, (stream->mode == MY_MODE_LIST) ? 0 : -1, &stream->msgid);
+   if (err != LDAP_SUCCESS)
+      stream->msgid = -1;
+
+   for(x = 0; ((ctrls[x])); x++)
+      ldap_control_free(ctrls[x]);
+
+   return(err);
+}
+
+
+/// sorts entries of stream and writes sorted run to temporary file
+/// @param[in] stream  search results of one server
+int my_spill(MyStream * stream)
+{
+   size_t     x;
+   size_t     size;
+   void     * ptr;
+   FILE     * fp;
+   LDAPUtilsSortBuff * res;
+
+   res = &stream->res;
+
+   if (stream->fps_len >= stream->fps_size)
+   {
+      size = (stream->fps_size) ? (stream->fps_size * 2) : 16;
+      if ((ptr = realloc(stream->fps, sizeof(FILE *) * size)) == NULL)
+         return(-1);
+      stream->fps      = ptr;
+      stream->fps_size = size;
+   };
+   if ((fp = ldaputils_sort_temp(stream->cnf->tmpdir, PROGRAM_NAME, MY_FILE_BUFF_LEN)) == NULL)
+      return(-1);
+   stream->fps[stream->fps_len++] = fp;
+
+   ldaputils_sort_records(res);
+   for(x = 0; (x < res->items_len); x++)
+      if (ldaputils_sort_put(fp, &res->items[x]) == -1)
+         return(-1);
+   if (fflush(fp) == EOF)
+      return(-1);
+
+   res->text_len  = 0;
+   res->items_len = 0;
+
+   return(0);
+}
+
+
+/// compares one subtree of both servers
+/// @param[in] work    state of thread
+/// @param[in] sub     subtree to compare
+int my_subtree(MyWork * work, MySubtree * sub)
+{
+   int              x;
+   int              err;
+   int              mode;
+   int              errnum;
+   int              started;
+   MyConfig       * cnf;
+   MyStream       * streams;
+
+   cnf     = work->cnf;
+   streams = work->streams;
+
+   while(1)
+   {
+      mode = ( (!(cnf->client_sort)) && (!(atomic_load(&cnf->unsorted))) ) ? MY_MODE_SERVER : MY_MODE_CLIENT;
+
+      // starts searches of both servers at once
+      err = LDAP_SUCCESS;
+      for(x = 0; ( (x < 2) && (err == LDAP_SUCCESS) ); x++)
+         if ((err = my_open(work, x, sub, mode)) != LDAP_SUCCESS)
+            work->side = x;
+
+      // entries sorted locally are read from both servers concurrently
+      if ( (err == LDAP_SUCCESS) && (mode == MY_MODE_CLIENT) )
+      {
+         started = (pthread_create(&streams[MY_NEW].thread, NULL, my_drain, &streams[MY_NEW]) == 0);
+         my_drain(&streams[MY_OLD]);
+         if ((started))
+            pthread_join(streams[MY_NEW].thread, NULL);
+         else
+            my_drain(&streams[MY_NEW]);
+      };
+
+      if (err == LDAP_SUCCESS)
+         err = my_join(work, sub);
+      errnum = errno;
+      my_close(&streams[MY_OLD]);
+      my_close(&streams[MY_NEW]);
+      errno = errnum;
+      if ( (err == LDAP_SUCCESS) || (mode == MY_MODE_CLIENT) || (err == LDAP_LOCAL_ERROR) || (err == LDAP_NO_MEMORY) )
+         return(err);
+
+      // falls back to sorting entries locally when a server does not sort by DN
+      if ( (!(atomic_exchange(&cnf->unsorted, 1))) && ((cnf->verbose)) )
+         fprintf(stderr, "%s: %s: %s, sorting entries locally\n", cnf->prog_name, ((cnf->uris[work->side])) ? cnf->uris[work->side] : "ldap", ldap_err2string(err));
+      sub->res.text_len  = 0;
+      sub->res.items_len = 0;
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// divides the compared entries into subtrees
+/// @param[in] cnf     reference to configuration
+int my_subtrees(MyConfig * cnf)
+{
+   int              x;
+   int              err;
+   int              scope;
+   size_t           y;
+   size_t           z;
+   void           * ptr;
+   MyWork         * work;
+   MySubtree      * sub;
+
+   work = &cnf->works[0];
+
+   // top level entries of both servers are compared as separate subtrees
+   for(x = 0; ( (x < 2) && (cnf->lud->scope != LDAP_SCOPE_BASE) && (cnf->subtrees_len <= MY_SUBTREES_MAX) ); x++)
+   {
+      if ((err = my_children(work, x)) != LDAP_SUCCESS)
+      {
+         work->side = x;
+         return(err);
+      };
+   };
+   if (cnf->subtrees_len > 1)
+      qsort(cnf->subtrees, cnf->subtrees_len, sizeof(MySubtree), my_cmp_subtree);
+   for(y = 0, z = 0; (y < cnf->subtrees_len); y++)
+   {
+      if ( ((z)) && (!(my_cmp_subtree(&cnf->subtrees[z-1], &cnf->subtrees[y]))) )
+      {
+         free(cnf->subtrees[y].rdn);
+         free(cnf->subtrees[y].key);
+         continue;
+      };
+      cnf->subtrees[z++] = cnf->subtrees[y];
+   };
+   cnf->subtrees_len = z;
+
+   // a base with too many top level entries is compared as one subtree
+   scope = (cnf->lud->scope == LDAP_SCOPE_ONE) ? LDAP_SCOPE_BASE : LDAP_SCOPE_SUB;
+   if (cnf->subtrees_len > MY_SUBTREES_MAX)
+   {
+      for(y = 0; (y < cnf->subtrees_len); y++)
+      {
+         free(cnf->subtrees[y].rdn);
+         free(cnf->subtrees[y].key);
+      };
+      cnf->subtrees_len = 0;
+   };
+   for(y = 0; (y < cnf->subtrees_len); y++)
+      cnf->subtrees[y].scope = scope;
+
+   // adds base DN, or the entire search if it was not divided
+   if ( (cnf->lud->scope != LDAP_SCOPE_SUB) && ((cnf->subtrees_len)) )
+      return(LDAP_SUCCESS);
+   if (cnf->subtrees_len >= cnf->subtrees_size)
+   {
+      if ((ptr = realloc(cnf->subtrees, sizeof(MySubtree) * (cnf->subtrees_len + 1))) == NULL)
+         return(LDAP_NO_MEMORY);
+      cnf->subtrees      = ptr;
+      cnf->subtrees_size = cnf->subtrees_len + 1;
+   };
+   sub = &cnf->subtrees[cnf->subtrees_len++];
+   memset(sub, 0, sizeof(MySubtree));
+   sub->scope = ( (cnf->lud->scope == LDAP_SCOPE_SUB) && (cnf->subtrees_len > 1) ) ? LDAP_SCOPE_BASE : cnf->lud->scope;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// appends formatted DN to records
+/// @param[in] res     records
+/// @param[in] dn      parsed DN
+/// @param[in] format  LDAPUTILS_DN_DN or LDAPUTILS_DN_KEY
+int my_text_dn(LDAPUtilsSortBuff * res, const LDAPUtilsDN * dn, int format)
+{
+   size_t     len;
+
+   len = ldaputils_dn_format(dn, format, NULL, 0);
+   if (ldaputils_sort_grow(res, len + 1) == -1)
+      return(-1);
+   ldaputils_dn_format(dn, format, &res->text[res->text_len], len + 1);
+   res->text_len += len;
+
+   return(0);
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   int          x;
+   size_t       y;
+   MyWork     * work;
+   MyStream   * stream;
+
+   assert(cnf != NULL);
+
+   for(y = 0; ( ((cnf->works)) && (y < cnf->threads) ); y++)
+   {
+      work = &cnf->works[y];
+      for(x = 0; (x < 2); x++)
+      {
+         stream = &work->streams[x];
+         my_close(stream);
+         if ((stream->base))
+            free(stream->base);
+         ldaputils_sort_free(&stream->res);
+         if ((stream->prev))
+            free(stream->prev);
+         if ((stream->buff))
+            free(stream->buff);
+         if ((stream->fps))
+            free(stream->fps);
+         ldaputils_diff_free(&work->parsed[x]);
+         if ((work->lds[x]))
+            ldap_unbind_ext_s(work->lds[x], NULL, NULL);
+      };
+   };
+   if ((cnf->works))
+      free(cnf->works);
+
+   for(y = 0; (y < cnf->subtrees_len); y++)
+   {
+      if ((cnf->subtrees[y].rdn))
+         free(cnf->subtrees[y].rdn);
+      if ((cnf->subtrees[y].key))
+         free(cnf->subtrees[y].key);
+      ldaputils_sort_free(&cnf->subtrees[y].res);
+   };
+   if ((cnf->subtrees))
+      free(cnf->subtrees);
+
+   if ((cnf->uris[MY_OLD]))
+      ldap_memfree(cnf->uris[MY_OLD]);
+   if ((cnf->bases[MY_OLD]))
+      ldap_memfree(cnf->bases[MY_OLD]);
+   if ((cnf->uris[MY_NEW]))
+      free(cnf->uris[MY_NEW]);
+   if ((cnf->bases[MY_NEW]))
+      free(cnf->bases[MY_NEW]);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   if ((cnf->lud))
+      ldaputils_unbind(cnf->lud);
+
+   free(cnf);
+
+   return;
+}
+
+
+/// compares subtrees, called by worker threads
+/// @param[in] ptr     state of thread
+void * my_worker(void * ptr)
+{
+   int            x;
+   int            err;
+   int            expected;
+   size_t         idx;
+   MyWork       * work;
+   MyConfig     * cnf;
+
+   work = ptr;
+   cnf  = work->cnf;
+   err  = LDAP_SUCCESS;
+
+   // each thread searches both servers with its own connections
+   for(x = 0; ( (x < 2) && (err == LDAP_SUCCESS) ); x++)
+      if ( (!(work->lds[x])) && ((err = my_connect(cnf, x, &work->lds[x])) != LDAP_SUCCESS) )
+         work->side = x;
+
+   while ( (err == LDAP_SUCCESS) && ((idx = atomic_fetch_add(&cnf->next, 1)) < cnf->subtrees_len) )
+   {
+      if (atomic_load(&cnf->err) != LDAP_SUCCESS)
+         return(NULL);
+      err = my_subtree(work, &cnf->subtrees[idx]);
+   };
+   if (err == LDAP_SUCCESS)
+      return(NULL);
+
+   // records the first failure and stops the remaining threads
+   expected = LDAP_SUCCESS;
+   if ((atomic_compare_exchange_strong(&cnf->err, &expected, err)))
+   {
+      cnf->errnum  = errno;
+      cnf->errside = work->side;
+   };
+   atomic_store(&cnf->next, cnf->subtrees_len);
+
+   return(NULL);
+}
+
+/* end of source file */
@@ -60,13 +60,16 @@
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <strings.h>
 #include <time.h>
+#include <fcntl.h>
 #include <getopt.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 #define LDAP_DEPRECATED 1
 #include <ldap.h>
@@ -86,7 +89,10 @@
 #define PROGRAM_NAME "ldapdn2str"
 #endif
 
-#define MY_SHORT_OPTIONS "hV"
+#define MY_SHORT_OPTIONS "f:ho:V"
+
+#define MY_READ_LEN      (1024 * 1024)
+#define MY_ROWS          4096
 
 
 /////////////////
@@ -98,22 +104,28 @@
 #pragma mark - Datatypes
 #endif
 
-#define MY_FORMAT_DN     0x01
-#define MY_FORMAT_RDN    0x02
-#define MY_FORMAT_UFN    0x03
-#define MY_FORMAT_ADC    0x04
-#define MY_FORMAT_DCE    0x05
-#define MY_FORMAT_IDN    0x06
+#define MY_FORMAT_DN     LDAPUTILS_DN_DN
+#define MY_FORMAT_RDN    LDAPUTILS_DN_RDN
+#define MY_FORMAT_UFN    LDAPUTILS_DN_UFN
+#define MY_FORMAT_ADC    LDAPUTILS_DN_ADC
+#define MY_FORMAT_DCE    LDAPUTILS_DN_DCE
+#define MY_FORMAT_IDN    LDAPUTILS_DN_IDN
 
 
 /* configuration union */
 typedef struct my_config MyConfig;
 struct my_config
 {
-   LDAPUtils          * lud;
    int                  type;
    int                  pad0;
-   LDAPDN               dn;
+   atomic_size_t        invalid;      // number of DNs which could not be parsed
+   size_t               threads;      // number of formatting threads
+   size_t               files_len;
+   const char        ** files;        // files containing one DN per line
+   const char         * output;
+   const char         * str;          // DN passed as argument
+   LDAPUtilsSink      * out;
+   LDAPUtilsPipeline  * pipe;
 };
 
 
@@ -132,6 +144,15 @@ int main(int argc, char * argv[]);
 // parses configuration
 int my_config(int argc, char * argv[], MyConfig ** cnfp);
 
+// formats DN into output
+int my_dnstr(const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out);
+
+// queues each line of file for formatting
+int my_file(MyConfig * cnf, const char * file, size_t src);
+
+// formats DN read from input, called by formatter threads
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+
 // fress resources
 void my_unbind(MyConfig * cnf);
 
@@ -148,8 +169,10 @@ void my_unbind(MyConfig * cnf);
 /// prints program usage and exits
 void ldaputils_usage(void)
 {
-   printf("Usage: %s [options] dn\n", PROGRAM_NAME);
+   printf("Usage: %s [options] [dn]\n", PROGRAM_NAME);
    ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("  -f file, --file=file      read DNs from file, one per line (default: stdin)\n");
+   printf("  --threads=num             number of threads used to format DNs (default: number of CPUs)\n");
    printf("  --dn                      print distinguished name\n");
    printf("  --rdn                     print relative distinguished name\n");
    printf("  --ufn                     user friendly name of DN\n");
@@ -166,11 +189,11 @@ void ldaputils_usage(void)
 /// @param[in] argv   array of arguments
 int main(int argc, char * argv[])
 {
+   int                    rc;
    int                    err;
-   int                    i;
-   int                    len;
-   char                 * str;
-   char                ** edn;
+   size_t                 x;
+   LDAPUtilsDN            dn;
+   LDAPUtilsPipelineOpts  opts;
    MyConfig             * cnf;
 
    cnf = NULL;
@@ -181,51 +204,64 @@ int main(int argc, char * argv[])
    if (!(cnf))
       return(0);
 
-   switch(cnf->type)
+   // formats DN passed as argument
+   if ((cnf->str))
    {
-      case MY_FORMAT_ADC:
-      ldap_dn2str(cnf->dn, &str, LDAP_DN_FORMAT_AD_CANONICAL);
-      printf("%s\n", str);
-      ldap_memfree(str);
-      break;
-
-      case MY_FORMAT_DCE:
-      ldap_dn2str(cnf->dn, &str, LDAP_DN_FORMAT_DCE);
-      printf("%s\n", str);
-      ldap_memfree(str);
-      break;
-
-      case MY_FORMAT_UFN:
-      ldap_dn2str(cnf->dn, &str, LDAP_DN_FORMAT_UFN);
-      printf("%s\n", str);
-      ldap_memfree(str);
-      break;
-
-      case MY_FORMAT_RDN:
-      ldap_dn2str(cnf->dn, &str, LDAP_DN_FORMAT_LDAPV3);
-      edn = ldap_explode_dn(str, 0);
-      printf("%s\n", edn[0]);
-      ldap_value_free(edn);
-      ldap_memfree(str);
-      break;
-
-      case MY_FORMAT_IDN:
-      ldap_dn2str(cnf->dn, &str, LDAP_DN_FORMAT_LDAPV3);
-      edn = ldap_explode_dn(str, 0);
-      for(len = 0; ((edn[len])); len++);
-      printf("%s", edn[len-1]);
-      for(i = len-1; i > 0; i--)
-         printf(",%s", edn[i-1]);
-      printf("\n");
-      ldap_value_free(edn);
-      ldap_memfree(str);
-      break;
-
-      default:
-      ldap_dn2str(cnf->dn, &str, LDAP_DN_FORMAT_LDAPV3);
-      printf("%s\n", str);
-      ldap_memfree(str);
-      break;
+      if (ldaputils_dn_parse(&dn, cnf->str, strlen(cnf->str)) == -1)
+      {
+         fprintf(stderr, "%s: %s: %s\n", PROGRAM_NAME, cnf->str, ((errno == ENOMEM)) ? "out of virtual memory" : "invalid DN syntax");
+         my_unbind(cnf);
+         return(1);
+      };
+      rc = my_dnstr(&dn, cnf->type, cnf->out);
+      ldaputils_dn_free(&dn);
+      if (rc == -1)
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+      ldaputils_sink_write(cnf->out, "\n", 1);
+      if (ldaputils_sink_flush(cnf->out) == -1)
+      {
+         fprintf(stderr, "%s: write(): %s\n", PROGRAM_NAME, strerror(errno));
+         my_unbind(cnf);
+         return(1);
+      };
+      my_unbind(cnf);
+      return(0);
+   };
+
+   // starts threads which format DNs and write output in order
+   memset(&opts, 0, sizeof(opts));
+   opts.threads = cnf->threads;
+   opts.rows    = MY_ROWS;
+   opts.flags   = LDAPUTILS_PIPELINE_FLUSH;
+   opts.ctx     = cnf;
+   opts.format  = my_row;
+   if (ldaputils_pipeline_initialize(&cnf->pipe, cnf->out, &opts) == -1)
+   {
+      fprintf(stderr, "%s: ldaputils_pipeline_initialize(): %s\n", PROGRAM_NAME, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // queues DNs from each file, or stdin if no files were specified
+   err = 0;
+   if (!(cnf->files_len))
+      err = my_file(cnf, "-", 0);
+   for(x = 0; ( (x < cnf->files_len) && (!(err)) ); x++)
+      err = my_file(cnf, cnf->files[x], x);
+
+   // waits for remaining output to be written
+   if ((rc = ldaputils_pipeline_finish(cnf->pipe)) == LDAP_OTHER)
+      fprintf(stderr, "%s: write(): %s\n", PROGRAM_NAME, strerror(errno));
+   else if (rc != LDAP_SUCCESS)
+      fprintf(stderr, "%s: %s\n", PROGRAM_NAME, ldap_err2string(rc));
+   if ( ((err)) || (rc != LDAP_SUCCESS) || ((atomic_load(&cnf->invalid))) )
+   {
+      my_unbind(cnf);
+      return(1);
    };
 
    // frees resources
@@ -241,10 +277,10 @@ int main(int argc, char * argv[])
 /// @param[in] cnfp   reference to configuration pointer
 int my_config(int argc, char * argv[], MyConfig ** cnfp)
 {
-   int        c;
-   int        err;
-   int        option_index;
-   MyConfig * cnf;
+   int            c;
+   int            option_index;
+   void         * ptr;
+   MyConfig     * cnf;
 
    static char   short_options[] = MY_SHORT_OPTIONS;
    static struct option long_options[] =
@@ -252,12 +288,14 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       {"help",          no_argument,       0, 'h'},
       {"verbose",       no_argument,       0, 'v'},
       {"version",       no_argument,       0, 'V'},
+      {"file",          required_argument, 0, 'f'},
       {"dn",            no_argument,       0, '9'},
       {"rdn",           no_argument,       0, '8'},
       {"ufn",           no_argument,       0, '7'},
       {"adc",           no_argument,       0, '6'},
       {"dce",           no_argument,       0, '5'},
       {"idn",           no_argument,       0, '4'},
+      {"threads",       required_argument, 0, '3'},
       {NULL,            0,                 0, 0  }
    };
 
@@ -268,26 +306,14 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
    memset(cnf, 0, sizeof(MyConfig));
+   atomic_init(&cnf->invalid, 0);
 
-   // initialize ldap utilities
-   if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
-   {
-      fprintf(stderr, "%s: ldaputils_initialize(): %s\n", PROGRAM_NAME, ldap_err2string(err));
-      my_unbind(cnf);
-      return(1);
-   };
-
-   // loops through args
+   // loops through args, DNs are formatted without initializing LDAP library
    option_index = 0;
    while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
    {
-      switch(ldaputils_getopt(cnf->lud, c, optarg))
+      switch(c)
       {
-         // shared option exit without error
-         case -2:
-         my_unbind(cnf);
-         return(0);
-
          // no more arguments
          case -1:
          break;
@@ -296,10 +322,33 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          case 0:
          break;
 
-         // shared option error
-         case 1:
+         case 'f':
+         if ((ptr = realloc(cnf->files, sizeof(char *) * (cnf->files_len+1))) == NULL)
+         {
+            fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->files = ptr;
+         cnf->files[cnf->files_len++] = optarg;
+         break;
+
+         case 'h':
+         ldaputils_usage();
          my_unbind(cnf);
-         return(1);
+         return(0);
+
+         case 'o':
+         cnf->output = optarg;
+         break;
+
+         case 'v':
+         break;
+
+         case 'V':
+         ldaputils_version(PROGRAM_NAME);
+         my_unbind(cnf);
+         return(0);
 
          case '9':
          cnf->type = MY_FORMAT_DN;
@@ -325,6 +374,10 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          cnf->type = MY_FORMAT_IDN;
          break;
 
+         case '3':
+         cnf->threads = (size_t)atoll(optarg);
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -340,26 +393,21 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       };
    };
 
-   // saves filter
-   if (argc < (optind+1))
+   // saves DN, DNs are read from input if not specified
+   if ( (argc > (optind+1)) || ( ((cnf->files_len)) && (argc > optind) ) )
    {
-      fprintf(stderr, "%s: missing required argument\n", PROGRAM_NAME);
-      fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
-      my_unbind(cnf);
-      return(1);
-   };
-   if (argc > (optind+1))
-   {
-      fprintf(stderr, "%s: unknown argument `%s'\n", PROGRAM_NAME, argv[optind+1]);
+      fprintf(stderr, "%s: unknown argument `%s'\n", PROGRAM_NAME, argv[argc-1]);
       fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
       my_unbind(cnf);
       return(1);
    };
+   if (argc > optind)
+      cnf->str = argv[optind];
 
-   // parses DN
-   if ((err = ldap_str2dn(argv[optind], &cnf->dn, LDAP_DN_FORMAT_LDAPV3|LDAP_DN_PEDANTIC)))
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->output, LDAPUTILS_SINK_PREALLOC) == -1)
    {
-      fprintf(stderr, "%s: error processing DN with ldap_str2dn()\n", PROGRAM_NAME);
+      fprintf(stderr, "%s: %s: %s\n", PROGRAM_NAME, ((cnf->output)) ? cnf->output : "stdout", strerror(errno));
       my_unbind(cnf);
       return(1);
    };
@@ -370,17 +418,178 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
 }
 
 
+/// formats DN into output
+/// @param[in] dn      parsed DN
+/// @param[in] type    DN format
+/// @param[in] out     output buffer
+int my_dnstr(const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out)
+{
+   int      rc;
+   size_t   len;
+   char   * str;
+   char     buff[LDAPUTILS_BUFF_LEN];
+
+   if ((len = ldaputils_dn_format(dn, type, buff, sizeof(buff))) < sizeof(buff))
+      return(ldaputils_sink_write(out, buff, len));
+
+   // DN exceeds stack buffer
+   if ((str = malloc(len+1)) == NULL)
+      return(-1);
+   ldaputils_dn_format(dn, type, str, len+1);
+   rc = ldaputils_sink_write(out, str, len);
+   free(str);
+
+   return(rc);
+}
+
+
+/// queues each line of file for formatting
+/// @param[in] cnf     reference to configuration
+/// @param[in] file    name of file, "-" for stdin
+/// @param[in] src     index of file, reported with line numbers of invalid DNs
+int my_file(MyConfig * cnf, const char * file, size_t src)
+{
+   int         fd;
+   int         err;
+   ssize_t     rc;
+   size_t      line;
+   size_t      pos;
+   size_t      len;
+   size_t      eol;
+   size_t      want;
+   size_t      size;
+   char      * buff;
+   char      * ptr;
+
+   // opens input
+   if (!(strcmp(file, "-")))
+   {
+      fd   = STDIN_FILENO;
+      file = "stdin";
+   }
+   else if ((fd = open(file, O_RDONLY)) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", PROGRAM_NAME, file, strerror(errno));
+      return(-1);
+   };
+
+   size = MY_READ_LEN;
+   if ((buff = malloc(size)) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      if (fd != STDIN_FILENO)
+         close(fd);
+      return(-1);
+   };
+
+   // reads large chunks and queues complete lines
+   err  = LDAP_SUCCESS;
+   len  = 0;
+   line = 0;
+   while (err == LDAP_SUCCESS)
+   {
+      want = size - len;
+      if ((rc = read(fd, &buff[len], want)) == 0)
+         break;
+      if (rc == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         fprintf(stderr, "%s: %s: %s\n", PROGRAM_NAME, file, strerror(errno));
+         err = LDAP_OTHER;
+         break;
+      };
+      len += (size_t)rc;
+
+      for(pos = 0; ( (err == LDAP_SUCCESS) && ((ptr = memchr(&buff[pos], '\n', len - pos)) != NULL) ); pos = eol + 1)
+      {
+         eol = (size_t)(ptr - buff);
+         err = ldaputils_pipeline_dn(cnf->pipe, &buff[pos], ((eol > pos) && (buff[eol-1] == '\r')) ? eol-pos-1 : eol-pos, src, ++line);
+      };
+
+      // retains partial line, growing buffer if line exceeds buffer
+      if ((pos))
+      {
+         memmove(buff, &buff[pos], len - pos);
+         len -= pos;
+      }
+      else if (len == size)
+      {
+         if ((ptr = realloc(buff, size * 2)) == NULL)
+         {
+            fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+            err = LDAP_NO_MEMORY;
+            break;
+         };
+         buff  = ptr;
+         size *= 2;
+      };
+
+      // writes DNs already received when input is slower than formatting
+      if ((size_t)rc < want)
+         ldaputils_pipeline_flush(cnf->pipe);
+   };
+
+   // queues final line which was not terminated by newline
+   if ( (err == LDAP_SUCCESS) && ((len)) )
+      err = ldaputils_pipeline_dn(cnf->pipe, buff, ((buff[len-1] == '\r')) ? len-1 : len, src, ++line);
+
+   free(buff);
+   if (fd != STDIN_FILENO)
+      close(fd);
+
+   return((err == LDAP_SUCCESS) ? 0 : -1);
+}
+
+
+/// formats DN read from input, called by formatter threads
+/// @param[in] ctx     reference to configuration
+/// @param[in] row     DN without attributes
+/// @param[in] out     formatted output of batch
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out)
+{
+   int            rc;
+   MyConfig     * cnf;
+   const char   * file;
+   LDAPUtilsDN    dn;
+
+   cnf = ctx;
+
+   // invalid DNs are printed as empty lines to keep output aligned with input
+   if (ldaputils_dn_parse(&dn, row->dn.bv_val, row->dn.bv_len) == -1)
+   {
+      if (errno == ENOMEM)
+         return(LDAP_NO_MEMORY);
+      file = ((cnf->files_len)) ? cnf->files[row->src] : "-";
+      file = ((strcmp(file, "-"))) ? file : "stdin";
+      fprintf(stderr, "%s: %s:%zu: invalid DN syntax\n", PROGRAM_NAME, file, row->idx);
+      atomic_fetch_add(&cnf->invalid, 1);
+      ldaputils_sink_write(out, "\n", 1);
+      return(LDAP_SUCCESS);
+   };
+
+   rc = my_dnstr(&dn, cnf->type, out);
+   ldaputils_dn_free(&dn);
+   if (rc == -1)
+      return(LDAP_NO_MEMORY);
+   ldaputils_sink_write(out, "\n", 1);
+
+   return(LDAP_SUCCESS);
+}
+
+
 // fress resources
 void my_unbind(MyConfig * cnf)
 {
    assert(cnf != NULL);
 
-   if ((cnf->lud))
-      ldaputils_unbind(cnf->lud);
+   if ((cnf->pipe))
+      ldaputils_pipeline_free(cnf->pipe);
 
-   if ((cnf->dn))
-      ldap_dnfree(cnf->dn);
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
 
+   free(cnf->files);
    free(cnf);
 
    return;
@@ -58,6 +58,7 @@
 
 #define _GNU_SOURCE 1
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -97,11 +98,11 @@
 typedef struct my_config MyConfig;
 struct my_config
 {
-   LDAPUtils   * lud;
-   const char  * filter;
-   const char  * prog_name;
-   const char ** defvals;
-   char          output[LDAPUTILS_OPT_LEN];
+   LDAPUtils       * lud;
+   const char      * filter;
+   const char      * prog_name;
+   const char     ** defvals;
+   LDAPUtilsSink   * out;
 };
 
 
@@ -163,9 +164,9 @@ int my_cmp_strings(const void * ap, const void * bp);
 // parses configuration
 int my_config(int argc, char * argv[], MyConfig ** cnfp);
 
-void my_field(const char * name, const char * val, int isoid);
+void my_field(MyConfig * cnf, const char * name, const char * val, int isoid);
 
-void my_fields(const char * name, char ** vals, int isoid);
+void my_fields(MyConfig * cnf, const char * name, char ** vals, int isoid);
 
 char * my_monitor(MyConfig * cnf, const char * base);
 
@@ -236,6 +237,14 @@ int main(int argc, char * argv[])
       return(1);
    };
 
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    my_unbind(cnf);
 
    return(0);
@@ -368,13 +377,21 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
 
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    *cnfp = cnf;
 
    return(0);
 }
 
 
-void my_field(const char * name, const char * val, int isoid)
+void my_field(MyConfig * cnf, const char * name, const char * val, int isoid)
 {
    const LDAPSchemaSpec  * spec;
    char                  * desc;
@@ -387,23 +404,23 @@ void my_field(const char * name, const char * val, int isoid)
    if (!(name))
       name = "";
    if ((desc))
-      printf("%-28s %s (%s)\n", name, val, desc);
+      ldaputils_sink_printf(cnf->out, "%-28s %s (%s)\n", name, val, desc);
    else
-      printf("%-28s %s\n", name, val);
+      ldaputils_sink_printf(cnf->out, "%-28s %s\n", name, val);
 
    return;
 }
 
 
-void my_fields(const char * name, char ** vals, int isoid)
+void my_fields(MyConfig * cnf, const char * name, char ** vals, int isoid)
 {
    size_t x;
    size_t vals_len;
    for(vals_len = 0; ((vals[vals_len])); vals_len++);
    qsort(vals, vals_len, sizeof(char *), my_cmp_strings);
-   my_field(name, vals[0], isoid);
+   my_field(cnf, name, vals[0], isoid);
    for(x = 1; ((vals[x])); x++)
-      my_field(NULL, vals[x], isoid);
+      my_field(cnf, NULL, vals[x], isoid);
    return;
 }
 
@@ -538,9 +555,9 @@ int my_monitor_connections(MyConfig * cnf, const char * base)
 
       snprintf(buff, sizeof(buff), "%s: %s", name[0], vals[0]);
       if (!(count))
-         my_field("Connections:", buff, 0);
+         my_field(cnf, "Connections:", buff, 0);
       else
-         my_field(NULL, buff, 0);
+         my_field(cnf, NULL, buff, 0);
       count++;
 
       if ((name))
@@ -552,7 +569,7 @@ int my_monitor_connections(MyConfig * cnf, const char * base)
       msg = ldap_next_entry(ld, msg);
    };
 
-   printf("\n");
+   ldaputils_sink_printf(cnf->out, "\n");
 
    return(0);
 }
@@ -631,7 +648,7 @@ int my_monitor_database(MyConfig * cnf, const char * base)
          ldap_value_free(vals);
       };
 
-      my_field(((count)) ? NULL : "Naming contexts:", buff, 0);
+      my_field(cnf, ((count)) ? NULL : "Naming contexts:", buff, 0);
       count++;
 
       // retrieves next entry
@@ -727,9 +744,9 @@ int my_monitor_listeners(MyConfig * cnf, const char * base)
 
       snprintf(buff, sizeof(buff), "%s initiated: %s; completed %s", cn[0], initiated[0], completed[0]);
       if (!(count))
-         my_field("Operations:", buff, 0);
+         my_field(cnf, "Operations:", buff, 0);
       else
-         my_field(NULL, buff, 0);
+         my_field(cnf, NULL, buff, 0);
       count++;
 
       ldap_value_free(cn);
@@ -740,7 +757,7 @@ int my_monitor_listeners(MyConfig * cnf, const char * base)
       msg = ldap_next_entry(ld, msg);
    };
 
-   printf("\n");
+   ldaputils_sink_printf(cnf->out, "\n");
 
    return(0);
 }
@@ -830,9 +847,9 @@ int my_monitor_operations(MyConfig * cnf, const char * base)
          uri[0] = '\0';
          snprintf(buff, sizeof(buff), "%s%s", uris[0], addr);
          if (!(count))
-            my_field("Listeners:", buff, 0);
+            my_field(cnf, "Listeners:", buff, 0);
          else
-            my_field(NULL, buff, 0);
+            my_field(cnf, NULL, buff, 0);
          count++;
       };
 
@@ -843,7 +860,7 @@ int my_monitor_operations(MyConfig * cnf, const char * base)
       msg = ldap_next_entry(ld, msg);
    };
 
-   printf("\n");
+   ldaputils_sink_printf(cnf->out, "\n");
 
    return(0);
 }
@@ -920,45 +937,45 @@ int my_rootdse(MyConfig * cnf)
    // obtain vendor name and version
    if ((vals = ldap_get_values(ld, msg, "vendorName")) != NULL)
    {
-      my_fields("Vendor name:", vals, 0);
+      my_fields(cnf, "Vendor name:", vals, 0);
       ldap_value_free(vals);
    }
    else if ((vals = ldap_get_values(ld, msg, "isGlobalCatalogReady")) != NULL)
    {
-      my_field("Vendor name:", "Microsoft Active Directory", 0);
+      my_field(cnf, "Vendor name:", "Microsoft Active Directory", 0);
       ldap_value_free(vals);
    }
    else if ((vals = ldap_get_values(ld, msg, "objectClass")) != NULL)
    {
       for(s = 0; ((vals[s])); s++)
          if (!(strcasecmp(vals[s], "OpenLDAProotDSE")))
-            my_field("Vendor name:", "OpenLDAP", 0);
+            my_field(cnf, "Vendor name:", "OpenLDAP", 0);
       ldap_value_free(vals);
    };
    if ((vals = ldap_get_values(ld, msg, "vendorVersion")) != NULL)
    {
-      my_fields("Vendor version:", vals, 0);
+      my_fields(cnf, "Vendor version:", vals, 0);
       ldap_value_free(vals);
    }
    else if ((vers))
-      my_field("Vendor version:", vers, 0);
+      my_field(cnf, "Vendor version:", vers, 0);
    if ((vals = ldap_get_values(ld, msg, "supportedLDAPVersion")) != NULL)
    {
-      my_fields("LDAP version:", vals, 0);
+      my_fields(cnf, "LDAP version:", vals, 0);
       ldap_value_free(vals);
    };
 
    // DNs
    if ((schema))
-      my_fields("Subschema Subentry:", schema, 0);
+      my_fields(cnf, "Subschema Subentry:", schema, 0);
    if ((vals = ldap_get_values(ld, msg, "configContext")) != NULL)
    {
-      my_fields("Configuration context:", vals, 0);
+      my_fields(cnf, "Configuration context:", vals, 0);
       ldap_value_free(vals);
    };
    if ((monitor))
-      my_fields("Monitoring context:", monitor, 0);
-   printf("\n");
+      my_fields(cnf, "Monitoring context:", monitor, 0);
+   ldaputils_sink_printf(cnf->out, "\n");
 
    // print schema
    if ((schema))
@@ -979,13 +996,13 @@ int my_rootdse(MyConfig * cnf)
    if ((monitor))
    {
       if ((rc = my_monitor_database(cnf, monitor[0])) == -1)
-         my_fields("Naming contexts:", vals, 0);
-      printf("\n");
+         my_fields(cnf, "Naming contexts:", vals, 0);
+      ldaputils_sink_printf(cnf->out, "\n");
    }
    else
    {
-      my_fields("Naming contexts:", vals, 0);
-      printf("\n");
+      my_fields(cnf, "Naming contexts:", vals, 0);
+      ldaputils_sink_printf(cnf->out, "\n");
    };
 
    if ((schema))
@@ -998,32 +1015,32 @@ int my_rootdse(MyConfig * cnf)
    // obtain supported controls
    if ((vals = ldap_get_values(ld, msg, "supportedControl")) != NULL)
    {
-      my_fields("Supported controls:", vals, 1);
-      printf("\n");
+      my_fields(cnf, "Supported controls:", vals, 1);
+      ldaputils_sink_printf(cnf->out, "\n");
       ldap_value_free(vals);
    };
 
    // obtain supported extension
    if ((vals = ldap_get_values(ld, msg, "supportedExtension")) != NULL)
    {
-      my_fields("Supported extension:", vals, 1);
-      printf("\n");
+      my_fields(cnf, "Supported extension:", vals, 1);
+      ldaputils_sink_printf(cnf->out, "\n");
       ldap_value_free(vals);
    };
 
    // obtain supported features
    if ((vals = ldap_get_values(ld, msg, "supportedFeatures")) != NULL)
    {
-      my_fields("Supported features:", vals, 1);
-      printf("\n");
+      my_fields(cnf, "Supported features:", vals, 1);
+      ldaputils_sink_printf(cnf->out, "\n");
       ldap_value_free(vals);
    };
 
    // obtain supported SASL mechanisms
    if ((vals = ldap_get_values(ld, msg, "supportedSASLMechanisms")) != NULL)
    {
-      my_fields("Supported SASL mechanisms:", vals, 0);
-      printf("\n");
+      my_fields(cnf, "Supported SASL mechanisms:", vals, 0);
+      ldaputils_sink_printf(cnf->out, "\n");
       ldap_value_free(vals);
    };
 
@@ -1074,7 +1091,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "ldapSyntaxes: %i", i);
-         my_field("Schema:",  buff, 0);
+         my_field(cnf, "Schema:",  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1085,7 +1102,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "matchingRules: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1096,7 +1113,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "matchingRuleUse: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1107,7 +1124,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "attributeTypes: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1118,7 +1135,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "objectClasses: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1129,7 +1146,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "dITContentRules: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1140,7 +1157,7 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "dITStructureRules: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
@@ -1151,12 +1168,12 @@ int my_schema(MyConfig * cnf, const char * base)
       if (i > 0)
       {
          snprintf(buff, sizeof(buff), "nameForms: %i", i);
-         my_field(NULL,  buff, 0);
+         my_field(cnf, NULL,  buff, 0);
       };
       ldap_value_free(vals);
    };
 
-   printf("\n");
+   ldaputils_sink_printf(cnf->out, "\n");
 
    return(0);
 }
@@ -1173,6 +1190,9 @@ void my_unbind(MyConfig * cnf)
    if ((cnf->defvals))
       free(cnf->defvals);
 
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
    free(cnf);
 
    return;
@@ -0,0 +1,621 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldaplint.c validates LDAP entries against schema
+ */
+/*
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldaplint" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldaplint.c
+ *     gcc ${CFLAGS} -lldap -o ldaplint ldaplint.o ../lib/libldaputils.a \
+ *             ../lib/libldapschema.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldaplint" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldaplint.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -o ldaplint \
+ *             ldaplint.lo ../lib/libldaputils.a ../lib/libldapschema.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldaplint.lo ldaplint
+ */
+/*
+ *  The schema is retrieved from the server and compiled into bitmaps of the
+ *  required and allowed attributeTypes of each objectClass before the
+ *  search is started.  Entries are decoded as they are received and checked
+ *  by the formatter threads of the pipeline, each of which uses its own
+ *  checker and violation counters, so entries are checked without locks.
+ *  Violations are written in the order entries were received.
+ */
+#define _LDAP_UTILS_SRC_LDAPLINT 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <getopt.h>
+#include <assert.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+#include <ldapschema.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldaplint"
+#endif
+
+#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:7:6:"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#pragma mark - Datatypes
+
+// state of formatter thread
+typedef struct my_state MyState;
+struct my_state
+{
+   LDAPSchemaChecker * chk;
+   size_t              entries;      // number of entries checked
+   size_t              invalid;      // number of entries with violations
+   size_t              viols[LDAPSCHEMA_V_MAX+1];
+};
+
+
+// configuration union
+typedef struct my_config MyConfig;
+struct my_config
+{
+   LDAPUtils           * lud;
+   LDAPSchema          * lsd;
+   LDAPSchemaValidator * val;
+   const char          * prog_name;
+   LDAPUtilsSink       * out;
+   LDAPUtilsPipeline   * pipe;
+   MyState             * states;       // state of each formatter thread
+   const char          * cache_dir;    // directory of cached schemas
+   size_t                threads;      // number of checking threads
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// queues search results for checking
+int my_results(MyConfig * cnf, LDAPMessage * res);
+
+// checks entry and prints violations
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+
+// returns state of formatter thread
+void * my_state(void * ctx, size_t idx);
+
+// prints number of entries and violations
+void my_summary(MyConfig * cnf);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] [filter]\n", PROGRAM_NAME);
+   ldaputils_usage_search(MY_SHORT_OPTIONS);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Lint Options:\n");
+   printf("  --schema-cache=dir        reuse schema cached in dir until server's schema changes\n");
+   printf("  --threads=num             number of threads used to check entries (default: number of CPUs)\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int                    err;
+   int                    rc;
+   size_t                 x;
+   size_t                 invalid;
+   long                   num;
+   MyConfig             * cnf;
+   LDAPMessage          * res;
+   LDAPUtilsPipelineOpts  opts;
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(2);
+   if (!(cnf))
+      return(0);
+
+   // starts TLS and binds to LDAP
+   if ((err = ldaputils_bind_s(cnf->lud)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldap_sasl_bind_s(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // retrieves and compiles schema
+   if ( ((err = ldapschema_fetch_cache(cnf->lsd, cnf->lud->ld, cnf->cache_dir)) != LDAP_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+   {
+      fprintf(stderr, "%s: ldapschema_fetch_cache(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+   if ((err = ldapschema_validator_initialize(cnf->lsd, &cnf->val)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldapschema_validator_initialize(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // allocates checker for each formatter thread
+   if (!(cnf->threads))
+   {
+      num          = sysconf(_SC_NPROCESSORS_ONLN);
+      cnf->threads = (num < 1) ? 1 : (size_t)num;
+   };
+   if (cnf->threads > LDAPUTILS_PIPELINE_MAX_THREADS)
+      cnf->threads = LDAPUTILS_PIPELINE_MAX_THREADS;
+   if ((cnf->states = malloc(sizeof(MyState) * cnf->threads)) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(2);
+   };
+   bzero(cnf->states, sizeof(MyState) * cnf->threads);
+   for(x = 0; (x < cnf->threads); x++)
+   {
+      if ((err = ldapschema_checker_initialize(cnf->val, &cnf->states[x].chk)) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: ldapschema_checker_initialize(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+         my_unbind(cnf);
+         return(2);
+      };
+   };
+
+   // starts threads which check entries and write violations in order
+   memset(&opts, 0, sizeof(opts));
+   opts.threads = cnf->threads;
+   opts.ctx     = cnf;
+   opts.format  = my_row;
+   opts.worker  = my_state;
+   if (ldaputils_pipeline_initialize(&cnf->pipe, cnf->out, &opts) == -1)
+   {
+      fprintf(stderr, "%s: ldaputils_pipeline_initialize(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // checks entries as they are received unless sorting requires all results
+   if (!(cnf->lud->sortattr))
+   {
+      if ((err = ldaputils_search_each(cnf->lud, ldaputils_pipeline_entry, cnf->pipe)) != LDAP_SUCCESS)
+      {
+         // reports search errors which were not caused by a failed stage
+         if ((rc = ldaputils_pipeline_finish(cnf->pipe)) == LDAP_OTHER)
+            fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+         else if ( (rc == LDAP_SUCCESS) && (err != LDAP_NO_MEMORY) )
+            fprintf(stderr, "%s: ldaputils_search_each(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+         my_unbind(cnf);
+         return(2);
+      };
+   } else {
+      // performs LDAP search
+      if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+         my_unbind(cnf);
+         return(2);
+      };
+
+      // queues entries
+      if ((err = my_results(cnf, res)) != LDAP_SUCCESS)
+      {
+         ldap_msgfree(res);
+         my_unbind(cnf);
+         return(2);
+      };
+
+      ldap_msgfree(res);
+   };
+
+   // waits for violations to be written
+   if ((err = ldaputils_pipeline_finish(cnf->pipe)) != LDAP_SUCCESS)
+   {
+      if (err == LDAP_OTHER)
+         fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      else if (err == LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   if ((cnf->lud->verbose))
+      my_summary(cnf);
+
+   for(x = 0, invalid = 0; (x < cnf->threads); x++)
+      invalid += cnf->states[x].invalid;
+
+   my_unbind(cnf);
+
+   return(((invalid)) ? 1 : 0);
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int        c;
+   int        err;
+   int        option_index;
+   MyConfig * cnf;
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument, 0, 'h'},
+      {"verbose",       no_argument, 0, 'v'},
+      {"version",       no_argument, 0, 'V'},
+      {"threads",       required_argument, 0, '7'},
+      {"schema-cache",  required_argument, 0, '6'},
+      {NULL,            0,           0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+
+   // initialize ldap utilities
+   if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldaputils_initialize(): %s\n", PROGRAM_NAME, ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // initialize schema
+   if ((err = ldapschema_initialize(&cnf->lsd)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldapschema_initialize(): %s\n", PROGRAM_NAME, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(ldaputils_getopt(cnf->lud, c, optarg))
+      {
+         // shared option exit without error
+         case -2:
+         my_unbind(cnf);
+         return(0);
+
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         // shared option error
+         case 1:
+         my_unbind(cnf);
+         return(1);
+
+         case '7':
+         cnf->threads = (size_t)atoll(optarg);
+         break;
+
+         case '6':
+         cnf->cache_dir = optarg;
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   cnf->prog_name = ldaputils_get_prog_name(cnf->lud);
+
+   // saves filter
+   cnf->lud->filter = "(objectclass=*)";
+   if (argc > optind)
+   {
+      if ((index(argv[optind], '=')) == NULL)
+      {
+         fprintf(stderr, "%s: invalid filter `%s'\n", cnf->prog_name, argv[optind]);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+      cnf->lud->filter = argv[optind];
+      optind++;
+   };
+   if (argc > optind)
+   {
+      fprintf(stderr, "%s: unrecognized argument `%s'\n", cnf->prog_name, argv[optind]);
+      fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // reads password
+   if ((err = ldaputils_pass(cnf->lud)) != 0)
+   {
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// queues search results for checking
+/// @param[in] cnf     reference to configuration
+/// @param[in] res     search results
+int my_results(MyConfig * cnf, LDAPMessage * res)
+{
+   int               err;
+   LDAPMessage     * msg;
+   LDAP            * ld;
+
+   assert(cnf != NULL);
+   assert(res != NULL);
+
+   ld      = ldaputils_get_ld(cnf->lud);
+
+   // sorts entries
+   if ((cnf->lud->sortattr))
+      ldap_sort_entries(ld, &res, cnf->lud->sortattr, strcasecmp);
+
+   // loops through entries
+   for(msg = ldap_first_entry(ld, res); ((msg)); msg = ldap_next_entry(ld, msg))
+      if ((err = ldaputils_pipeline_entry(cnf->pipe, ld, msg)) != LDAP_SUCCESS)
+         return(err);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// checks entry and prints violations, called by formatter threads
+/// @param[in] ctx     state of formatter thread
+/// @param[in] row     decoded entry
+/// @param[in] out     formatted output of batch
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out)
+{
+   int                      rc;
+   int                      code;
+   size_t                   x;
+   size_t                   value;
+   MyState                * state;
+   const LDAPUtilsRowAttr * attr;
+   struct berval            name;
+
+   state = ctx;
+
+   ldapschema_check_begin(state->chk);
+   for(x = 0; (x < row->attrs_len); x++)
+   {
+      attr = &row->attrs[x];
+      if (ldapschema_check_attribute(state->chk, &attr->name, attr->vals, attr->vals_len) != LDAPSCHEMA_SUCCESS)
+         return(LDAP_NO_MEMORY);
+   };
+   if ((rc = ldapschema_check_end(state->chk)) < 0)
+      return(LDAP_NO_MEMORY);
+
+   state->entries++;
+   if (!(rc))
+      return(LDAP_SUCCESS);
+   state->invalid++;
+
+   // prints one line for each violation
+   for(x = 0; ((code = ldapschema_check_violation(state->chk, x, &name, &value)) != 0); x++)
+   {
+      state->viols[code]++;
+      ldaputils_sink_write(out, row->dn.bv_val, row->dn.bv_len);
+      ldaputils_sink_printf(out, ": %s", ldapschema_violation2string(code));
+      if (!(name.bv_len))
+         ldaputils_sink_puts(out, "\n");
+      else if ( (code == LDAPSCHEMA_V_SYNTAX) || (code == LDAPSCHEMA_V_UNKNOWN_CLASS) )
+         ldaputils_sink_printf(out, ": %.*s (value %zu)\n", (int)name.bv_len, name.bv_val, value + 1);
+      else
+         ldaputils_sink_printf(out, ": %.*s\n", (int)name.bv_len, name.bv_val);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// returns state of formatter thread
+/// @param[in] ctx     reference to configuration
+/// @param[in] idx     index of formatter thread
+void * my_state(void * ctx, size_t idx)
+{
+   MyConfig * cnf;
+   cnf = ctx;
+   return(&cnf->states[idx]);
+}
+
+
+/// prints number of entries and violations
+/// @param[in] cnf     reference to configuration
+void my_summary(MyConfig * cnf)
+{
+   int      code;
+   size_t   x;
+   size_t   entries;
+   size_t   invalid;
+   size_t   viols[LDAPSCHEMA_V_MAX+1];
+
+   entries = 0;
+   invalid = 0;
+   bzero(viols, sizeof(viols));
+   for(x = 0; (x < cnf->threads); x++)
+   {
+      entries += cnf->states[x].entries;
+      invalid += cnf->states[x].invalid;
+      for(code = 1; (code <= LDAPSCHEMA_V_MAX); code++)
+         viols[code] += cnf->states[x].viols[code];
+   };
+
+   fprintf(stderr, "%s: %zu entries checked, %zu entries with violations\n", cnf->prog_name, entries, invalid);
+   for(code = 1; (code <= LDAPSCHEMA_V_MAX); code++)
+      if ((viols[code]))
+         fprintf(stderr, "%s:    %zu %s\n", cnf->prog_name, viols[code], ldapschema_violation2string(code));
+
+   return;
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   size_t x;
+
+   assert(cnf != NULL);
+
+   if ((cnf->pipe))
+      ldaputils_pipeline_free(cnf->pipe);
+
+   if ((cnf->lud))
+      ldaputils_unbind(cnf->lud);
+
+   if ((cnf->states))
+   {
+      for(x = 0; (x < cnf->threads); x++)
+         ldapschema_checker_free(cnf->states[x].chk);
+      free(cnf->states);
+   };
+
+   if ((cnf->val))
+      ldapschema_validator_free(cnf->val);
+
+   if ((cnf->lsd))
+      ldapschema_free(cnf->lsd);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   free(cnf);
+
+   return;
+}
+
+/* end of source file */
@@ -60,6 +60,7 @@
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -117,10 +118,12 @@ struct my_config
 {
    LDAPUtils          * lud;
    LDAPSchema         * lsd;
+   LDAPUtilsSink      * out;
    int                  noextra;
    int                  action;
    uint64_t             types;
    char               ** args;
+   const char         * cache_dir;
 };
 
 
@@ -194,6 +197,7 @@ void ldaputils_usage(void)
    printf("  --lint                    display schema errors\n");
    printf("  --list                    list objects in schema\n");
    printf("  --noextra                 do not include related objects or data\n");
+   printf("  --schema-cache=dir        reuse schema cached in dir until server's schema changes\n");
    printf("  --type=type               restrict operations to specific object types\n");
    printf("Object types\n");
    for(idx = 0; ((my_obj_types[idx].type)); idx++)
@@ -233,9 +237,9 @@ int main(int argc, char * argv[])
    };
 
    // fetches schema
-   if ( ((err = ldapschema_fetch(cnf->lsd, cnf->lud->ld)) != LDAP_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+   if ( ((err = ldapschema_fetch_cache(cnf->lsd, cnf->lud->ld, cnf->cache_dir)) != LDAP_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
    {
-      fprintf(stderr, "%s: ldapschema_fetch(): %s\n", cnf->lud->prog_name, ldapschema_err2string(err));
+      fprintf(stderr, "%s: ldapschema_fetch_cache(): %s\n", cnf->lud->prog_name, ldapschema_err2string(err));
       my_unbind(cnf);
       return(1);
    };
@@ -249,6 +253,14 @@ int main(int argc, char * argv[])
       default:             err = my_run_details(cnf); break;
    };
 
+   // writes remaining output
+   if ( (ldaputils_sink_flush(cnf->out) == -1) || (fflush(stdout) == EOF) )
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->lud->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    // frees resources
    my_unbind(cnf);
 
@@ -271,7 +283,7 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
    size_t         idx;
    size_t         len;
 
-   static char   short_options[] = MY_SHORT_OPTIONS "98:76";
+   static char   short_options[] = MY_SHORT_OPTIONS "98:762:";
    static struct option long_options[] =
    {
       {"schemalint",    no_argument,       0, '9'},
@@ -280,6 +292,7 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       {"list",          no_argument,       0, '7'},
       {"dump",          no_argument,       0, '6'},
       {"noextra",       no_argument,       0, '5'},
+      {"schema-cache",  required_argument, 0, '2'},
       {"help",          no_argument,       0, 'h'},
       {"verbose",       no_argument,       0, 'v'},
       {"version",       no_argument,       0, 'V'},
@@ -401,6 +414,11 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          cnf->noextra++;
          break;
 
+         // --schema-cache=dir option
+         case '2':
+         cnf->cache_dir = optarg;
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -454,6 +472,14 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
 
+   // opens output, schema definitions are printed by libldapschema to stdout
+   if (ldaputils_sink_open(&cnf->out, NULL, 0) == -1)
+   {
+      fprintf(stderr, "%s: stdout: %s\n", cnf->lud->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    *cnfp = cnf;
 
    return(0);
@@ -566,8 +592,10 @@ int my_run_details(MyConfig * cnf)
    // print results
    for(idx = 0; (idx < list_len); idx++)
    {
+      ldaputils_sink_flush(cnf->out);
       ldapschema_print(cnf->lsd, list[idx]);
-      printf("\n\n");
+      fflush(stdout);
+      ldaputils_sink_puts(cnf->out, "\n\n");
    };
 
    return(0);
@@ -576,6 +604,8 @@ int my_run_details(MyConfig * cnf)
 
 int my_run_dump(MyConfig * cnf)
 {
+   ldaputils_sink_flush(cnf->out);
+
    if ((cnf->types & MY_OBJ_SYNTAX) != 0)
       ldapschema_printall(cnf->lsd, LDAPSCHEMA_SYNTAX);
 
@@ -598,18 +628,18 @@ int my_run_lint(MyConfig * cnf)
 
    if ((err = ldapschema_errno(cnf->lsd)) == LDAPSCHEMA_SUCCESS)
    {
-      printf("no schema errors detected\n");
+      ldaputils_sink_printf(cnf->out, "no schema errors detected\n");
       return(0);
    };
 
    if ((errs = ldapschema_schema_errors(cnf->lsd)) == NULL)
    {
-      printf("unknown schema error detected\n");
+      ldaputils_sink_printf(cnf->out, "unknown schema error detected\n");
       return(MY_EXIT_SCHEMAERR);
    };
 
    for(pos = 0; ((errs[pos])); pos++)
-      printf("schema error %zu: %s\n", (pos+1), errs[pos]);
+      ldaputils_sink_printf(cnf->out, "schema error %zu: %s\n", (pos+1), errs[pos]);
    ldapschema_value_free(errs);
 
    return(MY_EXIT_SCHEMAERR);
@@ -637,7 +667,7 @@ int my_run_list(MyConfig * cnf)
       {
          ldapschema_get_info_ldapsyntax(cnf->lsd, syntax, LDAPSCHEMA_FLD_OID,  &oid);
          ldapschema_get_info_ldapsyntax(cnf->lsd, syntax, LDAPSCHEMA_FLD_DESC, &desc);
-         printf("%-15s %-35s DESC ( %s )\n", "ldapsyntax:", oid, desc);
+         ldaputils_sink_printf(cnf->out, "%-15s %-35s DESC ( %s )\n", "ldapsyntax:", oid, desc);
          ldapschema_memfree(oid);
          ldapschema_memfree(desc);
          syntax = ldapschema_next_ldapsyntax(cnf->lsd, cur);
@@ -663,18 +693,18 @@ int my_run_list(MyConfig * cnf)
          len = strlen(buff);
          snprintf(&buff[len], (sizeof(buff)-len-2), " )");
          if ( ((syntax)) && (!(cnf->noextra)) )
-            printf("%-15s %-35s NAME %-30s", "attributeType:", oid, buff);
+            ldaputils_sink_printf(cnf->out, "%-15s %-35s NAME %-30s", "attributeType:", oid, buff);
          else
-            printf("%-15s %-35s NAME %s", "attributeType:", oid, buff);
+            ldaputils_sink_printf(cnf->out, "%-15s %-35s NAME %s", "attributeType:", oid, buff);
          ldapschema_memfree(oid);
          ldapschema_memfree(names);
          if ( ((syntax)) && (!(cnf->noextra)) )
          {
             ldapschema_get_info_ldapsyntax(cnf->lsd, syntax, LDAPSCHEMA_FLD_DESC, &desc);
-            printf("   [ %s ]", desc);
+            ldaputils_sink_printf(cnf->out, "   [ %s ]", desc);
             ldapschema_memfree(desc);
          };
-         printf("\n");
+         ldaputils_sink_printf(cnf->out, "\n");
          attr = ldapschema_next_attributetype(cnf->lsd, cur);
       };
       ldapschema_curfree(cur);
@@ -688,10 +718,10 @@ int my_run_list(MyConfig * cnf)
       {
          ldapschema_get_info_objectclass(cnf->lsd, objcls, LDAPSCHEMA_FLD_OID,  &oid);
          ldapschema_get_info_objectclass(cnf->lsd, objcls, LDAPSCHEMA_FLD_NAME, &names);
-         printf("%-15s %-35s NAME ( %s", "objectClass:", oid, names[0]);
+         ldaputils_sink_printf(cnf->out, "%-15s %-35s NAME ( %s", "objectClass:", oid, names[0]);
          for(idx = 1; ((names[idx])); idx++)
-            printf(" $ %s", names[idx]);
-         printf(" )\n");
+            ldaputils_sink_printf(cnf->out, " $ %s", names[idx]);
+         ldaputils_sink_printf(cnf->out, " )\n");
          ldapschema_memfree(oid);
          ldapschema_memfree(names);
          objcls = ldapschema_next_objectclass(cnf->lsd, cur);
@@ -717,6 +747,9 @@ void my_unbind(MyConfig * cnf)
    if ((cnf->args))
       free(cnf->args);
 
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
    free(cnf);
 
    return;
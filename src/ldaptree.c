@@ -60,6 +60,7 @@
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -86,7 +87,7 @@
 #define PROGRAM_NAME "ldaptree"
 #endif
 
-#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "87:6:5:4:3"
+#define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "987:6:5:4:3o:0:"
 
 
 /////////////////
@@ -106,6 +107,9 @@ struct my_config
    int                  copy_entry;
    int                  pad0;
    char               * basedn;
+   const char         * countattr;
+   LDAPUtilsSink      * out;
+   const char         * compress;
    LDAPUtilsTreeOpts    treeopts;
 };
 
@@ -152,6 +156,10 @@ void ldaputils_usage(void)
    printf("  --style=format            output format of bullets or hierarchy (default: hierarchy)\n");
    printf("  --compact                 remove white space used for styling\n");
    printf("  --expand                  expand DN prefix\n");
+   printf("  --threads=num             number of threads used to render tree (default: number of CPUs)\n");
+   printf("  --subordinates[=attr]     display number of subordinates of collapsed branches\n");
+   printf("                            (default attribute: %s)\n", LDAPUTILS_TREE_SUBORDINATES);
+   printf("  --compress=type[:level]   compress output using gzip or zstd\n");
    printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
    return;
 }
@@ -194,7 +202,7 @@ int main(int argc, char * argv[])
    };
 
    // retrieve entries
-   if ((tree = ldaputils_get_tree(cnf->lud->ld, res, cnf->copy_entry)) == NULL)
+   if ((tree = ldaputils_get_tree(cnf->lud->ld, res, cnf->copy_entry, cnf->countattr)) == NULL)
    {
       fprintf(stderr, "%s: ldaputils_get_entries(): out of virtual memory\n", cnf->lud->prog_name);
       my_unbind(cnf);
@@ -206,29 +214,35 @@ int main(int argc, char * argv[])
    // print header
    if (cnf->lud->silent < 2)
    {
-      printf("#\n");
+      ldaputils_sink_printf(cnf->out, "#\n");
       ldap_get_option(cnf->lud->ld, LDAP_OPT_DEFBASE, &str);
       switch(cnf->lud->scope)
       {
-         case LDAP_SCOPE_ONE:      printf("# base: %s with scope one\n", str); break;
-         case LDAP_SCOPE_SUBTREE:  printf("# base: %s with scope subtree\n", str); break;
-         case LDAP_SCOPE_BASE:     printf("# base: %s with scope base\n", str); break;
-         case LDAP_SCOPE_CHILDREN: printf("# base: %s with scope children\n", str); break;
-         default:                  printf("# base: %s\n", str); break;
+         case LDAP_SCOPE_ONE:      ldaputils_sink_printf(cnf->out, "# base: %s with scope one\n", str); break;
+         case LDAP_SCOPE_SUBTREE:  ldaputils_sink_printf(cnf->out, "# base: %s with scope subtree\n", str); break;
+         case LDAP_SCOPE_BASE:     ldaputils_sink_printf(cnf->out, "# base: %s with scope base\n", str); break;
+         case LDAP_SCOPE_CHILDREN: ldaputils_sink_printf(cnf->out, "# base: %s with scope children\n", str); break;
+         default:                  ldaputils_sink_printf(cnf->out, "# base: %s\n", str); break;
       };
-      printf("# filter: %s\n", cnf->lud->filter);
+      ldaputils_sink_printf(cnf->out, "# filter: %s\n", cnf->lud->filter);
       if ( ((cnf->lud->attrs)) && ((cnf->copy_entry)) )
       {
-         printf("# requesting:");
+         ldaputils_sink_printf(cnf->out, "# requesting:");
          for(i = 0; ((cnf->lud->attrs[i])); i++)
-            printf(" %s", cnf->lud->attrs[i]);
-         printf("\n");
+            ldaputils_sink_printf(cnf->out, " %s", cnf->lud->attrs[i]);
+         ldaputils_sink_printf(cnf->out, "\n");
       };
-      printf("#\n");
+      ldaputils_sink_printf(cnf->out, "#\n");
    };
 
    // displays entries
-   ldaputils_tree_print(tree, &cnf->treeopts);
+   if ( (ldaputils_tree_print(tree, &cnf->treeopts, cnf->out) == -1) || (ldaputils_sink_flush(cnf->out) == -1) )
+   {
+      fprintf(stderr, "%s: ldaputils_tree_print(): %s\n", cnf->lud->prog_name, strerror(errno));
+      ldaputils_tree_free(tree);
+      my_unbind(cnf);
+      return(1);
+   };
 
    // frees resources
    ldaputils_tree_free(tree);
@@ -264,6 +278,9 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       {"maxdepth",      required_argument, 0, '7'},
       {"no-leafs",      no_argument,       0, '8'},
       {"noleafs",       no_argument,       0, '8'},
+      {"subordinates",  optional_argument, 0, '9'},
+      {"threads",       required_argument, 0, '1'},
+      {"compress",      required_argument, 0, '0'},
       {"help",          no_argument,       0, 'h'},
       {"verbose",       no_argument,       0, 'v'},
       {"version",       no_argument,       0, 'V'},
@@ -310,6 +327,14 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          my_unbind(cnf);
          return(1);
 
+         case '0':
+         cnf->compress = optarg;
+         break;
+
+         case '1':
+         cnf->treeopts.threads = (size_t)atoll(optarg);
+         break;
+
          case '2':
          cnf->treeopts.expandall = 1;
          break;
@@ -350,6 +375,11 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
          cnf->treeopts.noleaf = 1;
          break;
 
+         case '9':
+         cnf->treeopts.subordinates = 1;
+         cnf->countattr = ((optarg)) ? optarg : LDAPUTILS_TREE_SUBORDINATES;
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -380,7 +410,7 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
    if (argc > optind)
    {
       cnf->copy_entry = 1;
-      if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * (size_t)(argc-optind+1))))
+      if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * (size_t)(argc-optind+2))))
       {
          fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
          my_unbind(cnf);
@@ -388,7 +418,18 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       };
       for(c = 0; c < (argc-optind); c++)
          cnf->lud->attrs[c] = argv[optind+c];
+      if ((cnf->countattr))
+         cnf->lud->attrs[c++] = (char *)cnf->countattr;
       cnf->lud->attrs[c] = NULL;
+   } else if ((cnf->countattr)) {
+      if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * 2)))
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+      cnf->lud->attrs[0] = (char *)cnf->countattr;
+      cnf->lud->attrs[1] = NULL;
    } else {
       if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * 2)))
       {
@@ -413,6 +454,20 @@ int my_config(int argc, char * argv[], MyConfig ** cnfp)
       return(1);
    };
 
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->lud->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->lud->prog_name, ((cnf->lud->output)) ? cnf->lud->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+   if ( ((cnf->compress)) && (ldaputils_sink_compress(cnf->out, cnf->compress, cnf->treeopts.threads) == -1) )
+   {
+      fprintf(stderr, "%s: --compress=%s: %s\n", cnf->lud->prog_name, cnf->compress, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
    *cnfp = cnf;
 
    return(0);
@@ -427,6 +482,9 @@ void my_unbind(MyConfig * cnf)
    if ((cnf->lud))
       ldaputils_unbind(cnf->lud);
 
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
    free(cnf);
 
    return;
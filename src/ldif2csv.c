@@ -0,0 +1,714 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldif2csv.c convert LDIF file to CSV file
+ */
+/*
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldif2csv" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldif2csv.c
+ *     gcc ${CFLAGS} -lldap -o ldif2csv ldif2csv.o ../lib/libldaputils.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldif2csv" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldif2csv.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -o ldif2csv \
+ *             ldif2csv.lo ../lib/libldaputils.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldif2csv.lo ldif2csv
+ */
+#define _LDAP_UTILS_SRC_LDIF2CSV 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <assert.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldif2csv"
+#endif
+
+#define MY_SHORT_OPTIONS "f:ho:vV98:7:6:"
+
+// column types
+#define MY_COL_ATTR     0                  // attribute values
+#define MY_COL_DN       LDAPUTILS_DN_DN    // entry's DN
+#define MY_COL_RDN      LDAPUTILS_DN_RDN   // entry's relative DN
+#define MY_COL_UFN      LDAPUTILS_DN_UFN   // entry's User Friendly Name
+#define MY_COL_ADC      LDAPUTILS_DN_ADC   // entry's Active Directory canonical name
+#define MY_COL_DCE      LDAPUTILS_DN_DCE   // entry's DN in DCE-style
+#define MY_COL_MAX      6
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+/* output column */
+typedef struct my_column MyColumn;
+struct my_column
+{
+   const char      * name;
+   size_t            name_len;
+   int               type;         // column type
+   int               head;         // first column of same attribute
+};
+
+
+/* configuration union */
+typedef struct my_config MyConfig;
+struct my_config
+{
+   const char      * prog_name;
+   const char      * file;         // LDIF file to convert
+   const char      * output;       // CSV file to write
+   char           ** attrs;        // requested attributes
+   const char     ** defvals;
+   LDAPUtilsLDIF   * ldif;
+   LDAPUtilsSink   * out;
+   LDAPUtilsPipeline * pipe;
+   const char      * compress;     // output compression algorithm and level
+   size_t            threads;      // number of parsing, formatting, and compression threads
+   int               verbose;
+   int               flags;        // CSV encoding flags
+   int               separator;    // multi-value separator
+   int               pad0;
+   MyColumn        * cols;         // output columns
+   size_t            cols_len;
+   int             * hash;         // attribute name to column index
+   size_t            hash_mask;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// finds column of attribute
+int my_column(void * ctx, const struct berval * attr);
+
+// builds column map
+int my_columns(MyConfig * cnf);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// appends DN transform of entry as CSV field
+int my_dnstr(MyConfig * cnf, const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out);
+
+// calculates case-insensitive hash of attribute name
+size_t my_hash(const char * name, size_t len);
+
+// formats entry
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] attributes[:values]...\n", PROGRAM_NAME);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("  -f file, --file=file      read entries from LDIF file (default: stdin)\n");
+   printf("Special Attributes:\n");
+   printf("  dn                        entry's DN\n");
+   printf("  rdn                       entry's relative DN\n");
+   printf("  ufn                       entry's User Friendly Name\n");
+   printf("  adc                       entry's Active Directory canonical name\n");
+   printf("  dce                       entry's DN in DCE-style\n");
+   printf("CSV Options:\n");
+   printf("  --rfc4180                 RFC 4180 quoting of fields\n");
+   printf("  --separator=char          separator between multiple values (default: %c)\n", LDAPUTILS_CSV_SEPARATOR);
+   printf("  --compress=type[:level]   compress output using gzip or zstd\n");
+   printf("  --threads=num             number of threads used to parse entries (default: number of CPUs)\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int                    x;
+   int                    err;
+   MyConfig             * cnf;
+   LDAPUtilsPipelineOpts  opts;
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(1);
+   if (!(cnf))
+      return(0);
+
+   // prints attribute names
+   for(x = 0; ((size_t)x < cnf->cols_len); x++)
+   {
+      ldaputils_sink_puts(cnf->out, ((x)) ? ",\"" : "\"");
+      ldaputils_sink_csv(cnf->out, cnf->attrs[x], strlen(cnf->attrs[x]), '"', cnf->flags);
+      ldaputils_sink_puts(cnf->out, "\"");
+   };
+   ldaputils_sink_puts(cnf->out, ((cnf->flags & LDAPUTILS_CSV_RFC4180)) ? "\r\n" : "\n");
+
+   // starts threads which parse and format entries and write output in order
+   memset(&opts, 0, sizeof(opts));
+   opts.threads = cnf->threads;
+   opts.columns = cnf->cols_len;
+   opts.ctx     = cnf;
+   opts.column  = my_column;
+   opts.format  = my_row;
+   if (ldaputils_pipeline_initialize(&cnf->pipe, cnf->out, &opts) == -1)
+   {
+      fprintf(stderr, "%s: ldaputils_pipeline_initialize(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // queues chunks of LDIF file, the file remains mapped until the pipeline finishes
+   if ((err = ldaputils_pipeline_ldif(cnf->pipe, cnf->ldif)) == LDAP_SUCCESS)
+      err = ldaputils_pipeline_finish(cnf->pipe);
+   else
+      ldaputils_pipeline_finish(cnf->pipe);
+   switch(err)
+   {
+      case LDAP_SUCCESS:
+      break;
+
+      case LDAP_OTHER:
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+
+      case LDAP_DECODING_ERROR:
+      case LDAP_NOT_SUPPORTED:
+      case LDAP_UNWILLING_TO_PERFORM:
+      fprintf(stderr, "%s: %s: offset %zu: %s\n", cnf->prog_name, ((cnf->file)) ? cnf->file : "stdin", ldaputils_pipeline_offset(cnf->pipe), ldaputils_ldif_err2string(err));
+      my_unbind(cnf);
+      return(1);
+
+      default:
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   my_unbind(cnf);
+
+   return(0);
+}
+
+
+/// finds column of attribute
+/// @param[in] ctx    reference to configuration
+/// @param[in] attr   attribute description from LDIF record
+int my_column(void * ctx, const struct berval * attr)
+{
+   size_t     idx;
+   int        x;
+   MyColumn * col;
+   MyConfig * cnf;
+
+   cnf = ctx;
+
+   for(idx = my_hash(attr->bv_val, attr->bv_len) & cnf->hash_mask; ((x = cnf->hash[idx]) != -1); idx = (idx+1) & cnf->hash_mask)
+   {
+      col = &cnf->cols[x];
+      if ( (col->name_len == attr->bv_len) && (strncasecmp(col->name, attr->bv_val, attr->bv_len) == 0) )
+         return(x);
+   };
+
+   return(-1);
+}
+
+
+/// builds column map
+/// @param[in] cnf    reference to configuration
+int my_columns(MyConfig * cnf)
+{
+   size_t          x;
+   size_t          y;
+   size_t          idx;
+   size_t          size;
+   MyColumn      * col;
+   struct berval   attr;
+
+   static const char * names[MY_COL_MAX] = { NULL, "dn", "rdn", "ufn", "adc", "dce" };
+
+   for(cnf->cols_len = 0; ((cnf->attrs[cnf->cols_len])); cnf->cols_len++);
+   for(size = 16; (size < (cnf->cols_len * 2)); size <<= 1);
+
+   if ((cnf->cols = calloc(cnf->cols_len+1, sizeof(MyColumn))) == NULL)
+      return(-1);
+   if ((cnf->hash = malloc(sizeof(int) * size)) == NULL)
+      return(-1);
+   for(idx = 0; (idx < size); idx++)
+      cnf->hash[idx] = -1;
+   cnf->hash_mask = size - 1;
+
+   for(x = 0; (x < cnf->cols_len); x++)
+   {
+      col           = &cnf->cols[x];
+      col->name     = cnf->attrs[x];
+      col->name_len = strlen(col->name);
+      col->head     = (int)x;
+
+      // special attributes derived from the DN
+      for(y = 1; (y < MY_COL_MAX); y++)
+         if (strcasecmp(names[y], col->name) == 0)
+            col->type = (int)y;
+      if (col->type != MY_COL_ATTR)
+         continue;
+
+      // attribute requested more than once shares the first column's values
+      attr.bv_val = (char *)col->name;
+      attr.bv_len = col->name_len;
+      if ((col->head = my_column(cnf, &attr)) != -1)
+         continue;
+      col->head = (int)x;
+
+      for(idx = my_hash(col->name, col->name_len) & cnf->hash_mask; (cnf->hash[idx] != -1); idx = (idx+1) & cnf->hash_mask);
+      cnf->hash[idx] = (int)x;
+   };
+
+   return(0);
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int        c;
+   int        option_index;
+   char     * str;
+   MyConfig * cnf;
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"file",          required_argument, 0, 'f'},
+      {"rfc4180",       no_argument,       0, '9'},
+      {"separator",     required_argument, 0, '8'},
+      {"compress",      required_argument, 0, '7'},
+      {"threads",       required_argument, 0, '6'},
+      {NULL,            0,                 0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+   cnf->prog_name = PROGRAM_NAME;
+   cnf->separator = LDAPUTILS_CSV_SEPARATOR;
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(c)
+      {
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         case 'f':
+         cnf->file = optarg;
+         break;
+
+         case 'h':
+         ldaputils_usage();
+         my_unbind(cnf);
+         return(0);
+
+         case 'o':
+         cnf->output = optarg;
+         break;
+
+         case 'v':
+         cnf->verbose++;
+         break;
+
+         case 'V':
+         ldaputils_version(PROGRAM_NAME);
+         my_unbind(cnf);
+         return(0);
+
+         case '9':
+         cnf->flags |= LDAPUTILS_CSV_RFC4180;
+         break;
+
+         case '8':
+         if ( (strlen(optarg) != 1) || (optarg[0] == '"') )
+         {
+            fprintf(stderr, "%s: separator must be a single character other than quote\n", PROGRAM_NAME);
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->separator = optarg[0];
+         break;
+
+         case '7':
+         cnf->compress = optarg;
+         break;
+
+         case '6':
+         cnf->threads = (size_t)atoll(optarg);
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // checks for required arguments
+   if (argc < (optind+1))
+   {
+      fprintf(stderr, "%s: missing required arguments\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // configures attributes to convert into columns
+   if (!(cnf->attrs = (char **) malloc(sizeof(char *) * (size_t)(argc-optind+1))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   if (!(cnf->defvals = (const char **) malloc(sizeof(char *) * (size_t)(argc-optind+1))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   for(c = 0; c < (argc-optind); c++)
+   {
+      cnf->attrs[c]   = argv[optind+c];
+      cnf->defvals[c] = "";
+      if ((str = index(argv[optind+c], ':')) != NULL)
+      {
+         str[0] = '\0';
+         cnf->defvals[c] = &str[1];
+      };
+   };
+   cnf->attrs[c]   = NULL;
+   cnf->defvals[c] = NULL;
+
+   // maps attribute names to columns
+   if (my_columns(cnf) == -1)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens input
+   if (ldaputils_ldif_open(&cnf->ldif, cnf->file) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->file)) ? cnf->file : "stdin", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->output)) ? cnf->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+   if ( ((cnf->compress)) && (ldaputils_sink_compress(cnf->out, cnf->compress, cnf->threads) == -1) )
+   {
+      fprintf(stderr, "%s: --compress=%s: %s\n", cnf->prog_name, cnf->compress, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// appends DN transform of entry as CSV field
+/// @param[in] cnf     reference to configuration
+/// @param[in] dn      parsed DN of entry
+/// @param[in] type    column type
+/// @param[in] out     formatted output of batch
+int my_dnstr(MyConfig * cnf, const LDAPUtilsDN * dn, int type, LDAPUtilsSink * out)
+{
+   int      rc;
+   size_t   len;
+   char   * str;
+   char     buff[LDAPUTILS_BUFF_LEN];
+
+   if ((len = ldaputils_dn_format(dn, type, buff, sizeof(buff))) < sizeof(buff))
+      return(ldaputils_sink_csv(out, buff, len, '"', cnf->flags));
+
+   // DN exceeds stack buffer
+   if ((str = malloc(len+1)) == NULL)
+      return(-1);
+   ldaputils_dn_format(dn, type, str, len+1);
+   rc = ldaputils_sink_csv(out, str, len, '"', cnf->flags);
+   free(str);
+
+   return(rc);
+}
+
+
+/// calculates case-insensitive hash of attribute name
+/// @param[in] name   attribute name
+/// @param[in] len    length of attribute name
+size_t my_hash(const char * name, size_t len)
+{
+   size_t     x;
+   uint64_t   hash;
+
+   hash = 14695981039346656037ULL;
+   for(x = 0; (x < len); x++)
+   {
+      hash ^= (unsigned char)tolower((unsigned char)name[x]);
+      hash *= 1099511628211ULL;
+   };
+
+   return((size_t)(hash ^ (hash >> 32)));
+}
+
+
+/// formats entry, called by pipeline threads
+/// @param[in] ctx    reference to configuration
+/// @param[in] row    parsed record with attributes mapped onto columns
+/// @param[in] out    formatted output of batch
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out)
+{
+   int                      x;
+   size_t                   y;
+   int                      rc;
+   int                      parsed;
+   char                     sep;
+   MyConfig               * cnf;
+   MyColumn               * col;
+   const LDAPUtilsRowAttr * attr;
+   LDAPUtilsDN              dn;
+
+   cnf    = ctx;
+   sep    = (char)cnf->separator;
+   rc     = LDAP_SUCCESS;
+   parsed = 0;
+
+   // prints columns
+   ldaputils_sink_puts(out, "\"");
+   for(x = 0; ( (x < (int)cnf->cols_len) && (rc == LDAP_SUCCESS) ); x++)
+   {
+      col = &cnf->cols[x];
+
+      // print delimiter
+      if (x > 0)
+         ldaputils_sink_puts(out, "\",\"");
+
+      switch(col->type)
+      {
+         case MY_COL_ATTR:
+         attr = &row->attrs[col->head];
+         if (!(attr->vals_len))
+         {
+            ldaputils_sink_csv(out, cnf->defvals[x], strlen(cnf->defvals[x]), '"', cnf->flags);
+            break;
+         };
+         for(y = 0; (y < attr->vals_len); y++)
+         {
+            if (y > 0)
+               ldaputils_sink_write(out, &sep, 1);
+            ldaputils_sink_csv(out, attr->vals[y].bv_val, attr->vals[y].bv_len, sep, cnf->flags);
+         };
+         break;
+
+         case MY_COL_DN:
+         ldaputils_sink_csv(out, row->dn.bv_val, row->dn.bv_len, '"', cnf->flags);
+         break;
+
+         default:
+         // DN is parsed once for all columns derived from it, columns of a
+         // DN which cannot be parsed repeat the DN as received
+         if (!(parsed))
+         {
+            parsed = (ldaputils_dn_parse(&dn, row->dn.bv_val, row->dn.bv_len) == 0) ? 1 : -1;
+            if ( (parsed == -1) && (errno == ENOMEM) )
+            {
+               fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+               rc = LDAP_NO_MEMORY;
+               break;
+            };
+         };
+         if (parsed == -1)
+         {
+            ldaputils_sink_csv(out, row->dn.bv_val, row->dn.bv_len, '"', cnf->flags);
+            break;
+         };
+         if (my_dnstr(cnf, &dn, col->type, out) == -1)
+         {
+            fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+            rc = LDAP_NO_MEMORY;
+         };
+         break;
+      };
+   };
+   ldaputils_sink_puts(out, ((cnf->flags & LDAPUTILS_CSV_RFC4180)) ? "\"\r\n" : "\"\n");
+   if (parsed == 1)
+      ldaputils_dn_free(&dn);
+
+   return(rc);
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   assert(cnf != NULL);
+
+   if ((cnf->attrs))
+      free(cnf->attrs);
+
+   if ((cnf->defvals))
+      free(cnf->defvals);
+
+   // pipeline references the LDIF data until it is freed
+   if ((cnf->pipe))
+      ldaputils_pipeline_free(cnf->pipe);
+
+   if ((cnf->ldif))
+      ldaputils_ldif_close(cnf->ldif);
+
+   if ((cnf->cols))
+      free(cnf->cols);
+
+   if ((cnf->hash))
+      free(cnf->hash);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   free(cnf);
+
+   return;
+}
+
+/* end of source file */
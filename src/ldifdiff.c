@@ -0,0 +1,1110 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldifdiff.c compares two LDIF files and prints LDIF change records
+ */
+/*
+ *  Both files are partitioned by a hash of the normalized DN of each record,
+ *  which places the old and new versions of an entry in the same bucket.
+ *  Files which fit within the memory budget are partitioned in memory into
+ *  several buckets per thread.
+ *  Larger files are written to one temporary file per bucket and file.
+ *  Worker threads compare the buckets independently.  Records which are
+ *  identical byte for byte are skipped without being decoded.  Other records
+ *  are decoded and each attribute is summarized by the sum of the hashes of
+ *  its values, so values are only compared for attributes whose sums differ.
+ *  Each bucket sorts its change records and the buckets are then merged.
+ *  The output deletes children before their parents, then adds parents
+ *  before their children.
+ *
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldifdiff" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldifdiff.c
+ *     gcc ${CFLAGS} -lldap -lpthread -o ldifdiff ldifdiff.o ../lib/libldaputils.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldifdiff" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldifdiff.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -lpthread -o ldifdiff \
+ *             ldifdiff.lo ../lib/libldaputils.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldifdiff.lo ldifdiff
+ */
+#define _LDAP_UTILS_SRC_LDIFDIFF 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldifdiff"
+#endif
+
+#define MY_SHORT_OPTIONS "ho:vV9:8:7:"
+
+#define MY_MEMORY        (256 * 1024 * 1024)   // default memory used to compare records
+#define MY_MEMORY_MIN    (1024 * 1024)
+#define MY_CHUNK_LEN     (16 * 1024 * 1024)    // bytes of LDIF scanned for records at once
+#define MY_FILE_BUFF_LEN (64 * 1024)           // stdio buffer of each temporary file
+#define MY_BUCKETS_MAX   256
+#define MY_BUCKETS_SPLIT 8                     // buckets per thread when comparing in memory
+#define MY_THREADS_MAX   256
+#define MY_OVERHEAD      3                     // memory used per byte of compared records
+
+#define MY_OLD           0
+#define MY_NEW           1
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+/* record of input */
+typedef struct my_entry MyEntry;
+struct my_entry
+{
+   uint64_t          hash;         // hash of normalized DN, high bits select bucket
+   const char      * key;          // normalized DN
+   size_t            key_off;      // offset of normalized DN while keys are appended
+   size_t            key_len;
+   const char      * rec;          // original bytes of record
+   size_t            rec_len;
+   size_t            bucket;
+   int               matched;      // old record has a new record with the same DN
+   int               pad0;
+};
+
+
+/* sorted change records of bucket */
+typedef struct my_result MyResult;
+struct my_result
+{
+   FILE            * fp;           // temporary file, or NULL if kept in memory
+   LDAPUtilsSortBuff recs;         // sort keys and change records
+};
+
+
+/* records of one file within a bucket */
+typedef struct my_bucket MyBucket;
+struct my_bucket
+{
+   MyEntry         * ents;
+   size_t            ents_len;
+   MyEntry         * store;        // records read from temporary file
+   size_t            store_size;
+   char            * data;         // contents of temporary file
+   size_t            data_size;
+   size_t          * table;        // one based indexes of records by hash of DN
+   size_t            table_size;
+};
+
+
+/* input file */
+typedef struct my_side MySide;
+struct my_side
+{
+   struct my_config * cnf;
+   const char      * file;
+   LDAPUtilsLDIF   * ldif;
+   FILE           ** fps;          // temporary file of each bucket
+   MyEntry         * ents;         // records when partitioned in memory
+   size_t            ents_len;
+   size_t            ents_size;
+   size_t          * starts;       // first record of each bucket when partitioned in memory
+   char            * keys;         // normalized DNs of records
+   size_t            keys_len;
+   size_t            keys_size;
+   char            * buff;         // decoded DN of current record
+   size_t            buff_size;
+   size_t            off;          // offset of record which could not be read
+   int               err;
+   int               errnum;
+};
+
+
+/* state of thread which compares buckets */
+typedef struct my_work MyWork;
+struct my_work
+{
+   struct my_config * cnf;
+   MyBucket          buckets[2];
+   LDAPUtilsDiffEntry parsed[2];
+   pthread_t         thread;
+   int               side;         // file of record which could not be decoded
+   int               pad0;
+};
+
+
+/* configuration union */
+typedef struct my_config MyConfig;
+struct my_config
+{
+   const char      * prog_name;
+   const char      * output;       // -o output file
+   const char      * tmpdir;       // directory of temporary files
+   size_t            memory;       // memory used to compare records
+   size_t            threads;      // number of threads which compare buckets
+   size_t            buckets;
+   int               verbose;
+   int               disk;         // buckets are stored in temporary files
+   MySide            sides[2];
+   MyWork          * works;
+   MyResult        * results;
+   LDAPUtilsSink   * out;
+   atomic_size_t     next;         // next bucket to compare
+   atomic_size_t     changes;      // number of change records
+   atomic_int        err;          // result code of first bucket which failed
+   int               errnum;
+   int               errside;
+   int               pad0;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// appends change record which deletes or adds an entry
+int my_change(MyWork * work, MyResult * res, const MyEntry * ent, int side);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// compares one bucket of both files
+int my_diff(MyWork * work, size_t idx);
+
+// renders normalized DN of record
+int my_dnkey(MySide * side, const struct berval * rec, size_t * lenp);
+
+// loads one file of bucket
+int my_load(MyWork * work, int side, size_t idx);
+
+// merges sorted change records of all buckets into output
+int my_merge(MyConfig * cnf);
+
+// partitions file by normalized DN, called by partition threads
+void * my_partition(void * ptr);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+// compares buckets, called by worker threads
+void * my_worker(void * ptr);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] oldfile newfile\n", PROGRAM_NAME);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Diff Options:\n");
+   printf("  --memory=size             memory used to compare records (default: %iM)\n", (MY_MEMORY / 1024 / 1024));
+   printf("  --threads=num             number of threads used to compare records (default: number of CPUs)\n");
+   printf("  --tmpdir=dir              directory for temporary files (default: $TMPDIR or /tmp)\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int              x;
+   int              err;
+   size_t           y;
+   size_t           started;
+   MySide         * side;
+   MyConfig       * cnf;
+   pthread_t        threads[2];
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(2);
+   if (!(cnf))
+      return(0);
+
+   // partitions both files concurrently
+   for(x = 0; (x < 2); x++)
+   {
+      if ((err = pthread_create(&threads[x], NULL, my_partition, &cnf->sides[x])) != 0)
+      {
+         fprintf(stderr, "%s: pthread_create(): %s\n", cnf->prog_name, strerror(err));
+         for(; (x > 0); x--)
+            pthread_join(threads[x-1], NULL);
+         my_unbind(cnf);
+         return(2);
+      };
+   };
+   for(x = 0; (x < 2); x++)
+      pthread_join(threads[x], NULL);
+   for(x = 0; (x < 2); x++)
+   {
+      side = &cnf->sides[x];
+      if (side->err == LDAP_SUCCESS)
+         continue;
+      if (side->err == LDAP_OTHER)
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(side->errnum));
+      else if (side->err == LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      else
+         fprintf(stderr, "%s: %s: offset %zu: %s\n", cnf->prog_name, side->file, side->off, ldaputils_ldif_err2string(side->err));
+      my_unbind(cnf);
+      return(2);
+   };
+   if ((cnf->verbose))
+      fprintf(stderr, "%s: comparing %zu buckets %s with %zu threads\n", cnf->prog_name, cnf->buckets, ((cnf->disk)) ? "stored in temporary files" : "in memory", cnf->threads);
+
+   // compares buckets
+   for(started = 0; (started < cnf->threads); started++)
+   {
+      if ((err = pthread_create(&cnf->works[started].thread, NULL, my_worker, &cnf->works[started])) != 0)
+      {
+         fprintf(stderr, "%s: pthread_create(): %s\n", cnf->prog_name, strerror(err));
+         atomic_store(&cnf->next, cnf->buckets);
+         break;
+      };
+   };
+   for(y = 0; (y < started); y++)
+      pthread_join(cnf->works[y].thread, NULL);
+   if ( ((err = atomic_load(&cnf->err)) != LDAP_SUCCESS) || (started < cnf->threads) )
+   {
+      if (err == LDAP_OTHER)
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(cnf->errnum));
+      else if (err == LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      else if (err != LDAP_SUCCESS)
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->sides[cnf->errside].file, ldaputils_ldif_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // writes change records in order
+   if ( (my_merge(cnf) == -1) || (ldaputils_sink_flush(cnf->out) == -1) )
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // exit status matches diff(1)
+   x = ((atomic_load(&cnf->changes))) ? 1 : 0;
+
+   my_unbind(cnf);
+
+   return(x);
+}
+
+
+/// appends change record which deletes or adds an entry
+/// @param[in] work    state of thread
+/// @param[in] res     change records of bucket
+/// @param[in] ent     record of entry
+/// @param[in] side    MY_OLD to delete entry, MY_NEW to add entry
+int my_change(MyWork * work, MyResult * res, const MyEntry * ent, int side)
+{
+   int                   err;
+   LDAPUtilsDiffEntry  * parsed;
+
+   parsed = &work->parsed[side];
+   if ((err = ldaputils_diff_parse(parsed, ent->rec, ent->rec_len)) != LDAP_SUCCESS)
+      return(err);
+
+   if (side == MY_OLD)
+      return(ldaputils_diff_delete(&res->recs, parsed, ent->key, ent->key_len));
+   return(ldaputils_diff_add(&res->recs, parsed, ent->key, ent->key_len));
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int        c;
+   int        x;
+   int        option_index;
+   size_t     y;
+   size_t     total;
+   long       cpus;
+   MyConfig * cnf;
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"tmpdir",        required_argument, 0, '9'},
+      {"memory",        required_argument, 0, '8'},
+      {"threads",       required_argument, 0, '7'},
+      {NULL,            0,                 0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+   cnf->prog_name = PROGRAM_NAME;
+   cnf->memory    = MY_MEMORY;
+   if ((cnf->tmpdir = getenv("TMPDIR")) == NULL)
+      cnf->tmpdir = "/tmp";
+   atomic_init(&cnf->next,    0);
+   atomic_init(&cnf->changes, 0);
+   atomic_init(&cnf->err,     LDAP_SUCCESS);
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(c)
+      {
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         case 'h':
+         ldaputils_usage();
+         my_unbind(cnf);
+         return(0);
+
+         case 'o':
+         cnf->output = optarg;
+         break;
+
+         case 'v':
+         cnf->verbose++;
+         break;
+
+         case 'V':
+         ldaputils_version(PROGRAM_NAME);
+         my_unbind(cnf);
+         return(0);
+
+         case '9':
+         cnf->tmpdir = optarg;
+         break;
+
+         case '8':
+         if ( (ldaputils_sort_size(optarg, &cnf->memory) == -1) || (cnf->memory < MY_MEMORY_MIN) )
+         {
+            fprintf(stderr, "%s: invalid memory size `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         case '7':
+         if ( (ldaputils_sort_size(optarg, &cnf->threads) == -1) || (!(cnf->threads)) || (cnf->threads > MY_THREADS_MAX) )
+         {
+            fprintf(stderr, "%s: invalid number of threads `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // checks for required arguments
+   if ((argc - optind) != 2)
+   {
+      fprintf(stderr, "%s: %s\n", PROGRAM_NAME, ((argc - optind) < 2) ? "missing required arguments" : "too many arguments");
+      fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+      my_unbind(cnf);
+      return(1);
+   };
+   if ( (!(strcmp(argv[optind], "-"))) && (!(strcmp(argv[optind+1], "-"))) )
+   {
+      fprintf(stderr, "%s: only one file may be read from stdin\n", PROGRAM_NAME);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens input
+   for(x = 0, total = 0; (x < 2); x++)
+   {
+      cnf->sides[x].cnf  = cnf;
+      cnf->sides[x].file = argv[optind+x];
+      if (ldaputils_ldif_open(&cnf->sides[x].ldif, cnf->sides[x].file) == -1)
+      {
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->sides[x].file, strerror(errno));
+         my_unbind(cnf);
+         return(1);
+      };
+      total += ldaputils_ldif_size(cnf->sides[x].ldif);
+   };
+
+   // determines number of threads
+   if (!(cnf->threads))
+   {
+      cpus         = sysconf(_SC_NPROCESSORS_ONLN);
+      cnf->threads = (cpus < 1) ? 1 : (cpus > MY_THREADS_MAX) ? MY_THREADS_MAX : (size_t)cpus;
+   };
+
+   // each thread compares one bucket at a time within its share of memory,
+   // several buckets per thread keep threads busy when buckets are uneven
+   cnf->buckets = cnf->threads * MY_BUCKETS_SPLIT;
+   cnf->buckets = (cnf->buckets > MY_BUCKETS_MAX) ? MY_BUCKETS_MAX : cnf->buckets;
+   if ((total * MY_OVERHEAD) > cnf->memory)
+   {
+      cnf->disk    = 1;
+      cnf->buckets = ((total * MY_OVERHEAD) / (cnf->memory / cnf->threads)) + 1;
+      cnf->buckets = (cnf->buckets < cnf->threads)  ? cnf->threads   : cnf->buckets;
+      cnf->buckets = (cnf->buckets > MY_BUCKETS_MAX) ? MY_BUCKETS_MAX : cnf->buckets;
+   };
+
+   // allocates buckets
+   if ( ((cnf->works = calloc(cnf->threads, sizeof(MyWork))) == NULL) || ((cnf->results = calloc(cnf->buckets, sizeof(MyResult))) == NULL) )
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   for(y = 0; (y < cnf->threads); y++)
+      cnf->works[y].cnf = cnf;
+   for(x = 0; ( ((cnf->disk)) && (x < 2) ); x++)
+   {
+      if ((cnf->sides[x].fps = calloc(cnf->buckets, sizeof(FILE *))) == NULL)
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+         my_unbind(cnf);
+         return(1);
+      };
+      for(y = 0; (y < cnf->buckets); y++)
+      {
+         if ((cnf->sides[x].fps[y] = ldaputils_sort_temp(cnf->tmpdir, PROGRAM_NAME, MY_FILE_BUFF_LEN)) == NULL)
+         {
+            fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(errno));
+            my_unbind(cnf);
+            return(1);
+         };
+      };
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->output)) ? cnf->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// compares one bucket of both files
+/// @param[in] work    state of thread
+/// @param[in] idx     index of bucket
+int my_diff(MyWork * work, size_t idx)
+{
+   int              err;
+   size_t           x;
+   size_t           y;
+   size_t           mask;
+   FILE           * fp;
+   MyConfig       * cnf;
+   MyResult       * res;
+   MyBucket       * old;
+   MyBucket       * new;
+   MyEntry        * ent;
+   MyEntry        * match;
+   void           * ptr;
+
+   cnf        = work->cnf;
+   res        = &cnf->results[idx];
+   old        = &work->buckets[MY_OLD];
+   new        = &work->buckets[MY_NEW];
+   work->side = MY_NEW;
+
+   if ((err = my_load(work, MY_OLD, idx)) != LDAP_SUCCESS)
+      return(err);
+   if ((err = my_load(work, MY_NEW, idx)) != LDAP_SUCCESS)
+      return(err);
+
+   // indexes old records by hash of DN using open addressing
+   for(x = 16; (x < (old->ents_len * 2)); x *= 2);
+   if (x > old->table_size)
+   {
+      if ((ptr = realloc(old->table, sizeof(size_t) * x)) == NULL)
+         return(LDAP_NO_MEMORY);
+      old->table      = ptr;
+      old->table_size = x;
+   };
+   mask = x - 1;
+   memset(old->table, 0, sizeof(size_t) * x);
+   for(x = 0; (x < old->ents_len); x++)
+   {
+      for(y = (size_t)old->ents[x].hash & mask; ((old->table[y])); y = (y + 1) & mask);
+      old->table[y] = x + 1;
+   };
+
+   // compares new records with old records of the same DN
+   for(x = 0; (x < new->ents_len); x++)
+   {
+      ent   = &new->ents[x];
+      match = NULL;
+      for(y = (size_t)ent->hash & mask; ((old->table[y])); y = (y + 1) & mask)
+      {
+         match = &old->ents[old->table[y] - 1];
+         if ( (!(match->matched)) && (match->hash == ent->hash) && (match->key_len == ent->key_len) && (!(memcmp(match->key, ent->key, ent->key_len))) )
+            break;
+         match = NULL;
+      };
+      if (!(match))
+      {
+         if ((err = my_change(work, res, ent, MY_NEW)) != LDAP_SUCCESS)
+            return(err);
+         continue;
+      };
+      match->matched = 1;
+      if ( (match->rec_len == ent->rec_len) && (!(memcmp(match->rec, ent->rec, ent->rec_len))) )
+         continue;
+      if ((err = ldaputils_diff_parse(&work->parsed[MY_OLD], match->rec, match->rec_len)) != LDAP_SUCCESS)
+      {
+         work->side = MY_OLD;
+         return(err);
+      };
+      if ((err = ldaputils_diff_parse(&work->parsed[MY_NEW], ent->rec, ent->rec_len)) != LDAP_SUCCESS)
+         return(err);
+      if ((err = ldaputils_diff_modify(&res->recs, &work->parsed[MY_OLD], &work->parsed[MY_NEW], ent->key, ent->key_len)) != LDAP_SUCCESS)
+         return(err);
+   };
+
+   // deletes old records without new records
+   for(x = 0; (x < old->ents_len); x++)
+   {
+      if ((old->ents[x].matched))
+         continue;
+      if ((err = my_change(work, res, &old->ents[x], MY_OLD)) != LDAP_SUCCESS)
+      {
+         work->side = MY_OLD;
+         return(err);
+      };
+   };
+
+   // sorts change records of bucket
+   ldaputils_sort_records(&res->recs);
+   atomic_fetch_add(&cnf->changes, res->recs.items_len);
+   if (!(cnf->disk))
+      return(LDAP_SUCCESS);
+
+   // writes change records to temporary file when buckets do not fit in memory
+   if ((fp = ldaputils_sort_temp(cnf->tmpdir, PROGRAM_NAME, MY_FILE_BUFF_LEN)) == NULL)
+      return(LDAP_OTHER);
+   res->fp = fp;
+   for(x = 0; (x < res->recs.items_len); x++)
+      if (ldaputils_sort_put(fp, &res->recs.items[x]) == -1)
+         return(LDAP_OTHER);
+   if (fflush(fp) == EOF)
+      return(LDAP_OTHER);
+   ldaputils_sort_free(&res->recs);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// renders normalized DN of record after the keys of previous records
+/// @param[in] side    input file
+/// @param[in] rec     LDIF record
+/// @param[out] lenp   length of normalized DN
+int my_dnkey(MySide * side, const struct berval * rec, size_t * lenp)
+{
+   int             err;
+   size_t          len;
+   size_t          size;
+   void          * ptr;
+   struct berval   val;
+   LDAPUtilsDN     dn;
+
+   // values are decoded into a buffer as long as the record
+   if (rec->bv_len >= side->buff_size)
+   {
+      if ((ptr = realloc(side->buff, rec->bv_len + 1)) == NULL)
+         return(LDAP_NO_MEMORY);
+      side->buff      = ptr;
+      side->buff_size = rec->bv_len + 1;
+   };
+
+   if ((err = ldaputils_ldif_value(rec, "dn", side->buff, &val)) != LDAP_SUCCESS)
+      return(err);
+   if (ldaputils_dn_parse(&dn, val.bv_val, val.bv_len) == -1)
+      return(((errno == ENOMEM)) ? LDAP_NO_MEMORY : LDAP_INVALID_DN_SYNTAX);
+
+   len = ldaputils_dn_format(&dn, LDAPUTILS_DN_KEY, NULL, 0);
+   if ((side->keys_len + len) > side->keys_size)
+   {
+      size = (side->keys_size) ? (side->keys_size * 2) : (64 * 1024);
+      while (size < (side->keys_len + len))
+         size *= 2;
+      if ((ptr = realloc(side->keys, size)) == NULL)
+      {
+         ldaputils_dn_free(&dn);
+         return(LDAP_NO_MEMORY);
+      };
+      side->keys      = ptr;
+      side->keys_size = size;
+   };
+   ldaputils_dn_format(&dn, LDAPUTILS_DN_KEY, &side->keys[side->keys_len], len);
+   ldaputils_dn_free(&dn);
+   *lenp = len;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// loads one file of bucket
+/// @param[in] work    state of thread
+/// @param[in] side    MY_OLD or MY_NEW
+/// @param[in] idx     index of bucket
+int my_load(MyWork * work, int side, size_t idx)
+{
+   size_t          pos;
+   size_t          size;
+   size_t          hdr[2];
+   off_t           len;
+   FILE          * fp;
+   void          * ptr;
+   MySide        * src;
+   MyBucket      * bucket;
+   MyEntry       * ent;
+
+   src    = &work->cnf->sides[side];
+   bucket = &work->buckets[side];
+
+   // records partitioned in memory are grouped by bucket
+   if (!(work->cnf->disk))
+   {
+      bucket->ents     = &src->ents[src->starts[idx]];
+      bucket->ents_len = src->starts[idx+1] - src->starts[idx];
+      return(LDAP_SUCCESS);
+   };
+
+   // reads temporary file of bucket
+   fp = src->fps[idx];
+   if ( (fseeko(fp, 0, SEEK_END) == -1) || ((len = ftello(fp)) == -1) )
+      return(LDAP_OTHER);
+   rewind(fp);
+   if ((size_t)len > bucket->data_size)
+   {
+      if ((ptr = realloc(bucket->data, (size_t)len)) == NULL)
+         return(LDAP_NO_MEMORY);
+      bucket->data      = ptr;
+      bucket->data_size = (size_t)len;
+   };
+   if (fread(bucket->data, 1, (size_t)len, fp) != (size_t)len)
+   {
+      if (!(ferror(fp)))
+         errno = EIO;
+      return(LDAP_OTHER);
+   };
+
+   // records are stored as the lengths, normalized DN, and record
+   bucket->ents     = bucket->store;
+   bucket->ents_len = 0;
+   for(pos = 0; ((pos + sizeof(hdr)) <= (size_t)len); pos += hdr[0] + hdr[1])
+   {
+      memcpy(hdr, &bucket->data[pos], sizeof(hdr));
+      pos += sizeof(hdr);
+      if (bucket->ents_len >= bucket->store_size)
+      {
+         size = (bucket->store_size) ? (bucket->store_size * 2) : 1024;
+         if ((ptr = realloc(bucket->store, sizeof(MyEntry) * size)) == NULL)
+            return(LDAP_NO_MEMORY);
+         bucket->store      = ptr;
+         bucket->store_size = size;
+         bucket->ents       = ptr;
+      };
+      ent          = &bucket->ents[bucket->ents_len++];
+      memset(ent, 0, sizeof(MyEntry));
+      ent->key     = &bucket->data[pos];
+      ent->key_len = hdr[0];
+      ent->rec     = &bucket->data[pos + hdr[0]];
+      ent->rec_len = hdr[1];
+      ent->hash    = ldaputils_diff_hash(ent->key, ent->key_len);
+      ent->bucket  = idx;
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// merges sorted change records of all buckets into output
+/// @param[in] cnf     reference to configuration
+int my_merge(MyConfig * cnf)
+{
+   int                         rc;
+   size_t                      x;
+   LDAPUtilsSortRun          * runs;
+   LDAPUtilsSortMerge          merge;
+   const LDAPUtilsSortItem   * item;
+
+   if ((runs = calloc(cnf->buckets, sizeof(LDAPUtilsSortRun))) == NULL)
+      return(-1);
+   for(x = 0; (x < cnf->buckets); x++)
+   {
+      runs[x].fp  = cnf->results[x].fp;
+      runs[x].mem = &cnf->results[x].recs;
+   };
+
+   rc = -1;
+   if (ldaputils_sort_merge_init(&merge, runs, cnf->buckets) == -1)
+      goto done;
+   if ( ((atomic_load(&cnf->changes))) && (ldaputils_sink_puts(cnf->out, "version: 1\n\n") == -1) )
+      goto done;
+   while ((item = ldaputils_sort_merge_item(&merge)) != NULL)
+   {
+      if (ldaputils_sink_write(cnf->out, item->data, item->data_len) == -1)
+         goto done;
+      if (ldaputils_sort_merge_next(&merge) == -1)
+         goto done;
+   };
+   rc = 0;
+
+   done:
+   ldaputils_sort_merge_free(&merge);
+   free(runs);
+
+   return(rc);
+}
+
+
+/// partitions file by normalized DN, called by partition threads
+/// @param[in] ptr     input file
+void * my_partition(void * ptr)
+{
+   int              err;
+   size_t           x;
+   size_t           n;
+   size_t           off;
+   size_t           pos;
+   size_t           size;
+   size_t           hdr[2];
+   size_t         * counts;
+   char           * eol;
+   FILE           * fp;
+   MyEntry        * ents;
+   MyEntry        * ent;
+   MyConfig       * cnf;
+   MySide         * side;
+   struct berval    chunk;
+   struct berval    rec;
+
+   side = ptr;
+   cnf  = side->cnf;
+
+   while (ldaputils_ldif_chunk(side->ldif, MY_CHUNK_LEN, &chunk, &off) == 1)
+   {
+      pos = 0;
+      while (ldaputils_ldif_record(chunk.bv_val, chunk.bv_len, &pos, &rec) == 1)
+      {
+         // version line is not part of the first record
+         if ( (rec.bv_len >= 8) && (!(strncasecmp(rec.bv_val, "version:", 8))) && ((eol = memchr(rec.bv_val, '\n', rec.bv_len)) != NULL) )
+         {
+            n           = (size_t)(eol - rec.bv_val) + 1;
+            rec.bv_val += n;
+            rec.bv_len -= n;
+         };
+
+         side->off = off + (size_t)(rec.bv_val - chunk.bv_val);
+         if ((err = my_dnkey(side, &rec, &hdr[0])) != LDAP_SUCCESS)
+         {
+            side->err = err;
+            return(NULL);
+         };
+
+         // writes normalized DN and record to temporary file of bucket
+         if ((cnf->disk))
+         {
+            hdr[1] = rec.bv_len;
+            fp     = side->fps[(ldaputils_diff_hash(side->keys, hdr[0]) >> 32) % cnf->buckets];
+            if ( (fwrite(hdr, sizeof(hdr), 1, fp) != 1) || (fwrite(side->keys, 1, hdr[0], fp) != hdr[0]) || (fwrite(rec.bv_val, 1, hdr[1], fp) != hdr[1]) )
+            {
+               side->err    = LDAP_OTHER;
+               side->errnum = errno;
+               return(NULL);
+            };
+            continue;
+         };
+
+         // keeps reference to record
+         if (side->ents_len >= side->ents_size)
+         {
+            size = (side->ents_size) ? (side->ents_size * 2) : 1024;
+            if ((ents = realloc(side->ents, sizeof(MyEntry) * size)) == NULL)
+            {
+               side->err = LDAP_NO_MEMORY;
+               return(NULL);
+            };
+            side->ents      = ents;
+            side->ents_size = size;
+         };
+         ent           = &side->ents[side->ents_len++];
+         memset(ent, 0, sizeof(MyEntry));
+         ent->key_off  = side->keys_len;
+         ent->key_len  = hdr[0];
+         ent->rec      = rec.bv_val;
+         ent->rec_len  = rec.bv_len;
+         ent->hash     = ldaputils_diff_hash(&side->keys[ent->key_off], ent->key_len);
+         ent->bucket   = (ent->hash >> 32) % cnf->buckets;
+         side->keys_len += hdr[0];
+      };
+   };
+
+   if ((cnf->disk))
+   {
+      for(x = 0; (x < cnf->buckets); x++)
+      {
+         if (fflush(side->fps[x]) == EOF)
+         {
+            side->err    = LDAP_OTHER;
+            side->errnum = errno;
+            return(NULL);
+         };
+      };
+      return(NULL);
+   };
+
+   // groups records by bucket
+   if ( ((counts = calloc(cnf->buckets + 1, sizeof(size_t))) == NULL) || ((ents = malloc(sizeof(MyEntry) * (side->ents_len + 1))) == NULL) )
+   {
+      if ((counts))
+         free(counts);
+      side->err = LDAP_NO_MEMORY;
+      return(NULL);
+   };
+   for(x = 0; (x < side->ents_len); x++)
+      counts[side->ents[x].bucket + 1]++;
+   for(x = 0; (x < cnf->buckets); x++)
+      counts[x+1] += counts[x];
+   side->starts = counts;
+   if ((counts = malloc(sizeof(size_t) * cnf->buckets)) == NULL)
+   {
+      free(ents);
+      side->err = LDAP_NO_MEMORY;
+      return(NULL);
+   };
+   memcpy(counts, side->starts, sizeof(size_t) * cnf->buckets);
+   for(x = 0; (x < side->ents_len); x++)
+   {
+      ent      = &ents[counts[side->ents[x].bucket]++];
+      *ent     = side->ents[x];
+      ent->key = &side->keys[ent->key_off];
+   };
+   free(counts);
+   free(side->ents);
+   side->ents      = ents;
+   side->ents_size = side->ents_len + 1;
+
+   return(NULL);
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   int      x;
+   int      y;
+   size_t   z;
+
+   assert(cnf != NULL);
+
+   for(z = 0; ( ((cnf->works)) && (z < cnf->threads) ); z++)
+   {
+      for(x = 0; (x < 2); x++)
+      {
+         if ((cnf->works[z].buckets[x].store))
+            free(cnf->works[z].buckets[x].store);
+         if ((cnf->works[z].buckets[x].data))
+            free(cnf->works[z].buckets[x].data);
+         if ((cnf->works[z].buckets[x].table))
+            free(cnf->works[z].buckets[x].table);
+         ldaputils_diff_free(&cnf->works[z].parsed[x]);
+      };
+   };
+   if ((cnf->works))
+      free(cnf->works);
+
+   for(z = 0; ( ((cnf->results)) && (z < cnf->buckets) ); z++)
+   {
+      if ((cnf->results[z].fp))
+         fclose(cnf->results[z].fp);
+      ldaputils_sort_free(&cnf->results[z].recs);
+   };
+   if ((cnf->results))
+      free(cnf->results);
+
+   for(y = 0; (y < 2); y++)
+   {
+      for(z = 0; ( ((cnf->sides[y].fps)) && (z < cnf->buckets) ); z++)
+         if ((cnf->sides[y].fps[z]))
+            fclose(cnf->sides[y].fps[z]);
+      if ((cnf->sides[y].fps))
+         free(cnf->sides[y].fps);
+      if ((cnf->sides[y].ents))
+         free(cnf->sides[y].ents);
+      if ((cnf->sides[y].starts))
+         free(cnf->sides[y].starts);
+      if ((cnf->sides[y].keys))
+         free(cnf->sides[y].keys);
+      if ((cnf->sides[y].buff))
+         free(cnf->sides[y].buff);
+      if ((cnf->sides[y].ldif))
+         ldaputils_ldif_close(cnf->sides[y].ldif);
+   };
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   free(cnf);
+
+   return;
+}
+
+
+/// compares buckets, called by worker threads
+/// @param[in] ptr     state of thread
+void * my_worker(void * ptr)
+{
+   int            err;
+   int            expected;
+   size_t         idx;
+   MyWork       * work;
+   MyConfig     * cnf;
+
+   work = ptr;
+   cnf  = work->cnf;
+
+   while ((idx = atomic_fetch_add(&cnf->next, 1)) < cnf->buckets)
+   {
+      if (atomic_load(&cnf->err) != LDAP_SUCCESS)
+         return(NULL);
+      if ((err = my_diff(work, idx)) == LDAP_SUCCESS)
+         continue;
+
+      // records the first failure and stops the remaining threads
+      expected = LDAP_SUCCESS;
+      if ((atomic_compare_exchange_strong(&cnf->err, &expected, err)))
+      {
+         cnf->errnum  = errno;
+         cnf->errside = work->side;
+      };
+      atomic_store(&cnf->next, cnf->buckets);
+      return(NULL);
+   };
+
+   return(NULL);
+}
+
+/* end of source file */
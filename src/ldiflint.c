@@ -0,0 +1,655 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldiflint.c validates LDIF entries against schema
+ */
+/*
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldiflint" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldiflint.c
+ *     gcc ${CFLAGS} -lldap -o ldiflint ldiflint.o ../lib/libldaputils.a \
+ *             ../lib/libldapschema.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldiflint" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldiflint.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -o ldiflint \
+ *             ldiflint.lo ../lib/libldaputils.a ../lib/libldapschema.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldiflint.lo ldiflint
+ */
+/*
+ *  The schema is read from files instead of a directory server with
+ *  ldapschema_load().  A file may contain the subschema entry of a server, as
+ *  saved by ldapsearch, the cn=schema,cn=config entries of OpenLDAP, an
+ *  OpenLDAP .schema file, or a schema cache written by ldaplint.  The
+ *  definitions of all files are parsed and linked by ldapschema_link() once
+ *  every file is loaded, so files may be listed in any order.
+ *
+ *  The LDIF being checked is split into chunks on record boundaries which
+ *  are parsed and checked by the formatter threads of the pipeline, each of
+ *  which uses its own checker and violation counters.  Violations are
+ *  written in the order of the records within the file.
+ */
+#define _LDAP_UTILS_SRC_LDIFLINT 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <getopt.h>
+#include <assert.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+#include <ldapschema.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldiflint"
+#endif
+
+#define MY_SHORT_OPTIONS "f:ho:s:vV7:"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+// state of formatter thread
+typedef struct my_state MyState;
+struct my_state
+{
+   LDAPSchemaChecker * chk;
+   size_t              entries;      // number of entries checked
+   size_t              invalid;      // number of entries with violations
+   size_t              skipped;      // number of change records skipped
+   size_t              viols[LDAPSCHEMA_V_MAX+1];
+};
+
+
+// configuration union
+typedef struct my_config MyConfig;
+struct my_config
+{
+   const char          * prog_name;
+   const char          * file;         // LDIF file to check
+   const char          * output;       // file to write violations
+   const char         ** schemas;      // files containing schema
+   size_t                schemas_len;
+   LDAPSchema          * lsd;
+   LDAPSchemaValidator * val;
+   LDAPUtilsLDIF       * ldif;
+   LDAPUtilsSink       * out;
+   LDAPUtilsPipeline   * pipe;
+   MyState             * states;       // state of each formatter thread
+   size_t                threads;      // number of checking threads
+   int                   verbose;
+   int                   pad0;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// checks entry and prints violations
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out);
+
+// loads schema from schema files
+int my_schema(MyConfig * cnf);
+
+// returns state of formatter thread
+void * my_state(void * ctx, size_t idx);
+
+// prints number of entries and violations
+void my_summary(MyConfig * cnf);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] -s schema\n", PROGRAM_NAME);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("  -f file, --file=file      read entries from LDIF file (default: stdin)\n");
+   printf("  -s file, --schema=file    read schema from LDIF, .schema or cache file, may be repeated\n");
+   printf("Lint Options:\n");
+   printf("  --threads=num             number of threads used to check entries (default: number of CPUs)\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int                    err;
+   size_t                 x;
+   size_t                 invalid;
+   long                   num;
+   MyConfig             * cnf;
+   LDAPUtilsPipelineOpts  opts;
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(2);
+   if (!(cnf))
+      return(0);
+
+   // loads and compiles schema
+   if (my_schema(cnf) != 0)
+   {
+      my_unbind(cnf);
+      return(2);
+   };
+   if ((err = ldapschema_validator_initialize(cnf->lsd, &cnf->val)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldapschema_validator_initialize(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // allocates checker for each formatter thread
+   if (!(cnf->threads))
+   {
+      num          = sysconf(_SC_NPROCESSORS_ONLN);
+      cnf->threads = (num < 1) ? 1 : (size_t)num;
+   };
+   if (cnf->threads > LDAPUTILS_PIPELINE_MAX_THREADS)
+      cnf->threads = LDAPUTILS_PIPELINE_MAX_THREADS;
+   if ((cnf->states = malloc(sizeof(MyState) * cnf->threads)) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(2);
+   };
+   bzero(cnf->states, sizeof(MyState) * cnf->threads);
+   for(x = 0; (x < cnf->threads); x++)
+   {
+      if ((err = ldapschema_checker_initialize(cnf->val, &cnf->states[x].chk)) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: ldapschema_checker_initialize(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+         my_unbind(cnf);
+         return(2);
+      };
+   };
+
+   // starts threads which parse and check entries and write violations in order
+   memset(&opts, 0, sizeof(opts));
+   opts.threads = cnf->threads;
+   opts.flags   = LDAPUTILS_PIPELINE_CHANGES;
+   opts.ctx     = cnf;
+   opts.format  = my_row;
+   opts.worker  = my_state;
+   if (ldaputils_pipeline_initialize(&cnf->pipe, cnf->out, &opts) == -1)
+   {
+      fprintf(stderr, "%s: ldaputils_pipeline_initialize(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // queues chunks of LDIF file, the file remains mapped until the pipeline finishes
+   if ((err = ldaputils_pipeline_ldif(cnf->pipe, cnf->ldif)) == LDAP_SUCCESS)
+      err = ldaputils_pipeline_finish(cnf->pipe);
+   else
+      ldaputils_pipeline_finish(cnf->pipe);
+   switch(err)
+   {
+      case LDAP_SUCCESS:
+      break;
+
+      case LDAP_OTHER:
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+
+      case LDAP_NO_MEMORY:
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(2);
+
+      case LDAP_DECODING_ERROR:
+      case LDAP_NOT_SUPPORTED:
+      fprintf(stderr, "%s: %s: offset %zu: %s\n", cnf->prog_name, ((cnf->file)) ? cnf->file : "stdin", ldaputils_pipeline_offset(cnf->pipe), ldaputils_ldif_err2string(err));
+      my_unbind(cnf);
+      return(2);
+
+      default:
+      my_unbind(cnf);
+      return(2);
+   };
+
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(2);
+   };
+
+   if ((cnf->verbose))
+      my_summary(cnf);
+
+   for(x = 0, invalid = 0; (x < cnf->threads); x++)
+      invalid += cnf->states[x].invalid;
+
+   my_unbind(cnf);
+
+   return(((invalid)) ? 1 : 0);
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int        c;
+   int        option_index;
+   void     * ptr;
+   MyConfig * cnf;
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"file",          required_argument, 0, 'f'},
+      {"schema",        required_argument, 0, 's'},
+      {"threads",       required_argument, 0, '7'},
+      {NULL,            0,                 0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+   cnf->prog_name = PROGRAM_NAME;
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(c)
+      {
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         case 'f':
+         cnf->file = optarg;
+         break;
+
+         case 'h':
+         ldaputils_usage();
+         my_unbind(cnf);
+         return(0);
+
+         case 'o':
+         cnf->output = optarg;
+         break;
+
+         case 's':
+         if ((ptr = realloc(cnf->schemas, sizeof(char *) * (cnf->schemas_len+1))) == NULL)
+         {
+            fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->schemas = ptr;
+         cnf->schemas[cnf->schemas_len++] = optarg;
+         break;
+
+         case 'v':
+         cnf->verbose++;
+         break;
+
+         case 'V':
+         ldaputils_version(PROGRAM_NAME);
+         my_unbind(cnf);
+         return(0);
+
+         case '7':
+         cnf->threads = (size_t)atoll(optarg);
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // checks for required arguments
+   if (!(cnf->schemas_len))
+   {
+      fprintf(stderr, "%s: missing required schema file\n", cnf->prog_name);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   if (argc > optind)
+   {
+      fprintf(stderr, "%s: unrecognized argument `%s'\n", cnf->prog_name, argv[optind]);
+      fprintf(stderr, "Try `%s --help' for more information.\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // initialize schema
+   if ((c = ldapschema_initialize(&cnf->lsd)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldapschema_initialize(): %s\n", cnf->prog_name, ldapschema_err2string(c));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens input
+   if (ldaputils_ldif_open(&cnf->ldif, cnf->file) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->file)) ? cnf->file : "stdin", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->output)) ? cnf->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// checks entry and prints violations, called by formatter threads
+/// @param[in] ctx     state of formatter thread
+/// @param[in] row     decoded entry
+/// @param[in] out     formatted output of batch
+int my_row(void * ctx, const LDAPUtilsRow * row, LDAPUtilsSink * out)
+{
+   int                      rc;
+   int                      code;
+   size_t                   x;
+   size_t                   value;
+   MyState                * state;
+   const LDAPUtilsRowAttr * attr;
+   const LDAPUtilsRowAttr * changetype;
+   struct berval            name;
+
+   state = ctx;
+
+   // only the content of add records can be checked
+   changetype = NULL;
+   for(x = 0; ( (x < row->attrs_len) && (!(changetype)) ); x++)
+      if ( (row->attrs[x].name.bv_len == 10) && (!(strcasecmp(row->attrs[x].name.bv_val, "changetype"))) )
+         changetype = &row->attrs[x];
+   if ( ((changetype)) && ( (changetype->vals_len != 1) || (changetype->vals[0].bv_len != 3) || (strncasecmp(changetype->vals[0].bv_val, "add", 3) != 0) ) )
+   {
+      state->skipped++;
+      return(LDAP_SUCCESS);
+   };
+
+   ldapschema_check_begin(state->chk);
+   for(x = 0; (x < row->attrs_len); x++)
+   {
+      attr = &row->attrs[x];
+      if (attr == changetype)
+         continue;
+      if (ldapschema_check_attribute(state->chk, &attr->name, attr->vals, attr->vals_len) != LDAPSCHEMA_SUCCESS)
+         return(LDAP_NO_MEMORY);
+   };
+   if ((rc = ldapschema_check_end(state->chk)) < 0)
+      return(LDAP_NO_MEMORY);
+
+   state->entries++;
+   if (!(rc))
+      return(LDAP_SUCCESS);
+   state->invalid++;
+
+   // prints one line for each violation
+   for(x = 0; ((code = ldapschema_check_violation(state->chk, x, &name, &value)) != 0); x++)
+   {
+      state->viols[code]++;
+      ldaputils_sink_write(out, row->dn.bv_val, row->dn.bv_len);
+      ldaputils_sink_printf(out, ": %s", ldapschema_violation2string(code));
+      if (!(name.bv_len))
+         ldaputils_sink_puts(out, "\n");
+      else if ( (code == LDAPSCHEMA_V_SYNTAX) || (code == LDAPSCHEMA_V_UNKNOWN_CLASS) )
+         ldaputils_sink_printf(out, ": %.*s (value %zu)\n", (int)name.bv_len, name.bv_val, value + 1);
+      else
+         ldaputils_sink_printf(out, ": %.*s\n", (int)name.bv_len, name.bv_val);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// loads schema from schema files
+/// @param[in] cnf     reference to configuration
+int my_schema(MyConfig * cnf)
+{
+   int              err;
+   size_t           x;
+   char          ** errs;
+
+   // queues definitions of every file before any definition is parsed
+   for(x = 0; (x < cnf->schemas_len); x++)
+   {
+      if ((err = ldapschema_load(cnf->lsd, cnf->schemas[x])) == LDAPSCHEMA_SUCCESS)
+         continue;
+      if (err == LDAPSCHEMA_FILE_ERROR)
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->schemas[x], strerror(errno));
+      else
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->schemas[x], ldapschema_err2string(err));
+      return(-1);
+   };
+
+   // parses definitions and links superiors once all files are loaded
+   if ( ((err = ldapschema_link(cnf->lsd)) != LDAP_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+   {
+      fprintf(stderr, "%s: ldapschema_link(): %s\n", cnf->prog_name, ldapschema_err2string(err));
+      return(-1);
+   };
+   if ( (err == LDAPSCHEMA_SCHEMA_ERROR) && ((cnf->verbose)) && ((errs = ldapschema_schema_errors(cnf->lsd)) != NULL) )
+   {
+      for(x = 0; ((errs[x])); x++)
+         fprintf(stderr, "%s: schema error %zu: %s\n", cnf->prog_name, (x+1), errs[x]);
+      ldapschema_value_free(errs);
+   };
+
+   return(0);
+}
+
+
+/// returns state of formatter thread
+/// @param[in] ctx     reference to configuration
+/// @param[in] idx     index of formatter thread
+void * my_state(void * ctx, size_t idx)
+{
+   MyConfig * cnf;
+   cnf = ctx;
+   return(&cnf->states[idx]);
+}
+
+
+/// prints number of entries and violations
+/// @param[in] cnf     reference to configuration
+void my_summary(MyConfig * cnf)
+{
+   int      code;
+   size_t   x;
+   size_t   entries;
+   size_t   invalid;
+   size_t   skipped;
+   size_t   viols[LDAPSCHEMA_V_MAX+1];
+
+   entries = 0;
+   invalid = 0;
+   skipped = 0;
+   bzero(viols, sizeof(viols));
+   for(x = 0; (x < cnf->threads); x++)
+   {
+      entries += cnf->states[x].entries;
+      invalid += cnf->states[x].invalid;
+      skipped += cnf->states[x].skipped;
+      for(code = 1; (code <= LDAPSCHEMA_V_MAX); code++)
+         viols[code] += cnf->states[x].viols[code];
+   };
+
+   fprintf(stderr, "%s: %zu entries checked, %zu entries with violations\n", cnf->prog_name, entries, invalid);
+   if ((skipped))
+      fprintf(stderr, "%s: %zu change records skipped\n", cnf->prog_name, skipped);
+   for(code = 1; (code <= LDAPSCHEMA_V_MAX); code++)
+      if ((viols[code]))
+         fprintf(stderr, "%s:    %zu %s\n", cnf->prog_name, viols[code], ldapschema_violation2string(code));
+
+   return;
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   size_t x;
+
+   assert(cnf != NULL);
+
+   // pipeline references the LDIF data until it is freed
+   if ((cnf->pipe))
+      ldaputils_pipeline_free(cnf->pipe);
+
+   if ((cnf->ldif))
+      ldaputils_ldif_close(cnf->ldif);
+
+   if ((cnf->states))
+   {
+      for(x = 0; (x < cnf->threads); x++)
+         ldapschema_checker_free(cnf->states[x].chk);
+      free(cnf->states);
+   };
+
+   if ((cnf->val))
+      ldapschema_validator_free(cnf->val);
+
+   if ((cnf->lsd))
+      ldapschema_free(cnf->lsd);
+
+   if ((cnf->schemas))
+      free(cnf->schemas);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   free(cnf);
+
+   return;
+}
+
+/* end of source file */
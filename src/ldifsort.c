@@ -0,0 +1,742 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file src/ldifsort.c sorts LDIF files which may exceed available memory
+ */
+/*
+ *  Records are read from memory mapped LDIF files and a binary key is
+ *  computed once for each record.  Keys compare with memcmp() in the same
+ *  order as ldaputils_entry_cmp() and ldaputils_entry_cmp_dn(), so sorting
+ *  never parses a DN twice.  When the keys and record references exceed the
+ *  memory budget, the sorted run is written to a temporary file as keys
+ *  followed by the original bytes of each record.  Runs are combined with a
+ *  k-way merge using a loser tree, which needs one comparison per level of
+ *  the tree for each record written.
+ *
+ *  Simple Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldifsort" -Wall -I../include'
+ *     gcc ${CFLAGS} -c ldifsort.c
+ *     gcc ${CFLAGS} -lldap -o ldifsort ldifsort.o ../lib/libldaputils.a
+ *
+ *  Libtool Build:
+ *     export CFLAGS='-DPROGRAM_NAME="ldifsort" -Wall -I../include'
+ *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldifsort.c
+ *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -o ldifsort \
+ *             ldifsort.lo ../lib/libldaputils.a
+ *
+ *  Libtool Clean:
+ *     libtool --mode=clean rm -f ldifsort.lo ldifsort
+ */
+#define _LDAP_UTILS_SRC_LDIFSORT 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <assert.h>
+
+#define LDAP_DEPRECATED 1
+#include <ldap.h>
+#include <ldaputils.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "ldifsort"
+#endif
+
+#define MY_SHORT_OPTIONS "ho:S:vV9:8:"
+
+#define MY_MEMORY        (256 * 1024 * 1024)   // default memory used to sort a run
+#define MY_MEMORY_MIN    (1024 * 1024)         // smallest memory accepted by --memory
+#define MY_CHUNK_LEN     (16 * 1024 * 1024)    // bytes of LDIF scanned for records at once
+#define MY_RUN_BUFF_LEN  (256 * 1024)          // stdio buffer of each run
+#define MY_FANIN         128                   // maximum number of runs merged at once
+#define MY_SEQ_LEN       8                     // bytes of record sequence appended to keys
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+/* configuration union */
+typedef struct my_config MyConfig;
+struct my_config
+{
+   const char      * prog_name;
+   const char      * sortattr;     // -S sort by attribute
+   const char      * output;       // -o output file
+   const char      * tmpdir;       // directory of temporary runs
+   size_t            memory;       // memory used to sort a run
+   int               verbose;
+   int               version;      // input contained version line
+   const char     ** files;
+   size_t            files_len;
+   LDAPUtilsLDIF  ** ldifs;
+   LDAPUtilsSink   * out;
+   LDAPUtilsSortItem * items;       // records of current run
+   size_t            items_len;
+   size_t            items_size;
+   char            * keys;         // keys of current run
+   size_t            keys_len;
+   size_t            keys_size;
+   char            * buff;         // decoded values of current record
+   size_t            buff_size;
+   FILE           ** runs;         // sorted runs stored in temporary files
+   size_t            runs_len;
+   uint64_t          seq;          // number of records read
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(int argc, char * argv[]);
+
+// parses configuration
+int my_config(int argc, char * argv[], MyConfig ** cnfp);
+
+// renders sort key of record, returns length of complete key
+int my_key(MyConfig * cnf, const struct berval * rec, char * key, size_t size, size_t * lenp);
+
+// merges sorted runs into a run or the output
+int my_merge(MyConfig * cnf, FILE ** fps, size_t len, FILE * dst);
+
+// adds record to current run
+int my_record(MyConfig * cnf, const struct berval * rec);
+
+// sorts current run and writes it to a temporary file
+int my_spill(MyConfig * cnf);
+
+// fress resources
+void my_unbind(MyConfig * cnf);
+
+// writes record to a run or the output
+int my_write(MyConfig * cnf, const LDAPUtilsSortItem * item, FILE * dst);
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// prints program usage and exits
+void ldaputils_usage(void)
+{
+   printf("Usage: %s [options] [file ...]\n", PROGRAM_NAME);
+   ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("  -S attr                   sort records by attribute `attr'\n");
+   printf("Sort Options:\n");
+   printf("  --memory=size             memory used to sort each run (default: %iM, minimum: %iM)\n", (MY_MEMORY / 1024 / 1024), (MY_MEMORY_MIN / 1024 / 1024));
+   printf("  --tmpdir=dir              directory for temporary files (default: $TMPDIR or /tmp)\n");
+   printf("\nReport bugs to <%s>.\n", PACKAGE_BUGREPORT);
+   return;
+}
+
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int main(int argc, char * argv[])
+{
+   int              err;
+   size_t           x;
+   size_t           y;
+   size_t           off;
+   size_t           pos;
+   FILE           * fp;
+   MyConfig       * cnf;
+   struct berval    chunk;
+   struct berval    rec;
+
+   cnf = NULL;
+
+   // initializes resources and parses CLI arguments
+   if ((err = my_config(argc, argv, &cnf)) != 0)
+      return(1);
+   if (!(cnf))
+      return(0);
+
+   // computes keys of records, writing sorted runs as memory is exhausted
+   for(x = 0; (x < cnf->files_len); x++)
+   {
+      while (ldaputils_ldif_chunk(cnf->ldifs[x], MY_CHUNK_LEN, &chunk, &off) == 1)
+      {
+         // version line of file may be followed by a blank line instead of a record
+         if ( (off == 0) && (chunk.bv_len >= 8) && (!(strncasecmp(chunk.bv_val, "version:", 8))) )
+            cnf->version = 1;
+
+         pos = 0;
+         while (ldaputils_ldif_record(chunk.bv_val, chunk.bv_len, &pos, &rec) == 1)
+         {
+            if ((err = my_record(cnf, &rec)) == LDAP_SUCCESS)
+               continue;
+            if (err == LDAP_OTHER)
+               fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(errno));
+            else
+               fprintf(stderr, "%s: %s: offset %zu: %s\n", cnf->prog_name, cnf->files[x], off + (size_t)(rec.bv_val - chunk.bv_val), ldaputils_ldif_err2string(err));
+            my_unbind(cnf);
+            return(1);
+         };
+      };
+   };
+
+   // writes records directly when all records fit in memory
+   if (!(cnf->runs_len))
+   {
+      qsort(cnf->items, cnf->items_len, sizeof(LDAPUtilsSortItem), ldaputils_sort_cmp);
+      if ((cnf->version))
+         ldaputils_sink_puts(cnf->out, "version: 1\n\n");
+      for(x = 0; (x < cnf->items_len); x++)
+      {
+         if (my_write(cnf, &cnf->items[x], NULL) == -1)
+         {
+            fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+            my_unbind(cnf);
+            return(1);
+         };
+      };
+   } else {
+      if (my_spill(cnf) == -1)
+      {
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(errno));
+         my_unbind(cnf);
+         return(1);
+      };
+
+      // reduces number of runs to the number which may be merged at once
+      while (cnf->runs_len > MY_FANIN)
+      {
+         if ( ((fp = ldaputils_sort_temp(cnf->tmpdir, PROGRAM_NAME, MY_RUN_BUFF_LEN)) == NULL) || (my_merge(cnf, cnf->runs, MY_FANIN, fp) == -1) )
+         {
+            fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->tmpdir, strerror(errno));
+            if ((fp))
+               fclose(fp);
+            my_unbind(cnf);
+            return(1);
+         };
+         for(y = 0; (y < MY_FANIN); y++)
+            fclose(cnf->runs[y]);
+         memmove(cnf->runs, &cnf->runs[MY_FANIN], sizeof(FILE *) * (cnf->runs_len - MY_FANIN));
+         cnf->runs_len -= MY_FANIN;
+         cnf->runs[cnf->runs_len++] = fp;
+      };
+
+      if ((cnf->version))
+         ldaputils_sink_puts(cnf->out, "version: 1\n\n");
+      if (my_merge(cnf, cnf->runs, cnf->runs_len, NULL) == -1)
+      {
+         fprintf(stderr, "%s: %s\n", cnf->prog_name, strerror(errno));
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // writes remaining output
+   if (ldaputils_sink_flush(cnf->out) == -1)
+   {
+      fprintf(stderr, "%s: write(): %s\n", cnf->prog_name, strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   my_unbind(cnf);
+
+   return(0);
+}
+
+
+/// parses configuration
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+/// @param[in] cnfp   reference to configuration pointer
+int my_config(int argc, char * argv[], MyConfig ** cnfp)
+{
+   int        c;
+   int        option_index;
+   size_t     x;
+   MyConfig * cnf;
+
+   static const char * stdin_files[] = { "-", NULL };
+
+   static char   short_options[] = MY_SHORT_OPTIONS;
+   static struct option long_options[] =
+   {
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {"tmpdir",        required_argument, 0, '9'},
+      {"memory",        required_argument, 0, '8'},
+      {NULL,            0,                 0, 0  }
+   };
+
+   // allocates memory for configuration
+   if (!(cnf = (MyConfig *) malloc(sizeof(MyConfig))))
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
+      return(1);
+   };
+   memset(cnf, 0, sizeof(MyConfig));
+   cnf->prog_name = PROGRAM_NAME;
+   cnf->memory    = MY_MEMORY;
+   if ((cnf->tmpdir = getenv("TMPDIR")) == NULL)
+      cnf->tmpdir = "/tmp";
+
+   // loops through args
+   option_index = 0;
+   while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
+   {
+      switch(c)
+      {
+         // no more arguments
+         case -1:
+         break;
+
+         // long options toggles
+         case 0:
+         break;
+
+         case 'h':
+         ldaputils_usage();
+         my_unbind(cnf);
+         return(0);
+
+         case 'o':
+         cnf->output = optarg;
+         break;
+
+         case 'S':
+         cnf->sortattr = optarg;
+         break;
+
+         case 'v':
+         cnf->verbose++;
+         break;
+
+         case 'V':
+         ldaputils_version(PROGRAM_NAME);
+         my_unbind(cnf);
+         return(0);
+
+         case '9':
+         cnf->tmpdir = optarg;
+         break;
+
+         case '8':
+         if (ldaputils_sort_size(optarg, &cnf->memory) == -1)
+         {
+            fprintf(stderr, "%s: invalid memory size `%s'\n", PROGRAM_NAME, optarg);
+            my_unbind(cnf);
+            return(1);
+         };
+         if (cnf->memory < MY_MEMORY_MIN)
+         {
+            fprintf(stderr, "%s: memory size `%s' is less than the minimum of %iM\n", PROGRAM_NAME, optarg, (MY_MEMORY_MIN / 1024 / 1024));
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         // argument error
+         case '?':
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+
+         // unknown argument error
+         default:
+         fprintf(stderr, "%s: unrecognized option `--%c'\n", PROGRAM_NAME, c);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // reads stdin if no files are specified
+   if (optind < argc)
+   {
+      cnf->files     = (const char **)&argv[optind];
+      cnf->files_len = (size_t)(argc - optind);
+   } else {
+      cnf->files     = stdin_files;
+      cnf->files_len = 1;
+   };
+
+   // opens input
+   if ((cnf->ldifs = calloc(cnf->files_len, sizeof(LDAPUtilsLDIF *))) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+   for(x = 0; (x < cnf->files_len); x++)
+   {
+      if (ldaputils_ldif_open(&cnf->ldifs[x], cnf->files[x]) == -1)
+      {
+         fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, cnf->files[x], strerror(errno));
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
+   // divides memory between keys and references to records
+   cnf->items_size = (cnf->memory / 4) / sizeof(LDAPUtilsSortItem);
+   cnf->keys_size  = cnf->memory - (cnf->items_size * sizeof(LDAPUtilsSortItem));
+   if ( ((cnf->items = malloc(sizeof(LDAPUtilsSortItem) * cnf->items_size)) == NULL) || ((cnf->keys = malloc(cnf->keys_size)) == NULL) )
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", cnf->prog_name);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // opens output
+   if (ldaputils_sink_open(&cnf->out, cnf->output, LDAPUTILS_SINK_PREALLOC) == -1)
+   {
+      fprintf(stderr, "%s: %s: %s\n", cnf->prog_name, ((cnf->output)) ? cnf->output : "stdout", strerror(errno));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   *cnfp = cnf;
+
+   return(0);
+}
+
+
+/// renders sort key of record, returns length of complete key
+/// @param[in] cnf     reference to configuration
+/// @param[in] rec     LDIF record
+/// @param[out] key    buffer which receives key
+/// @param[in] size    size of buffer, key is truncated to fit
+/// @param[out] lenp   length of complete key
+int my_key(MyConfig * cnf, const struct berval * rec, char * key, size_t size, size_t * lenp)
+{
+   int             err;
+   size_t          x;
+   size_t          len;
+   size_t          pos;
+   uint64_t        seq;
+   struct berval   val;
+   LDAPUtilsDN     dn;
+
+   pos = 0;
+
+   // records without the attribute sort first, otherwise the first values
+   // are compared case insensitive, then case sensitive, and then by DN
+   if ((cnf->sortattr))
+   {
+      if ((err = ldaputils_ldif_value(rec, cnf->sortattr, cnf->buff, &val)) == LDAP_NO_SUCH_ATTRIBUTE)
+      {
+         if (size > 0)
+            key[0] = '\0';
+         pos = 1;
+      }
+      else if (err != LDAP_SUCCESS)
+      {
+         return(err);
+      } else {
+         len = strlen(val.bv_val);
+         if ((len * 2 + 2) <= size)
+         {
+            key[0] = 1;
+            for(x = 0; (x < len); x++)
+               key[x+1] = (char)tolower((unsigned char)val.bv_val[x]);
+            key[len+1] = '\0';
+            memcpy(&key[len+2], val.bv_val, len);
+         };
+         pos = len * 2 + 2;
+      };
+   };
+
+   // DN ordered like ldaputils_entry_cmp_dn(), inverted DN breaks ties by case
+   if ((err = ldaputils_ldif_value(rec, "dn", cnf->buff, &val)) != LDAP_SUCCESS)
+      return(err);
+   if (ldaputils_dn_parse(&dn, val.bv_val, val.bv_len) == -1)
+      return(((errno == ENOMEM)) ? LDAP_NO_MEMORY : LDAP_INVALID_DN_SYNTAX);
+   pos += ldaputils_dn_format(&dn, LDAPUTILS_DN_KEY, ((pos < size) ? &key[pos] : NULL), ((pos < size) ? (size - pos) : 0));
+   pos += ldaputils_dn_format(&dn, LDAPUTILS_DN_IDN, ((pos < size) ? &key[pos] : NULL), ((pos < size) ? (size - pos) : 0));
+   ldaputils_dn_free(&dn);
+
+   // position within input keeps records with the same key in order
+   if ((pos + MY_SEQ_LEN) <= size)
+      for(x = 0, seq = cnf->seq; (x < MY_SEQ_LEN); x++, seq >>= 8)
+         key[pos + MY_SEQ_LEN - x - 1] = (char)(seq & 0xff);
+   *lenp = pos + MY_SEQ_LEN;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// merges sorted runs into a run or the output
+/// @param[in] cnf     reference to configuration
+/// @param[in] fps     temporary files of runs
+/// @param[in] len     number of runs
+/// @param[in] dst     temporary file of merged run, or NULL to write output
+int my_merge(MyConfig * cnf, FILE ** fps, size_t len, FILE * dst)
+{
+   int                         rc;
+   size_t                      x;
+   LDAPUtilsSortRun          * runs;
+   LDAPUtilsSortMerge          merge;
+   const LDAPUtilsSortItem   * item;
+
+   if ((runs = calloc(len, sizeof(LDAPUtilsSortRun))) == NULL)
+      return(-1);
+   for(x = 0; (x < len); x++)
+      runs[x].fp = fps[x];
+
+   rc = -1;
+   if (ldaputils_sort_merge_init(&merge, runs, len) == -1)
+      goto done;
+   while ((item = ldaputils_sort_merge_item(&merge)) != NULL)
+   {
+      if (my_write(cnf, item, dst) == -1)
+         goto done;
+      if (ldaputils_sort_merge_next(&merge) == -1)
+         goto done;
+   };
+   if ( ((dst)) && (fflush(dst) == EOF) )
+      goto done;
+   rc = 0;
+
+   done:
+   ldaputils_sort_merge_free(&merge);
+   free(runs);
+
+   return(rc);
+}
+
+
+/// adds record to current run
+/// @param[in] cnf     reference to configuration
+/// @param[in] rec     LDIF record
+int my_record(MyConfig * cnf, const struct berval * rec)
+{
+   int             err;
+   size_t          n;
+   size_t          len;
+   size_t          avail;
+   char          * key;
+   char          * ptr;
+   LDAPUtilsSortItem * item;
+   struct berval   body;
+
+   body = *rec;
+
+   // version line is written once at the start of the output
+   if ( (body.bv_len >= 8) && (!(strncasecmp(body.bv_val, "version:", 8))) )
+   {
+      if ((ptr = memchr(body.bv_val, '\n', body.bv_len)) == NULL)
+         return(LDAP_DECODING_ERROR);
+      n             = (size_t)(ptr - body.bv_val) + 1;
+      body.bv_val  += n;
+      body.bv_len  -= n;
+      cnf->version  = 1;
+   };
+
+   // values are decoded into a buffer as long as the record
+   if (body.bv_len >= cnf->buff_size)
+   {
+      if ((ptr = realloc(cnf->buff, body.bv_len + 1)) == NULL)
+         return(LDAP_NO_MEMORY);
+      cnf->buff      = ptr;
+      cnf->buff_size = body.bv_len + 1;
+   };
+
+   // writes current run to disk if key does not fit in remaining memory
+   for(;;)
+   {
+      key   = &cnf->keys[cnf->keys_len];
+      avail = cnf->keys_size - cnf->keys_len;
+      if ((err = my_key(cnf, &body, key, avail, &len)) != LDAP_SUCCESS)
+         return(err);
+      if ( (len <= avail) && (cnf->items_len < cnf->items_size) )
+         break;
+      if (!(cnf->items_len))
+         return(LDAP_NO_MEMORY);
+      if (my_spill(cnf) == -1)
+         return(LDAP_OTHER);
+   };
+
+   item           = &cnf->items[cnf->items_len++];
+   item->key      = key;
+   item->key_len  = len;
+   item->data     = body.bv_val;
+   item->data_len = body.bv_len;
+   item->prefix   = ldaputils_sort_prefix(key, len);
+
+   cnf->keys_len += len;
+   cnf->seq++;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// sorts current run and writes it to a temporary file
+/// @param[in] cnf     reference to configuration
+int my_spill(MyConfig * cnf)
+{
+   size_t     x;
+   FILE     * fp;
+   void     * ptr;
+
+   if (!(cnf->items_len))
+      return(0);
+
+   qsort(cnf->items, cnf->items_len, sizeof(LDAPUtilsSortItem), ldaputils_sort_cmp);
+
+   if ((fp = ldaputils_sort_temp(cnf->tmpdir, PROGRAM_NAME, MY_RUN_BUFF_LEN)) == NULL)
+      return(-1);
+   for(x = 0; (x < cnf->items_len); x++)
+   {
+      if (my_write(cnf, &cnf->items[x], fp) == -1)
+      {
+         fclose(fp);
+         return(-1);
+      };
+   };
+   if ( (fflush(fp) == EOF) || ((ptr = realloc(cnf->runs, sizeof(FILE *) * (cnf->runs_len+1))) == NULL) )
+   {
+      fclose(fp);
+      return(-1);
+   };
+   cnf->runs = ptr;
+   cnf->runs[cnf->runs_len++] = fp;
+
+   if ((cnf->verbose))
+      fprintf(stderr, "%s: wrote run %zu with %zu records\n", cnf->prog_name, cnf->runs_len, cnf->items_len);
+
+   cnf->items_len = 0;
+   cnf->keys_len  = 0;
+
+   return(0);
+}
+
+
+// fress resources
+void my_unbind(MyConfig * cnf)
+{
+   size_t x;
+
+   assert(cnf != NULL);
+
+   for(x = 0; (x < cnf->runs_len); x++)
+      fclose(cnf->runs[x]);
+   if ((cnf->runs))
+      free(cnf->runs);
+
+   for(x = 0; ( ((cnf->ldifs)) && (x < cnf->files_len) ); x++)
+      if ((cnf->ldifs[x]))
+         ldaputils_ldif_close(cnf->ldifs[x]);
+   if ((cnf->ldifs))
+      free(cnf->ldifs);
+
+   if ((cnf->items))
+      free(cnf->items);
+
+   if ((cnf->keys))
+      free(cnf->keys);
+
+   if ((cnf->buff))
+      free(cnf->buff);
+
+   if ((cnf->out))
+      ldaputils_sink_close(cnf->out);
+
+   free(cnf);
+
+   return;
+}
+
+
+/// writes record to a run or the output
+/// @param[in] cnf     reference to configuration
+/// @param[in] item    record and key
+/// @param[in] dst     temporary file of run, or NULL to write output
+int my_write(MyConfig * cnf, const LDAPUtilsSortItem * item, FILE * dst)
+{
+   // runs store the key followed by the record
+   if ((dst))
+      return(ldaputils_sort_put(dst, item));
+
+   // output contains the original record followed by a blank line
+   if (ldaputils_sink_write(cnf->out, item->data, item->data_len) == -1)
+      return(-1);
+   if ( (!(item->data_len)) || (item->data[item->data_len-1] != '\n') )
+      ldaputils_sink_puts(cnf->out, "\n");
+   if ( (item->data_len >= 2) && (item->data[item->data_len-2] == '\r') )
+      return(ldaputils_sink_puts(cnf->out, "\r\n"));
+
+   return(ldaputils_sink_puts(cnf->out, "\n"));
+}
+
+/* end of source file */
@@ -0,0 +1,393 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/compresstest.c  tests block parallel output compression
+ */
+#define _LDAP_UTILS_TESTS_COMPRESSTEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <ldaputils.h>
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#endif
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+#include <zstd.h>
+#endif
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// bytes of generated output, spans several compressed blocks
+#define MY_DATA_LEN     (3 * 1024 * 1024 + 12345)
+
+// threads compressing blocks
+#define MY_THREADS      3
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+// compression specification and lengths of output written
+typedef struct my_test MyTest;
+struct my_test
+{
+   const char      * spec;
+   size_t            len;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// displays usage required by libldaputils
+void ldaputils_usage(void);
+
+// main statement
+int main(void);
+
+// compresses data into temporary file and checks decompressed file
+int my_check(const char * spec, const char * data, size_t len);
+
+// reads decompressed contents of file
+int my_read(const char * spec, int fd, char * buff, size_t size, size_t * lenp);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+static const MyTest my_tests[] =
+{
+   { "gzip",     MY_DATA_LEN },
+   { "gzip:1",   MY_DATA_LEN },
+   { "gzip:9",   1000 },
+   { "gzip",     0 },
+   { "zstd",     MY_DATA_LEN },
+   { "zstd:19",  1000 },
+   { "zstd",     0 },
+   { NULL,       0 }
+};
+
+static const char * my_invalid[] =
+{
+   "gzip:0",
+   "gzip:10",
+   "gzip:",
+   "gzip:1x",
+   "gzipx",
+   "lz4",
+   "",
+   NULL
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// displays usage required by libldaputils
+void ldaputils_usage(void)
+{
+   printf("Usage: compresstest\n");
+   return;
+}
+
+
+int main(void)
+{
+   int              errs;
+   int              rc;
+   size_t           x;
+   size_t           tested;
+   char           * data;
+   LDAPUtilsSink  * sink;
+
+   errs   = 0;
+   tested = 0;
+
+   // LDIF like lines with varying content
+   if ((data = malloc(MY_DATA_LEN)) == NULL)
+      return(1);
+   for(x = 0; (x < MY_DATA_LEN); x++)
+      data[x] = ((x % 61) == 60) ? '\n' : (char)('a' + ((x * 7 + x / 61) % 26));
+
+   for(x = 0; ((my_tests[x].spec)); x++)
+   {
+      if ((rc = my_check(my_tests[x].spec, data, my_tests[x].len)) == -1)
+      {
+         printf("SKIP: %s: not supported\n", my_tests[x].spec);
+         continue;
+      };
+      errs += rc;
+      tested++;
+   };
+
+   for(x = 0; ((my_invalid[x])); x++)
+   {
+      if (ldaputils_sink_fdopen(&sink, -1) == -1)
+      {
+         free(data);
+         return(1);
+      };
+      if (ldaputils_sink_compress(sink, my_invalid[x], MY_THREADS) != -1)
+      {
+         printf("FAIL: %s: invalid specification accepted\n", my_invalid[x]);
+         errs++;
+      };
+      ldaputils_sink_close(sink);
+      tested++;
+   };
+
+   free(data);
+
+   printf("%zu compression specifications tested, %i failures\n", tested, errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// compresses data into temporary file and checks decompressed file
+/// @param[in] spec      compression specification
+/// @param[in] data      uncompressed data
+/// @param[in] len       length of data
+int my_check(const char * spec, const char * data, size_t len)
+{
+   int              fd;
+   int              errs;
+   size_t           pos;
+   size_t           chunk;
+   size_t           out_len;
+   char           * out;
+   char             path[64];
+   LDAPUtilsSink  * sink;
+
+   snprintf(path, sizeof(path), "/tmp/compresstest.XXXXXX");
+   if ((fd = mkstemp(path)) == -1)
+   {
+      printf("FAIL: %s: mkstemp(): %s\n", spec, strerror(errno));
+      return(1);
+   };
+   unlink(path);
+
+   if (ldaputils_sink_fdopen(&sink, fd) == -1)
+   {
+      close(fd);
+      return(1);
+   };
+   if (ldaputils_sink_compress(sink, spec, MY_THREADS) == -1)
+   {
+      ldaputils_sink_close(sink);
+      close(fd);
+      return(((errno == ENOTSUP)) ? -1 : 1);
+   };
+
+   // writes data in uneven pieces with a flush which ends a block early
+   errs = 0;
+   for(pos = 0, chunk = 1; (pos < len); pos += chunk, chunk = (chunk * 3) % 100003 + 1)
+   {
+      chunk = ((len - pos) < chunk) ? (len - pos) : chunk;
+      if (ldaputils_sink_write(sink, &data[pos], chunk) == -1)
+      {
+         printf("FAIL: %s: write(): %s\n", spec, strerror(errno));
+         errs++;
+         break;
+      };
+      if ( (pos < (len / 2)) && ((pos + chunk) >= (len / 2)) && (ldaputils_sink_flush(sink) == -1) )
+      {
+         printf("FAIL: %s: flush(): %s\n", spec, strerror(errno));
+         errs++;
+         break;
+      };
+   };
+   if (ldaputils_sink_close(sink) == -1)
+   {
+      printf("FAIL: %s: close(): %s\n", spec, strerror(errno));
+      errs++;
+   };
+   if ((errs))
+   {
+      close(fd);
+      return(errs);
+   };
+
+   // decompressed output matches data
+   if ((out = malloc(len + 1)) == NULL)
+   {
+      close(fd);
+      return(1);
+   };
+   if (my_read(spec, fd, out, len + 1, &out_len) == -1)
+   {
+      printf("FAIL: %s: %zu bytes not decompressed\n", spec, len);
+      errs++;
+   }
+   else if ( (out_len != len) || ((memcmp(out, data, len))) )
+   {
+      printf("FAIL: %s: %zu bytes decompressed to %zu bytes\n", spec, len, out_len);
+      errs++;
+   };
+   free(out);
+   close(fd);
+
+   return(errs);
+}
+
+
+/// reads decompressed contents of file
+/// @param[in]  spec     compression specification
+/// @param[in]  fd       file descriptor of compressed file
+/// @param[out] buff     buffer for decompressed data
+/// @param[in]  size     size of buffer
+/// @param[out] lenp     length of decompressed data
+int my_read(const char * spec, int fd, char * buff, size_t size, size_t * lenp)
+{
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+   int              rc;
+   gzFile           gz;
+#endif
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+   ssize_t          n;
+   size_t           len;
+   size_t           ret;
+   off_t            off;
+   char           * data;
+   ZSTD_DStream   * zds;
+   ZSTD_inBuffer    in;
+   ZSTD_outBuffer   out;
+#endif
+
+   *lenp = 0;
+
+   if (lseek(fd, 0, SEEK_SET) == -1)
+      return(-1);
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+   // reads concatenated gzip members
+   if (!(strncmp(spec, "gzip", 4)))
+   {
+      if ((gz = gzdopen(dup(fd), "rb")) == NULL)
+         return(-1);
+      while ((rc = gzread(gz, &buff[*lenp], (unsigned)(size - *lenp))) > 0)
+         *lenp += (size_t)rc;
+      gzclose(gz);
+      return(((rc)) ? -1 : 0);
+   };
+#endif
+
+#if defined(HAVE_ZSTD_H) && defined(HAVE_LIBZSTD)
+   // reads concatenated zstd frames
+   if (!(strncmp(spec, "zstd", 4)))
+   {
+      if ( ((off = lseek(fd, 0, SEEK_END)) == -1) || (lseek(fd, 0, SEEK_SET) == -1) )
+         return(-1);
+      if ((data = malloc((size_t)off + 1)) == NULL)
+         return(-1);
+      for(len = 0; (len < (size_t)off); len += (size_t)n)
+      {
+         if ((n = read(fd, &data[len], (size_t)off - len)) <= 0)
+         {
+            free(data);
+            return(-1);
+         };
+      };
+      if ((zds = ZSTD_createDStream()) == NULL)
+      {
+         free(data);
+         return(-1);
+      };
+      ZSTD_initDStream(zds);
+      in.src   = data;
+      in.size  = len;
+      in.pos   = 0;
+      out.dst  = buff;
+      out.size = size;
+      out.pos  = 0;
+      ret      = 0;
+      while ( (in.pos < in.size) && (out.pos < out.size) && (!(ZSTD_isError(ret))) )
+         ret = ZSTD_decompressStream(zds, &out, &in);
+      ZSTD_freeDStream(zds);
+      free(data);
+      *lenp = out.pos;
+      return(((ZSTD_isError(ret))) ? -1 : 0);
+   };
+#endif
+
+   return(-1);
+}
+
+/* end of source file */
@@ -0,0 +1,282 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/csvtest.c  tests quoting of CSV fields
+ */
+#define _LDAP_UTILS_TESTS_CSVTEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <ldaputils.h>
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+// value and expected contents of field
+typedef struct my_test MyTest;
+struct my_test
+{
+   const char      * val;
+   size_t            val_len;
+   char              sep;
+   int               pad0;
+   const char      * rfc4180;      // contents of field with LDAPUTILS_CSV_RFC4180
+   const char      * legacy;       // contents of field without flags
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// displays usage required by libldaputils
+void ldaputils_usage(void);
+
+// main statement
+int main(void);
+
+// encodes value into file and returns contents of file
+char * my_encode(const MyTest * test, int flags, size_t * lenp);
+
+// decodes one quoted RFC 4180 field
+int my_unquote(const char * str, size_t len, char * buff, size_t * lenp);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+static const MyTest my_tests[] =
+{
+   { "plain value",            11, '|', 0, "plain value",              "plain value" },
+   { "",                        0, '|', 0, "",                         "" },
+   { "say \"hello\"",          11, '|', 0, "say \"\"hello\"\"",        "say 'hello'" },
+   { "\"",                      1, '|', 0, "\"\"",                     "'" },
+   { "cn=Doe\\, John,o=x",     17, '"', 0, "cn=Doe\\, John,o=x",       "cn=Doe\\, John,o=x" },
+   { "a|b\\c",                  5, '|', 0, "a|b\\c",                   "a:b\\c" },
+   { "a|b",                     3, '"', 0, "a|b",                      "a|b" },
+   { "a;b",                     3, ';', 0, "a;b",                      "a:b" },
+   { "line\r\nbreak",          11, '|', 0, "line\r\nbreak",            "line\r\nbreak" },
+   { "nul\0byte",               8, '|', 0, "nul\0byte",                "nul\0byte" },
+   { "0123456789abcdef0123456789abcdef\"0123456789abcdef|0123456789abcdef\"", 67, '|', 0,
+     "0123456789abcdef0123456789abcdef\"\"0123456789abcdef|0123456789abcdef\"\"",
+     "0123456789abcdef0123456789abcdef'0123456789abcdef:0123456789abcdef'" },
+   { NULL,                      0, '\0', 0, NULL,                      NULL }
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// displays usage required by libldaputils
+void ldaputils_usage(void)
+{
+   printf("Usage: csvtest\n");
+   return;
+}
+
+
+/// main statement
+int main(void)
+{
+   int            errs;
+   size_t         x;
+   size_t         len;
+   size_t         dec_len;
+   size_t         exp_len;
+   char         * str;
+   char         * dec;
+
+   errs = 0;
+
+   for(x = 0; ((my_tests[x].val)); x++)
+   {
+      // RFC 4180 only doubles quotes and decodes to the original value
+      if ((str = my_encode(&my_tests[x], LDAPUTILS_CSV_RFC4180, &len)) == NULL)
+         return(1);
+      exp_len = my_tests[x].val_len;
+      for(dec_len = 0; (dec_len < my_tests[x].val_len); dec_len++)
+         exp_len += (my_tests[x].val[dec_len] == '"') ? 1 : 0;
+      if ( (len != (exp_len + 2)) || ((memcmp(&str[1], my_tests[x].rfc4180, exp_len))) )
+      {
+         printf("FAIL: rfc4180 %zu: \"%.*s\"\n", x, (int)len, str);
+         errs++;
+      };
+      if ((dec = malloc(len + 1)) == NULL)
+         return(1);
+      if ( (my_unquote(str, len, dec, &dec_len) == -1) || (dec_len != my_tests[x].val_len) || ((memcmp(dec, my_tests[x].val, dec_len))) )
+      {
+         printf("FAIL: rfc4180 %zu: value does not round trip\n", x);
+         errs++;
+      };
+      free(dec);
+      free(str);
+
+      // legacy mode replaces quotes and separators of multiple values
+      if ((str = my_encode(&my_tests[x], 0, &len)) == NULL)
+         return(1);
+      if ( (len != (my_tests[x].val_len + 2)) || ((memcmp(&str[1], my_tests[x].legacy, my_tests[x].val_len))) )
+      {
+         printf("FAIL: legacy %zu: \"%.*s\"\n", x, (int)len, str);
+         errs++;
+      };
+      free(str);
+   };
+
+   printf("%zu values tested, %i failures\n", x, errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// encodes value into file and returns contents of file
+/// @param[in] test    value to encode
+/// @param[in] flags   encoding flags
+/// @param[out] lenp   length of returned contents
+char * my_encode(const MyTest * test, int flags, size_t * lenp)
+{
+   int               fd;
+   ssize_t           rc;
+   char            * str;
+   char              path[] = "/tmp/csvtest.XXXXXX";
+   LDAPUtilsSink   * sink;
+
+   if ((fd = mkstemp(path)) == -1)
+   {
+      perror("mkstemp()");
+      return(NULL);
+   };
+   unlink(path);
+
+   // field is written as it is by ldap2csv and ldif2csv
+   if (ldaputils_sink_fdopen(&sink, fd) == -1)
+   {
+      perror("ldaputils_sink_fdopen()");
+      close(fd);
+      return(NULL);
+   };
+   ldaputils_sink_puts(sink, "\"");
+   ldaputils_sink_csv(sink, test->val, test->val_len, test->sep, flags);
+   ldaputils_sink_puts(sink, "\"");
+   if (ldaputils_sink_close(sink) == -1)
+   {
+      perror("ldaputils_sink_close()");
+      close(fd);
+      return(NULL);
+   };
+
+   if ((str = malloc((test->val_len * 2) + 3)) == NULL)
+   {
+      close(fd);
+      return(NULL);
+   };
+   if ( ((rc = pread(fd, str, (test->val_len * 2) + 3, 0)) == -1) )
+   {
+      perror("pread()");
+      free(str);
+      close(fd);
+      return(NULL);
+   };
+   close(fd);
+   *lenp = (size_t)rc;
+
+   return(str);
+}
+
+
+/// decodes one quoted RFC 4180 field
+/// @param[in] str     quoted field
+/// @param[in] len     length of quoted field
+/// @param[out] buff   buffer of at least len bytes
+/// @param[out] lenp   length of decoded value
+int my_unquote(const char * str, size_t len, char * buff, size_t * lenp)
+{
+   size_t         x;
+   size_t         n;
+
+   if ( (len < 2) || (str[0] != '"') || (str[len-1] != '"') )
+      return(-1);
+
+   for(x = 1, n = 0; (x < (len - 1)); x++)
+   {
+      if (str[x] == '"')
+      {
+         // quotes within field must be doubled
+         if ( ((x + 1) >= (len - 1)) || (str[x+1] != '"') )
+            return(-1);
+         x++;
+      };
+      buff[n++] = str[x];
+   };
+   *lenp = n;
+
+   return(0);
+}
+
+/* end of source file */
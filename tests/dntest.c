@@ -0,0 +1,374 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/dntest.c  tests parsing and formatting of DNs
+ */
+#define _LDAP_UTILS_TESTS_DNTEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ldap.h>
+#include <ldaputils.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// number of RDNs of generated DN, more than fit without allocating
+#define MY_LONG_RDNS    150
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+// DN and expected formats, DN and UFN are the same as ldap_dn2str()
+typedef struct my_test MyTest;
+struct my_test
+{
+   const char      * str;
+   const char      * dn;
+   const char      * ufn;
+   const char      * dce;
+   const char      * adc;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// displays usage required by libldaputils
+void ldaputils_usage(void);
+
+// main statement
+int main(void);
+
+// compares format of parsed DN with expected string
+int my_check(const char * str, const LDAPUtilsDN * dn, int format, const char * expected);
+
+// tests DN longer than fits without allocating
+int my_long(void);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+static const MyTest my_tests[] =
+{
+   {  "",
+      "",
+      "",
+      "",
+      ""
+   },
+   {  "cn=Doe\\, John,dc=example,dc=com",
+      "cn=Doe\\2C John,dc=example,dc=com",
+      "Doe\\2C John, example.com",
+      "/dc=com/dc=example/cn=Doe\\, John",
+      "example.com/Doe\\, John"
+   },
+   {  "cn=a\\+b\\;c\\\\d\\\"e\\<f\\>g\\=h,o=x",
+      "cn=a\\2Bb\\3Bc\\5Cd\\22e\\3Cf\\3Eg\\3Dh,o=x",
+      "a\\2Bb\\3Bc\\5Cd\\22e\\3Cf\\3Eg\\3Dh, x",
+      "/o=x/cn=a+b;c\\\\d\"e<f>g\\=h",
+      "x/a+b;c\\\\d\"e<f>g=h/"
+   },
+   {  "cn=\\E2\\82\\AC,o=x",
+      "cn=\\E2\\82\\AC,o=x",
+      "\\E2\\82\\AC, x",
+      "/o=x/cn=\xE2\x82\xAC",
+      "x/\xE2\x82\xAC/"
+   },
+   {  "cn=\xC3\x84\xE2\x82\xAC,o=x",
+      "cn=\\C3\\84\\E2\\82\\AC,o=x",
+      "\\C3\\84\\E2\\82\\AC, x",
+      "/o=x/cn=\xC3\x84\xE2\x82\xAC",
+      "x/\xC3\x84\xE2\x82\xAC/"
+   },
+   {  "cn=line\\0Abreak,o=x",
+      "cn=line\nbreak,o=x",
+      "line\nbreak, x",
+      "/o=x/cn=line\\0Abreak",
+      "x/line\nbreak/"
+   },
+   {  "cn=\\20lead\\20,o=x",
+      "cn=\\20lead\\20,o=x",
+      "\\20lead\\20, x",
+      "/o=x/cn= lead ",
+      "x/ lead /"
+   },
+   {  "cn=\\#x,o=x",
+      "cn=\\23x,o=x",
+      "\\23x, x",
+      "/o=x/cn=#x",
+      "x/#x/"
+   },
+   {  "cn=\"a,b\" , o = x",
+      "cn=a\\2Cb,o=x",
+      "a\\2Cb, x",
+      "/o=x/cn=a\\,b",
+      "x/a\\,b/"
+   },
+   {  "cn=a+sn=b+uid=c,ou=people;dc=example,dc=com",
+      "cn=a+sn=b+uid=c,ou=people,dc=example,dc=com",
+      "a + b + c, people, example.com",
+      "/dc=com/dc=example/ou=people/cn=a,sn=b,uid=c",
+      "example.com/people/a,b,c"
+   },
+   {  "1=y,1.2.3=x,0.9.2342.19200300.100.1.25=com",
+      "1=y,1.2.3=x,0.9.2342.19200300.100.1.25=com",
+      "y, x, com",
+      "/0.9.2342.19200300.100.1.25=com/1.2.3=x/1=y",
+      "com/x/y"
+   },
+   {  "cn=a/b,o=x",
+      "cn=a/b,o=x",
+      "a/b, x",
+      "/o=x/cn=a\\/b",
+      "x/a\\/b/"
+   },
+   {  "cn=#04024869,o=x",
+      "cn=#04024869,o=x",
+      "#04024869, x",
+      "/o=x/cn=#04024869",
+      "x/#04024869/"
+   },
+   {  NULL, NULL, NULL, NULL, NULL }
+};
+
+
+// DNs rejected by ldap_str2dn()
+static const char * my_invalid[] =
+{
+   "   ",
+   "0cn=x",
+   "1.2.3cn=x",
+   "1..2=x",
+   "-cn=x",
+   "c_n=x",
+   "cn=x,",
+   "cn=x,,o=y",
+   "cn",
+   "=x",
+   "cn=a\\",
+   "cn=a\\g",
+   "cn=\"x",
+   "cn=a\"b",
+   "cn=#0",
+   NULL
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// displays usage required by libldaputils
+void ldaputils_usage(void)
+{
+   printf("Usage: dntest\n");
+   return;
+}
+
+
+/// main statement
+int main(void)
+{
+   int            errs;
+   size_t         x;
+   size_t         len;
+   char           buff[256];
+   LDAPUtilsDN    dn;
+   LDAPUtilsDN    copy;
+
+   errs = 0;
+
+   for(x = 0; ((my_tests[x].str)); x++)
+   {
+      if (ldaputils_dn_parse(&dn, my_tests[x].str, strlen(my_tests[x].str)) == -1)
+      {
+         printf("FAIL: %s: not parsed\n", my_tests[x].str);
+         errs++;
+         continue;
+      };
+      errs += my_check(my_tests[x].str, &dn, LDAPUTILS_DN_DN,  my_tests[x].dn);
+      errs += my_check(my_tests[x].str, &dn, LDAPUTILS_DN_UFN, my_tests[x].ufn);
+      errs += my_check(my_tests[x].str, &dn, LDAPUTILS_DN_DCE, my_tests[x].dce);
+      errs += my_check(my_tests[x].str, &dn, LDAPUTILS_DN_ADC, my_tests[x].adc);
+
+      // printed DN parses to the same DN
+      len = ldaputils_dn_format(&dn, LDAPUTILS_DN_DN, buff, sizeof(buff));
+      if (ldaputils_dn_parse(&copy, buff, len) == -1)
+      {
+         printf("FAIL: %s: printed DN not parsed\n", my_tests[x].str);
+         errs++;
+      } else {
+         errs += my_check(my_tests[x].str, &copy, LDAPUTILS_DN_DN, my_tests[x].dn);
+         if (copy.avas_len != dn.avas_len)
+         {
+            printf("FAIL: %s: printed DN has %zu values\n", my_tests[x].str, copy.avas_len);
+            errs++;
+         };
+         ldaputils_dn_free(&copy);
+      };
+      ldaputils_dn_free(&dn);
+   };
+
+   for(x = 0; ((my_invalid[x])); x++)
+   {
+      if (ldaputils_dn_parse(&dn, my_invalid[x], strlen(my_invalid[x])) == 0)
+      {
+         printf("FAIL: %s: invalid DN parsed\n", my_invalid[x]);
+         ldaputils_dn_free(&dn);
+         errs++;
+      };
+   };
+
+   errs += my_long();
+
+   printf("%zu DNs tested, %i failures\n", (sizeof(my_tests)/sizeof(MyTest)) + (sizeof(my_invalid)/sizeof(char *)) - 1, errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// compares format of parsed DN with expected string
+/// @param[in] str       DN which was parsed
+/// @param[in] dn        parsed DN
+/// @param[in] format    format of DN
+/// @param[in] expected  expected string
+int my_check(const char * str, const LDAPUtilsDN * dn, int format, const char * expected)
+{
+   size_t         len;
+   char           buff[256];
+
+   len = ldaputils_dn_format(dn, format, buff, sizeof(buff));
+   if ( (len == strlen(expected)) && (!(strcmp(buff, expected))) )
+      return(0);
+   printf("FAIL: %s: format %i: \"%s\", expected \"%s\"\n", str, format, buff, expected);
+
+   return(1);
+}
+
+
+/// tests DN longer than fits without allocating
+int my_long(void)
+{
+   int            errs;
+   size_t         x;
+   size_t         len;
+   size_t         pos;
+   char         * str;
+   char         * out;
+   LDAPUtilsDN    dn;
+
+   errs = 0;
+   len  = (MY_LONG_RDNS * 16) + 1;
+   if ((str = malloc(len)) == NULL)
+      return(1);
+   if ((out = malloc(len)) == NULL)
+   {
+      free(str);
+      return(1);
+   };
+
+   // multi-valued RDN followed by RDNs of one value each
+   for(x = 0, pos = 0; (x < MY_LONG_RDNS); x++)
+      pos += (size_t)snprintf(&str[pos], len - pos, "%sou=%zu", ((x == 0)) ? "" : ((x < 80)) ? "+" : ",", x);
+
+   if (ldaputils_dn_parse(&dn, str, pos) == -1)
+   {
+      printf("FAIL: DN of %i values not parsed\n", MY_LONG_RDNS);
+      free(str);
+      free(out);
+      return(1);
+   };
+   if ( (dn.avas_len != MY_LONG_RDNS) || (dn.rdns_len != (MY_LONG_RDNS - 79)) || ((dn.rdns[1] - dn.rdns[0]) != 80) )
+   {
+      printf("FAIL: DN of %i values parsed as %zu values of %zu RDNs\n", MY_LONG_RDNS, dn.avas_len, dn.rdns_len);
+      errs++;
+   };
+   if ( (ldaputils_dn_format(&dn, LDAPUTILS_DN_DN, out, len) != pos) || ((strcmp(str, out))) )
+   {
+      printf("FAIL: DN of %i values printed as \"%s\"\n", MY_LONG_RDNS, out);
+      errs++;
+   };
+   ldaputils_dn_free(&dn);
+
+   free(str);
+   free(out);
+
+   return(errs);
+}
+
+/* end of source file */
@@ -0,0 +1,318 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/entrytest.c  tests DNs and references of entries
+ */
+#define _LDAP_UTILS_TESTS_ENTRYTEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <ldap.h>
+#include <ldaputils.h>
+
+#include "lentry.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// number of threads creating and releasing entries
+#define MY_THREADS      4
+
+// entries created by each thread
+#define MY_ENTRIES      5000
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// displays usage required by libldaputils
+void ldaputils_usage(void);
+
+// main statement
+int main(void);
+
+// checks DN of entry and of copy of entry
+int my_check(const char * dn);
+
+// checks private copy of shared entry
+int my_detach(void);
+
+// creates and releases entries with DNs sharing parent nodes and references to shared entry
+void * my_thread(void * arg);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+// DNs are returned as passed instead of rebuilt from RDNs
+static const char * my_dns[] =
+{
+   "dc=example,dc=com",
+   "uid=jdoe,ou=people,dc=example,dc=com",
+   "UID=jdoe, OU=People, DC=Example, DC=com",
+   "cn=Doe\\, John,ou=people,dc=example,dc=com",
+   "cn=John Doe+uid=jdoe,ou=people,dc=example,dc=com",
+   "cn=\\E2\\82\\AC,ou=people,dc=example,dc=com",
+   NULL
+};
+
+// entry retained and released by all threads
+static LDAPUtilsEntry * my_shared = NULL;
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// displays usage required by libldaputils
+void ldaputils_usage(void)
+{
+   printf("Usage: entrytest\n");
+   return;
+}
+
+
+int main(void)
+{
+   int            errs;
+   size_t         x;
+   size_t         ids[MY_THREADS];
+   uintptr_t      rc;
+   pthread_t      threads[MY_THREADS];
+
+   errs = 0;
+
+   for(x = 0; ((my_dns[x])); x++)
+      errs += my_check(my_dns[x]);
+   errs += my_detach();
+
+   // concurrent lookups and releases of shared DN nodes and entry
+   if ((my_shared = ldaputils_entry_initialize(my_dns[1])) == NULL)
+   {
+      printf("FAIL: %s: entry not initialized\n", my_dns[1]);
+      return(1);
+   };
+   for(x = 0; x < MY_THREADS; x++)
+   {
+      ids[x] = x;
+      if ((pthread_create(&threads[x], NULL, my_thread, &ids[x])))
+      {
+         printf("FAIL: unable to create thread\n");
+         return(1);
+      };
+   };
+   for(x = 0; x < MY_THREADS; x++)
+   {
+      pthread_join(threads[x], (void **)&rc);
+      errs += (int)rc;
+   };
+   if (atomic_load(&my_shared->refcount) != 1)
+   {
+      printf("FAIL: shared entry has %zu references\n", atomic_load(&my_shared->refcount));
+      errs++;
+   };
+   ldaputils_entry_free(my_shared);
+
+   printf("%zu DNs tested, %i failures\n", (sizeof(my_dns)/sizeof(char *)) - 1 + (MY_THREADS * MY_ENTRIES), errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// checks DN of entry and of copy of entry
+/// @param[in] dn      DN of entry
+int my_check(const char * dn)
+{
+   int               errs;
+   const char      * str;
+   LDAPUtilsEntry  * entry;
+   LDAPUtilsEntry  * copy;
+
+   if ((entry = ldaputils_entry_initialize(dn)) == NULL)
+   {
+      printf("FAIL: %s: entry not initialized\n", dn);
+      return(1);
+   };
+   if ((copy = ldaputils_entry_copy(entry)) == NULL)
+   {
+      printf("FAIL: %s: entry not copied\n", dn);
+      ldaputils_entry_free(entry);
+      return(1);
+   };
+
+   errs = 0;
+   if ( ((str = ldaputils_get_dn(entry)) == NULL) || ((strcmp(str, dn))) )
+   {
+      printf("FAIL: %s: entry DN \"%s\"\n", dn, ((str)) ? str : "(null)");
+      errs++;
+   };
+   if ( ((str = ldaputils_get_dn(copy)) == NULL) || ((strcmp(str, dn))) )
+   {
+      printf("FAIL: %s: copied entry DN \"%s\"\n", dn, ((str)) ? str : "(null)");
+      errs++;
+   };
+   if (ldaputils_entry_cmp_dn(&entry, &copy) != 0)
+   {
+      printf("FAIL: %s: copied entry sorts apart from entry\n", dn);
+      errs++;
+   };
+
+   ldaputils_entry_free(copy);
+   ldaputils_entry_free(entry);
+
+   return(errs);
+}
+
+
+/// checks private copy of shared entry
+int my_detach(void)
+{
+   int               errs;
+   LDAPUtilsEntry  * entry;
+   LDAPUtilsEntry  * copy;
+
+   if ((entry = ldaputils_entry_initialize(my_dns[1])) == NULL)
+   {
+      printf("FAIL: %s: entry not initialized\n", my_dns[1]);
+      return(1);
+   };
+
+   errs = 0;
+
+   // entry which is not shared is modified in place
+   copy = entry;
+   if ( (ldaputils_entry_detach(&copy) != LDAP_SUCCESS) || (copy != entry) )
+   {
+      printf("FAIL: %s: entry without other references copied\n", my_dns[1]);
+      errs++;
+   };
+
+   // shared entry is replaced by copy
+   ldaputils_entry_retain(entry);
+   copy = entry;
+   if ( (ldaputils_entry_detach(&copy) != LDAP_SUCCESS) || (copy == entry) )
+   {
+      printf("FAIL: %s: shared entry not copied\n", my_dns[1]);
+      errs++;
+   } else {
+      if ( (atomic_load(&entry->refcount) != 1) || (atomic_load(&copy->refcount) != 1) )
+      {
+         printf("FAIL: %s: references not moved to copy\n", my_dns[1]);
+         errs++;
+      };
+      if ((strcmp(ldaputils_get_dn(copy), my_dns[1])))
+      {
+         printf("FAIL: %s: copy has DN \"%s\"\n", my_dns[1], ldaputils_get_dn(copy));
+         errs++;
+      };
+      ldaputils_entry_free(copy);
+   };
+   ldaputils_entry_free(entry);
+
+   return(errs);
+}
+
+
+/// creates and releases entries with DNs sharing parent nodes and references to shared entry
+/// @param[in] arg     index of thread
+void * my_thread(void * arg)
+{
+   uintptr_t         errs;
+   size_t            x;
+   size_t            id;
+   char              dn[128];
+   const char      * str;
+   LDAPUtilsEntry  * entry;
+
+   id   = *((size_t *)arg);
+   errs = 0;
+
+   for(x = 0; x < MY_ENTRIES; x++)
+   {
+      snprintf(dn, sizeof(dn), "uid=user%zu,ou=group%zu,dc=example,dc=com", (x * MY_THREADS) + id, x % 7);
+      if ((entry = ldaputils_entry_initialize(dn)) == NULL)
+      {
+         printf("FAIL: %s: entry not initialized\n", dn);
+         errs++;
+         continue;
+      };
+      if ( ((str = ldaputils_get_dn(entry)) == NULL) || ((strcmp(str, dn))) )
+      {
+         printf("FAIL: %s: entry DN \"%s\"\n", dn, ((str)) ? str : "(null)");
+         errs++;
+      };
+      ldaputils_entry_free(entry);
+      ldaputils_entry_free(ldaputils_entry_retain(my_shared));
+   };
+
+   return((void *)errs);
+}
+
+/* end of source file */
@@ -0,0 +1,156 @@
+#!/bin/sh
+#
+#   LDAP Utilities
+#   Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+#   All rights reserved.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_START@
+#
+#   Redistribution and use in source and binary forms, with or without
+#   modification, are permitted provided that the following conditions are
+#   met:
+#
+#      1. Redistributions of source code must retain the above copyright
+#         notice, this list of conditions and the following disclaimer.
+#
+#      2. Redistributions in binary form must reproduce the above copyright
+#         notice, this list of conditions and the following disclaimer in the
+#         documentation and/or other materials provided with the distribution.
+#
+#      3. Neither the name of the copyright holder nor the names of its
+#         contributors may be used to endorse or promote products derived from
+#         this software without specific prior written permission.
+#
+#   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#   THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+#   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_END@
+#   tests/ldif2csv.sh - checks LDIF parsing and reporting of invalid records
+#
+
+TESTNAME="`basename ${0}`" || exit 1
+LDIF2CSV="${LDIF2CSV:-./src/ldif2csv}"
+WORKDIR="`mktemp -d ${TMPDIR:-/tmp}/ldif2csv.XXXXXX`" || exit 1
+trap 'rm -rf "${WORKDIR}"' 0
+
+LDAPNOINIT=1
+export LDAPNOINIT
+
+
+# runs ldif2csv and compares exit status, output, and error
+#    usage: ldif2csv_test <name> <status> <error> [options]
+ldif2csv_test()
+{
+   NAME="${1}"
+   STATUS="${2}"
+   ERROR="${3}"
+   shift 3
+   ${LDIF2CSV} "${@}" > ${WORKDIR}/${NAME}.out 2> ${WORKDIR}/${NAME}.err
+   RC=$?
+   if test ${RC} -ne ${STATUS};then
+      echo "${TESTNAME}: ${NAME}: ldif2csv exited with ${RC}"
+      cat ${WORKDIR}/${NAME}.err
+      exit 1
+   fi
+   if test "x${ERROR}" = "x";then
+      if test -s ${WORKDIR}/${NAME}.err;then
+         echo "${TESTNAME}: ${NAME}: unexpected error"
+         cat ${WORKDIR}/${NAME}.err
+         exit 1
+      fi
+   elif ! grep -- "${ERROR}\$" ${WORKDIR}/${NAME}.err > /dev/null;then
+      echo "${TESTNAME}: ${NAME}: expected error: ${ERROR}"
+      cat ${WORKDIR}/${NAME}.err
+      exit 1
+   fi
+}
+
+
+# comments, version, folded lines, base64 values and add records
+cat > ${WORKDIR}/values.ldif << EOS || exit 1
+# leading comment
+version: 1
+
+dn: uid=jdoe,ou=people,
+ dc=example,dc=com
+uid: jdoe
+cn: J
+ ohn Doe
+description:: VHdvCkxpbmVz
+mail: jdoe@example.com
+mail: john@example.com
+
+# comment between records
+dn:: dWlkPWrDtnJnLG91PXBlb3BsZSxkYz1leGFtcGxlLGRjPWNvbQ==
+changetype: add
+uid: jorg
+cn:: SsO2cmcgIk1hdHRlIiBTbWl0aA==
+mail: jorg|smith@example.com
+EOS
+printf '"dn","uid","cn","description","mail"\n'                            >  ${WORKDIR}/values.exp
+printf '"uid=jdoe,ou=people,dc=example,dc=com","jdoe","John Doe",'         >> ${WORKDIR}/values.exp
+printf '"Two\nLines","jdoe@example.com|john@example.com"\n'                >> ${WORKDIR}/values.exp
+printf '"uid=j\303\266rg,ou=people,dc=example,dc=com","jorg",'             >> ${WORKDIR}/values.exp
+printf '"J\303\266rg '"'"'Matte'"'"' Smith","","jorg:smith@example.com"\n' >> ${WORKDIR}/values.exp
+ldif2csv_test values 0 "" -f ${WORKDIR}/values.ldif dn uid cn description mail
+cmp ${WORKDIR}/values.exp ${WORKDIR}/values.out || exit 1
+
+
+# entries spanning several chunks precede each invalid record
+awk 'BEGIN { for(x = 0; x < 30000; x++) printf("dn: uid=user%d,ou=people,dc=example,dc=com\nuid: user%d\n\n", x, x) }' \
+   > ${WORKDIR}/entries.ldif || exit 1
+OFFSET="`wc -c < ${WORKDIR}/entries.ldif | tr -d ' '`" || exit 1
+
+# line without attribute description
+cat ${WORKDIR}/entries.ldif - > ${WORKDIR}/invalid.ldif << EOS || exit 1
+dn: uid=invalid,ou=people,dc=example,dc=com
+invalid line
+
+dn: uid=after,ou=people,dc=example,dc=com
+uid: after
+EOS
+
+# value referenced by URL
+cat ${WORKDIR}/entries.ldif - > ${WORKDIR}/url.ldif << EOS || exit 1
+dn: uid=url,ou=people,dc=example,dc=com
+uid: url
+jpegPhoto:< file:///dev/null
+EOS
+
+# modify record with separators between changes
+cat ${WORKDIR}/entries.ldif - > ${WORKDIR}/modify.ldif << EOS || exit 1
+dn: uid=user1,ou=people,dc=example,dc=com
+changetype: modify
+replace: mail
+mail: user1@example.com
+-
+delete: description
+-
+EOS
+
+for NAME in invalid url modify;do
+   case ${NAME} in
+      invalid) ERROR="offset ${OFFSET}: invalid LDIF record";;
+      url)     ERROR="offset ${OFFSET}: URL values not supported";;
+      modify)  ERROR="offset ${OFFSET}: change records not supported";;
+   esac
+   ldif2csv_test ${NAME} 1 "${ERROR}" --threads=4 -f ${WORKDIR}/${NAME}.ldif dn uid
+   LINES="`wc -l < ${WORKDIR}/${NAME}.out | tr -d ' '`" || exit 1
+   if test "x${LINES}" != "x30001";then
+      echo "${TESTNAME}: ${NAME}: ${LINES} lines written before error"
+      exit 1
+   fi
+   tail -1 ${WORKDIR}/${NAME}.out | grep '^"uid=user29999,' > /dev/null || exit 1
+done
+
+
+# end of script
@@ -0,0 +1,140 @@
+#!/bin/sh
+#
+#   LDAP Utilities
+#   Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+#   All rights reserved.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_START@
+#
+#   Redistribution and use in source and binary forms, with or without
+#   modification, are permitted provided that the following conditions are
+#   met:
+#
+#      1. Redistributions of source code must retain the above copyright
+#         notice, this list of conditions and the following disclaimer.
+#
+#      2. Redistributions in binary form must reproduce the above copyright
+#         notice, this list of conditions and the following disclaimer in the
+#         documentation and/or other materials provided with the distribution.
+#
+#      3. Neither the name of the copyright holder nor the names of its
+#         contributors may be used to endorse or promote products derived from
+#         this software without specific prior written permission.
+#
+#   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#   THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+#   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_END@
+#   tests/ldifdiff.sh - compares files larger than the memory limit
+#
+
+TESTNAME="`basename ${0}`" || exit 1
+LDIFDIFF="${LDIFDIFF:-./src/ldifdiff}"
+WORKDIR="`mktemp -d ${TMPDIR:-/tmp}/ldifdiff.XXXXXX`" || exit 1
+trap 'rm -rf "${WORKDIR}"' 0
+
+LDAPNOINIT=1
+export LDAPNOINIT
+
+
+# runs ldifdiff and checks that files were compared the expected way
+#    usage: ldifdiff_test <name> <mode> [options]
+ldifdiff_test()
+{
+   NAME="${1}"
+   MODE="${2}"
+   shift 2
+   ${LDIFDIFF} -v "${@}" -o ${WORKDIR}/${NAME}.out \
+      ${WORKDIR}/old.ldif ${WORKDIR}/new.ldif 2> ${WORKDIR}/${NAME}.err
+   RC=$?
+   if test ${RC} -ne 1;then
+      echo "${TESTNAME}: ${NAME}: ldifdiff exited with ${RC}"
+      cat ${WORKDIR}/${NAME}.err
+      exit 1
+   fi
+   if ! grep "buckets ${MODE} with" ${WORKDIR}/${NAME}.err > /dev/null;then
+      echo "${TESTNAME}: ${NAME}: buckets not ${MODE}"
+      cat ${WORKDIR}/${NAME}.err
+      exit 1
+   fi
+}
+
+
+# counts change records of type
+#    usage: ldifdiff_count <name> <changetype> <count>
+ldifdiff_count()
+{
+   COUNT="`grep -c \"^changetype: ${2}\$\" ${WORKDIR}/${1}.out`"
+   if test "x${COUNT}" != "x${3}";then
+      echo "${TESTNAME}: ${1}: ${COUNT} ${2} records, expected ${3}"
+      exit 1
+   fi
+}
+
+
+# every hundredth entry is deleted or modified, others only differ by the
+# order of attributes or by folding, and entries are appended
+awk 'BEGIN {
+   for(x = 0; x < 20000; x++)
+   {
+      printf("dn: uid=user%d,ou=people,dc=example,dc=com\n", x);
+      printf("objectClass: inetOrgPerson\nuid: user%d\ncn: User %d\n", x, x);
+      printf("mail: user%d@example.com\n", x);
+      printf("description: entry %d of the generated directory\n\n", x);
+   }
+}' > ${WORKDIR}/old.ldif || exit 1
+awk 'BEGIN {
+   for(x = 1; x < 20150; x++)
+   {
+      if ((x % 100) == 0)
+         continue;
+      printf("dn: uid=user%d,ou=people,dc=example,dc=com\n", x);
+      printf("objectClass: inetOrgPerson\nuid: user%d\n", x);
+      if ((x % 100) == 1)
+         printf("cn: Changed %d\nmail: user%d@example.com\n", x, x);
+      else if ((x % 100) == 2)
+         printf("mail: user%d@example.com\ncn: User %d\n", x, x);
+      else
+         printf("cn: User %d\nmail: user%d@example.com\n", x, x);
+      if ((x % 100) == 3)
+         printf("description: entry %d of the gen\n erated directory\n\n", x);
+      else
+         printf("description: entry %d of the generated directory\n\n", x);
+   }
+}' > ${WORKDIR}/new.ldif || exit 1
+
+cat > ${WORKDIR}/modify.exp << EOS || exit 1
+dn: uid=user101,ou=people,dc=example,dc=com
+changetype: modify
+replace: cn
+cn: Changed 101
+-
+
+EOS
+
+
+# files are compared in memory and in temporary files smaller than the files
+ldifdiff_test memory "in memory" --threads=2
+ldifdiff_test disk "stored in temporary files" --threads=3 --memory=1M
+ldifdiff_test single "stored in temporary files" --threads=1 --memory=1M
+for NAME in memory disk single;do
+   ldifdiff_count ${NAME} delete 200
+   ldifdiff_count ${NAME} add 148
+   ldifdiff_count ${NAME} modify 200
+   grep -A5 '^dn: uid=user101,' ${WORKDIR}/${NAME}.out > ${WORKDIR}/${NAME}.modify
+   cmp ${WORKDIR}/modify.exp ${WORKDIR}/${NAME}.modify || exit 1
+done
+cmp ${WORKDIR}/memory.out ${WORKDIR}/disk.out   || exit 1
+cmp ${WORKDIR}/memory.out ${WORKDIR}/single.out || exit 1
+
+
+# end of script
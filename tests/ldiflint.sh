@@ -0,0 +1,116 @@
+#!/bin/sh
+#
+#   LDAP Utilities
+#   Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+#   All rights reserved.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_START@
+#
+#   Redistribution and use in source and binary forms, with or without
+#   modification, are permitted provided that the following conditions are
+#   met:
+#
+#      1. Redistributions of source code must retain the above copyright
+#         notice, this list of conditions and the following disclaimer.
+#
+#      2. Redistributions in binary form must reproduce the above copyright
+#         notice, this list of conditions and the following disclaimer in the
+#         documentation and/or other materials provided with the distribution.
+#
+#      3. Neither the name of the copyright holder nor the names of its
+#         contributors may be used to endorse or promote products derived from
+#         this software without specific prior written permission.
+#
+#   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#   THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+#   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_END@
+#   tests/ldiflint.sh - checks add records and skips other change records
+#
+
+TESTNAME="`basename ${0}`" || exit 1
+LDIFLINT="${LDIFLINT:-./src/ldiflint}"
+WORKDIR="`mktemp -d ${TMPDIR:-/tmp}/ldiflint.XXXXXX`" || exit 1
+trap 'rm -rf "${WORKDIR}"' 0
+
+LDAPNOINIT=1
+export LDAPNOINIT
+
+
+# schema used to check entries
+cat > ${WORKDIR}/test.schema << EOS || exit 1
+objectclass ( 2.5.6.0 NAME 'top' ABSTRACT MUST objectClass )
+objectclass ( 2.5.6.6 NAME 'person' SUP top STRUCTURAL
+	MUST ( sn \$ cn ) MAY description )
+objectclass ( 2.5.6.5 NAME 'organizationalUnit' SUP top STRUCTURAL
+	MUST ou MAY description )
+attributetype ( 2.5.4.0 NAME 'objectClass'
+	SYNTAX 1.3.6.1.4.1.1466.115.121.1.38 )
+attributetype ( 2.5.4.41 NAME 'name'
+	SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 )
+attributetype ( 2.5.4.3 NAME ( 'cn' 'commonName' ) SUP name )
+attributetype ( 2.5.4.4 NAME ( 'sn' 'surname' ) SUP name )
+attributetype ( 2.5.4.11 NAME ( 'ou' 'organizationalUnitName' ) SUP name )
+attributetype ( 2.5.4.13 NAME 'description'
+	SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 )
+attributetype ( 0.9.2342.19200300.100.1.3 NAME 'mail'
+	SYNTAX 1.3.6.1.4.1.1466.115.121.1.26 )
+EOS
+
+
+# content record, modify record, delete record and add record
+cat > ${WORKDIR}/test.ldif << EOS || exit 1
+version: 1
+
+dn: ou=people,dc=example,dc=com
+objectClass: organizationalUnit
+ou: people
+
+dn: cn=Jane Doe,ou=people,dc=example,dc=com
+changetype: modify
+replace: sn
+sn: Doe
+-
+add: mail
+mail: jane@example.com
+-
+
+dn: cn=John Doe,ou=people,dc=example,dc=com
+changetype: delete
+
+dn: cn=Bob,ou=people,dc=example,dc=com
+changetype: add
+objectClass: person
+cn: Bob
+EOS
+
+
+cat > ${WORKDIR}/expected.out << EOS || exit 1
+cn=Bob,ou=people,dc=example,dc=com: missing required attribute: sn
+EOS
+
+
+# only the add record has violations
+${LDIFLINT} -v -s ${WORKDIR}/test.schema -f ${WORKDIR}/test.ldif \
+   > ${WORKDIR}/test.out 2> ${WORKDIR}/test.err
+RC=$?
+if test ${RC} -ne 1;then
+   echo "${TESTNAME}: ldiflint exited with ${RC}"
+   cat ${WORKDIR}/test.err
+   exit 1
+fi
+diff ${WORKDIR}/expected.out ${WORKDIR}/test.out || exit 1
+grep '2 entries checked' ${WORKDIR}/test.err > /dev/null || exit 1
+grep '2 change records skipped' ${WORKDIR}/test.err > /dev/null || exit 1
+
+
+# end of script
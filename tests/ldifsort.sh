@@ -0,0 +1,110 @@
+#!/bin/sh
+#
+#   LDAP Utilities
+#   Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+#   All rights reserved.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_START@
+#
+#   Redistribution and use in source and binary forms, with or without
+#   modification, are permitted provided that the following conditions are
+#   met:
+#
+#      1. Redistributions of source code must retain the above copyright
+#         notice, this list of conditions and the following disclaimer.
+#
+#      2. Redistributions in binary form must reproduce the above copyright
+#         notice, this list of conditions and the following disclaimer in the
+#         documentation and/or other materials provided with the distribution.
+#
+#      3. Neither the name of the copyright holder nor the names of its
+#         contributors may be used to endorse or promote products derived from
+#         this software without specific prior written permission.
+#
+#   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+#   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+#   THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+#   PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+#   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+#   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+#   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+#   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+#   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+#   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+#   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+#   @BINDLE_BINARIES_BSD_LICENSE_END@
+#   tests/ldifsort.sh - sorts files larger than the memory limit
+#
+
+TESTNAME="`basename ${0}`" || exit 1
+LDIFSORT="${LDIFSORT:-./src/ldifsort}"
+WORKDIR="`mktemp -d ${TMPDIR:-/tmp}/ldifsort.XXXXXX`" || exit 1
+trap 'rm -rf "${WORKDIR}"' 0
+
+LDAPNOINIT=1
+export LDAPNOINIT
+
+
+# runs ldifsort and checks exit status
+#    usage: ldifsort_test <name> [options]
+ldifsort_test()
+{
+   NAME="${1}"
+   shift 1
+   ${LDIFSORT} "${@}" -o ${WORKDIR}/${NAME}.out ${WORKDIR}/input.ldif 2> ${WORKDIR}/${NAME}.err
+   RC=$?
+   if test ${RC} -ne 0;then
+      echo "${TESTNAME}: ${NAME}: ldifsort exited with ${RC}"
+      cat ${WORKDIR}/${NAME}.err
+      exit 1
+   fi
+}
+
+
+# entries in shuffled order, large enough to need several runs of 1M
+awk 'BEGIN {
+   for(x = 0; x < 30000; x++)
+   {
+      y = (x * 7919) % 30000;
+      printf("dn: uid=user%05d,ou=people,dc=example,dc=com\n", y);
+      printf("uid: user%05d\ncn: Name %05d\n", y, (30000 - y) % 1000);
+      printf("description: generated entry used to fill runs of the sort\n\n");
+   }
+}' > ${WORKDIR}/input.ldif || exit 1
+awk 'BEGIN {
+   for(x = 0; x < 30000; x++)
+      printf("dn: uid=user%05d,ou=people,dc=example,dc=com\n", x);
+}' > ${WORKDIR}/dn.exp || exit 1
+
+
+# sorts by DN in memory and with sorted runs in temporary files
+ldifsort_test memory
+ldifsort_test runs -v --memory=1M
+RUNS="`grep -c '^ldifsort: wrote run ' ${WORKDIR}/runs.err`"
+if test "${RUNS}" -lt 2;then
+   echo "${TESTNAME}: runs: ${RUNS} runs written"
+   exit 1
+fi
+grep '^dn: ' ${WORKDIR}/memory.out > ${WORKDIR}/memory.dn
+cmp ${WORKDIR}/dn.exp ${WORKDIR}/memory.dn    || exit 1
+cmp ${WORKDIR}/memory.out ${WORKDIR}/runs.out || exit 1
+
+
+# sorts by attribute with sorted runs in temporary files
+ldifsort_test attr_memory -S cn
+ldifsort_test attr_runs -S cn --memory=1M
+grep '^cn: ' ${WORKDIR}/attr_memory.out | LC_ALL=C sort -c || exit 1
+cmp ${WORKDIR}/attr_memory.out ${WORKDIR}/attr_runs.out || exit 1
+
+
+# memory below the minimum is rejected
+${LDIFSORT} --memory=512K -o ${WORKDIR}/small.out ${WORKDIR}/input.ldif 2> ${WORKDIR}/small.err
+if test $? -ne 1 || ! grep 'less than the minimum of 1M$' ${WORKDIR}/small.err > /dev/null;then
+   echo "${TESTNAME}: small: memory below minimum accepted"
+   cat ${WORKDIR}/small.err
+   exit 1
+fi
+
+
+# end of script
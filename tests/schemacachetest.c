@@ -0,0 +1,436 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/schemacachetest.c  tests reading and writing of schema cache files
+ */
+#define _LDAP_UTILS_TESTS_SCHEMACACHETEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <ldap.h>
+#include <ldapschema.h>
+
+#include "lcache.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// URI of server described by cache
+#define MY_URI          "ldap://ldap.example.com/"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(void);
+
+// appends fields and definitions to cache
+int my_build(LDAPSchemaCache * cache);
+
+// checks that damaged cache file is rejected
+int my_invalid(const char * dir, const char * name, const char * data, size_t len);
+
+// checks names of cache files
+int my_path(void);
+
+// writes, reads, and parses cache
+int my_roundtrip(const char * dir);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+// URI, DN, modifyTimestamp and entryCSN of subschema entry, entryCSN is empty
+static const char * my_fields[] =
+{
+   MY_URI,
+   "cn=Subschema",
+   "20261018120000Z",
+   "",
+   NULL
+};
+
+// definitions are stored in order of subschema entry, not in order of parsing
+static const struct
+{
+   int          type;
+   const char * def;
+} my_defs[] =
+{
+   { LDAPSCHEMA_OBJECTCLASS,   "( 2.5.6.0 NAME 'top' ABSTRACT MUST objectClass )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.3 NAME 'cn' SUP name )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.0 NAME 'objectClass' EQUALITY objectIdentifierMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.38 )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.41 NAME 'name' EQUALITY caseIgnoreMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.15{32768} )" },
+   { LDAPSCHEMA_SYNTAX,        "( 1.3.6.1.4.1.1466.115.121.1.15 DESC 'Directory String' )" },
+   { LDAPSCHEMA_SYNTAX,        "( 1.3.6.1.4.1.1466.115.121.1.38 DESC 'OID' )" },
+   { 0, NULL }
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+int main(void)
+{
+   int               errs;
+   int               tests;
+   char              dir[256];
+   char            * data;
+   size_t            len;
+   LDAPSchemaCache   cache;
+
+   snprintf(dir, sizeof(dir), "%s/schemacachetest.XXXXXX", ((getenv("TMPDIR"))) ? getenv("TMPDIR") : "/tmp");
+   if (mkdtemp(dir) == NULL)
+   {
+      printf("FAIL: unable to create directory %s\n", dir);
+      return(1);
+   };
+
+   errs  = 0;
+   tests = 0;
+
+   errs += my_path();
+   tests++;
+
+   errs += my_roundtrip(dir);
+   tests++;
+
+   // damaged copies of valid cache
+   bzero(&cache, sizeof(cache));
+   if (my_build(&cache) == -1)
+   {
+      printf("FAIL: unable to build cache\n");
+      rmdir(dir);
+      return(1);
+   };
+   if ((data = malloc(cache.data_len + 64)) == NULL)
+   {
+      printf("FAIL: out of virtual memory\n");
+      ldapschema_cache_free(&cache);
+      rmdir(dir);
+      return(1);
+   };
+
+   errs += my_invalid(dir, "empty", cache.data, 0);
+   errs += my_invalid(dir, "magic only", cache.data, LDAPSCHEMA_CACHE_MAGIC_LEN - 1);
+   errs += my_invalid(dir, "truncated record", cache.data, cache.data_len - 1);
+   errs += my_invalid(dir, "truncated header", cache.data, cache.data_len - 6 - strlen(my_defs[5].def) + 3);
+   tests += 4;
+
+   memcpy(data, cache.data, cache.data_len);
+   data[0] = 'X';
+   errs += my_invalid(dir, "bad magic", data, cache.data_len);
+   tests++;
+
+   memcpy(data, cache.data, cache.data_len);
+   data[cache.data_len - 1] = 'X';
+   errs += my_invalid(dir, "unterminated record", data, cache.data_len);
+   tests++;
+
+   // only URI, DN and modifyTimestamp
+   len = LDAPSCHEMA_CACHE_MAGIC_LEN;
+   len += strlen(my_fields[0]) + 6;
+   len += strlen(my_fields[1]) + 6;
+   len += strlen(my_fields[2]) + 6;
+   errs += my_invalid(dir, "missing field", cache.data, len);
+   tests++;
+
+   // field following definitions
+   if (ldapschema_cache_append(&cache, LDAPSCHEMA_CACHE_FIELD, "extra", 5) == -1)
+   {
+      printf("FAIL: unable to append field\n");
+      errs++;
+   } else {
+      errs += my_invalid(dir, "trailing field", cache.data, cache.data_len);
+   };
+   tests++;
+
+   free(data);
+   ldapschema_cache_free(&cache);
+   rmdir(dir);
+
+   printf("%i cache files tested, %i failures\n", tests, errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// appends fields and definitions to cache
+/// @param[in] cache   reference to cache
+int my_build(LDAPSchemaCache * cache)
+{
+   size_t x;
+
+   for(x = 0; ((my_fields[x])); x++)
+      if (ldapschema_cache_append(cache, LDAPSCHEMA_CACHE_FIELD, my_fields[x], strlen(my_fields[x])) == -1)
+         return(-1);
+   for(x = 0; ((my_defs[x].def)); x++)
+      if (ldapschema_cache_append(cache, my_defs[x].type, my_defs[x].def, strlen(my_defs[x].def)) == -1)
+         return(-1);
+
+   return(0);
+}
+
+
+/// checks that damaged cache file is rejected
+/// @param[in] dir     temporary directory
+/// @param[in] name    description of damage
+/// @param[in] data    contents of cache file
+/// @param[in] len     length of contents
+int my_invalid(const char * dir, const char * name, const char * data, size_t len)
+{
+   int               fd;
+   int               errs;
+   char              file[512];
+   LDAPSchemaCache   cache;
+
+   snprintf(file, sizeof(file), "%s/invalid.cache", dir);
+   if ((fd = open(file, O_WRONLY|O_CREAT|O_TRUNC, 0600)) == -1)
+   {
+      printf("FAIL: %s: unable to create %s\n", name, file);
+      return(1);
+   };
+   if ( ((len)) && (write(fd, data, len) != (ssize_t)len) )
+   {
+      printf("FAIL: %s: unable to write %s\n", name, file);
+      close(fd);
+      unlink(file);
+      return(1);
+   };
+   close(fd);
+
+   errs = 0;
+   if (ldapschema_cache_read(&cache, file) != -1)
+   {
+      printf("FAIL: %s: damaged cache file accepted\n", name);
+      ldapschema_cache_free(&cache);
+      errs++;
+   };
+   unlink(file);
+
+   return(errs);
+}
+
+
+/// checks names of cache files
+int my_path(void)
+{
+   int      errs;
+   char   * path1;
+   char   * path2;
+   char   * path3;
+
+   path1 = ldapschema_cache_path("/var/cache", MY_URI);
+   path2 = ldapschema_cache_path("/var/cache", MY_URI);
+   path3 = ldapschema_cache_path("/var/cache", "ldap://ldap2.example.com/");
+   if ( (!(path1)) || (!(path2)) || (!(path3)) )
+   {
+      printf("FAIL: path: out of virtual memory\n");
+      free(path1);
+      free(path2);
+      free(path3);
+      return(1);
+   };
+
+   errs = 0;
+   if ( (strlen(path1) != 40) || ((strncmp(path1, "/var/cache/schema-", 18))) || ((strcmp(&path1[34], ".cache"))) )
+   {
+      printf("FAIL: path: unexpected name \"%s\"\n", path1);
+      errs++;
+   };
+   if ((strcmp(path1, path2)))
+   {
+      printf("FAIL: path: \"%s\" and \"%s\" name same server\n", path1, path2);
+      errs++;
+   };
+   if (!(strcmp(path1, path3)))
+   {
+      printf("FAIL: path: different servers share \"%s\"\n", path1);
+      errs++;
+   };
+
+   free(path1);
+   free(path2);
+   free(path3);
+
+   return(errs);
+}
+
+
+/// writes, reads, and parses cache
+/// @param[in] dir     temporary directory
+int my_roundtrip(const char * dir)
+{
+   int               errs;
+   int               rc;
+   int               type;
+   size_t            x;
+   size_t            pos;
+   char            * file;
+   struct berval     str;
+   struct berval   * fields[LDAPSCHEMA_CACHE_FIELDS];
+   LDAPSchema      * lsd;
+   LDAPSchemaCache   cache;
+
+   bzero(&cache, sizeof(cache));
+   if ( (my_build(&cache) == -1) || ((file = ldapschema_cache_path(dir, MY_URI)) == NULL) )
+   {
+      printf("FAIL: roundtrip: out of virtual memory\n");
+      ldapschema_cache_free(&cache);
+      return(1);
+   };
+   rc = ldapschema_cache_write(&cache, file);
+   ldapschema_cache_free(&cache);
+   if (rc == -1)
+   {
+      printf("FAIL: roundtrip: unable to write %s\n", file);
+      free(file);
+      return(1);
+   };
+   rc = ldapschema_cache_read(&cache, file);
+   unlink(file);
+   free(file);
+   if (rc == -1)
+   {
+      printf("FAIL: roundtrip: written cache rejected\n");
+      return(1);
+   };
+
+   errs = 0;
+
+   // fields
+   fields[0] = &cache.uri;
+   fields[1] = &cache.dn;
+   fields[2] = &cache.timestamp;
+   fields[3] = &cache.csn;
+   for(x = 0; (x < LDAPSCHEMA_CACHE_FIELDS); x++)
+   {
+      if ( (fields[x]->bv_len != strlen(my_fields[x])) || ((strcmp(fields[x]->bv_val, my_fields[x]))) )
+      {
+         printf("FAIL: roundtrip: field %zu is \"%s\", expected \"%s\"\n", x, fields[x]->bv_val, my_fields[x]);
+         errs++;
+      };
+   };
+
+   // definitions
+   pos = cache.defs;
+   for(x = 0; ((my_defs[x].def)); x++)
+   {
+      if ((rc = ldapschema_cache_next(&cache, &pos, &type, &str)) != 1)
+      {
+         printf("FAIL: roundtrip: definition %zu missing\n", x);
+         errs++;
+         break;
+      };
+      if ( (type != my_defs[x].type) || (str.bv_len != strlen(my_defs[x].def)) || ((strcmp(str.bv_val, my_defs[x].def))) )
+      {
+         printf("FAIL: roundtrip: definition %zu is %i \"%s\"\n", x, type, str.bv_val);
+         errs++;
+      };
+   };
+   if ( (rc == 1) && (ldapschema_cache_next(&cache, &pos, &type, &str) != 0) )
+   {
+      printf("FAIL: roundtrip: unexpected definition following definitions\n");
+      errs++;
+   };
+
+   // syntaxes are parsed before attribute types and attribute types before object classes
+   if (ldapschema_initialize(&lsd) != LDAPSCHEMA_SUCCESS)
+   {
+      printf("FAIL: roundtrip: out of virtual memory\n");
+      ldapschema_cache_free(&cache);
+      return(errs+1);
+   };
+   if ((rc = ldapschema_cache_parse(lsd, &cache)) != LDAPSCHEMA_SUCCESS)
+   {
+      printf("FAIL: roundtrip: parsing definitions returned %i\n", rc);
+      errs++;
+   };
+   if ( (ldapschema_count_ldapsyntaxes(lsd) != 2) || (ldapschema_count_attributetypes(lsd) != 3) || (ldapschema_count_objectclasses(lsd) != 1) )
+   {
+      printf("FAIL: roundtrip: parsed %zu syntaxes, %zu attribute types and %zu object classes\n",
+         ldapschema_count_ldapsyntaxes(lsd), ldapschema_count_attributetypes(lsd), ldapschema_count_objectclasses(lsd));
+      errs++;
+   };
+   if ((rc = ldapschema_link(lsd)) != LDAPSCHEMA_SUCCESS)
+   {
+      printf("FAIL: roundtrip: linking definitions returned %i\n", rc);
+      errs++;
+   };
+   ldapschema_free(lsd);
+   ldapschema_cache_free(&cache);
+
+   return(errs);
+}
+
+/* end of source file */
@@ -0,0 +1,311 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/treetest.c  tests rendering of trees with threads and counts
+ */
+#define _LDAP_UTILS_TESTS_TREETEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ldaputils.h>
+
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// branches and entries of generated tree
+#define MY_BRANCHES     12
+#define MY_ENTRIES      30
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// displays usage required by libldaputils
+void ldaputils_usage(void);
+
+// main statement
+int main(void);
+
+// checks subordinate counts of branches which are not displayed
+int my_counts(void);
+
+// renders tree with number of threads into string
+char * my_render(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts, size_t threads);
+
+// stores number of subordinates, defined in lib/libldaputils/ltree.c
+void ldaputils_tree_set_subordinates(LDAPUtilsTree * tree, struct berval ** vals);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+// tree with counts from numSubordinates and hasSubordinates
+static const char * my_counts_exp =
+   "+--dc=example, dc=com\n"
+   "   +--ou=groups (+)\n"
+   "   +--ou=people (5 children)\n"
+   "   |  +--uid=jdoe\n"
+   "   |  \\--uid=jsmith\n"
+   "   |\n"
+   "   \\--ou=system\n"
+   " \n"
+   "\n";
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+/// displays usage required by libldaputils
+void ldaputils_usage(void)
+{
+   printf("Usage: treetest\n");
+   return;
+}
+
+
+int main(void)
+{
+   int                  errs;
+   size_t               x;
+   size_t               y;
+   size_t               z;
+   size_t               tested;
+   char                 dn[128];
+   char               * serial;
+   char               * parallel;
+   LDAPUtilsTree      * tree;
+   LDAPUtilsTreeOpts    opts[8];
+   static const size_t  threads[] = { 2, 3, 8, 0 };
+
+   errs   = 0;
+   tested = 0;
+
+   // branches with nested groups, leaf entries, and empty branches
+   if ((tree = ldaputils_tree_initialize(NULL, 0)) == NULL)
+      return(1);
+   for(x = 0; (x < MY_BRANCHES); x++)
+   {
+      for(y = 0; (y < ((x % 3) * MY_ENTRIES / 2)); y++)
+      {
+         snprintf(dn, sizeof(dn), "uid=user%zu,ou=people,ou=branch%zu,dc=example,dc=com", y, x);
+         if (ldaputils_tree_add_dn(tree, dn, NULL) != LDAP_SUCCESS)
+            return(1);
+         if ((y % 7))
+            continue;
+         snprintf(dn, sizeof(dn), "cn=group%zu,ou=groups,ou=branch%zu,dc=example,dc=com", y, x);
+         if (ldaputils_tree_add_dn(tree, dn, NULL) != LDAP_SUCCESS)
+            return(1);
+      };
+      snprintf(dn, sizeof(dn), "ou=branch%zu,dc=example,dc=com", x);
+      if (ldaputils_tree_add_dn(tree, dn, NULL) != LDAP_SUCCESS)
+         return(1);
+   };
+
+   // parallel rendering matches rendering with one thread
+   bzero(opts, sizeof(opts));
+   opts[1].compact     = 1;
+   opts[2].style       = LDAPUTILS_TREE_BULLETS;
+   opts[3].maxdepth    = 3;
+   opts[4].maxchildren = 4;
+   opts[5].maxleafs    = 2;
+   opts[6].noleaf      = 1;
+   opts[7].expandall   = 1;
+   for(x = 0; (x < (sizeof(opts)/sizeof(LDAPUtilsTreeOpts))); x++)
+   {
+      if ((serial = my_render(tree, &opts[x], 1)) == NULL)
+      {
+         printf("FAIL: options %zu: not rendered\n", x);
+         errs++;
+         continue;
+      };
+      for(z = 0; ((threads[z])); z++)
+      {
+         tested++;
+         if ((parallel = my_render(tree, &opts[x], threads[z])) == NULL)
+         {
+            printf("FAIL: options %zu: not rendered with %zu threads\n", x, threads[z]);
+            errs++;
+            continue;
+         };
+         if ((strcmp(serial, parallel)))
+         {
+            printf("FAIL: options %zu: rendered differently with %zu threads\n", x, threads[z]);
+            errs++;
+         };
+         free(parallel);
+      };
+      free(serial);
+   };
+   ldaputils_tree_free(tree);
+
+   errs += my_counts();
+   tested++;
+
+   printf("%zu renderings tested, %i failures\n", tested, errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// checks subordinate counts of branches which are not displayed
+int my_counts(void)
+{
+   int                  errs;
+   char               * str;
+   LDAPUtilsTree      * tree;
+   LDAPUtilsTree      * node;
+   LDAPUtilsTreeOpts    opts;
+   struct berval        val;
+   struct berval      * vals[2];
+
+   if ((tree = ldaputils_tree_initialize(NULL, 0)) == NULL)
+      return(1);
+   vals[0] = &val;
+   vals[1] = NULL;
+   errs    = 0;
+
+   // more subordinates than entries which were returned
+   if (ldaputils_tree_add_dn(tree, "ou=people,dc=example,dc=com", &node) != LDAP_SUCCESS)
+      errs++;
+   val.bv_val = "5";
+   val.bv_len = 1;
+   ldaputils_tree_set_subordinates(node, vals);
+   if (ldaputils_tree_add_dn(tree, "uid=jdoe,ou=people,dc=example,dc=com", NULL) != LDAP_SUCCESS)
+      errs++;
+   if (ldaputils_tree_add_dn(tree, "uid=jsmith,ou=people,dc=example,dc=com", NULL) != LDAP_SUCCESS)
+      errs++;
+
+   // children reported by hasSubordinates
+   if (ldaputils_tree_add_dn(tree, "ou=groups,dc=example,dc=com", &node) != LDAP_SUCCESS)
+      errs++;
+   val.bv_val = "TRUE";
+   val.bv_len = 4;
+   ldaputils_tree_set_subordinates(node, vals);
+
+   // no children
+   if (ldaputils_tree_add_dn(tree, "ou=system,dc=example,dc=com", &node) != LDAP_SUCCESS)
+      errs++;
+   val.bv_val = "FALSE";
+   val.bv_len = 5;
+   ldaputils_tree_set_subordinates(node, vals);
+
+   bzero(&opts, sizeof(opts));
+   opts.subordinates = 1;
+   if ((errs))
+      printf("FAIL: counts: tree not built\n");
+   else if ((str = my_render(tree, &opts, 1)) == NULL)
+   {
+      printf("FAIL: counts: not rendered\n");
+      errs++;
+   } else {
+      if ((strcmp(str, my_counts_exp)))
+      {
+         printf("FAIL: counts: rendered as:\n%s", str);
+         errs++;
+      };
+      free(str);
+   };
+   ldaputils_tree_free(tree);
+
+   return(errs);
+}
+
+
+/// renders tree with number of threads into string
+/// @param[in] tree      root of tree
+/// @param[in] opts      display options
+/// @param[in] threads   number of rendering threads
+char * my_render(LDAPUtilsTree * tree, LDAPUtilsTreeOpts * opts, size_t threads)
+{
+   char             * str;
+   LDAPUtilsSink    * sink;
+
+   opts->threads = threads;
+
+   if (ldaputils_sink_fdopen(&sink, -1) == -1)
+      return(NULL);
+   if (ldaputils_tree_print(tree, opts, sink) == -1)
+   {
+      ldaputils_sink_close(sink);
+      return(NULL);
+   };
+   if ((str = malloc(sink->buff_len + 1)) != NULL)
+   {
+      memcpy(str, sink->buff, sink->buff_len);
+      str[sink->buff_len] = '\0';
+   };
+   ldaputils_sink_close(sink);
+
+   return(str);
+}
+
+/* end of source file */
@@ -0,0 +1,432 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2019 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/validatetest.c  tests schema validation of entries
+ */
+#define _LDAP_UTILS_TESTS_VALIDATETEST 1
+#undef __LDAPUTILS_PMARK
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Headers
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <ldap.h>
+#include <ldapschema.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Definitions
+#endif
+
+// number of threads sharing validator
+#define MY_THREADS      4
+
+// passes over test entries made by each thread
+#define MY_PASSES       500
+
+// maximum attributes, values and violations of test entry
+#define MY_ATTRS        6
+#define MY_VALS         3
+#define MY_VIOLS        3
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Datatypes
+#endif
+
+/// attribute of test entry
+typedef struct my_attr
+{
+   const char * name;
+   const char * vals[MY_VALS+1];
+} MyAttr;
+
+
+/// expected violation of test entry
+typedef struct my_viol
+{
+   int          code;
+   const char * name;
+   size_t       value;
+} MyViol;
+
+
+/// test entry and its expected violations
+typedef struct my_entry
+{
+   const char * desc;
+   MyAttr       attrs[MY_ATTRS+1];
+   MyViol       viols[MY_VIOLS+1];
+} MyEntry;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Prototypes
+#endif
+
+// main statement
+int main(void);
+
+// checks entry and compares violations
+int my_check(LDAPSchemaChecker * chk, const MyEntry * entry, int verbose);
+
+// checks all entries with checker of thread
+void * my_thread(void * arg);
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Variables
+#endif
+
+// validator shared by threads
+static LDAPSchemaValidator * my_val = NULL;
+
+// schema used to check entries
+static const struct
+{
+   int          type;
+   const char * def;
+} my_defs[] =
+{
+   { LDAPSCHEMA_SYNTAX,        "( 1.3.6.1.4.1.1466.115.121.1.15 DESC 'Directory String' )" },
+   { LDAPSCHEMA_SYNTAX,        "( 1.3.6.1.4.1.1466.115.121.1.27 DESC 'INTEGER' )" },
+   { LDAPSCHEMA_SYNTAX,        "( 1.3.6.1.4.1.1466.115.121.1.38 DESC 'OID' )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.0 NAME 'objectClass' SYNTAX 1.3.6.1.4.1.1466.115.121.1.38 )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.41 NAME 'name' SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.3 NAME ( 'cn' 'commonName' ) SUP name )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.4 NAME ( 'sn' 'surname' ) SUP name )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.4.13 NAME 'description' SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 1.3.6.1.1.1.1.0 NAME 'uidNumber' SYNTAX 1.3.6.1.4.1.1466.115.121.1.27 SINGLE-VALUE )" },
+   { LDAPSCHEMA_ATTRIBUTETYPE, "( 2.5.18.1 NAME 'createTimestamp' NO-USER-MODIFICATION USAGE directoryOperation )" },
+   { LDAPSCHEMA_OBJECTCLASS,   "( 2.5.6.0 NAME 'top' ABSTRACT MUST objectClass )" },
+   { LDAPSCHEMA_OBJECTCLASS,   "( 2.5.6.6 NAME 'person' SUP top STRUCTURAL MUST ( sn $ cn ) MAY description )" },
+   { LDAPSCHEMA_OBJECTCLASS,   "( 1.3.6.1.4.1.99999.2.1 NAME 'namedObject' SUP top STRUCTURAL MAY name )" },
+   { LDAPSCHEMA_OBJECTCLASS,   "( 1.3.6.1.4.1.99999.2.2 NAME 'account' SUP top AUXILIARY MAY uidNumber )" },
+   { LDAPSCHEMA_OBJECTCLASS,   "( 1.3.6.1.4.1.1466.101.120.111 NAME 'extensibleObject' SUP top AUXILIARY )" },
+   { 0, NULL }
+};
+
+// entries and the violations reported in order
+static const MyEntry my_entries[] =
+{
+   {  "valid entry",
+      {  { "objectClass",       { "top", "person", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "SN",                { "Doe", NULL } },
+         { "description",       { "J\xc3\xb6rg's friend", NULL } },
+         { "createTimestamp",   { "20261018120000Z", NULL } },
+         { NULL,                { NULL } } },
+      {  { 0, NULL, 0 } } },
+   {  "attribute options",
+      {  { "objectClass",       { "person", NULL } },
+         { "cn;lang-en",        { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "uidNumber;binary",  { "\x02\x01\x05", NULL } },
+         { "objectClass",       { "account", NULL } },
+         { NULL,                { NULL } } },
+      {  { 0, NULL, 0 } } },
+   {  "subtype of allowed attribute",
+      {  { "objectClass",       { "namedObject", NULL } },
+         { "commonName",        { "printer", NULL } },
+         { NULL,                { NULL } } },
+      {  { 0, NULL, 0 } } },
+   {  "extensible object",
+      {  { "objectClass",       { "person", "extensibleObject", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "uidNumber",         { "1000", NULL } },
+         { NULL,                { NULL } } },
+      {  { 0, NULL, 0 } } },
+   {  "unknown objectClass",
+      {  { "objectClass",       { "person", "bogus", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "uidNumber",         { "1000", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_UNKNOWN_CLASS,     "bogus",       1 },
+         { 0, NULL, 0 } } },
+   {  "no structural objectClass",
+      {  { "objectClass",       { "top", "account", NULL } },
+         { "uidNumber",         { "1000", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_NO_STRUCTURAL,     "",            0 },
+         { 0, NULL, 0 } } },
+   {  "unknown attributeType",
+      {  { "objectClass",       { "person", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "fooBar",            { "x", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_UNKNOWN_ATTRIBUTE, "fooBar",      0 },
+         { 0, NULL, 0 } } },
+   {  "attribute not allowed",
+      {  { "objectClass",       { "person", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "uidNumber",         { "1000", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_NOT_ALLOWED,       "uidNumber",   0 },
+         { 0, NULL, 0 } } },
+   {  "missing required attributes",
+      {  { "objectClass",       { "person", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_MISSING,           "cn",          0 },
+         { LDAPSCHEMA_V_MISSING,           "sn",          0 },
+         { 0, NULL, 0 } } },
+   {  "missing objectClass",
+      {  { "cn",                { "John Doe", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_MISSING,           "objectClass", 0 },
+         { 0, NULL, 0 } } },
+   {  "multiple values of single value attribute",
+      {  { "objectClass",       { "person", "account", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "uidNumber",         { "1000", "1001", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_SINGLE_VALUE,      "uidNumber",   1 },
+         { 0, NULL, 0 } } },
+   {  "values not matching syntax",
+      {  { "objectClass",       { "person", "account", NULL } },
+         { "cn",                { "John Doe", NULL } },
+         { "sn",                { "Doe", NULL } },
+         { "description",       { "valid", "J\xf6rg", NULL } },
+         { "uidNumber",         { "-0", NULL } },
+         { NULL,                { NULL } } },
+      {  { LDAPSCHEMA_V_SYNTAX,            "description", 1 },
+         { LDAPSCHEMA_V_SYNTAX,            "uidNumber",   0 },
+         { 0, NULL, 0 } } },
+   {  NULL, { { NULL, { NULL } } }, { { 0, NULL, 0 } } }
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#ifdef __LDAPUTILS_PMARK
+#pragma mark - Functions
+#endif
+
+int main(void)
+{
+   int                   rc;
+   int                   errs;
+   size_t                x;
+   size_t                passes;
+   uintptr_t             res;
+   struct berval         bv;
+   pthread_t             threads[MY_THREADS];
+   LDAPSchema          * lsd;
+   LDAPSchemaChecker   * chk;
+
+   if (ldapschema_initialize(&lsd) != LDAPSCHEMA_SUCCESS)
+   {
+      printf("FAIL: out of virtual memory\n");
+      return(1);
+   };
+   for(x = 0; ((my_defs[x].def)); x++)
+   {
+      bv.bv_val = (char *)my_defs[x].def;
+      bv.bv_len = strlen(my_defs[x].def);
+      if ((rc = ldapschema_parse(lsd, my_defs[x].type, &bv)) != LDAPSCHEMA_SUCCESS)
+      {
+         printf("FAIL: %s: %s\n", my_defs[x].def, ldapschema_err2string(rc));
+         ldapschema_free(lsd);
+         return(1);
+      };
+   };
+   if ( ((rc = ldapschema_link(lsd)) != LDAPSCHEMA_SUCCESS) ||
+        ((rc = ldapschema_validator_initialize(lsd, &my_val)) != LDAPSCHEMA_SUCCESS) ||
+        ((rc = ldapschema_checker_initialize(my_val, &chk)) != LDAPSCHEMA_SUCCESS) )
+   {
+      printf("FAIL: unable to compile schema: %s\n", ldapschema_err2string(rc));
+      ldapschema_validator_free(my_val);
+      ldapschema_free(lsd);
+      return(1);
+   };
+
+   errs = 0;
+
+   // reports each failure once before checking concurrently
+   for(x = 0; ((my_entries[x].desc)); x++)
+      errs += my_check(chk, &my_entries[x], 1);
+   ldapschema_checker_free(chk);
+
+   // validator is shared, checkers are not
+   passes = MY_PASSES;
+   for(x = 0; ( (!(errs)) && (x < MY_THREADS) ); x++)
+   {
+      if ((pthread_create(&threads[x], NULL, my_thread, &passes)))
+      {
+         printf("FAIL: unable to create thread\n");
+         ldapschema_validator_free(my_val);
+         ldapschema_free(lsd);
+         return(1);
+      };
+   };
+   for(x = 0; ( (!(errs)) && (x < MY_THREADS) ); x++)
+   {
+      pthread_join(threads[x], (void **)&res);
+      errs += (int)res;
+   };
+
+   ldapschema_validator_free(my_val);
+   ldapschema_free(lsd);
+
+   printf("%zu entries tested, %i failures\n", (sizeof(my_entries)/sizeof(MyEntry)) - 1, errs);
+
+   return(((errs)) ? 1 : 0);
+}
+
+
+/// checks entry and compares violations
+/// @param[in] chk      reference to checker
+/// @param[in] entry    test entry
+/// @param[in] verbose  print mismatched violations
+int my_check(LDAPSchemaChecker * chk, const MyEntry * entry, int verbose)
+{
+   int               rc;
+   int               code;
+   size_t            x;
+   size_t            y;
+   size_t            value;
+   struct berval     name;
+   struct berval     vals[MY_VALS];
+
+   ldapschema_check_begin(chk);
+   for(x = 0; ((entry->attrs[x].name)); x++)
+   {
+      for(y = 0; ((entry->attrs[x].vals[y])); y++)
+      {
+         vals[y].bv_val = (char *)entry->attrs[x].vals[y];
+         vals[y].bv_len = strlen(entry->attrs[x].vals[y]);
+      };
+      name.bv_val = (char *)entry->attrs[x].name;
+      name.bv_len = strlen(entry->attrs[x].name);
+      if (ldapschema_check_attribute(chk, &name, vals, y) != LDAPSCHEMA_SUCCESS)
+      {
+         if ((verbose))
+            printf("FAIL: %s: out of virtual memory\n", entry->desc);
+         return(1);
+      };
+   };
+   if ((rc = ldapschema_check_end(chk)) < 0)
+   {
+      if ((verbose))
+         printf("FAIL: %s: out of virtual memory\n", entry->desc);
+      return(1);
+   };
+
+   for(x = 0; ((code = ldapschema_check_violation(chk, x, &name, &value)) != 0); x++)
+   {
+      if ( (code != entry->viols[x].code) ||
+           (name.bv_len != strlen(entry->viols[x].name)) ||
+           ((strncmp(name.bv_val, entry->viols[x].name, name.bv_len))) ||
+           (value != entry->viols[x].value) )
+      {
+         if ((verbose))
+            printf("FAIL: %s: violation %zu is %s: %.*s (value %zu)\n", entry->desc, x,
+               ldapschema_violation2string(code), (int)name.bv_len, ((name.bv_val)) ? name.bv_val : "", value);
+         return(1);
+      };
+   };
+   if ( (entry->viols[x].code != 0) || ((size_t)rc != x) )
+   {
+      if ((verbose))
+         printf("FAIL: %s: %i violations reported, %zu listed\n", entry->desc, rc, x);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+/// checks all entries with checker of thread
+/// @param[in] arg     number of passes over entries
+void * my_thread(void * arg)
+{
+   uintptr_t             errs;
+   size_t                x;
+   size_t                y;
+   size_t                passes;
+   LDAPSchemaChecker   * chk;
+
+   passes = *((size_t *)arg);
+
+   errs = 1;
+   if (ldapschema_checker_initialize(my_val, &chk) != LDAPSCHEMA_SUCCESS)
+      return((void *)errs);
+
+   errs = 0;
+   for(x = 0; x < passes; x++)
+      for(y = 0; ((my_entries[y].desc)); y++)
+         errs += (uintptr_t)my_check(chk, &my_entries[y], 0);
+   ldapschema_checker_free(chk);
+
+   return((void *)errs);
+}
+
+/* end of source file */